@@ -0,0 +1,63 @@
+/*  =================== File Information =================
+	File Name: AllocationTracker.cpp
+	Description:
+	Author:
+
+	Purpose: Counting replacements of the global operator new and delete
+	Usage:
+	===================================================== */
+
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include "AllocationTracker.h"
+
+#ifdef CGLAB_TRACK_ALLOCATIONS
+
+// relaxed, the totals only have to add up once the threads are done
+static std::atomic<size_t> allocationCount(0);
+static std::atomic<size_t> freeCount(0);
+static std::atomic<size_t> allocatedBytes(0);
+
+/*	new[] and the nothrow and sized forms all end up in these two */
+void* operator new(std::size_t size) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	void* p = malloc(size > 0 ? size : 1);
+	if (p == NULL) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	if (p != NULL) {
+		freeCount.fetch_add(1, std::memory_order_relaxed);
+		free(p);
+	}
+}
+
+bool allocationTrackingEnabled() {
+	return true;
+}
+
+AllocationStats getAllocationStats() {
+	AllocationStats stats;
+	stats.allocations = allocationCount.load(std::memory_order_relaxed);
+	stats.frees = freeCount.load(std::memory_order_relaxed);
+	stats.bytes = allocatedBytes.load(std::memory_order_relaxed);
+	return stats;
+}
+
+#else
+
+bool allocationTrackingEnabled() {
+	return false;
+}
+
+AllocationStats getAllocationStats() {
+	AllocationStats stats = { 0, 0, 0 };
+	return stats;
+}
+
+#endif
@@ -0,0 +1,38 @@
+/*  =================== File Information =================
+	File Name: AllocationTracker.h
+	Description:
+	Author:
+
+	Purpose: Counts the heap allocations made through operator new, so a
+			 frame can be checked for allocations.  The counting replaces
+			 the global operator new and delete and is only compiled in
+			 when CGLAB_TRACK_ALLOCATIONS is defined: in every build
+			 without NDEBUG, and with -DCGLAB_TRACK_ALLOCATIONS=ON in cmake
+			 for benchmark builds.  Otherwise the counters stay 0.
+	Usage:	AllocationStats before = getAllocationStats();
+			renderer.drawFrame(...);
+			size_t allocations = getAllocationStats().allocations - before.allocations;
+	===================================================== */
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <cstddef>
+
+#if !defined(NDEBUG) && !defined(CGLAB_TRACK_ALLOCATIONS)
+#define CGLAB_TRACK_ALLOCATIONS 1
+#endif
+
+/*
+	Totals since the program started, of all threads
+*/
+struct AllocationStats {
+	size_t allocations;
+	size_t frees;
+	size_t bytes;		// requested by the allocations
+};
+
+// false when the counting is not compiled in
+bool allocationTrackingEnabled();
+AllocationStats getAllocationStats();
+
+#endif
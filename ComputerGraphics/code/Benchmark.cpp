@@ -0,0 +1,526 @@
+/*  =================== File Information =================
+	File Name: Benchmark.cpp
+	Description:
+	Author:
+
+	Purpose: Event recording and benchmark replay
+	Usage:
+	===================================================== */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cctype>
+#include "Benchmark.h"
+#include "Headless.h"
+#include "SceneRenderer.h"
+#include "AllocationTracker.h"
+
+EventRecorder::EventRecorder() {
+	file = NULL;
+	frame = 0;
+}
+
+EventRecorder::~EventRecorder() {
+	if (file != NULL) {
+		fclose(file);
+	}
+}
+
+bool EventRecorder::open(std::string fileName) {
+	file = fopen(fileName.c_str(), "w");
+	if (file == NULL) {
+		std::cout << "Unable to open event recording: " << fileName << std::endl;
+		return false;
+	}
+	fprintf(file, "# frame event args\n");
+	frame = 0;
+	return true;
+}
+
+void EventRecorder::record(const char* name, int a, int b) {
+	if (file == NULL) {
+		return;
+	}
+	std::string event = name;
+	if (event == "key") {
+		fprintf(file, "%d %s %c\n", frame, name, (char)a);
+	}
+	else if (event == "wheel") {
+		fprintf(file, "%d %s %d\n", frame, name, a);
+	}
+	else if (event == "drag-end" || event == "release" || event == "undo" || event == "redo") {
+		fprintf(file, "%d %s\n", frame, name);
+	}
+	else {
+		fprintf(file, "%d %s %d %d\n", frame, name, a, b);
+	}
+}
+
+void EventRecorder::nextFrame() {
+	frame++;
+}
+
+bool parseBenchmarkOptions(int argc, char** argv, BenchmarkOptions& options) {
+	bool bench = false;
+	options.outputPath = "benchmark.json";
+	options.width = 640;
+	options.height = 480;
+	options.warmupFrames = 10;
+	options.frames = 0;
+	options.dragPrediction = false;
+	options.pickBuffer = false;
+	options.spheres = 0;
+	options.frustumCulling = true;
+	options.occlusionCulling = false;
+	options.shaders = false;
+	options.zeroAllocations = false;
+	options.textureCompression = COMPRESSION_NONE;
+	options.textureCache = true;
+	options.instanceTextures = "";
+	options.atlas = false;
+	options.virtualTexture = "";
+	options.virtualSize = 32768;
+	options.paintHistory = true;
+	options.textureResize = noResize();
+	options.animate = false;
+	options.streamTransforms = true;
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = (i + 1 < argc);
+		if (arg == "--bench" && hasValue) {
+			bench = true;
+			options.scriptPath = argv[++i];
+		}
+		else if (arg == "--bench-output" && hasValue) {
+			options.outputPath = argv[++i];
+		}
+		else if (arg == "--size" && hasValue) {
+			sscanf(argv[++i], "%dx%d", &options.width, &options.height);
+		}
+		else if (arg == "--warmup" && hasValue) {
+			options.warmupFrames = atoi(argv[++i]);
+		}
+		else if (arg == "--frames" && hasValue) {
+			options.frames = atoi(argv[++i]);
+		}
+		else if (arg == "--drag-prediction") {
+			options.dragPrediction = true;
+		}
+		else if (arg == "--pick-buffer") {
+			options.pickBuffer = true;
+		}
+		else if (arg == "--spheres" && hasValue) {
+			options.spheres = atoi(argv[++i]);
+		}
+		else if (arg == "--no-frustum-culling") {
+			options.frustumCulling = false;
+		}
+		else if (arg == "--occlusion-culling") {
+			options.occlusionCulling = true;
+		}
+		else if (arg == "--shaders") {
+			options.shaders = true;
+		}
+		else if (arg == "--zero-allocations") {
+			options.zeroAllocations = true;
+		}
+		else if (arg == "--texture-compression" && hasValue) {
+			if (!parseCompressionName(argv[++i], options.textureCompression)) {
+				std::cout << "invalid --texture-compression, expected none, bc1 or bc7" << std::endl;
+			}
+		}
+		else if (arg == "--no-texture-cache") {
+			options.textureCache = false;
+		}
+		else if (arg == "--instance-textures" && hasValue) {
+			options.instanceTextures = argv[++i];
+		}
+		else if (arg == "--atlas") {
+			options.atlas = true;
+		}
+		else if (arg == "--virtual-texture" && hasValue) {
+			options.virtualTexture = argv[++i];
+		}
+		else if (arg == "--virtual-size" && hasValue) {
+			options.virtualSize = atoi(argv[++i]);
+		}
+		else if (arg == "--no-paint-history") {
+			options.paintHistory = false;
+		}
+		else if (arg == "--animate") {
+			options.animate = true;
+		}
+		else if (arg == "--no-stream-buffer") {
+			options.streamTransforms = false;
+		}
+	}
+	parseResizePolicy(argc, argv, options.textureResize);
+	options.dynamicResolution = parseResolutionOptions(argc, argv, options.resolutionScaler);
+	if (options.width <= 0 || options.height <= 0) {
+		options.width = 640;
+		options.height = 480;
+	}
+	if (options.warmupFrames < 0) {
+		options.warmupFrames = 0;
+	}
+	return bench;
+}
+
+static bool eventFrameLess(const BenchmarkEvent& a, const BenchmarkEvent& b) {
+	return a.frame < b.frame;
+}
+
+bool loadBenchmarkScript(std::string fileName, std::vector<BenchmarkEvent>& events) {
+	std::ifstream scriptFile(fileName.c_str());
+	if (!scriptFile.is_open()) {
+		std::cout << "Unable to open benchmark script: " << fileName << std::endl;
+		return false;
+	}
+	std::string line;
+	int lineNumber = 0;
+	while (getline(scriptFile, line)) {
+		lineNumber++;
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		std::istringstream stream(line);
+		BenchmarkEvent event;
+		if (!(stream >> event.frame >> event.name)) {
+			std::cout << fileName << ":" << lineNumber << ": expected <frame> <event>" << std::endl;
+			continue;
+		}
+		for (int i = 0; i < 5; i++) {
+			event.args[i] = 0;
+			std::string token;
+			if (stream >> token) {
+				// keys are written as characters, everything else as numbers
+				bool character = token.size() == 1 && !isdigit((unsigned char)token[0]);
+				event.args[i] = character ? token[0] : atoi(token.c_str());
+			}
+		}
+		events.push_back(event);
+	}
+	// keep the file order of events within a frame
+	std::stable_sort(events.begin(), events.end(), eventFrameLess);
+	return true;
+}
+
+static double percentile(std::vector<double> values, double p) {
+	if (values.empty()) {
+		return 0;
+	}
+	std::sort(values.begin(), values.end());
+	size_t index = (size_t)(p / 100.0 * (values.size() - 1) + 0.5);
+	return values[std::min(index, values.size() - 1)];
+}
+
+static double mean(const std::vector<double>& values) {
+	if (values.empty()) {
+		return 0;
+	}
+	double sum = 0;
+	for (size_t i = 0; i < values.size(); i++) {
+		sum += values[i];
+	}
+	return sum / values.size();
+}
+
+static void writeStatistics(FILE* out, const char* name, const std::vector<double>& values, bool last) {
+	fprintf(out, "  \"%s\": { \"count\": %d, \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n",
+		name, (int)values.size(), mean(values), percentile(values, 50), percentile(values, 90),
+		percentile(values, 95), percentile(values, 99), percentile(values, 100), last ? "" : ",");
+}
+
+int runBenchmark(const BenchmarkOptions& options) {
+	std::vector<BenchmarkEvent> events;
+	if (!loadBenchmarkScript(options.scriptPath, events)) {
+		return 1;
+	}
+	int frames = options.frames;
+	if (frames <= 0) {
+		frames = events.empty() ? 1 : events.back().frame + 1;
+	}
+	frames += options.warmupFrames;
+
+	if (!createOffscreenContext(options.width, options.height)) {
+		return 1;
+	}
+	std::string rendererName = (const char*)glGetString(GL_RENDERER);
+
+	typedef std::chrono::steady_clock Clock;
+	SceneRenderer* renderer = new SceneRenderer();
+	renderer->virtualTextureFile = options.virtualTexture;
+	renderer->virtualTextureSize = options.virtualSize;
+	renderer->textureManager.setResize(options.textureResize);
+	renderer->initGL(options.width, options.height);
+	renderer->dragController.setPrediction(options.dragPrediction);
+	renderer->pickBufferEnabled = options.pickBuffer;
+	renderer->setSphereInstances(options.spheres);
+	renderer->setInstanceTextures(options.instanceTextures, options.atlas);
+	renderer->frustumCulling = options.frustumCulling;
+	renderer->occlusionCulling = options.occlusionCulling;
+	renderer->shaderPipeline = options.shaders;
+	renderer->streamTransforms = options.streamTransforms;
+	renderer->paintHistory = options.paintHistory;
+	renderer->dynamicResolution = options.dynamicResolution;
+	renderer->resolutionScaler = options.resolutionScaler;
+	renderer->textureManager.setCompression(options.textureCompression, options.textureCache);
+	size_t initialUploadBytes = 0;		// uploaded before the first measured frame
+
+	std::vector<double> frameTimes;		// milliseconds
+	CullStats culledTotal = { 0, 0, 0, 0 };	// summed over the measured frames
+	GLStateStats stateTotal = { 0, 0, 0 };
+	VirtualTextureStats virtualTotal = { 0, 0, 0, 0, 0, 0, 0 };
+	TransformStats transformTotal = { 0, 0 };
+	StreamBufferStats streamBefore = renderer->getStreamStats();	// at the first measured frame
+	std::vector<double> pickTimes;		// microseconds
+	std::vector<double> uploadBytes;	// per measured frame
+	std::vector<double> allocations;	// per measured frame, events included
+	std::vector<double> resolutionScales;	// per measured frame, with dynamic resolution
+	int allocatingFrames = 0;
+	// nothing below may allocate inside the measured frames
+	frameTimes.reserve(frames);
+	pickTimes.reserve(events.size());
+	uploadBytes.reserve(frames);
+	allocations.reserve(frames);
+	resolutionScales.reserve(frames);
+	bool castRay = false;
+	int mouseX = 0;
+	int mouseY = 0;
+	size_t nextEvent = 0;
+
+	for (int frame = 0; frame < frames; frame++) {
+		// Warmup frames replay no events, the script starts right after them
+		int scriptFrame = frame - options.warmupFrames;
+		size_t uploadedBefore = renderer->textureManager.getStats().uploadBytes;
+		if (scriptFrame == 0) {
+			initialUploadBytes = uploadedBefore;
+			streamBefore = renderer->getStreamStats();
+		}
+		size_t allocationsBefore = getAllocationStats().allocations;
+		Clock::time_point start = Clock::now();
+
+		while (scriptFrame >= 0 && nextEvent < events.size() && events[nextEvent].frame <= scriptFrame) {
+			const BenchmarkEvent& event = events[nextEvent++];
+			const int* a = event.args;
+			if (event.name == "key") {
+				renderer->moveEye(a[0]);
+				renderer->updateCamera(options.width, options.height);
+			}
+			else if (event.name == "wheel") {
+				renderer->zoom(a[0]);
+				renderer->updateCamera(options.width, options.height);
+			}
+			else if (event.name == "drag-begin" || event.name == "click") {
+				Clock::time_point pickStart = Clock::now();
+				if (event.name == "drag-begin") {
+					renderer->beginDrag(a[0], a[1]);
+				}
+				else if (options.pickBuffer) {
+					renderer->pickObject(a[0], a[1]);
+					castRay = true;
+				}
+				else {
+					RayHit hit;
+					renderer->pickScene(a[0], a[1], hit);
+					castRay = true;
+				}
+				pickTimes.push_back(std::chrono::duration<double, std::micro>(Clock::now() - pickStart).count());
+				mouseX = a[0];
+				mouseY = a[1];
+			}
+			else if (event.name == "drag") {
+				renderer->dragTo(a[0], a[1]);
+				mouseX = a[0];
+				mouseY = a[1];
+			}
+			else if (event.name == "drag-end") {
+				renderer->endDrag();
+			}
+			else if (event.name == "release") {
+				castRay = false;
+				renderer->endStroke();
+			}
+			else if (event.name == "undo") {
+				renderer->undoPaint();
+			}
+			else if (event.name == "redo") {
+				renderer->redoPaint();
+			}
+			else if (event.name == "brush") {
+				renderer->paintAt(a[0], a[1]);
+			}
+			else if (event.name == "paint") {
+				renderer->myObject->paintTexture(a[0], a[1], (char)a[2], (char)a[3], (char)a[4]);
+			}
+			else {
+				std::cout << "unknown benchmark event: " << event.name << std::endl;
+			}
+		}
+
+		if (options.animate) {
+			// the same fixed timestep as the events
+			renderer->animateSphereInstances(frame / 60.0);
+		}
+		renderer->drawFrame(castRay, mouseX, mouseY);
+		glFinish();
+		double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		size_t frameAllocations = getAllocationStats().allocations - allocationsBefore;
+		// the frame's scratch memory did not fit the arena, it regrows next frame
+		bool arenaOverflow = renderer->frameArena.getExtraBlocks() > 0;
+
+		if (scriptFrame >= 0) {
+			const CullStats& cullStats = renderer->getCullStats();
+			culledTotal.tested += cullStats.tested;
+			culledTotal.frustumCulled += cullStats.frustumCulled;
+			culledTotal.occlusionCulled += cullStats.occlusionCulled;
+			culledTotal.drawn += cullStats.drawn;
+			const GLStateStats& stateStats = renderer->getGLStateStats();
+			stateTotal.issued += stateStats.issued;
+			stateTotal.skipped += stateStats.skipped;
+			stateTotal.textureBinds += stateStats.textureBinds;
+			const VirtualTextureStats& virtualStats = renderer->virtualTexture.getStats();
+			virtualTotal.requestedTiles += virtualStats.requestedTiles;
+			virtualTotal.missingTiles += virtualStats.missingTiles;
+			virtualTotal.uploads += virtualStats.uploads;
+			virtualTotal.paintUploads += virtualStats.paintUploads;
+			const TransformStats& transformStats = renderer->getTransformStats();
+			transformTotal.objects += transformStats.objects;
+			transformTotal.seconds += transformStats.seconds;
+			frameTimes.push_back(milliseconds);
+			uploadBytes.push_back((double)(renderer->textureManager.getStats().uploadBytes - uploadedBefore));
+			allocations.push_back((double)frameAllocations);
+			if (options.dynamicResolution) {
+				resolutionScales.push_back((double)renderer->getFrameWidth() / options.width);
+			}
+			if ((frameAllocations > 0 || arenaOverflow) && options.zeroAllocations) {
+				if (allocatingFrames < 10) {
+					std::cout << "frame " << scriptFrame << " made " << frameAllocations << " heap allocations";
+					if (arenaOverflow) {
+						std::cout << " and overflowed the frame arena by " << renderer->frameArena.getExtraBlocks() << " blocks";
+					}
+					std::cout << std::endl;
+				}
+				allocatingFrames++;
+			}
+		}
+	}
+
+	const TextureStats& textureStats = renderer->textureManager.getStats();
+	const DragStats& dragStats = renderer->dragController.getStats();
+	double totalUpload = 0;
+	for (size_t i = 0; i < uploadBytes.size(); i++) {
+		totalUpload += uploadBytes[i];
+	}
+
+	FILE* out = (options.outputPath == "-") ? stdout : fopen(options.outputPath.c_str(), "w");
+	if (out == NULL) {
+		std::cout << "Unable to write benchmark report: " << options.outputPath << std::endl;
+		delete renderer;
+		destroyOffscreenContext();
+		return 1;
+	}
+	fprintf(out, "{\n");
+	fprintf(out, "  \"script\": \"%s\",\n", options.scriptPath.c_str());
+	fprintf(out, "  \"build\": \"%s %s\",\n", __DATE__, __TIME__);
+	fprintf(out, "  \"renderer\": \"%s\",\n", rendererName.c_str());
+	fprintf(out, "  \"pipeline\": \"%s\",\n", renderer->shaderPipeline ? "shaders" : "fixed function");
+	fprintf(out, "  \"width\": %d,\n  \"height\": %d,\n", options.width, options.height);
+	fprintf(out, "  \"warmup_frames\": %d,\n  \"frames\": %d,\n  \"events\": %d,\n",
+		options.warmupFrames, (int)frameTimes.size(), (int)events.size());
+	writeStatistics(out, "frame_time_ms", frameTimes, false);
+	writeStatistics(out, "pick_latency_us", pickTimes, false);
+	writeStatistics(out, "texture_upload_bytes_per_frame", uploadBytes, false);
+	if (allocationTrackingEnabled()) {
+		writeStatistics(out, "heap_allocations_per_frame", allocations, false);
+	}
+	if (renderer->dynamicResolution) {
+		ResolutionScaler& scaler = renderer->resolutionScaler;
+		const ResolutionScalerStats& scalerStats = scaler.getStats();
+		writeStatistics(out, "resolution_scale", resolutionScales, false);
+		fprintf(out, "  \"dynamic_resolution\": { \"min_scale\": %.2f, \"max_scale\": %.2f, \"target_frame_ms\": %.2f, \"final_scale\": %.3f, \"increases\": %d, \"decreases\": %d, \"reverts\": %d },\n",
+			scaler.getMinScale(), scaler.getMaxScale(), scaler.getTargetTime(), scaler.getScale(),
+			scalerStats.increases, scalerStats.decreases, scalerStats.reverts);
+	}
+	fprintf(out, "  \"texture_upload_bytes\": { \"initial\": %zu, \"measured\": %.0f },\n", initialUploadBytes, totalUpload);
+	fprintf(out, "  \"drag\": { \"events\": %d, \"updates\": %d },\n", dragStats.events, dragStats.updates);
+	double measuredFrames = std::max(1.0, (double)frameTimes.size());
+	fprintf(out, "  \"culling_per_frame\": { \"tested\": %.1f, \"frustum_culled\": %.1f, \"occlusion_culled\": %.1f, \"drawn\": %.1f },\n",
+		culledTotal.tested / measuredFrames, culledTotal.frustumCulled / measuredFrames,
+		culledTotal.occlusionCulled / measuredFrames, culledTotal.drawn / measuredFrames);
+	fprintf(out, "  \"gl_state_calls_per_frame\": { \"issued\": %.1f, \"skipped\": %.1f, \"texture_binds\": %.1f },\n",
+		stateTotal.issued / measuredFrames, stateTotal.skipped / measuredFrames, stateTotal.textureBinds / measuredFrames);
+	if (renderer->shaderPipeline) {
+		const StreamBufferStats& streamStats = renderer->getStreamStats();
+		fprintf(out, "  \"transform_updates\": { \"stream_buffer\": %s, \"objects_per_frame\": %.1f, \"update_ms_per_frame\": %.4f, \"objects_per_ms\": %.0f, \"ring_waits\": %d, \"ring_wait_ms\": %.3f, \"ring_grows\": %d },\n",
+			renderer->isStreamingTransforms() ? "true" : "false", transformTotal.objects / measuredFrames,
+			1000.0 * transformTotal.seconds / measuredFrames,
+			transformTotal.seconds > 0 ? transformTotal.objects / (1000.0 * transformTotal.seconds) : 0.0,
+			streamStats.waits - streamBefore.waits, 1000.0 * (streamStats.waitSeconds - streamBefore.waitSeconds),
+			streamStats.grows - streamBefore.grows);
+	}
+	if (options.atlas) {
+		const AtlasStats& atlasStats = renderer->getAtlasStats();
+		fprintf(out, "  \"texture_atlas\": { \"images\": %d, \"pages\": %d, \"efficiency\": %.3f, \"pack_ms\": %.2f },\n",
+			atlasStats.images, atlasStats.pages, atlasStats.efficiency, 1000.0 * atlasStats.packSeconds);
+	}
+	PaintHistory& history = renderer->myObject->getPaintHistory();
+	if (history.getStepCount() > 0) {
+		const PaintHistoryStats& historyStats = history.getStats();
+		fprintf(out, "  \"paint_history\": { \"undo_steps\": %d, \"redo_steps\": %d, \"tile_images\": %d, \"bytes\": %zu, \"uncompressed_bytes\": %zu, \"restored_tiles\": %d, \"step_bytes\": [",
+			historyStats.undoSteps, historyStats.redoSteps, historyStats.tileImages, historyStats.bytes,
+			historyStats.rawBytes, historyStats.restoredTiles);
+		for (int i = 0; i < history.getStepCount(); i++) {
+			fprintf(out, "%s%zu", i > 0 ? ", " : "", history.getStepBytes(i));
+		}
+		fprintf(out, "] },\n");
+	}
+	if (renderer->virtualTexture.isOpen()) {
+		TileStore& store = renderer->virtualTexture.getStore();
+		const TileStoreStats& storeStats = store.getStats();
+		// the tile file is only complete after the flush
+		store.flush();
+		fprintf(out, "  \"virtual_texture\": { \"size\": %d, \"requested_tiles_per_frame\": %.1f, \"missing_tiles_per_frame\": %.1f, \"uploads_per_frame\": %.1f, \"paint_uploads_per_frame\": %.1f, \"tile_reads\": %d, \"tiles_generated\": %d, \"tile_writes\": %d, \"host_bytes\": %zu, \"gpu_cache_bytes\": %zu, \"file_bytes\": %zu },\n",
+			store.getSize(), virtualTotal.requestedTiles / measuredFrames, virtualTotal.missingTiles / measuredFrames,
+			virtualTotal.uploads / measuredFrames, virtualTotal.paintUploads / measuredFrames, storeStats.tileReads,
+			storeStats.tilesGenerated, storeStats.tileWrites,
+			(size_t)storeStats.hostTiles * VIRTUAL_TILE_SIZE * VIRTUAL_TILE_SIZE * 3,
+			renderer->virtualTexture.getCacheBytes(), storeStats.fileBytes);
+	}
+	if (textureStats.compressedUploads > 0) {
+		// a block compressed without loss has an infinite PSNR, which JSON cannot hold
+		fprintf(out, "  \"texture_compression\": { \"format\": \"%s\", \"uploads\": %d, \"cache_hits\": %d, \"encode_mpix_per_s\": %.1f, \"gpu_bytes_saved\": %zu, \"min_psnr_db\": %.2f },\n",
+			compressionName(options.textureCompression), textureStats.compressedUploads, textureStats.compressionCacheHits,
+			textureStats.encodeSeconds > 0 ? textureStats.encodedTexels / textureStats.encodeSeconds / 1e6 : 0.0,
+			textureStats.gpuBytesSaved, std::min(textureStats.minPSNR, 999.0));
+	}
+	if (textureStats.resampledTextures > 0) {
+		fprintf(out, "  \"texture_resize\": { \"filter\": \"%s\", \"textures\": %d, \"seconds\": %.4f },\n",
+			resampleFilterName(options.textureResize.filter), textureStats.resampledTextures, textureStats.resampleSeconds);
+	}
+	fprintf(out, "  \"texture_residency\": { \"host_bytes\": %zu, \"gpu_bytes\": %zu, \"host_evictions\": %d, \"gpu_evictions\": %d, \"host_reloads\": %d, \"gpu_reloads\": %d }\n",
+		textureStats.hostResidentBytes, textureStats.gpuResidentBytes, textureStats.hostEvictions,
+		textureStats.gpuEvictions, textureStats.hostReloads, textureStats.gpuReloads);
+	fprintf(out, "}\n");
+	if (out != stdout) {
+		fclose(out);
+		std::cout << "benchmark report written to " << options.outputPath << std::endl;
+	}
+
+	delete renderer;
+	destroyOffscreenContext();
+	if (options.zeroAllocations && !allocationTrackingEnabled()) {
+		std::cout << "--zero-allocations needs a build with CGLAB_TRACK_ALLOCATIONS" << std::endl;
+		return 1;
+	}
+	if (allocatingFrames > 0) {
+		std::cout << allocatingFrames << " of " << frameTimes.size() << " measured frames allocated" << std::endl;
+		return 1;
+	}
+	return 0;
+}
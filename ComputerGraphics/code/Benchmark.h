@@ -0,0 +1,140 @@
+/*  =================== File Information =================
+	File Name: Benchmark.h
+	Description:
+	Author:
+
+	Purpose: Reproducible scene benchmark.  A recorded or hand written
+			 sequence of input events is replayed against the scene at a
+			 fixed timestep of one event frame per rendered frame, and the
+			 frame times, pick latency and texture upload volume are
+			 written as JSON.
+	Usage:	ComputerGraphics --record events.txt
+				records the events of an interactive session
+			ComputerGraphics --bench events.txt [--bench-output result.json]
+				[--size 640x480] [--warmup 10] [--frames N] [--drag-prediction]
+				[--pick-buffer] [--spheres N] [--no-frustum-culling]
+				[--occlusion-culling] [--shaders] [--zero-allocations]
+				[--texture-compression bc1|bc7] [--no-texture-cache]
+				[--instance-textures a.ppm,b.ppm,...] [--atlas]
+				[--virtual-texture surface.vt] [--virtual-size 32768]
+				[--no-paint-history] [--resize-textures pot|WxH]
+				[--max-texture-size N] [--resample-filter box|bilinear|lanczos3]
+				[--dynamic-resolution] [--resolution-scale 0.5,1.0]
+				[--target-frame-ms 16.7] [--animate] [--no-stream-buffer]
+				replays them offscreen; the default size is the canvas of
+				the default window, where recordings are made
+
+			Event files hold one event per line: "<frame> <event> <args>"
+				<frame> key <w|a|s|d>		eye movement
+				<frame> wheel <dy>			zoom
+				<frame> drag-begin <x> <y>	right button pressed
+				<frame> drag <x> <y>
+				<frame> drag-end
+				<frame> click <x> <y>		left button pressed (ray cast)
+				<frame> release				left button released, ends a stroke
+				<frame> paint <x> <y> <r> <g> <b>	texel of the blend texture
+				<frame> brush <x> <y>		left button in paint mode
+				<frame> undo				undo the last stroke ('z')
+				<frame> redo				('y')
+			Lines starting with '#' are ignored.
+
+			--animate moves every sphere instance each frame.  With
+			--shaders the report gives the number of object transforms
+			written per millisecond, into the persistently mapped ring
+			or, with --no-stream-buffer, uploaded every frame.
+
+			With --zero-allocations the run fails if a measured frame,
+			its events included, allocated from the heap.  The count
+			includes the GL driver: llvmpipe compiles a new shader variant
+			the first time a state combination is drawn, e.g. the first
+			pick highlight, so only repeated events are expected to be free.
+			The tiles a stroke keeps for undo are allocated as well, run
+			with --no-paint-history to check painting itself.
+			A frame whose scratch memory does not fit the frame arena
+			fails too, the arena grows with heap blocks then.
+	===================================================== */
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include "TextureCompression.h"
+#include "Resample.h"
+#include "ResolutionScaler.h"
+
+struct BenchmarkEvent {
+	int frame;
+	std::string name;
+	int args[5];
+};
+
+struct BenchmarkOptions {
+	std::string scriptPath;
+	std::string outputPath;
+	int width;
+	int height;
+	int warmupFrames;	// rendered but not included in the frame time statistics
+	int frames;			// 0 runs until the last event of the script
+	bool dragPrediction;
+	bool pickBuffer;	// clicks look up the CPU object id buffer instead of casting a ray
+	int spheres;		// extra sphere instances, see SceneRenderer::setSphereInstances
+	bool frustumCulling;
+	bool occlusionCulling;
+	bool shaders;		// SceneRenderer::shaderPipeline
+	bool zeroAllocations;	// fail if a measured frame allocates, see AllocationTracker.h
+	TextureCompression textureCompression;
+	bool textureCache;	// read encoded textures from the disk cache, see TextureManager::setCompression
+	std::string instanceTextures;	// comma separated, see SceneRenderer::setInstanceTextures
+	bool atlas;			// pack the instance textures into atlas pages
+	std::string virtualTexture;	// tile file, see SceneRenderer::virtualTextureFile
+	int virtualSize;	// texels per side of a new tile file
+	bool paintHistory;	// SceneRenderer::paintHistory
+	ResizePolicy textureResize;	// applied as textures load, see TextureManager::setResize
+	bool dynamicResolution;		// SceneRenderer::dynamicResolution
+	ResolutionScaler resolutionScaler;	// its bounds and target frame time
+	bool animate;		// SceneRenderer::animateSphereInstances every frame
+	bool streamTransforms;	// SceneRenderer::streamTransforms
+};
+
+/*	===============================================
+Desc:	Writes the input events of an interactive session in the format
+		read by loadBenchmarkScript.  Does nothing until open() succeeded.
+Precondition:
+Postcondition:
+=============================================== */
+class EventRecorder {
+public:
+	EventRecorder();
+	~EventRecorder();
+
+	bool open(std::string fileName);
+	void record(const char* name, int a = 0, int b = 0);
+	void nextFrame();
+
+private:
+	FILE* file;
+	int frame;
+};
+
+/*	===============================================
+Desc:	Parses the command line.  Returns true if --bench was given.
+Precondition:
+Postcondition:
+=============================================== */
+bool parseBenchmarkOptions(int argc, char** argv, BenchmarkOptions& options);
+/*	===============================================
+Desc:	Reads an event file, sorted by frame.
+Precondition:
+Postcondition:	Returns false if the file could not be read.
+=============================================== */
+bool loadBenchmarkScript(std::string fileName, std::vector<BenchmarkEvent>& events);
+/*	===============================================
+Desc:	Replays the script in an offscreen context and writes the report.
+		Returns the process exit code.
+Precondition:
+Postcondition:
+=============================================== */
+int runBenchmark(const BenchmarkOptions& options);
+
+#endif
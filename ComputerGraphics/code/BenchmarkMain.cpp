@@ -0,0 +1,34 @@
+/*  =================== File Information =================
+	File Name: BenchmarkMain.cpp
+	Description:
+	Author:
+
+	Purpose: Driver for the headless benchmark executable.  It offers the
+			 --bench and --headless modes of the viewer without linking
+			 FLTK, for hosts that have no display and no FLTK.
+	Usage:	cglab_bench --bench events.txt [options, see Benchmark.h]
+			cglab_bench --headless [options, see Headless.h]
+			cglab_bench --resample-dir in out [options, see Resample.h]
+	===================================================== */
+
+#include <iostream>
+#include "Benchmark.h"
+#include "Headless.h"
+#include "Resample.h"
+
+int main(int argc, char **argv) {
+	BenchmarkOptions benchmarkOptions;
+	if (parseBenchmarkOptions(argc, argv, benchmarkOptions)) {
+		return runBenchmark(benchmarkOptions);
+	}
+	HeadlessOptions headlessOptions;
+	if (parseHeadlessOptions(argc, argv, headlessOptions)) {
+		return runHeadless(headlessOptions);
+	}
+	ResampleBatchOptions resampleOptions;
+	if (parseResampleBatchOptions(argc, argv, resampleOptions)) {
+		return runResampleBatch(resampleOptions);
+	}
+	std::cout << "usage: " << argv[0] << " --bench <events.txt> | --headless [options] | --resample-dir <in> <out> [options]" << std::endl;
+	return 1;
+}
@@ -38,13 +38,13 @@ void Camera::setRotUVW(float u, float v, float w) {
 }
 
 
-void Camera::orientLookAt(glm::vec3 eyePoint, glm::vec3 lookatPoint, glm::vec3 upVec) {
+void Camera::orientLookAt(const glm::vec3& eyePoint, const glm::vec3& lookatPoint, const glm::vec3& upVec) {
 	glm::vec3 lookVec = lookatPoint - eyePoint;
 	orientLookVec(eyePoint, lookVec, upVec);
 }
 
 
-void Camera::orientLookVec(glm::vec3 _eyePoint, glm::vec3 lookVec, glm::vec3 upVec) {
+void Camera::orientLookVec(const glm::vec3& _eyePoint, const glm::vec3& lookVec, const glm::vec3& upVec) {
 	eyePoint = _eyePoint;
 	modelViewMatrix = glm::mat4(1.0f);
 	upV = upVec;
@@ -209,7 +209,7 @@ void Camera::rotateW(float degrees) {
 	v = rot * glm::vec4(v, 0.0f);
 }
 
-void Camera::rotate(glm::vec3 point, glm::vec3 axis, float degrees) {
+void Camera::rotate(const glm::vec3& point, const glm::vec3& axis, float degrees) {
 	/*
 	*Update calculation of modelview and translation
 	*/
@@ -236,7 +236,7 @@ void Camera::rotate(glm::vec3 point, glm::vec3 axis, float degrees) {
 	modelViewMatrix = trans2 * m5 * m4 * m3 * m2 * m1 * trans1 * modelViewMatrix;
 }
 
-void Camera::translate(glm::vec3 v) {
+void Camera::translate(const glm::vec3& v) {
 	eyePoint = v;
 	//trans4 = glm::translate(glm::mat4(1.0f), v);
 	//glm::mat4 trans = glm::translate(glm::mat4(1.0f), v);
@@ -24,8 +24,8 @@ public:
 	~Camera();
 
 	void reset();
-	void orientLookAt(glm::vec3 eyePoint, glm::vec3 focusPoint, glm::vec3 upVec);
-	void orientLookVec(glm::vec3 eyePoint, glm::vec3 lookVec, glm::vec3 upVec);
+	void orientLookAt(const glm::vec3& eyePoint, const glm::vec3& focusPoint, const glm::vec3& upVec);
+	void orientLookVec(const glm::vec3& eyePoint, const glm::vec3& lookVec, const glm::vec3& upVec);
 	void setViewAngle(float _viewAngle);
 	void setNearPlane(float _nearPlane);
 	void setFarPlane(float _farPlane);
@@ -42,9 +42,9 @@ public:
 	void rotateV(float degree);
 	void rotateU(float degree);
 	void rotateW(float degree);
-	void rotate(glm::vec3 point, glm::vec3 axis, float degree);
+	void rotate(const glm::vec3& point, const glm::vec3& axis, float degree);
 
-	void translate(glm::vec3 v);
+	void translate(const glm::vec3& v);
 
 	glm::vec3 getEyePoint();
 	glm::vec3 getLookVector();
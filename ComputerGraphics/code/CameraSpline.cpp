@@ -0,0 +1,148 @@
+/*  =================== File Information =================
+	File Name: CameraSpline.cpp
+	Description:
+	Author:
+
+	Purpose: Catmull-Rom and B-spline camera paths with arc length lookup
+	Usage:
+	===================================================== */
+
+#include <cmath>
+#include <algorithm>
+#include "CameraSpline.h"
+
+CameraSpline::CameraSpline() {
+	type = SPLINE_CATMULL_ROM;
+	closed = false;
+	segments = 0;
+}
+
+void CameraSpline::setControlPoints(const std::vector<glm::vec3>& points, SplineType _type, bool _closed) {
+	controlPoints = points;
+	type = _type;
+	closed = _closed && points.size() > 2;
+	segments = closed ? (int)points.size() : std::max(0, (int)points.size() - 1);
+	distances.clear();
+	if (controlPoints.empty()) {
+		return;
+	}
+
+	// chords between close samples, the error shrinks with SPLINE_SIZE squared
+	int samples = segments * SPLINE_SIZE;
+	distances.resize(samples + 1);
+	distances[0] = 0.0f;
+	glm::vec3 previous = evaluate(0.0f);
+	for (int k = 1; k <= samples; k++) {
+		glm::vec3 current = evaluate((float)k / SPLINE_SIZE);
+		distances[k] = distances[k - 1] + glm::length(current - previous);
+		previous = current;
+	}
+}
+
+const glm::vec3& CameraSpline::point(int i) {
+	int n = (int)controlPoints.size();
+	if (closed) {
+		return controlPoints[((i % n) + n) % n];
+	}
+	// the end points are repeated
+	return controlPoints[std::min(std::max(i, 0), n - 1)];
+}
+
+glm::vec3 CameraSpline::evaluate(float u) {
+	if (segments == 0) {
+		return controlPoints[0];
+	}
+	int i = std::min(std::max((int)floor(u), 0), segments - 1);
+	float t = u - (float)i;
+	float t2 = t * t;
+	float t3 = t2 * t;
+	const glm::vec3& p0 = point(i - 1);
+	const glm::vec3& p1 = point(i);
+	const glm::vec3& p2 = point(i + 1);
+	const glm::vec3& p3 = point(i + 2);
+	if (type == SPLINE_B_SPLINE) {
+		return (p0 * (1.0f - 3.0f * t + 3.0f * t2 - t3) + p1 * (4.0f - 6.0f * t2 + 3.0f * t3)
+			+ p2 * (1.0f + 3.0f * t + 3.0f * t2 - 3.0f * t3) + p3 * t3) * (1.0f / 6.0f);
+	}
+	return (p1 * 2.0f + (p2 - p0) * t + (p0 * 2.0f - p1 * 5.0f + p2 * 4.0f - p3) * t2
+		+ (p1 * 3.0f - p0 - p2 * 3.0f + p3) * t3) * 0.5f;
+}
+
+glm::vec3 CameraSpline::derivative(float u) {
+	if (segments == 0) {
+		return glm::vec3(0.0f);
+	}
+	int i = std::min(std::max((int)floor(u), 0), segments - 1);
+	float t = u - (float)i;
+	float t2 = t * t;
+	const glm::vec3& p0 = point(i - 1);
+	const glm::vec3& p1 = point(i);
+	const glm::vec3& p2 = point(i + 1);
+	const glm::vec3& p3 = point(i + 2);
+	if (type == SPLINE_B_SPLINE) {
+		return (p0 * (-1.0f + 2.0f * t - t2) + p1 * (-4.0f * t + 3.0f * t2)
+			+ p2 * (1.0f + 2.0f * t - 3.0f * t2) + p3 * t2) * 0.5f;
+	}
+	return ((p2 - p0) + (p0 * 2.0f - p1 * 5.0f + p2 * 4.0f - p3) * (2.0f * t)
+		+ (p1 * 3.0f - p0 - p2 * 3.0f + p3) * (3.0f * t2)) * 0.5f;
+}
+
+float CameraSpline::wrapDistance(float distance) {
+	float length = getLength();
+	if (length <= 0.0f) {
+		return 0.0f;
+	}
+	if (closed) {
+		distance = fmod(distance, length);
+		return distance < 0.0f ? distance + length : distance;
+	}
+	return std::min(std::max(distance, 0.0f), length);
+}
+
+float CameraSpline::parameterBetween(float distance, size_t sample) {
+	if (sample + 1 >= distances.size()) {
+		return (float)segments;
+	}
+	// linear between the samples, they are close enough
+	float span = distances[sample + 1] - distances[sample];
+	float f = span > 0.0f ? (distance - distances[sample]) / span : 0.0f;
+	return ((float)sample + std::min(std::max(f, 0.0f), 1.0f)) / SPLINE_SIZE;
+}
+
+CameraPose CameraSpline::poseAtParameter(float u) {
+	CameraPose pose;
+	pose.position = evaluate(u);
+	glm::vec3 tangent = derivative(u);
+	float length = glm::length(tangent);
+	pose.look = length > 1e-6f ? tangent / length : glm::vec3(0, 0, -1);
+	return pose;
+}
+
+CameraPose CameraSpline::poseAt(float distance) {
+	distance = wrapDistance(distance);
+	// last sample at or before the distance
+	size_t sample = std::upper_bound(distances.begin(), distances.end(), distance) - distances.begin();
+	sample = sample > 0 ? sample - 1 : 0;
+	return poseAtParameter(parameterBetween(distance, sample));
+}
+
+void CameraSpline::samplePoses(float startDistance, float spacing, int count, std::vector<CameraPose>& poses) {
+	poses.resize(std::max(count, 0));
+	if (count <= 0) {
+		return;
+	}
+	float distance = wrapDistance(startDistance);
+	size_t sample = std::upper_bound(distances.begin(), distances.end(), distance) - distances.begin();
+	sample = sample > 0 ? sample - 1 : 0;
+	for (int i = 0; i < count; i++) {
+		distance = wrapDistance(startDistance + spacing * (float)i);
+		if (distance < distances[sample]) {
+			// wrapped around a closed path
+			sample = 0;
+		}
+		while (sample + 1 < distances.size() - 1 && distances[sample + 1] <= distance) {
+			sample++;
+		}
+		poses[i] = poseAtParameter(parameterBetween(distance, sample));
+	}
+}
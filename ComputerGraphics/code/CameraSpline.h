@@ -0,0 +1,99 @@
+/*  =================== File Information =================
+	File Name: CameraSpline.h
+	Description:
+	Author:
+
+	Purpose: Camera path through a list of control points, either as a
+			 Catmull-Rom spline (passes through the points) or a uniform
+			 cubic B-spline (smoother, only approaches them).  The spline
+			 parameter does not run at constant speed, so an arc length
+			 table of SPLINE_SIZE samples per segment maps a distance along
+			 the path to a parameter with a binary search.  Poses look
+			 along the path.
+	Usage:	CameraSpline spline;
+			spline.setControlPoints(points, SPLINE_CATMULL_ROM, true);
+			CameraPose pose = spline.poseAt(distance);
+			// or a whole fly-through at once
+			std::vector<CameraPose> poses;
+			spline.samplePoses(0, spline.getLength() / 1000, 1000, poses);
+	===================================================== */
+#ifndef CAMERA_SPLINE_H
+#define CAMERA_SPLINE_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#define SPLINE_SIZE 100			// arc length samples per segment
+#define COASTER_SPEED 0.0001	// path lengths travelled per millisecond
+
+enum SplineType {
+	SPLINE_CATMULL_ROM,
+	SPLINE_B_SPLINE
+};
+
+struct CameraPose {
+	glm::vec3 position;
+	glm::vec3 look;		// unit tangent of the path
+};
+
+class CameraSpline {
+public:
+	CameraSpline();
+
+	/*	===============================================
+	Desc:	Sets the path and builds its arc length table.  A closed path
+			returns to the first point and distances wrap around it; an
+			open one ends at the last point (Catmull-Rom) and distances
+			are clamped to it.
+	Precondition:
+	Postcondition:	isEmpty() if points is empty.
+	=============================================== */
+	void setControlPoints(const std::vector<glm::vec3>& points, SplineType type, bool closed);
+	bool isEmpty() { return controlPoints.empty(); }
+	float getLength() { return distances.empty() ? 0.0f : distances.back(); }
+	int getSegmentCount() { return segments; }
+	bool isClosed() { return closed; }
+	const std::vector<glm::vec3>& getControlPoints() { return controlPoints; }
+
+	/*	===============================================
+	Desc:	Point and derivative at spline parameter u, segment i covers
+			u in [i, i + 1].
+	Precondition:	!isEmpty()
+	Postcondition:
+	=============================================== */
+	glm::vec3 evaluate(float u);
+	glm::vec3 derivative(float u);
+
+	/*	===============================================
+	Desc:	Pose at the given distance along the path, O(log n) in the
+			number of table samples.
+	Precondition:	!isEmpty()
+	Postcondition:
+	=============================================== */
+	CameraPose poseAt(float distance);
+	/*	===============================================
+	Desc:	Fills poses with count poses spaced evenly from startDistance.
+			The distances only grow, so the table is walked once instead
+			of searched per pose.
+	Precondition:	!isEmpty(), spacing >= 0
+	Postcondition:
+	=============================================== */
+	void samplePoses(float startDistance, float spacing, int count, std::vector<CameraPose>& poses);
+
+private:
+	// control point i of the spline, extended or wrapped past the ends
+	const glm::vec3& point(int i);
+	// the distance moved into the path, wrapped or clamped
+	float wrapDistance(float distance);
+	// parameter of a distance that lies between samples sample and sample + 1
+	float parameterBetween(float distance, size_t sample);
+	CameraPose poseAtParameter(float u);
+
+	std::vector<glm::vec3> controlPoints;
+	SplineType type;
+	bool closed;
+	int segments;
+	std::vector<float> distances;	// arc length at parameter k / SPLINE_SIZE
+};
+
+#endif
@@ -0,0 +1,379 @@
+/*  =================== File Information =================
+	File Name: CommandBuffer.cpp
+	Description:
+	Author:
+
+	Purpose: Recording and replay of static draw calls
+	Usage:
+	===================================================== */
+
+#include <cstring>
+#include "CommandBuffer.h"
+
+// vertex arrays a draw sends besides the position
+#define ARRAY_NORMAL 1
+#define ARRAY_TEXCOORD 2
+#define ARRAY_COLOR 4
+
+static void setClientState(GLenum array, bool enabled) {
+	if (enabled) {
+		glEnableClientState(array);
+	}
+	else {
+		glDisableClientState(array);
+	}
+}
+
+static void setAttributeArray(GLuint attribute, bool enabled) {
+	if (enabled) {
+		glEnableVertexAttribArray(attribute);
+	}
+	else {
+		glDisableVertexAttribArray(attribute);
+	}
+}
+
+CommandBuffer::CommandBuffer() {
+	textureManager = NULL;
+	vertexBuffer = 0;
+	vertexArray = 0;
+	vertexArrayArrays = 0;
+	clear();
+}
+
+CommandBuffer::~CommandBuffer() {
+	release();
+}
+
+void CommandBuffer::clear() {
+	commands.clear();
+	pendingState.clear();
+	issuedState.clear();
+	vertices.clear();
+	recorded = false;
+	blockMode = GL_TRIANGLES;
+	blockFirst = 0;
+	inBlock = false;
+	setArrays = 0;
+	// the initial current values of GL
+	memset(current, 0, sizeof(current));
+	current[5] = 1.0f;
+	current[8] = current[9] = current[10] = 1.0f;
+	stats.recorded = stats.compiled = stats.vertices = 0;
+}
+
+void CommandBuffer::begin(GLenum mode) {
+	blockMode = mode;
+	blockFirst = (int)(vertices.size() / COMMAND_VERTEX_FLOATS);
+	inBlock = true;
+}
+
+void CommandBuffer::end() {
+	if (!inBlock) {
+		return;
+	}
+	inBlock = false;
+	stats.recorded++;
+	int count = (int)(vertices.size() / COMMAND_VERTEX_FLOATS) - blockFirst;
+	if (count == 0) {
+		return;
+	}
+	flushState();
+	// lines, points and triangles are independent of each other, so
+	// neighbouring draws of them become one range
+	if (!commands.empty()) {
+		Command& last = commands.back();
+		bool independent = blockMode == GL_POINTS || blockMode == GL_LINES || blockMode == GL_TRIANGLES;
+		if (last.type == COMMAND_DRAW && last.name == blockMode && last.arrays == setArrays &&
+			last.first + last.count == blockFirst && independent) {
+			last.count += count;
+			return;
+		}
+	}
+	Command draw;
+	draw.type = COMMAND_DRAW;
+	draw.name = blockMode;
+	draw.value = 0;
+	draw.first = blockFirst;
+	draw.count = count;
+	draw.arrays = setArrays;
+	commands.push_back(draw);
+}
+
+void CommandBuffer::vertex3f(float x, float y, float z) {
+	current[0] = x;
+	current[1] = y;
+	current[2] = z;
+	vertices.insert(vertices.end(), current, current + COMMAND_VERTEX_FLOATS);
+}
+
+void CommandBuffer::normal3f(float x, float y, float z) {
+	current[3] = x;
+	current[4] = y;
+	current[5] = z;
+	setArrays |= ARRAY_NORMAL;
+}
+
+void CommandBuffer::texCoord2f(float s, float t) {
+	current[6] = s;
+	current[7] = t;
+	setArrays |= ARRAY_TEXCOORD;
+}
+
+void CommandBuffer::color3f(float r, float g, float b) {
+	current[8] = r;
+	current[9] = g;
+	current[10] = b;
+	setArrays |= ARRAY_COLOR;
+}
+
+void CommandBuffer::enable(GLenum cap) {
+	addState(COMMAND_ENABLE, cap, GL_TRUE);
+}
+
+void CommandBuffer::disable(GLenum cap) {
+	addState(COMMAND_ENABLE, cap, GL_FALSE);
+}
+
+void CommandBuffer::polygonMode(GLenum mode) {
+	addState(COMMAND_POLYGON_MODE, GL_FRONT_AND_BACK, mode);
+}
+
+void CommandBuffer::bindTexture(TextureManager* manager, int handle) {
+	textureManager = manager;
+	addState(COMMAND_BIND_TEXTURE, 0, handle);
+}
+
+void CommandBuffer::texParameter(GLenum name, GLint value) {
+	addState(COMMAND_TEX_PARAMETER, name, value);
+}
+
+void CommandBuffer::addState(CommandType type, GLenum name, GLint value) {
+	stats.recorded++;
+	if (type == COMMAND_BIND_TEXTURE) {
+		// texture parameters set before the bind belong to the texture bound
+		// before it, so they cannot be moved past it
+		for (size_t i = 0; i < pendingState.size(); i++) {
+			if (pendingState[i].type == COMMAND_TEX_PARAMETER) {
+				flushState();
+				break;
+			}
+		}
+	}
+	// only the last value before a draw matters
+	for (size_t i = 0; i < pendingState.size(); i++) {
+		if (pendingState[i].type == type && pendingState[i].name == name) {
+			pendingState[i].value = value;
+			return;
+		}
+	}
+	Command state;
+	state.type = type;
+	state.name = name;
+	state.value = value;
+	state.first = state.count = state.arrays = 0;
+	pendingState.push_back(state);
+}
+
+void CommandBuffer::flushState() {
+	for (size_t i = 0; i < pendingState.size(); i++) {
+		const Command& state = pendingState[i];
+		size_t k = 0;
+		while (k < issuedState.size() && !(issuedState[k].type == state.type && issuedState[k].name == state.name)) {
+			k++;
+		}
+		if (k < issuedState.size() && issuedState[k].value == state.value) {
+			continue;
+		}
+		if (k < issuedState.size()) {
+			issuedState[k].value = state.value;
+		}
+		else {
+			issuedState.push_back(state);
+		}
+		if (state.type == COMMAND_BIND_TEXTURE) {
+			// the parameters set so far belong to the old texture
+			for (size_t j = issuedState.size(); j-- > 0;) {
+				if (issuedState[j].type == COMMAND_TEX_PARAMETER) {
+					issuedState.erase(issuedState.begin() + j);
+				}
+			}
+		}
+		commands.push_back(state);
+	}
+	pendingState.clear();
+}
+
+void CommandBuffer::finish() {
+	end();
+	// state left at the end stays in effect after a replay
+	flushState();
+	if (!vertices.empty()) {
+		if (vertexBuffer == 0) {
+			glGenBuffers(1, &vertexBuffer);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	stats.compiled = (int)commands.size();
+	stats.vertices = (int)(vertices.size() / COMMAND_VERTEX_FLOATS);
+	// the host copy is only needed until the upload
+	std::vector<float>().swap(vertices);
+	recorded = true;
+}
+
+void CommandBuffer::replay(GLStateCache& state) {
+	if (!recorded || commands.empty()) {
+		return;
+	}
+	bool hasVertices = stats.vertices > 0;
+	if (hasVertices) {
+		GLsizei stride = COMMAND_VERTEX_FLOATS * sizeof(float);
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glEnableClientState(GL_VERTEX_ARRAY);
+		// with a buffer bound the pointers are byte offsets into it
+		glVertexPointer(3, GL_FLOAT, stride, (const void*)0);
+		glNormalPointer(GL_FLOAT, stride, (const void*)(3 * sizeof(float)));
+		glTexCoordPointer(2, GL_FLOAT, stride, (const void*)(6 * sizeof(float)));
+		glColorPointer(3, GL_FLOAT, stride, (const void*)(8 * sizeof(float)));
+	}
+
+	int enabledArrays = 0;
+	for (size_t i = 0; i < commands.size(); i++) {
+		const Command& command = commands[i];
+		switch (command.type) {
+		case COMMAND_ENABLE:
+			if (command.value) {
+				state.enable(command.name);
+			}
+			else {
+				state.disable(command.name);
+			}
+			break;
+		case COMMAND_POLYGON_MODE:
+			state.polygonMode(command.value);
+			break;
+		case COMMAND_BIND_TEXTURE:
+			textureManager->bind(command.value);
+			break;
+		case COMMAND_TEX_PARAMETER:
+			state.texParameter(command.name, command.value);
+			break;
+		case COMMAND_DRAW: {
+			// only the arrays that differ from the previous draw are switched
+			int changed = enabledArrays ^ command.arrays;
+			if (changed & ARRAY_NORMAL) {
+				setClientState(GL_NORMAL_ARRAY, (command.arrays & ARRAY_NORMAL) != 0);
+			}
+			if (changed & ARRAY_TEXCOORD) {
+				setClientState(GL_TEXTURE_COORD_ARRAY, (command.arrays & ARRAY_TEXCOORD) != 0);
+			}
+			if (changed & ARRAY_COLOR) {
+				setClientState(GL_COLOR_ARRAY, (command.arrays & ARRAY_COLOR) != 0);
+			}
+			enabledArrays = command.arrays;
+			if (command.arrays & ARRAY_COLOR) {
+				// GL leaves the current color undefined after a color array
+				state.invalidateColor();
+			}
+			glDrawArrays(command.name, command.first, command.count);
+			break;
+		}
+		}
+	}
+
+	if (hasVertices) {
+		if (enabledArrays & ARRAY_NORMAL) {
+			glDisableClientState(GL_NORMAL_ARRAY);
+		}
+		if (enabledArrays & ARRAY_TEXCOORD) {
+			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		}
+		if (enabledArrays & ARRAY_COLOR) {
+			glDisableClientState(GL_COLOR_ARRAY);
+		}
+		glDisableClientState(GL_VERTEX_ARRAY);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+}
+
+void CommandBuffer::replay(GLStateCache& state, ShaderPipeline& pipeline) {
+	if (!recorded || commands.empty()) {
+		return;
+	}
+	if (vertexArray == 0 && stats.vertices > 0) {
+		GLsizei stride = COMMAND_VERTEX_FLOATS * sizeof(float);
+		glGenVertexArrays(1, &vertexArray);
+		state.bindVertexArray(vertexArray);
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glVertexAttribPointer(ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, stride, (const void*)0);
+		glVertexAttribPointer(ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, stride, (const void*)(3 * sizeof(float)));
+		glVertexAttribPointer(ATTRIBUTE_TEXCOORD, 2, GL_FLOAT, GL_FALSE, stride, (const void*)(6 * sizeof(float)));
+		glVertexAttribPointer(ATTRIBUTE_COLOR, 3, GL_FLOAT, GL_FALSE, stride, (const void*)(8 * sizeof(float)));
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glEnableVertexAttribArray(ATTRIBUTE_POSITION);
+		vertexArrayArrays = 0;
+	}
+
+	for (size_t i = 0; i < commands.size(); i++) {
+		const Command& command = commands[i];
+		switch (command.type) {
+		case COMMAND_ENABLE:
+			if (command.name == GL_LIGHTING) {
+				pipeline.setLighting(command.value != 0);
+			}
+			else if (command.name == GL_TEXTURE_2D) {
+				pipeline.setTexturing(command.value != 0);
+			}
+			else if (command.value) {
+				state.enable(command.name);
+			}
+			else {
+				state.disable(command.name);
+			}
+			break;
+		case COMMAND_POLYGON_MODE:
+			state.polygonMode(command.value);
+			break;
+		case COMMAND_BIND_TEXTURE:
+			textureManager->bind(command.value);
+			break;
+		case COMMAND_TEX_PARAMETER:
+			state.texParameter(command.name, command.value);
+			break;
+		case COMMAND_DRAW: {
+			state.bindVertexArray(vertexArray);
+			// the enabled attributes are state of the vertex array, so they
+			// stay switched between replays
+			int changed = vertexArrayArrays ^ command.arrays;
+			if (changed & ARRAY_NORMAL) {
+				setAttributeArray(ATTRIBUTE_NORMAL, (command.arrays & ARRAY_NORMAL) != 0);
+			}
+			if (changed & ARRAY_TEXCOORD) {
+				setAttributeArray(ATTRIBUTE_TEXCOORD, (command.arrays & ARRAY_TEXCOORD) != 0);
+			}
+			if (changed & ARRAY_COLOR) {
+				setAttributeArray(ATTRIBUTE_COLOR, (command.arrays & ARRAY_COLOR) != 0);
+			}
+			vertexArrayArrays = command.arrays;
+			pipeline.prepareDraw(state, (command.arrays & ARRAY_NORMAL) != 0, (command.arrays & ARRAY_COLOR) != 0);
+			glDrawArrays(command.name, command.first, command.count);
+			break;
+		}
+		}
+	}
+}
+
+void CommandBuffer::release() {
+	if (vertexArray != 0) {
+		glDeleteVertexArrays(1, &vertexArray);
+	}
+	vertexArray = 0;
+	vertexArrayArrays = 0;
+	if (vertexBuffer != 0) {
+		glDeleteBuffers(1, &vertexBuffer);
+	}
+	vertexBuffer = 0;
+	clear();
+}
@@ -0,0 +1,153 @@
+/*  =================== File Information =================
+	File Name: CommandBuffer.h
+	Description:
+	Author:
+
+	Purpose: Records the immediate mode calls of a static part of the scene
+			 once and replays them every frame.  The vertices of all
+			 glBegin/glEnd blocks go into one vertex buffer, a block becomes
+			 a draw range of it, and state calls that would not change
+			 anything are dropped when the recording is finished.
+	Usage:	if (!commands.isRecorded()) {
+				commands.disable(GL_LIGHTING);
+				commands.begin(GL_LINES);
+				commands.color3f(1, 0, 0);
+				commands.vertex3f(0, 0, 0); commands.vertex3f(1, 0, 0);
+				commands.end();
+				commands.enable(GL_LIGHTING);
+				commands.finish();
+			}
+			commands.replay(state);
+	===================================================== */
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include <vector>
+#include "GLExt.h"
+#include "TextureManager.h"
+#include "GLStateCache.h"
+#include "ShaderPipeline.h"
+
+// position (3), normal (3), texture coordinate (2), color (3)
+#define COMMAND_VERTEX_FLOATS 11
+
+struct CommandBufferStats {
+	int recorded;	// calls made while recording, vertices not counted
+	int compiled;	// state changes and draws left after finish()
+	int vertices;
+};
+
+class CommandBuffer {
+public:
+	CommandBuffer();
+	/*	===============================================
+	Desc:	Deletes the vertex buffer
+	Precondition:	The GL context that uploaded it is current.
+	Postcondition:
+	=============================================== */
+	~CommandBuffer();
+
+	/*	===============================================
+	Desc:	Throws the recording away so the buffer can be recorded again.
+			The GL vertex buffer is kept and refilled by the next finish(),
+			so no GL context is needed.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void clear();
+
+	/*	===============================================
+	Desc:	Recording, with the meaning of the GL calls of the same name.
+			Normal, texture coordinate and color keep their value between
+			blocks like the current values of GL do; a block only sends
+			the ones that were set at some point of the recording, the
+			others come from the GL state at replay.
+	Precondition:	The buffer is not recorded.
+	Postcondition:
+	=============================================== */
+	void begin(GLenum mode);
+	void end();
+	void vertex3f(float x, float y, float z);
+	void normal3f(float x, float y, float z);
+	void texCoord2f(float s, float t);
+	void color3f(float r, float g, float b);
+	void enable(GLenum cap);
+	void disable(GLenum cap);
+	void polygonMode(GLenum mode);
+	// resolved at replay, as the manager may upload the texture to a new id
+	void bindTexture(TextureManager* manager, int handle);
+	void texParameter(GLenum name, GLint value);
+
+	/*	===============================================
+	Desc:	Ends the recording: drops state changes that repeat the value
+			already set or are overridden before the next draw, merges
+			neighbouring draws of the same kind and uploads the vertices.
+	Precondition:	A GL context is current.
+	Postcondition:	isRecorded() is true.
+	=============================================== */
+	void finish();
+	/*	===============================================
+	Desc:	Issues the recorded state changes through the state cache, so
+			the ones already in effect are skipped, and the draws.  The
+			state changes stay in effect afterwards as they would with the
+			immediate mode calls; the vertex arrays and buffer binding are
+			restored.
+	Precondition:	finish() was called in the current context.
+	Postcondition:
+	=============================================== */
+	void replay(GLStateCache& state);
+	/*	===============================================
+	Desc:	Replays the recording with the shader pipeline.  GL_LIGHTING and
+			GL_TEXTURE_2D switch the pipeline's programs instead of the
+			fixed function state, the vertices come from generic attributes.
+	Precondition:	finish() was called in the current context, the
+					pipeline is ready and an object is bound.
+	Postcondition:
+	=============================================== */
+	void replay(GLStateCache& state, ShaderPipeline& pipeline);
+	void release();
+
+	bool isRecorded() { return recorded; }
+	const CommandBufferStats& getStats() { return stats; }
+
+private:
+	enum CommandType {
+		COMMAND_ENABLE,		// value GL_TRUE or GL_FALSE
+		COMMAND_POLYGON_MODE,
+		COMMAND_BIND_TEXTURE,
+		COMMAND_TEX_PARAMETER,
+		COMMAND_DRAW
+	};
+	struct Command {
+		CommandType type;
+		GLenum name;		// capability, face, texture parameter or primitive mode
+		GLint value;		// the value set, a texture handle for COMMAND_BIND_TEXTURE
+		int first;			// draw range in vertices
+		int count;
+		int arrays;			// ARRAY_ bits of a draw
+	};
+
+	void addState(CommandType type, GLenum name, GLint value);
+	void flushState();
+
+	std::vector<Command> commands;
+	std::vector<Command> pendingState;	// state changes since the last draw
+	std::vector<Command> issuedState;	// last value flushed of every state
+	std::vector<float> vertices;
+	TextureManager* textureManager;
+	GLuint vertexBuffer;
+	GLuint vertexArray;			// generic attributes for the shader pipeline
+	int vertexArrayArrays;		// ARRAY_ bits enabled in it
+	bool recorded;
+
+	// recording state
+	GLenum blockMode;
+	int blockFirst;
+	bool inBlock;
+	int setArrays;
+	float current[COMMAND_VERTEX_FLOATS];
+
+	CommandBufferStats stats;
+};
+
+#endif
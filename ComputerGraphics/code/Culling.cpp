@@ -0,0 +1,262 @@
+/*  =================== File Information =================
+	File Name: Culling.cpp
+	Description:
+	Author:
+
+	Purpose: Frustum and occlusion culling of bounding spheres
+	Usage:
+	===================================================== */
+
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include "Culling.h"
+#ifdef CULLING_SSE
+#include <emmintrin.h>
+#endif
+
+OcclusionBuffer::OcclusionBuffer() {
+	width = 0;
+	height = 0;
+	modelView = glm::mat4(1.0f);
+	scaleX = 1.0f;
+	scaleY = 1.0f;
+}
+
+void OcclusionBuffer::begin(Camera& camera) {
+	glm::mat4 projection = camera.getProjectionMatrix();
+	modelView = camera.getModelViewMatrix();
+	// clip w is the distance times -projection[2][3], which need not be 1
+	scaleX = fabs(projection[0][0] / projection[2][3]);
+	scaleY = fabs(projection[1][1] / projection[2][3]);
+	width = OCCLUSION_BUFFER_WIDTH;
+	height = std::max(1, OCCLUSION_BUFFER_WIDTH * camera.getScreenHeight() / std::max(1, camera.getScreenWidth()));
+	depths.assign(width * height, INFINITY);
+}
+
+float OcclusionBuffer::viewDepth(const glm::vec3& p) const {
+	return -(modelView[0][2] * p.x + modelView[1][2] * p.y + modelView[2][2] * p.z + modelView[3][2]);
+}
+
+bool OcclusionBuffer::bounds(const glm::vec3& center, float radius, float& minX, float& minY, float& maxX, float& maxY) const {
+	glm::vec3 view = glm::vec3(modelView * glm::vec4(center, 1.0f));
+	float depth = -view.z;
+	if (depth <= radius) {
+		return false;
+	}
+	// exact extent of the projected sphere along x and y, from the planes
+	// through the eye tangent to it (Mara and McGuire 2013)
+	float denominator = depth * depth - radius * radius;
+	float rootX = radius * sqrt(view.x * view.x + denominator);
+	float rootY = radius * sqrt(view.y * view.y + denominator);
+	minX = ((view.x * depth - rootX) / denominator * scaleX + 1.0f) * 0.5f * width;
+	maxX = ((view.x * depth + rootX) / denominator * scaleX + 1.0f) * 0.5f * width;
+	minY = (1.0f - (view.y * depth + rootY) / denominator * scaleY) * 0.5f * height;
+	maxY = (1.0f - (view.y * depth - rootY) / denominator * scaleY) * 0.5f * height;
+	return true;
+}
+
+void OcclusionBuffer::drawOccluder(const glm::vec3& center, float radius) {
+	glm::vec3 view = glm::vec3(modelView * glm::vec4(center, 1.0f));
+	float depth = -view.z;
+	if (depth <= radius) {
+		return;
+	}
+	// the disc through the centre facing the eye projects to an ellipse
+	// inside the silhouette; fill the cells completely inside it with the
+	// distance of the sphere's far side
+	float farDepth = depth + radius;
+	float x = (view.x / depth * scaleX + 1.0f) * 0.5f * width;
+	float y = (1.0f - view.y / depth * scaleY) * 0.5f * height;
+	float radiusX = radius / depth * scaleX * 0.5f * width;
+	float radiusY = radius / depth * scaleY * 0.5f * height;
+	int x0 = std::max(0, (int)ceil(x - radiusX));
+	int x1 = std::min(width, (int)floor(x + radiusX));
+	int y0 = std::max(0, (int)ceil(y - radiusY));
+	int y1 = std::min(height, (int)floor(y + radiusY));
+	for (int cellY = y0; cellY < y1; cellY++) {
+		// the corner farthest from the centre decides
+		float dy = std::max(fabs(cellY - y), fabs(cellY + 1 - y)) / radiusY;
+		for (int cellX = x0; cellX < x1; cellX++) {
+			float dx = std::max(fabs(cellX - x), fabs(cellX + 1 - x)) / radiusX;
+			if (dx * dx + dy * dy <= 1.0f) {
+				float& cell = depths[cellY * width + cellX];
+				cell = std::min(cell, farDepth);
+			}
+		}
+	}
+}
+
+bool OcclusionBuffer::isOccluded(const glm::vec3& center, float radius) const {
+	float minX, minY, maxX, maxY;
+	if (!bounds(center, radius, minX, minY, maxX, maxY)) {
+		return false;
+	}
+	float nearest = viewDepth(center) - radius;
+	int x0 = std::max(0, (int)floor(minX));
+	int x1 = std::min(width - 1, (int)floor(maxX));
+	int y0 = std::max(0, (int)floor(minY));
+	int y1 = std::min(height - 1, (int)floor(maxY));
+	for (int cellY = y0; cellY <= y1; cellY++) {
+		for (int cellX = x0; cellX <= x1; cellX++) {
+			if (depths[cellY * width + cellX] >= nearest) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+SceneCuller::SceneCuller() {
+	count = 0;
+	stats.tested = stats.frustumCulled = stats.occlusionCulled = stats.drawn = 0;
+}
+
+void SceneCuller::clear() {
+	count = 0;
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	radii.clear();
+	occluders.clear();
+}
+
+int SceneCuller::add(const glm::vec3& center, float radius, bool occluder) {
+	if (count % 4 == 0) {
+		// start a new group of four, the unused slots can never be inside
+		// a plane as their radius is -infinity
+		centerX.resize(count + 4, 0.0f);
+		centerY.resize(count + 4, 0.0f);
+		centerZ.resize(count + 4, 0.0f);
+		radii.resize(count + 4, -INFINITY);
+	}
+	centerX[count] = center.x;
+	centerY[count] = center.y;
+	centerZ[count] = center.z;
+	radii[count] = radius;
+	occluders.push_back(occluder ? 1 : 0);
+	return count++;
+}
+
+/*	An object that may become an occluder, ordered by the share of the
+	screen it covers, largest first
+*/
+struct OccluderCandidate {
+	float size;		// negated radius over distance
+	int index;
+};
+
+static bool coversMore(const OccluderCandidate& a, const OccluderCandidate& b) {
+	return a.size < b.size || (a.size == b.size && a.index < b.index);
+}
+
+void SceneCuller::cull(Camera& camera, bool frustum, bool occlusion, std::vector<int>& visible, FrameArena& arena) {
+	visible.clear();
+	int* insideFrustum = arena.allocateArray<int>(count);
+	int insideCount = 0;
+	stats.tested = count;
+	stats.frustumCulled = stats.occlusionCulled = stats.drawn = 0;
+
+	// planes of the clip space frustum -w <= x, y, z <= w in world space
+	// (Gribb and Hartmann), normalized so the distances compare to radii
+	glm::mat4 viewProjection = camera.getProjectionMatrix() * camera.getModelViewMatrix();
+	float plane[6][4];
+	for (int i = 0; i < 6; i++) {
+		int axis = i / 2;
+		float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+		for (int k = 0; k < 4; k++) {
+			plane[i][k] = viewProjection[k][3] + sign * viewProjection[k][axis];
+		}
+		float length = sqrt(plane[i][0] * plane[i][0] + plane[i][1] * plane[i][1] + plane[i][2] * plane[i][2]);
+		for (int k = 0; k < 4; k++) {
+			plane[i][k] /= length;
+		}
+	}
+
+	if (!frustum) {
+		for (int index = 0; index < count; index++) {
+			insideFrustum[insideCount++] = index;
+		}
+	}
+#ifdef CULLING_SSE
+	for (int group = 0; frustum && group < count; group += 4) {
+		__m128 x = _mm_loadu_ps(&centerX[group]);
+		__m128 y = _mm_loadu_ps(&centerY[group]);
+		__m128 z = _mm_loadu_ps(&centerZ[group]);
+		__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&radii[group]));
+		__m128 outside = _mm_setzero_ps();
+		for (int i = 0; i < 6; i++) {
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane[i][0])), _mm_mul_ps(y, _mm_set1_ps(plane[i][1]))),
+				_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane[i][2])), _mm_set1_ps(plane[i][3])));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+		}
+		int outsideMask = _mm_movemask_ps(outside);
+		for (int lane = 0; lane < 4 && group + lane < count; lane++) {
+			if (outsideMask & (1 << lane)) {
+				stats.frustumCulled++;
+			}
+			else {
+				insideFrustum[insideCount++] = group + lane;
+			}
+		}
+	}
+#else
+	for (int index = 0; frustum && index < count; index++) {
+		bool outside = false;
+		for (int i = 0; i < 6 && !outside; i++) {
+			float distance = plane[i][0] * centerX[index] + plane[i][1] * centerY[index] + plane[i][2] * centerZ[index] + plane[i][3];
+			outside = distance < -radii[index];
+		}
+		if (outside) {
+			stats.frustumCulled++;
+		}
+		else {
+			insideFrustum[insideCount++] = index;
+		}
+	}
+#endif
+
+	if (!occlusion) {
+		visible.assign(insideFrustum, insideFrustum + insideCount);
+		stats.drawn = (int)visible.size();
+		return;
+	}
+
+	// the occluders are the objects covering the most of the screen,
+	// i.e. with the largest radius relative to their distance
+	occlusionBuffer.begin(camera);
+	OccluderCandidate* candidates = arena.allocateArray<OccluderCandidate>(insideCount);
+	int candidateCount = 0;
+	for (int i = 0; i < insideCount; i++) {
+		int index = insideFrustum[i];
+		if (!occluders[index]) {
+			continue;
+		}
+		float depth = occlusionBuffer.viewDepth(glm::vec3(centerX[index], centerY[index], centerZ[index]));
+		if (depth > radii[index]) {
+			OccluderCandidate candidate = { -radii[index] / depth, index };
+			candidates[candidateCount++] = candidate;
+		}
+	}
+	int occluderCount = std::min(candidateCount, OCCLUSION_MAX_OCCLUDERS);
+	std::partial_sort(candidates, candidates + occluderCount, candidates + candidateCount, coversMore);
+	char* isOccluder = arena.allocateArray<char>(count);
+	memset(isOccluder, 0, count);
+	for (int i = 0; i < occluderCount; i++) {
+		int index = candidates[i].index;
+		occlusionBuffer.drawOccluder(glm::vec3(centerX[index], centerY[index], centerZ[index]), radii[index]);
+		isOccluder[index] = 1;
+	}
+
+	for (int i = 0; i < insideCount; i++) {
+		int index = insideFrustum[i];
+		if (!isOccluder[index] && occlusionBuffer.isOccluded(glm::vec3(centerX[index], centerY[index], centerZ[index]), radii[index])) {
+			stats.occlusionCulled++;
+		}
+		else {
+			visible.push_back(index);
+		}
+	}
+	stats.drawn = (int)visible.size();
+}
@@ -0,0 +1,130 @@
+/*  =================== File Information =================
+	File Name: Culling.h
+	Description:
+	Author:
+
+	Purpose: Decides which objects of the scene need to be drawn.  Every
+			 object is a bounding sphere; the spheres are kept as separate
+			 x, y, z and radius arrays so the six frustum planes are tested
+			 against four spheres at a time with SSE.  Optionally the
+			 largest objects are then rasterized as occluders into a small
+			 CPU depth buffer, and objects completely behind them are
+			 dropped as well.
+	Usage:	SceneCuller culler;
+			culler.clear();
+			culler.add(center, radius, true);
+			std::vector<int> visible;
+			culler.cull(camera, true, true, visible, arena);
+	===================================================== */
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "Camera.h"
+#include "FrameArena.h"
+
+#define OCCLUSION_BUFFER_WIDTH 64		// cells across, the height follows the aspect ratio
+#define OCCLUSION_MAX_OCCLUDERS 16		// largest objects on screen drawn into the buffer
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CULLING_SSE 1
+#endif
+
+/*
+	Counts of the last cull().  tested is the number of objects, every
+	one of them ends up in exactly one of the other three.
+*/
+struct CullStats {
+	int tested;
+	int frustumCulled;
+	int occlusionCulled;
+	int drawn;
+};
+
+/*
+	Conservative depth buffer: a cell stores the largest view distance
+	of the occluders covering all of it, so anything nearer
+	than that in a cell might still be visible.
+*/
+class OcclusionBuffer {
+public:
+	OcclusionBuffer();
+
+	/*	===============================================
+	Desc:	Sizes the buffer to the camera's aspect ratio and clears it
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void begin(Camera& camera);
+	/*	===============================================
+	Desc:	Fills the cells that lie inside the sphere's silhouette with
+			the distance of its far side
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void drawOccluder(const glm::vec3& center, float radius);
+	/*	===============================================
+	Desc:	Returns true if every cell the sphere may cover is filled
+			with an occluder nearer than the sphere
+	Precondition:
+	Postcondition:
+	=============================================== */
+	bool isOccluded(const glm::vec3& center, float radius) const;
+	// distance of a point in front of the eye along the view direction
+	float viewDepth(const glm::vec3& p) const;
+
+private:
+	// cell rectangle of the projected sphere, false if it reaches behind the eye
+	bool bounds(const glm::vec3& center, float radius, float& minX, float& minY, float& maxX, float& maxY) const;
+
+	int width;
+	int height;
+	glm::mat4 modelView;
+	float scaleX;	// projection scale of x and y, radius to NDC at distance 1
+	float scaleY;
+	std::vector<float> depths;
+};
+
+class SceneCuller {
+public:
+	SceneCuller();
+
+	/*	===============================================
+	Desc:	Removes every object
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void clear();
+	/*	===============================================
+	Desc:	Adds an object by its bounding sphere.  Only solid objects that
+			fill their bounding sphere should be occluders.
+	Precondition:
+	Postcondition:	Returns the index cull() reports the object by.
+	=============================================== */
+	int add(const glm::vec3& center, float radius, bool occluder);
+	/*	===============================================
+	Desc:	Finds the objects that may be visible from the camera.  Either
+			test can be switched off, with neither every object is visible.
+			The scratch lists come from the frame's arena.
+	Precondition:
+	Postcondition:	visible holds their indices in increasing order.
+	=============================================== */
+	void cull(Camera& camera, bool frustum, bool occlusion, std::vector<int>& visible, FrameArena& arena);
+
+	int size() const { return count; }
+	const CullStats& getStats() const { return stats; }
+
+private:
+	int count;
+	// padded to a multiple of four with spheres that are never visible
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> radii;
+	std::vector<char> occluders;
+	OcclusionBuffer occlusionBuffer;
+	CullStats stats;
+};
+
+#endif
@@ -0,0 +1,120 @@
+/*  =================== File Information =================
+	File Name: DragController.cpp
+	Description:
+	Author:
+
+	Purpose: Constant depth drag with per frame event coalescing and
+			 cursor prediction
+	Usage:
+	===================================================== */
+
+#include <algorithm>
+#include "DragController.h"
+#include "Picking.h"
+
+DragController::DragController() {
+	active = false;
+	prediction = false;
+	pending = false;
+	moving = false;
+	depth = 0;
+	cursorTime = 0;
+	lastUpdate = -1;
+	frameInterval = 1.0 / 60.0;
+	stats.events = 0;
+	stats.updates = 0;
+}
+
+void DragController::begin(Camera& camera, float x, float y, glm::vec3 hitPoint, glm::vec3 objectCenter, double time) {
+	glm::vec3 look = glm::normalize(camera.getLookVector());
+	// the plane through the hit point facing the camera
+	depth = glm::dot(hitPoint - camera.getEyePoint(), look);
+	offset = objectCenter - hitPoint;
+	cursor = glm::vec2(x, y);
+	velocity = glm::vec2(0, 0);
+	cursorTime = time;
+	lastUpdate = -1;
+	active = true;
+	pending = false;
+	moving = false;
+}
+
+void DragController::moveTo(float x, float y, double time) {
+	if (!active) {
+		return;
+	}
+	glm::vec2 position(x, y);
+	double dt = time - cursorTime;
+	if (dt > DRAG_VELOCITY_TIMEOUT) {
+		// the cursor was resting, start a new estimate
+		velocity = glm::vec2(0, 0);
+	}
+	else if (dt > 0) {
+		glm::vec2 sample = (position - cursor) / (float)dt;
+		velocity = velocity + DRAG_VELOCITY_SMOOTHING * (sample - velocity);
+	}
+	cursor = position;
+	cursorTime = time;
+	pending = true;
+	stats.events++;
+}
+
+void DragController::scaleCursor(float sx, float sy) {
+	cursor = glm::vec2(cursor.x * sx, cursor.y * sy);
+	velocity = glm::vec2(velocity.x * sx, velocity.y * sy);
+	// solved again, the object stays under the cursor
+	pending = active;
+}
+
+bool DragController::update(Camera& camera, double time, glm::vec3& objectCenter) {
+	if (!active) {
+		return false;
+	}
+	if (lastUpdate >= 0 && time > lastUpdate) {
+		frameInterval += 0.2 * ((time - lastUpdate) - frameInterval);
+	}
+	lastUpdate = time;
+
+	bool extrapolate = prediction && (time - cursorTime) < DRAG_VELOCITY_TIMEOUT;
+	// nothing to do unless the cursor moved, or a predicted position has to
+	// settle back onto the real cursor now that it stopped
+	if (!pending && !extrapolate && !moving) {
+		return false;
+	}
+	glm::vec2 target = cursor;
+	if (extrapolate) {
+		// aim for where the cursor will be when this frame is displayed
+		double lead = std::min(time - cursorTime + frameInterval, DRAG_MAX_PREDICTION);
+		target = target + velocity * (float)lead;
+	}
+	objectCenter = solve(camera, target.x, target.y);
+	pending = false;
+	moving = extrapolate;
+	stats.updates++;
+	return true;
+}
+
+void DragController::end(Camera& camera, glm::vec3& objectCenter) {
+	if (!active) {
+		return;
+	}
+	if (pending || moving) {
+		objectCenter = solve(camera, cursor.x, cursor.y);
+		stats.updates++;
+	}
+	active = false;
+	pending = false;
+	moving = false;
+}
+
+glm::vec3 DragController::solve(Camera& camera, float x, float y) {
+	glm::vec3 eye = camera.getEyePoint();
+	glm::vec3 look = glm::normalize(camera.getLookVector());
+	glm::vec3 ray = generateRay(camera, x, y);
+	float cosine = glm::dot(ray, look);
+	if (cosine < 1e-4f) {
+		// ray (almost) parallel to the plane, keep the object at the plane's center
+		return eye + depth * look + offset;
+	}
+	return eye + (depth / cosine) * ray + offset;
+}
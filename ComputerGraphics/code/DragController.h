@@ -0,0 +1,95 @@
+/*  =================== File Information =================
+	File Name: DragController.h
+	Description:
+	Author:
+
+	Purpose: Moves a dragged object with the mouse.  The object stays on
+			 the plane facing the camera at the depth where it was first
+			 hit, so every frame its position is found with a single
+			 ray-plane intersection.  Drag events are only queued; however
+			 many arrive between two frames, the position is solved once
+			 per frame for the latest cursor position.  Optionally the
+			 cursor is extrapolated from its recent velocity so the object
+			 is drawn where the cursor will be when the frame is shown.
+	Usage:	begin() on the button press, moveTo() for every drag event,
+			update() once per frame before drawing, end() on release.
+	===================================================== */
+#ifndef DRAG_CONTROLLER_H
+#define DRAG_CONTROLLER_H
+
+#include <glm/glm.hpp>
+#include "Camera.h"
+
+#define DRAG_VELOCITY_SMOOTHING 0.5f	// weight of the newest velocity sample
+#define DRAG_MAX_PREDICTION 0.05		// seconds the cursor is extrapolated at most
+#define DRAG_VELOCITY_TIMEOUT 0.1		// seconds without events after which the cursor counts as resting
+
+struct DragStats {
+	int events;		// drag events received
+	int updates;	// positions solved, at most one per frame
+};
+
+class DragController {
+public:
+	DragController();
+
+	/*	===============================================
+	Desc:	Starts dragging an object centered at objectCenter that the ray
+			through pixel (x, y) hit at hitPoint.  Pixels are those of the
+			camera's screen, fractions are allowed.
+	Precondition:	camera is the camera the hit was computed with.
+	Postcondition:
+	=============================================== */
+	void begin(Camera& camera, float x, float y, glm::vec3 hitPoint, glm::vec3 objectCenter, double time);
+	/*	===============================================
+	Desc:	Queues the cursor position of a drag event
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void moveTo(float x, float y, double time);
+	/*	===============================================
+	Desc:	Scales the cursor position and velocity, when the screen size
+			of the camera changes by sx x sy during a drag
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void scaleCursor(float sx, float sy);
+	/*	===============================================
+	Desc:	Solves the object position for the newest cursor position,
+			extrapolated by one frame interval if prediction is enabled.
+	Precondition:
+	Postcondition:	Returns false if nothing changed since the last update,
+					otherwise objectCenter receives the new position.
+	=============================================== */
+	bool update(Camera& camera, double time, glm::vec3& objectCenter);
+	/*	===============================================
+	Desc:	Stops dragging.  objectCenter receives the position under the
+			last real cursor position, without extrapolation.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void end(Camera& camera, glm::vec3& objectCenter);
+
+	bool isActive() { return active; }
+	void setPrediction(bool enabled) { prediction = enabled; }
+	bool getPrediction() { return prediction; }
+	const DragStats& getStats() { return stats; }
+
+private:
+	glm::vec3 solve(Camera& camera, float x, float y);
+
+	bool active;
+	bool prediction;
+	bool pending;			// a drag event arrived since the last update
+	bool moving;			// the last update used an extrapolated cursor
+	float depth;			// distance of the drag plane from the eye along the look vector
+	glm::vec3 offset;		// object center relative to the grabbed point
+	glm::vec2 cursor;		// newest cursor position
+	glm::vec2 velocity;		// smoothed cursor velocity in pixels per second
+	double cursorTime;		// time of the newest cursor position
+	double lastUpdate;		// time of the last update
+	double frameInterval;	// smoothed time between updates
+	DragStats stats;
+};
+
+#endif
@@ -0,0 +1,86 @@
+/*  =================== File Information =================
+	File Name: FrameArena.cpp
+	Description:
+	Author:
+
+	Purpose: Per frame linear allocator
+	Usage:
+	===================================================== */
+
+#include <new>
+#include <cstdint>
+#include <algorithm>
+#include "FrameArena.h"
+
+FrameArena::FrameArena(size_t _capacity) {
+	capacity = _capacity;
+	block = new char[capacity];
+	used = 0;
+	overflowCapacity = 0;
+	overflowOffset = 0;
+	overflowUsed = 0;
+	highWater = 0;
+	overflows = 0;
+}
+
+FrameArena::~FrameArena() {
+	for (size_t i = 0; i < overflowBlocks.size(); i++) {
+		delete[] overflowBlocks[i];
+	}
+	delete[] block;
+}
+
+void FrameArena::reset() {
+	highWater = std::max(highWater, getUsed());
+	if (!overflowBlocks.empty()) {
+		// one block for all of the last frame, with room to spare
+		for (size_t i = 0; i < overflowBlocks.size(); i++) {
+			delete[] overflowBlocks[i];
+		}
+		overflowBlocks.clear();
+		delete[] block;
+		capacity = highWater + highWater / 2;
+		block = new char[capacity];
+		overflows++;
+	}
+	used = 0;
+	overflowCapacity = 0;
+	overflowOffset = 0;
+	overflowUsed = 0;
+}
+
+/*	Offset of the first aligned byte at or after base + offset */
+static size_t alignOffset(char* base, size_t offset, size_t alignment) {
+	uintptr_t address = (uintptr_t)(base + offset);
+	return offset + ((alignment - address % alignment) % alignment);
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+	if (overflowBlocks.empty()) {
+		size_t start = alignOffset(block, used, alignment);
+		if (block != NULL && start + bytes <= capacity) {
+			used = start + bytes;
+			return block + start;
+		}
+	}
+	else {
+		char* last = overflowBlocks.back();
+		size_t start = alignOffset(last, overflowOffset, alignment);
+		if (start + bytes <= overflowCapacity) {
+			overflowUsed += start + bytes - overflowOffset;
+			overflowOffset = start + bytes;
+			return last + start;
+		}
+	}
+	// the block is full, this frame continues in an extra one
+	overflowCapacity = std::max(bytes + alignment, capacity);
+	char* extra = new (std::nothrow) char[overflowCapacity];
+	if (extra == NULL) {
+		return NULL;
+	}
+	overflowBlocks.push_back(extra);
+	size_t start = alignOffset(extra, 0, alignment);
+	overflowOffset = start + bytes;
+	overflowUsed += overflowOffset;
+	return extra + start;
+}
@@ -0,0 +1,72 @@
+/*  =================== File Information =================
+	File Name: FrameArena.h
+	Description:
+	Author:
+
+	Purpose: Linear allocator for memory that only lives for one frame.
+			 An allocation bumps an offset into one block, and reset()
+			 at the start of the next frame frees everything at once.  If
+			 a frame needs more than the block holds, the rest comes from
+			 extra blocks, and the next reset() replaces them with one
+			 block big enough for that frame.  Frames after that do not
+			 touch the heap at all.  Blocks come from operator new, so
+			 the AllocationTracker counts them like any other allocation.
+	Usage:	arena.reset();						// start of the frame
+			glm::vec3* rays = arena.allocateArray<glm::vec3>(count);
+	===================================================== */
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+#define FRAME_ARENA_SIZE (256 * 1024)	// initial block size in bytes
+#define FRAME_ARENA_ALIGNMENT 16		// default alignment, enough for SSE
+
+class FrameArena {
+public:
+	FrameArena(size_t capacity = FRAME_ARENA_SIZE);
+	~FrameArena();
+
+	/*	===============================================
+	Desc:	Frees every allocation of the last frame.  Their memory is
+			handed out again, nothing may point into it any more.
+	Precondition:
+	Postcondition:	getUsed() == 0
+	=============================================== */
+	void reset();
+	/*	===============================================
+	Desc:	Returns bytes of uninitialized memory, valid until reset().
+			alignment is a power of two.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void* allocate(size_t bytes, size_t alignment = FRAME_ARENA_ALIGNMENT);
+	// for types without constructors and destructors only, none are run
+	template <class T>
+	T* allocateArray(size_t count) {
+		return (T*)allocate(count * sizeof(T), alignof(T) > FRAME_ARENA_ALIGNMENT ? alignof(T) : FRAME_ARENA_ALIGNMENT);
+	}
+
+	size_t getUsed() { return used + overflowUsed; }	// bytes since reset(), with padding
+	size_t getCapacity() { return capacity; }
+	size_t getHighWater() { return highWater; }			// most bytes one frame used
+	int getOverflows() { return overflows; }			// frames that did not fit the block
+	int getExtraBlocks() { return (int)overflowBlocks.size(); }	// taken since reset()
+
+private:
+	FrameArena(const FrameArena&);
+	FrameArena& operator=(const FrameArena&);
+
+	char* block;
+	size_t capacity;
+	size_t used;
+	std::vector<char*> overflowBlocks;	// this frame's extra blocks, the last one is filled
+	size_t overflowCapacity;			// of the last extra block
+	size_t overflowOffset;
+	size_t overflowUsed;				// in all extra blocks
+	size_t highWater;
+	int overflows;
+};
+
+#endif
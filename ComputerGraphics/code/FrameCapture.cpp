@@ -0,0 +1,317 @@
+/*  =================== File Information =================
+	File Name: FrameCapture.cpp
+	Description:
+	Author:
+
+	Purpose: Double-buffered PBO readback and threaded frame writer
+	Usage:
+	===================================================== */
+
+#include "FrameCapture.h"
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#define dup _dup
+#define dup2 _dup2
+#define fileno _fileno
+#define fdopen _fdopen
+#else
+#include <unistd.h>
+#endif
+
+// Descriptor of the real stdout once it has been reserved for frame data
+static int stdoutForFrames = -1;
+
+/*	Keeps the real stdout for the frames and sends everything else
+	printed by the program to stderr, so log messages cannot end up in
+	the middle of the frame stream.
+*/
+static void reserveStdout() {
+	if (stdoutForFrames >= 0) {
+		return;
+	}
+	fflush(stdout);
+	stdoutForFrames = dup(fileno(stdout));
+	dup2(fileno(stderr), fileno(stdout));
+#ifdef _WIN32
+	_setmode(stdoutForFrames, _O_BINARY);
+#endif
+}
+
+bool parseCaptureOptions(int argc, char** argv, CaptureOptions& options) {
+	bool capture = false;
+	options.output = "capture";
+	options.format = CAPTURE_PPM_FILES;
+	options.policy = CAPTURE_DROP;
+	options.queueLength = 8;
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = (i + 1 < argc);
+		if (arg == "--capture" && hasValue) {
+			capture = true;
+			options.output = argv[++i];
+		}
+		else if (arg == "--capture-format" && hasValue) {
+			std::string format = argv[++i];
+			if (format == "ppm") options.format = CAPTURE_PPM_FILES;
+			else if (format == "ppm-stream") options.format = CAPTURE_PPM_STREAM;
+			else if (format == "raw") options.format = CAPTURE_RAW_STREAM;
+			else std::cout << "unknown capture format: " << format << std::endl;
+		}
+		else if (arg == "--capture-policy" && hasValue) {
+			std::string policy = argv[++i];
+			if (policy == "drop") options.policy = CAPTURE_DROP;
+			else if (policy == "block") options.policy = CAPTURE_BLOCK;
+			else std::cout << "unknown capture policy: " << policy << std::endl;
+		}
+		else if (arg == "--capture-queue" && hasValue) {
+			options.queueLength = atoi(argv[++i]);
+		}
+	}
+
+	if (options.queueLength < 1) {
+		options.queueLength = 1;
+	}
+	// Single images need a file name per frame, a pipe cannot hold them apart
+	if (options.output == "-" && options.format == CAPTURE_PPM_FILES) {
+		options.format = CAPTURE_PPM_STREAM;
+	}
+	// Reserve stdout right away, before anything else gets printed
+	if (capture && options.output == "-") {
+		reserveStdout();
+	}
+	return capture;
+}
+
+FrameCapture::FrameCapture() {
+	active = false;
+	width = 0;
+	height = 0;
+	frameBytes = 0;
+	pbo[0] = pbo[1] = 0;
+	pboPending[0] = pboPending[1] = false;
+	pboIndex = 0;
+	frameNumber = 0;
+	stopping = false;
+	stream = NULL;
+	memset(&stats, 0, sizeof(stats));
+}
+
+FrameCapture::~FrameCapture() {
+	stop();
+}
+
+bool FrameCapture::start(const CaptureOptions& _options, int _width, int _height) {
+	if (active) {
+		stop();
+	}
+	if (!loadGLExtensions()) {
+		std::cout << "Frame capture needs pixel buffer objects" << std::endl;
+		return false;
+	}
+
+	options = _options;
+	width = _width;
+	height = _height;
+	frameBytes = (size_t)width * height * 3;
+	frameNumber = 0;
+	memset(&stats, 0, sizeof(stats));
+
+	if (options.format != CAPTURE_PPM_FILES) {
+		if (options.output == "-") {
+			reserveStdout();
+			stream = fdopen(stdoutForFrames, "wb");
+			// closing the stream closes the descriptor
+			stdoutForFrames = -1;
+		}
+		else {
+			stream = fopen(options.output.c_str(), "wb");
+		}
+		if (stream == NULL) {
+			std::cout << "Unable to open capture output: " << options.output << std::endl;
+			return false;
+		}
+	}
+
+	glGenBuffers(2, pbo);
+	for (int i = 0; i < 2; i++) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[i]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, NULL, GL_STREAM_READ);
+		pboPending[i] = false;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	pboIndex = 0;
+
+	for (int i = 0; i < options.queueLength; i++) {
+		char* buffer = new char[frameBytes];
+		buffers.push_back(buffer);
+		freeBuffers.push_back(buffer);
+	}
+
+	stopping = false;
+	active = true;
+	writer = std::thread(&FrameCapture::writerLoop, this);
+	std::cerr << "capturing " << width << "x" << height << " frames to " << options.output << std::endl;
+	return true;
+}
+
+void FrameCapture::captureFrame(int currentWidth, int currentHeight) {
+	if (!active) {
+		return;
+	}
+	if (currentWidth != width || currentHeight != height) {
+		std::cerr << "framebuffer resized, stopping capture" << std::endl;
+		stop();
+		return;
+	}
+
+	// Start an asynchronous read of this frame into the current PBO ...
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[pboIndex]);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, 0);
+	pboPending[pboIndex] = true;
+	stats.captured++;
+
+	// ... and pick up the previous frame, whose read had a whole frame to finish
+	pboIndex = 1 - pboIndex;
+	collect(pboIndex);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+/*	Copies a finished PBO into a free frame buffer and queues it */
+void FrameCapture::collect(int index) {
+	if (!pboPending[index]) {
+		return;
+	}
+	pboPending[index] = false;
+	int number = frameNumber++;
+
+	char* buffer = NULL;
+	{
+		std::unique_lock<std::mutex> lock(queueMutex);
+		if (freeBuffers.empty() && options.policy == CAPTURE_BLOCK) {
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			bufferFreed.wait(lock, [this] { return !freeBuffers.empty(); });
+			stats.blockedSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+		if (freeBuffers.empty()) {
+			stats.dropped++;
+			return;
+		}
+		buffer = freeBuffers.back();
+		freeBuffers.pop_back();
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[index]);
+	void* mapped = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+	if (mapped != NULL) {
+		memcpy(buffer, mapped, frameBytes);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+
+	std::lock_guard<std::mutex> lock(queueMutex);
+	if (mapped == NULL) {
+		freeBuffers.push_back(buffer);
+		stats.dropped++;
+		return;
+	}
+	Frame frame;
+	frame.pixels = buffer;
+	frame.number = number;
+	queue.push_back(frame);
+	frameQueued.notify_one();
+}
+
+void FrameCapture::stop() {
+	if (!active) {
+		return;
+	}
+	// The most recent read is still in its PBO
+	collect(1 - pboIndex);
+	collect(pboIndex);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stopping = true;
+		frameQueued.notify_one();
+	}
+	writer.join();
+
+	glDeleteBuffers(2, pbo);
+	pbo[0] = pbo[1] = 0;
+	for (size_t i = 0; i < buffers.size(); i++) {
+		delete[] buffers[i];
+	}
+	buffers.clear();
+	freeBuffers.clear();
+
+	if (stream != NULL) {
+		fclose(stream);
+		stream = NULL;
+	}
+	active = false;
+	std::cerr << "capture stopped: " << stats.captured << " captured, " << stats.written << " written, "
+		<< stats.dropped << " dropped, " << stats.blockedSeconds * 1000.0 << " ms blocked" << std::endl;
+}
+
+CaptureStats FrameCapture::getStats() {
+	std::lock_guard<std::mutex> lock(queueMutex);
+	return stats;
+}
+
+void FrameCapture::writerLoop() {
+	while (true) {
+		Frame frame;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			frameQueued.wait(lock, [this] { return stopping || !queue.empty(); });
+			if (queue.empty()) {
+				return;		// stopping and everything has been written
+			}
+			frame = queue.front();
+			queue.pop_front();
+		}
+
+		writeFrame(frame);
+
+		std::lock_guard<std::mutex> lock(queueMutex);
+		freeBuffers.push_back(frame.pixels);
+		stats.written++;
+		bufferFreed.notify_one();
+	}
+}
+
+/*	Rows are written bottom row first, which flips the OpenGL image
+	into the top-down order of ppm and raw video.
+*/
+void FrameCapture::writeFrame(const Frame& frame) {
+	FILE* out = stream;
+	if (options.format == CAPTURE_PPM_FILES) {
+		char fileName[512];
+		snprintf(fileName, sizeof(fileName), "%s_%05d.ppm", options.output.c_str(), frame.number);
+		out = fopen(fileName, "wb");
+		if (out == NULL) {
+			std::cerr << "Unable to write capture frame: " << fileName << std::endl;
+			return;
+		}
+	}
+
+	if (options.format != CAPTURE_RAW_STREAM) {
+		fprintf(out, "P6\n# CREATOR: ComputerGraphics\n%d %d\n255\n", width, height);
+	}
+	size_t rowBytes = (size_t)width * 3;
+	for (int y = height - 1; y >= 0; y--) {
+		fwrite(frame.pixels + y * rowBytes, 1, rowBytes, out);
+	}
+
+	if (options.format == CAPTURE_PPM_FILES) {
+		fclose(out);
+	}
+}
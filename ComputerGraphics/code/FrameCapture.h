@@ -0,0 +1,130 @@
+/*  =================== File Information =================
+	File Name: FrameCapture.h
+	Description:
+	Author:
+
+	Purpose: Captures the rendered frames without stalling the render
+			 loop.  The framebuffer is read into one of two pixel buffer
+			 objects, so the read of frame N completes while frame N+1 is
+			 rendered, and a writer thread sends the frames to disk or to
+			 a pipe.
+	Usage:	--capture <output> [--capture-format ppm|ppm-stream|raw]
+				[--capture-policy drop|block] [--capture-queue 8]
+
+			ppm writes <output>_00000.ppm, ... ; ppm-stream and raw write
+			one concatenated stream to the file <output>, or to stdout if
+			<output> is "-".  For example:
+			--capture - --capture-format raw | ffmpeg -f rawvideo -pix_fmt rgb24 -s 800x500 -i - out.mp4
+	===================================================== */
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include "GLExt.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+
+enum CaptureFormat {
+	CAPTURE_PPM_FILES,	// one P6 file per frame
+	CAPTURE_PPM_STREAM,	// concatenated P6 images (ffmpeg -f image2pipe)
+	CAPTURE_RAW_STREAM	// rgb24 rows, top to bottom, no headers
+};
+
+// What happens when the writer falls behind and every frame buffer is queued
+enum CapturePolicy {
+	CAPTURE_DROP,		// skip the frame, the render loop never waits
+	CAPTURE_BLOCK		// wait for the writer, no frame is lost
+};
+
+struct CaptureOptions {
+	std::string output;
+	CaptureFormat format;
+	CapturePolicy policy;
+	int queueLength;	// number of frames that can wait for the writer
+};
+
+struct CaptureStats {
+	int captured;		// frames read back from OpenGL
+	int written;
+	int dropped;
+	double blockedSeconds;	// time the render thread waited (CAPTURE_BLOCK)
+};
+
+/*	===============================================
+Desc:	Parses the capture options of the command line.  Returns true if
+		--capture was given.
+Precondition:
+Postcondition:
+=============================================== */
+bool parseCaptureOptions(int argc, char** argv, CaptureOptions& options);
+
+class FrameCapture {
+public:
+	FrameCapture();
+	~FrameCapture();
+
+	/*	===============================================
+	Desc:	Creates the pixel buffer objects and starts the writer thread
+	Precondition:	A GL context is current, and stays current for every
+					following call until stop().
+	Postcondition:	Returns false if the output could not be opened.
+	=============================================== */
+	bool start(const CaptureOptions& _options, int _width, int _height);
+	/*	===============================================
+	Desc:	Starts the read of the current framebuffer and hands the frame
+			read during the previous call to the writer.
+	Precondition:	The frame has been drawn but not yet swapped.
+	Postcondition:	Capture stops if the framebuffer size changed.
+	=============================================== */
+	void captureFrame(int currentWidth, int currentHeight);
+	/*	===============================================
+	Desc:	Queues the last frame still in flight, waits for the writer to
+			finish and releases the pixel buffer objects.
+	Precondition:	The GL context used by start() is current.
+	Postcondition:
+	=============================================== */
+	void stop();
+
+	bool isActive() { return active; }
+	CaptureStats getStats();
+
+private:
+	struct Frame {
+		char* pixels;	// bottom-up rows, as read from OpenGL
+		int number;
+	};
+
+	void collect(int index);
+	void writerLoop();
+	void writeFrame(const Frame& frame);
+
+	CaptureOptions options;
+	bool active;
+	int width;
+	int height;
+	size_t frameBytes;
+
+	GLuint pbo[2];
+	bool pboPending[2];
+	int pboIndex;
+	int frameNumber;
+
+	// Frame buffers are allocated once in start() and recycled
+	std::vector<char*> buffers;
+	std::vector<char*> freeBuffers;
+	std::deque<Frame> queue;
+	std::mutex queueMutex;
+	std::condition_variable frameQueued;
+	std::condition_variable bufferFreed;
+	bool stopping;
+	std::thread writer;
+
+	FILE* stream;
+	CaptureStats stats;
+};
+
+#endif
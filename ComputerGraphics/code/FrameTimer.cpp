@@ -0,0 +1,97 @@
+/*  =================== File Information =================
+	File Name: FrameTimer.cpp
+	Description:
+	Author:
+
+	Purpose: Frame times from the wall clock, the GPU kept close by fences
+	Usage:
+	===================================================== */
+
+#include "FrameTimer.h"
+
+#define FRAME_TIMER_WAIT_NS 1000000000	// a wait is retried after this, a second
+
+FrameTimer::FrameTimer() {
+	for (int i = 0; i < FRAME_TIMER_FRAMES; i++) {
+		fences[i] = 0;
+		tags[i] = 0;
+	}
+	frame = 0;
+	started = false;
+	lastTag = 0;
+	ready = false;
+	resultMilliseconds = 0;
+	resultTag = 0;
+	support = -1;
+}
+
+FrameTimer::~FrameTimer() {
+	release();
+}
+
+void FrameTimer::release() {
+	for (int i = 0; i < FRAME_TIMER_FRAMES; i++) {
+		if (fences[i] != 0) {
+			glDeleteSync(fences[i]);
+			fences[i] = 0;
+		}
+	}
+	frame = 0;
+	started = false;
+	ready = false;
+	support = -1;
+}
+
+void FrameTimer::begin(int tag) {
+	if (support < 0) {
+		support = hasGLFences() ? 1 : 0;
+	}
+	typedef std::chrono::steady_clock Clock;
+	int oldestTag = lastTag;
+	GLsync fence = fences[frame];
+	if (fence != 0) {
+		fences[frame] = 0;
+		oldestTag = tags[frame];
+		// the fence may still sit in an unflushed command buffer
+		GLenum status;
+		do {
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FRAME_TIMER_WAIT_NS);
+		} while (status == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(fence);
+	}
+	Clock::time_point now = Clock::now();
+	if (started) {
+		double milliseconds = std::chrono::duration<double, std::milli>(now - lastStart).count();
+		ready = milliseconds <= FRAME_TIMER_MAX_MS;
+		resultMilliseconds = milliseconds;
+		resultTag = oldestTag;
+	}
+	started = true;
+	lastStart = now;
+	lastTag = tag;
+	tags[frame] = tag;
+}
+
+void FrameTimer::end() {
+	if (!started) {
+		return;
+	}
+	if (support == 1) {
+		if (fences[frame] != 0) {
+			// end() without begin(), nobody waits for the older fence
+			glDeleteSync(fences[frame]);
+		}
+		fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	frame = (frame + 1) % FRAME_TIMER_FRAMES;
+}
+
+bool FrameTimer::collect(double& milliseconds, int& tag) {
+	if (!ready) {
+		return false;
+	}
+	ready = false;
+	milliseconds = resultMilliseconds;
+	tag = resultTag;
+	return true;
+}
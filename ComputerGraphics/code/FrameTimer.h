@@ -0,0 +1,88 @@
+/*  =================== File Information =================
+	File Name: FrameTimer.h
+	Description:
+	Author:
+
+	Purpose: Measures how long frames take, every frame the same way:
+			 a frame's time is the wall clock time from its begin() to
+			 the begin() of the next frame.  end() places a fence after
+			 the frame's GL commands, and begin() first waits for the
+			 fence of the frame FRAME_TIMER_FRAMES frames back, so the
+			 CPU stays at most that many frames ahead of the GPU and the
+			 time between frames follows whichever of the two is slower.
+			 What the driver defers, e.g. llvmpipe rasterizing a frame
+			 drawn into the window only when it is read back or swapped,
+			 is counted like everything else.
+			 Contexts without fences get the time between frames alone.
+
+			 Each frame carries a tag given to begin(), so results of
+			 frames drawn under other conditions (e.g. another resolution)
+			 can be told apart.  A result is tagged with the oldest frame
+			 it may include, the one whose fence was waited for.  Gaps
+			 longer than FRAME_TIMER_MAX_MS, such as a viewer that drew
+			 nothing for a while, are dropped.
+	Usage:	timer.begin(tag);
+			// draw
+			timer.end();
+			double milliseconds;
+			int frameTag;
+			while (timer.collect(milliseconds, frameTag)) {
+				// an earlier frame's time
+			}
+	===================================================== */
+#ifndef FRAME_TIMER_H
+#define FRAME_TIMER_H
+
+#include <chrono>
+#include "GLExt.h"
+
+#define FRAME_TIMER_FRAMES 2	// frames the CPU may be ahead of the GPU
+#define FRAME_TIMER_MAX_MS 1000.0	// longer gaps between frames are not timed
+
+class FrameTimer {
+public:
+	FrameTimer();
+	/*	===============================================
+	Desc:	Deletes the fences
+	Precondition:	The GL context they were created in is current.
+	Postcondition:
+	=============================================== */
+	~FrameTimer();
+
+	/*	===============================================
+	Desc:	Start and end of the frame's GL commands.  begin() waits for
+			the GPU if it is more than FRAME_TIMER_FRAMES frames behind.
+	Precondition:	A GL context is current.
+	Postcondition:
+	=============================================== */
+	void begin(int tag);
+	void end();
+	/*	===============================================
+	Desc:	Takes the time of the frame before the last begin(), once
+	Precondition:
+	Postcondition:	Returns false if there is none.
+	=============================================== */
+	bool collect(double& milliseconds, int& tag);
+	/*	===============================================
+	Desc:	Deletes the fences and forgets the frames in flight
+	Precondition:	The GL context they were created in is current.
+	Postcondition:
+	=============================================== */
+	void release();
+	// false until the first begin(), and where the time between frames is used alone
+	bool usesFences() { return support == 1; }
+
+private:
+	GLsync fences[FRAME_TIMER_FRAMES];	// after the last frame of each slot, 0 if none
+	int tags[FRAME_TIMER_FRAMES];
+	int frame;			// slot of the current frame
+	bool started;		// a frame was begun since release()
+	int lastTag;
+	bool ready;			// result not collected yet
+	double resultMilliseconds;
+	int resultTag;
+	int support;		// -1 until checked, then 0 or 1
+	std::chrono::steady_clock::time_point lastStart;
+};
+
+#endif
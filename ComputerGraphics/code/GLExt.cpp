@@ -0,0 +1,92 @@
+/*  =================== File Information =================
+	File Name: GLExt.cpp
+	Description:
+	Author:
+
+	Purpose: OpenGL entry point loading
+	Usage:
+	===================================================== */
+
+#include "GLExt.h"
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define CG_DEFINE_GL_FUNCTION(type, name) type cg_##name = NULL;
+CG_GL_FUNCTIONS(CG_DEFINE_GL_FUNCTION)
+CG_GL_SHADER_FUNCTIONS(CG_DEFINE_GL_FUNCTION)
+CG_GL_STORAGE_FUNCTIONS(CG_DEFINE_GL_FUNCTION)
+#undef CG_DEFINE_GL_FUNCTION
+
+static bool shaderFunctions = false;
+
+bool loadGLExtensions() {
+	bool complete = true;
+#define CG_LOAD_GL_FUNCTION(type, name) \
+	cg_##name = (type)wglGetProcAddress(#name); \
+	if (cg_##name == NULL) { \
+		std::cout << "missing OpenGL function " << #name << std::endl; \
+		complete = false; \
+	}
+	CG_GL_FUNCTIONS(CG_LOAD_GL_FUNCTION)
+	bool buffers = complete;
+	CG_GL_SHADER_FUNCTIONS(CG_LOAD_GL_FUNCTION)
+#undef CG_LOAD_GL_FUNCTION
+	shaderFunctions = complete;
+	// optional, older drivers do not have it and nothing needs to be said
+	cg_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)wglGetProcAddress("glBufferStorage");
+	return buffers;
+}
+
+bool hasGLShaderFunctions() {
+	return shaderFunctions;
+}
+#else
+bool loadGLExtensions() {
+	return true;
+}
+
+bool hasGLShaderFunctions() {
+	return true;
+}
+#endif
+
+// libGL exports every entry point whether or not the driver has it, the
+// context's version tells
+static bool hasGLVersion(int wantedMajor, int wantedMinor) {
+	GLint major = 0;
+	GLint minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	return major > wantedMajor || (major == wantedMajor && minor >= wantedMinor);
+}
+
+bool hasGLBufferStorage() {
+#ifdef _WIN32
+	if (!shaderFunctions || cg_glBufferStorage == NULL) {
+		return false;
+	}
+#endif
+	return hasGLVersion(4, 4) || hasGLExtension("GL_ARB_buffer_storage");
+}
+
+bool hasGLFences() {
+	return hasGLShaderFunctions() && (hasGLVersion(3, 2) || hasGLExtension("GL_ARB_sync"));
+}
+
+bool hasGLExtension(const char* name) {
+	const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+	if (extensions == NULL) {
+		return false;
+	}
+	size_t length = strlen(name);
+	const char* p = extensions;
+	while ((p = strstr(p, name)) != NULL) {
+		// only accept whole words, GL_EXT_foo must not match GL_EXT_foo_bar
+		if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0')) {
+			return true;
+		}
+		p += length;
+	}
+	return false;
+}
@@ -0,0 +1,177 @@
+/*  =================== File Information =================
+	File Name: GLExt.h
+	Description:
+	Author:
+
+	Purpose: Access to OpenGL entry points newer than 1.1 (buffer objects,
+			 compressed textures, vertex arrays, shaders, uniform buffers,
+			 framebuffers, fences, persistently mapped
+			 buffers).  On Linux the GL library exports them directly; on
+			 Windows opengl32.lib only exports OpenGL 1.1, so they are
+			 looked up with wglGetProcAddress once a context exists.
+	Usage:	Include this header instead of <FL/gl.h> (so the scene code
+			builds without FLTK), before any other GL header, and call
+			loadGLExtensions() after the context has been made current.
+	===================================================== */
+#ifndef GL_EXT_H
+#define GL_EXT_H
+
+#ifndef _WIN32
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES 1
+#endif
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+#include <GL/glu.h>
+#include <GL/glext.h>
+
+#ifdef _WIN32
+#define CG_GL_FUNCTIONS(X) \
+	X(PFNGLGENBUFFERSPROC, glGenBuffers) \
+	X(PFNGLDELETEBUFFERSPROC, glDeleteBuffers) \
+	X(PFNGLBINDBUFFERPROC, glBindBuffer) \
+	X(PFNGLBUFFERDATAPROC, glBufferData) \
+	X(PFNGLMAPBUFFERPROC, glMapBuffer) \
+	X(PFNGLUNMAPBUFFERPROC, glUnmapBuffer) \
+	X(PFNGLCOMPRESSEDTEXIMAGE2DPROC, glCompressedTexImage2D) \
+	X(PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC, glCompressedTexSubImage2D)
+
+// OpenGL 3.x, only needed by the shader pipeline and dynamic resolution
+#define CG_GL_SHADER_FUNCTIONS(X) \
+	X(PFNGLBUFFERSUBDATAPROC, glBufferSubData) \
+	X(PFNGLMAPBUFFERRANGEPROC, glMapBufferRange) \
+	X(PFNGLCOPYBUFFERSUBDATAPROC, glCopyBufferSubData) \
+	X(PFNGLFENCESYNCPROC, glFenceSync) \
+	X(PFNGLCLIENTWAITSYNCPROC, glClientWaitSync) \
+	X(PFNGLDELETESYNCPROC, glDeleteSync) \
+	X(PFNGLBINDBUFFERBASEPROC, glBindBufferBase) \
+	X(PFNGLBINDBUFFERRANGEPROC, glBindBufferRange) \
+	X(PFNGLGENVERTEXARRAYSPROC, glGenVertexArrays) \
+	X(PFNGLDELETEVERTEXARRAYSPROC, glDeleteVertexArrays) \
+	X(PFNGLBINDVERTEXARRAYPROC, glBindVertexArray) \
+	X(PFNGLVERTEXATTRIBPOINTERPROC, glVertexAttribPointer) \
+	X(PFNGLENABLEVERTEXATTRIBARRAYPROC, glEnableVertexAttribArray) \
+	X(PFNGLDISABLEVERTEXATTRIBARRAYPROC, glDisableVertexAttribArray) \
+	X(PFNGLVERTEXATTRIB4FPROC, glVertexAttrib4f) \
+	X(PFNGLCREATESHADERPROC, glCreateShader) \
+	X(PFNGLSHADERSOURCEPROC, glShaderSource) \
+	X(PFNGLCOMPILESHADERPROC, glCompileShader) \
+	X(PFNGLGETSHADERIVPROC, glGetShaderiv) \
+	X(PFNGLGETSHADERINFOLOGPROC, glGetShaderInfoLog) \
+	X(PFNGLDELETESHADERPROC, glDeleteShader) \
+	X(PFNGLCREATEPROGRAMPROC, glCreateProgram) \
+	X(PFNGLATTACHSHADERPROC, glAttachShader) \
+	X(PFNGLBINDATTRIBLOCATIONPROC, glBindAttribLocation) \
+	X(PFNGLLINKPROGRAMPROC, glLinkProgram) \
+	X(PFNGLGETPROGRAMIVPROC, glGetProgramiv) \
+	X(PFNGLGETPROGRAMINFOLOGPROC, glGetProgramInfoLog) \
+	X(PFNGLDELETEPROGRAMPROC, glDeleteProgram) \
+	X(PFNGLUSEPROGRAMPROC, glUseProgram) \
+	X(PFNGLGETUNIFORMLOCATIONPROC, glGetUniformLocation) \
+	X(PFNGLUNIFORM1IPROC, glUniform1i) \
+	X(PFNGLUNIFORM4FPROC, glUniform4f) \
+	X(PFNGLACTIVETEXTUREPROC, glActiveTexture) \
+	X(PFNGLGETUNIFORMBLOCKINDEXPROC, glGetUniformBlockIndex) \
+	X(PFNGLUNIFORMBLOCKBINDINGPROC, glUniformBlockBinding) \
+	X(PFNGLGENFRAMEBUFFERSPROC, glGenFramebuffers) \
+	X(PFNGLDELETEFRAMEBUFFERSPROC, glDeleteFramebuffers) \
+	X(PFNGLBINDFRAMEBUFFERPROC, glBindFramebuffer) \
+	X(PFNGLFRAMEBUFFERRENDERBUFFERPROC, glFramebufferRenderbuffer) \
+	X(PFNGLCHECKFRAMEBUFFERSTATUSPROC, glCheckFramebufferStatus) \
+	X(PFNGLBLITFRAMEBUFFERPROC, glBlitFramebuffer) \
+	X(PFNGLGENRENDERBUFFERSPROC, glGenRenderbuffers) \
+	X(PFNGLDELETERENDERBUFFERSPROC, glDeleteRenderbuffers) \
+	X(PFNGLBINDRENDERBUFFERPROC, glBindRenderbuffer) \
+	X(PFNGLRENDERBUFFERSTORAGEPROC, glRenderbufferStorage)
+
+// OpenGL 4.4 or GL_ARB_buffer_storage, only needed by StreamBuffer
+#define CG_GL_STORAGE_FUNCTIONS(X) \
+	X(PFNGLBUFFERSTORAGEPROC, glBufferStorage)
+
+#define CG_DECLARE_GL_FUNCTION(type, name) extern type cg_##name;
+CG_GL_FUNCTIONS(CG_DECLARE_GL_FUNCTION)
+CG_GL_SHADER_FUNCTIONS(CG_DECLARE_GL_FUNCTION)
+CG_GL_STORAGE_FUNCTIONS(CG_DECLARE_GL_FUNCTION)
+#undef CG_DECLARE_GL_FUNCTION
+
+#define glGenBuffers cg_glGenBuffers
+#define glDeleteBuffers cg_glDeleteBuffers
+#define glBindBuffer cg_glBindBuffer
+#define glBufferData cg_glBufferData
+#define glMapBuffer cg_glMapBuffer
+#define glUnmapBuffer cg_glUnmapBuffer
+#define glCompressedTexImage2D cg_glCompressedTexImage2D
+#define glCompressedTexSubImage2D cg_glCompressedTexSubImage2D
+#define glBufferSubData cg_glBufferSubData
+#define glMapBufferRange cg_glMapBufferRange
+#define glCopyBufferSubData cg_glCopyBufferSubData
+#define glFenceSync cg_glFenceSync
+#define glClientWaitSync cg_glClientWaitSync
+#define glDeleteSync cg_glDeleteSync
+#define glBindBufferBase cg_glBindBufferBase
+#define glBindBufferRange cg_glBindBufferRange
+#define glGenVertexArrays cg_glGenVertexArrays
+#define glDeleteVertexArrays cg_glDeleteVertexArrays
+#define glBindVertexArray cg_glBindVertexArray
+#define glVertexAttribPointer cg_glVertexAttribPointer
+#define glEnableVertexAttribArray cg_glEnableVertexAttribArray
+#define glDisableVertexAttribArray cg_glDisableVertexAttribArray
+#define glVertexAttrib4f cg_glVertexAttrib4f
+#define glCreateShader cg_glCreateShader
+#define glShaderSource cg_glShaderSource
+#define glCompileShader cg_glCompileShader
+#define glGetShaderiv cg_glGetShaderiv
+#define glGetShaderInfoLog cg_glGetShaderInfoLog
+#define glDeleteShader cg_glDeleteShader
+#define glCreateProgram cg_glCreateProgram
+#define glAttachShader cg_glAttachShader
+#define glBindAttribLocation cg_glBindAttribLocation
+#define glLinkProgram cg_glLinkProgram
+#define glGetProgramiv cg_glGetProgramiv
+#define glGetProgramInfoLog cg_glGetProgramInfoLog
+#define glDeleteProgram cg_glDeleteProgram
+#define glUseProgram cg_glUseProgram
+#define glGetUniformLocation cg_glGetUniformLocation
+#define glUniform1i cg_glUniform1i
+#define glUniform4f cg_glUniform4f
+#define glActiveTexture cg_glActiveTexture
+#define glGetUniformBlockIndex cg_glGetUniformBlockIndex
+#define glUniformBlockBinding cg_glUniformBlockBinding
+#define glGenFramebuffers cg_glGenFramebuffers
+#define glDeleteFramebuffers cg_glDeleteFramebuffers
+#define glBindFramebuffer cg_glBindFramebuffer
+#define glFramebufferRenderbuffer cg_glFramebufferRenderbuffer
+#define glCheckFramebufferStatus cg_glCheckFramebufferStatus
+#define glBlitFramebuffer cg_glBlitFramebuffer
+#define glGenRenderbuffers cg_glGenRenderbuffers
+#define glDeleteRenderbuffers cg_glDeleteRenderbuffers
+#define glBindRenderbuffer cg_glBindRenderbuffer
+#define glRenderbufferStorage cg_glRenderbufferStorage
+#define glBufferStorage cg_glBufferStorage
+#endif
+
+/*	===============================================
+Desc:	Resolves the entry points listed above.
+Precondition:	A GL context is current.
+Postcondition:	Returns false if any buffer object or compressed texture entry
+				point is missing.
+				Missing shader entry points only make hasGLShaderFunctions()
+				return false, a missing glBufferStorage hasGLBufferStorage().
+=============================================== */
+bool loadGLExtensions();
+bool hasGLShaderFunctions();
+bool hasGLBufferStorage();
+// fence sync objects, OpenGL 3.2 or GL_ARB_sync
+bool hasGLFences();
+/*	===============================================
+Desc:	Returns true if the current context advertises the named extension
+Precondition:	A GL context is current.
+Postcondition:
+=============================================== */
+bool hasGLExtension(const char* name);
+
+#endif
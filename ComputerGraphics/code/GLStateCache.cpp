@@ -0,0 +1,259 @@
+/*  =================== File Information =================
+	File Name: GLStateCache.cpp
+	Description:
+	Author:
+
+	Purpose: Redundant GL state change filter
+	Usage:
+	===================================================== */
+
+#include <glm/gtc/type_ptr.hpp>
+#include "GLStateCache.h"
+
+GLStateCache::GLStateCache() {
+	reset();
+	beginFrame();
+}
+
+void GLStateCache::reset() {
+	capabilities.clear();
+	boundTexture = 0;
+	textureKnown = false;
+	textureParameters.clear();
+	polygonModeValue = GL_FILL;
+	polygonModeKnown = false;
+	color = glm::vec3(1.0f);
+	colorKnown = false;
+	matrixModeValue = GL_MODELVIEW;
+	matrixModeKnown = false;
+	modelView.known = false;
+	modelView.saved.clear();
+	projection.known = false;
+	projection.saved.clear();
+	program = 0;
+	programKnown = false;
+	vertexArray = 0;
+	vertexArrayKnown = false;
+}
+
+void GLStateCache::beginFrame() {
+	stats.issued = 0;
+	stats.skipped = 0;
+	stats.textureBinds = 0;
+}
+
+bool GLStateCache::skip(bool unchanged) {
+	if (unchanged) {
+		stats.skipped++;
+		return true;
+	}
+	stats.issued++;
+	return false;
+}
+
+void GLStateCache::enable(GLenum cap) {
+	setCapability(cap, true);
+}
+
+void GLStateCache::disable(GLenum cap) {
+	setCapability(cap, false);
+}
+
+void GLStateCache::setCapability(GLenum cap, bool enabled) {
+	// a handful of capabilities, a linear search is the fastest
+	size_t i = 0;
+	while (i < capabilities.size() && capabilities[i].cap != cap) {
+		i++;
+	}
+	if (skip(i < capabilities.size() && capabilities[i].enabled == enabled)) {
+		return;
+	}
+	if (i == capabilities.size()) {
+		Capability capability;
+		capability.cap = cap;
+		capabilities.push_back(capability);
+	}
+	capabilities[i].enabled = enabled;
+	if (enabled) {
+		glEnable(cap);
+	}
+	else {
+		glDisable(cap);
+	}
+}
+
+void GLStateCache::polygonMode(GLenum mode) {
+	if (skip(polygonModeKnown && polygonModeValue == mode)) {
+		return;
+	}
+	polygonModeValue = mode;
+	polygonModeKnown = true;
+	glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void GLStateCache::color3f(float r, float g, float b) {
+	glm::vec3 value(r, g, b);
+	if (skip(colorKnown && color == value)) {
+		return;
+	}
+	color = value;
+	colorKnown = true;
+	glColor3f(r, g, b);
+}
+
+void GLStateCache::invalidateColor() {
+	colorKnown = false;
+}
+
+void GLStateCache::bindTexture(GLuint texture) {
+	if (skip(textureKnown && boundTexture == texture)) {
+		return;
+	}
+	boundTexture = texture;
+	textureKnown = true;
+	stats.textureBinds++;
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GLStateCache::texParameter(GLenum name, GLint value) {
+	size_t i = 0;
+	if (textureKnown) {
+		while (i < textureParameters.size() && !(textureParameters[i].texture == boundTexture && textureParameters[i].name == name)) {
+			i++;
+		}
+		if (skip(i < textureParameters.size() && textureParameters[i].value == value)) {
+			return;
+		}
+		if (i == textureParameters.size()) {
+			TextureParameter parameter;
+			parameter.texture = boundTexture;
+			parameter.name = name;
+			textureParameters.push_back(parameter);
+		}
+		textureParameters[i].value = value;
+	}
+	else {
+		stats.issued++;
+	}
+	glTexParameteri(GL_TEXTURE_2D, name, value);
+}
+
+void GLStateCache::forgetTexture(GLuint texture) {
+	for (size_t i = textureParameters.size(); i-- > 0;) {
+		if (textureParameters[i].texture == texture) {
+			textureParameters.erase(textureParameters.begin() + i);
+		}
+	}
+	// deleting the bound texture binds 0
+	if (textureKnown && boundTexture == texture) {
+		boundTexture = 0;
+	}
+}
+
+GLStateCache::MatrixStack* GLStateCache::currentStack() {
+	if (!matrixModeKnown) {
+		return NULL;
+	}
+	if (matrixModeValue == GL_MODELVIEW) {
+		return &modelView;
+	}
+	if (matrixModeValue == GL_PROJECTION) {
+		return &projection;
+	}
+	return NULL;
+}
+
+void GLStateCache::matrixMode(GLenum mode) {
+	if (skip(matrixModeKnown && matrixModeValue == mode)) {
+		return;
+	}
+	matrixModeValue = mode;
+	matrixModeKnown = true;
+	glMatrixMode(mode);
+}
+
+void GLStateCache::loadMatrix(const glm::mat4& matrix) {
+	MatrixStack* stack = currentStack();
+	if (skip(stack != NULL && stack->known && stack->top == matrix)) {
+		return;
+	}
+	if (stack != NULL) {
+		stack->top = matrix;
+		stack->known = true;
+	}
+	glLoadMatrixf(glm::value_ptr(matrix));
+}
+
+void GLStateCache::pushMatrix() {
+	stats.issued++;
+	MatrixStack* stack = currentStack();
+	if (stack != NULL) {
+		stack->saved.push_back(std::make_pair(stack->top, stack->known));
+	}
+	else {
+		// cannot tell which stack grew
+		modelView.known = projection.known = false;
+		modelView.saved.clear();
+		projection.saved.clear();
+	}
+	glPushMatrix();
+}
+
+void GLStateCache::popMatrix() {
+	stats.issued++;
+	MatrixStack* stack = currentStack();
+	if (stack != NULL && !stack->saved.empty()) {
+		stack->top = stack->saved.back().first;
+		stack->known = stack->saved.back().second;
+		stack->saved.pop_back();
+	}
+	else if (stack != NULL) {
+		stack->known = false;
+	}
+	else {
+		modelView.known = projection.known = false;
+	}
+	glPopMatrix();
+}
+
+void GLStateCache::translate(float x, float y, float z) {
+	stats.issued++;
+	MatrixStack* stack = currentStack();
+	if (stack != NULL) {
+		stack->known = false;
+	}
+	else {
+		modelView.known = projection.known = false;
+	}
+	glTranslatef(x, y, z);
+}
+
+void GLStateCache::rotate(float angle, float x, float y, float z) {
+	stats.issued++;
+	MatrixStack* stack = currentStack();
+	if (stack != NULL) {
+		stack->known = false;
+	}
+	else {
+		modelView.known = projection.known = false;
+	}
+	glRotatef(angle, x, y, z);
+}
+
+void GLStateCache::useProgram(GLuint _program) {
+	if (skip(programKnown && program == _program)) {
+		return;
+	}
+	program = _program;
+	programKnown = true;
+	glUseProgram(program);
+}
+
+void GLStateCache::bindVertexArray(GLuint _vertexArray) {
+	if (skip(vertexArrayKnown && vertexArray == _vertexArray)) {
+		return;
+	}
+	vertexArray = _vertexArray;
+	vertexArrayKnown = true;
+	glBindVertexArray(vertexArray);
+}
@@ -0,0 +1,126 @@
+/*  =================== File Information =================
+	File Name: GLStateCache.h
+	Description:
+	Author:
+
+	Purpose: Shadows the state the scene changes every frame
+			 (capabilities, the bound texture and its parameters, polygon
+			 mode, current color, the matrices, and the program and vertex
+			 array of the shader pipeline) and drops the
+			 calls that would set a value that is already set.  Every call
+			 is counted as issued or skipped.
+	Usage:	Route all changes of the shadowed state through one cache per
+			context, call reset() when the context is new and beginFrame()
+			before each frame.
+	===================================================== */
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <vector>
+#include <utility>
+#include <glm/glm.hpp>
+#include "GLExt.h"
+
+struct GLStateStats {
+	int issued;		// calls passed on to GL since beginFrame()
+	int skipped;	// calls dropped because they changed nothing
+	int textureBinds;	// glBindTexture calls among the issued ones
+};
+
+class GLStateCache {
+public:
+	GLStateCache();
+
+	/*	===============================================
+	Desc:	Forgets every shadowed value, so the next call of each kind is
+			issued.  Needed whenever the context changes or GL state was
+			changed behind the cache's back.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void reset();
+	// zeroes the counters
+	void beginFrame();
+
+	void enable(GLenum cap);
+	void disable(GLenum cap);
+	void polygonMode(GLenum mode);
+	void color3f(float r, float g, float b);
+	// after glColor calls or color arrays not made through the cache
+	void invalidateColor();
+
+	/*	===============================================
+	Desc:	Binds a texture to GL_TEXTURE_2D.  The parameters are shadowed
+			per texture, so binding a texture back does not make its
+			parameters unknown.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void bindTexture(GLuint texture);
+	void texParameter(GLenum name, GLint value);
+	// called before glDeleteTextures, the id may be handed out again
+	void forgetTexture(GLuint texture);
+
+	/*	===============================================
+	Desc:	Matrix calls.  The top of the modelview and projection stacks
+			is shadowed through push and pop; translate and rotate are
+			always issued and make the top unknown until the next
+			loadMatrix or popMatrix.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void matrixMode(GLenum mode);
+	void loadMatrix(const glm::mat4& matrix);
+	void pushMatrix();
+	void popMatrix();
+	void translate(float x, float y, float z);
+	void rotate(float angle, float x, float y, float z);
+
+	// shader pipeline objects, 0 returns to the fixed function path
+	void useProgram(GLuint program);
+	void bindVertexArray(GLuint vertexArray);
+
+	const GLStateStats& getStats() { return stats; }
+
+private:
+	struct Capability {
+		GLenum cap;
+		bool enabled;
+	};
+	struct TextureParameter {
+		GLuint texture;
+		GLenum name;
+		GLint value;
+	};
+	struct MatrixStack {
+		glm::mat4 top;
+		bool known;
+		std::vector<std::pair<glm::mat4, bool> > saved;	// by pushMatrix
+	};
+
+	// counts the call, returns true if it can be dropped
+	bool skip(bool unchanged);
+	void setCapability(GLenum cap, bool enabled);
+	MatrixStack* currentStack();
+
+	std::vector<Capability> capabilities;
+	GLuint boundTexture;
+	bool textureKnown;
+	std::vector<TextureParameter> textureParameters;
+	GLenum polygonModeValue;
+	bool polygonModeKnown;
+	glm::vec3 color;
+	bool colorKnown;
+	GLenum matrixModeValue;
+	bool matrixModeKnown;
+	MatrixStack modelView;
+	MatrixStack projection;
+	GLuint program;
+	bool programKnown;
+	GLuint vertexArray;
+	bool vertexArrayKnown;
+
+	GLStateStats stats;
+};
+
+#endif
@@ -0,0 +1,335 @@
+/*  =================== File Information =================
+	File Name: Headless.cpp
+	Description:
+	Author:
+
+	Purpose: Offscreen rendering backend for batch image generation
+	Usage:
+	===================================================== */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include "Headless.h"
+#include "SceneRenderer.h"
+#include "ppm.h"
+
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+static EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+static EGLSurface eglSurface = EGL_NO_SURFACE;
+static EGLContext eglContext = EGL_NO_CONTEXT;
+#endif
+
+bool parseHeadlessOptions(int argc, char** argv, HeadlessOptions& options) {
+	bool headless = false;
+	options.width = 800;
+	options.height = 500;
+	options.frames = 1;
+	options.cameraPath = "";
+	options.cameraSpline = "";
+	options.meshFile = "";
+	options.outputPrefix = "frame";
+	options.writeFrames = true;
+	options.shaders = false;
+	options.textureCompression = COMPRESSION_NONE;
+	options.textureResize = noResize();
+	parseResizePolicy(argc, argv, options.textureResize);
+	options.dynamicResolution = parseResolutionOptions(argc, argv, options.resolutionScaler);
+	options.capture = parseCaptureOptions(argc, argv, options.captureOptions);
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = (i + 1 < argc);
+		if (arg == "--headless") {
+			headless = true;
+		}
+		else if (arg == "--size" && hasValue) {
+			if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2) {
+				std::cout << "invalid --size, expected WIDTHxHEIGHT" << std::endl;
+			}
+		}
+		else if (arg == "--frames" && hasValue) {
+			options.frames = atoi(argv[++i]);
+		}
+		else if (arg == "--camera-path" && hasValue) {
+			options.cameraPath = argv[++i];
+		}
+		else if (arg == "--camera-spline" && hasValue) {
+			options.cameraSpline = argv[++i];
+			if (options.cameraSpline != "catmull-rom" && options.cameraSpline != "b-spline") {
+				std::cout << "invalid --camera-spline, expected catmull-rom or b-spline" << std::endl;
+				options.cameraSpline = "catmull-rom";
+			}
+		}
+		else if (arg == "--output" && hasValue) {
+			options.outputPrefix = argv[++i];
+		}
+		else if (arg == "--no-write") {
+			options.writeFrames = false;
+		}
+		else if (arg == "--mesh" && hasValue) {
+			options.meshFile = argv[++i];
+		}
+		else if (arg == "--shaders") {
+			options.shaders = true;
+		}
+		else if (arg == "--texture-compression" && hasValue) {
+			if (!parseCompressionName(argv[++i], options.textureCompression)) {
+				std::cout << "invalid --texture-compression, expected none, bc1 or bc7" << std::endl;
+			}
+		}
+	}
+
+	if (options.width <= 0 || options.height <= 0) {
+		options.width = 800;
+		options.height = 500;
+	}
+	if (options.frames < 1) {
+		options.frames = 1;
+	}
+	return headless;
+}
+
+#ifdef __linux__
+bool createOffscreenContext(int width, int height) {
+	// Prefer the surfaceless platform so no X server is needed, fall back
+	// to the default display otherwise.
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay != NULL) {
+		eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	}
+	if (eglDisplay == EGL_NO_DISPLAY) {
+		eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+	EGLint major, minor;
+	if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &major, &minor)) {
+		std::cout << "Unable to initialize EGL" << std::endl;
+		return false;
+	}
+
+	EGLint configAttribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint numConfigs = 0;
+	if (!eglChooseConfig(eglDisplay, configAttribs, &config, 1, &numConfigs) || numConfigs < 1) {
+		std::cout << "No EGL config with an RGBA8/depth24 pbuffer" << std::endl;
+		destroyOffscreenContext();
+		return false;
+	}
+
+	EGLint pbufferAttribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+	eglSurface = eglCreatePbufferSurface(eglDisplay, config, pbufferAttribs);
+	eglBindAPI(EGL_OPENGL_API);
+	eglContext = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, NULL);
+	if (eglSurface == EGL_NO_SURFACE || eglContext == EGL_NO_CONTEXT ||
+		!eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext)) {
+		std::cout << "Unable to create the offscreen GL context" << std::endl;
+		destroyOffscreenContext();
+		return false;
+	}
+
+	std::cout << "offscreen context: " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << std::endl;
+	return true;
+}
+
+void destroyOffscreenContext() {
+	if (eglDisplay == EGL_NO_DISPLAY) {
+		return;
+	}
+	eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (eglContext != EGL_NO_CONTEXT) {
+		eglDestroyContext(eglDisplay, eglContext);
+	}
+	if (eglSurface != EGL_NO_SURFACE) {
+		eglDestroySurface(eglDisplay, eglSurface);
+	}
+	eglTerminate(eglDisplay);
+	eglDisplay = EGL_NO_DISPLAY;
+	eglSurface = EGL_NO_SURFACE;
+	eglContext = EGL_NO_CONTEXT;
+}
+#else
+bool createOffscreenContext(int width, int height) {
+	std::cout << "Headless rendering is only supported on Linux (EGL)" << std::endl;
+	return false;
+}
+
+void destroyOffscreenContext() {
+}
+#endif
+
+/*	Reads one eye position per line, ignoring empty lines and lines
+	starting with '#'.
+*/
+static std::vector<glm::vec3> loadCameraPath(std::string fileName) {
+	std::vector<glm::vec3> points;
+	std::ifstream pathFile(fileName.c_str());
+	if (!pathFile.is_open()) {
+		std::cout << "Unable to open camera path: " << fileName << std::endl;
+		return points;
+	}
+	std::string line;
+	while (getline(pathFile, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		std::istringstream stream(line);
+		glm::vec3 p;
+		if (stream >> p.x >> p.y >> p.z) {
+			points.push_back(p);
+		}
+	}
+	return points;
+}
+
+static glm::vec3 evaluateCameraPath(const std::vector<glm::vec3>& points, int frame, int frames) {
+	if (points.size() == 1 || frames <= 1) {
+		return points[0];
+	}
+	float s = (float)frame / (float)(frames - 1) * (float)(points.size() - 1);
+	int i = (int)s;
+	if (i >= (int)points.size() - 1) {
+		return points.back();
+	}
+	float f = s - (float)i;
+	return points[i] * (1.0f - f) + points[i + 1] * f;
+}
+
+/*	OpenGL returns the rows bottom up, ppm stores them top down */
+static void readFrame(ppm& image) {
+	int width = image.getWidth();
+	int height = image.getHeight();
+	char* pixels = image.getPixels();
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+	std::vector<char> row(width * 3);
+	for (int y = 0; y < height / 2; y++) {
+		char* top = pixels + y * width * 3;
+		char* bottom = pixels + (height - 1 - y) * width * 3;
+		memcpy(&row[0], top, width * 3);
+		memcpy(top, bottom, width * 3);
+		memcpy(bottom, &row[0], width * 3);
+	}
+}
+
+int runHeadless(const HeadlessOptions& options) {
+	typedef std::chrono::steady_clock Clock;
+	std::vector<glm::vec3> cameraPath;
+	if (!options.cameraPath.empty()) {
+		cameraPath = loadCameraPath(options.cameraPath);
+		if (cameraPath.empty()) {
+			return 1;
+		}
+	}
+
+	if (!createOffscreenContext(options.width, options.height)) {
+		return 1;
+	}
+
+	// The renderer owns GL objects, so it has to go away before the context
+	SceneRenderer* renderer = new SceneRenderer();
+	renderer->meshFile = options.meshFile;
+	renderer->textureManager.setResize(options.textureResize);
+	renderer->initGL(options.width, options.height);
+	renderer->shaderPipeline = options.shaders;
+	renderer->textureManager.setCompression(options.textureCompression);
+	renderer->dynamicResolution = options.dynamicResolution;
+	renderer->resolutionScaler = options.resolutionScaler;
+
+	// every pose of the fly-through is generated up front
+	std::vector<CameraPose> poses;
+	if (!options.cameraSpline.empty()) {
+		Clock::time_point start = Clock::now();
+		SplineType type = (options.cameraSpline == "b-spline") ? SPLINE_B_SPLINE : SPLINE_CATMULL_ROM;
+		if (cameraPath.empty()) {
+			std::vector<glm::vec3> loop = renderer->cameraSpline.getControlPoints();
+			renderer->cameraSpline.setControlPoints(loop, type, true);
+		}
+		else {
+			renderer->cameraSpline.setControlPoints(cameraPath, type, false);
+		}
+		CameraSpline& spline = renderer->cameraSpline;
+		int steps = spline.isClosed() ? options.frames : std::max(1, options.frames - 1);
+		spline.samplePoses(0, spline.getLength() / steps, options.frames, poses);
+		printf("camera spline: %d poses over a length of %.2f in %.3f ms\n", options.frames, spline.getLength(),
+			1000.0 * std::chrono::duration<double>(Clock::now() - start).count());
+	}
+	ppm frameImage(options.width, options.height);
+	FrameCapture capture;
+	if (options.capture && !capture.start(options.captureOptions, options.width, options.height)) {
+		delete renderer;
+		destroyOffscreenContext();
+		return 1;
+	}
+
+	double renderSeconds = 0;
+	double totalSeconds = 0;
+	char fileName[512];
+
+	for (int frame = 0; frame < options.frames; frame++) {
+		Clock::time_point start = Clock::now();
+		if (!poses.empty()) {
+			renderer->eyePosition = poses[frame].position;
+			renderer->lookVector = poses[frame].look;
+		}
+		else if (!cameraPath.empty()) {
+			renderer->eyePosition = evaluateCameraPath(cameraPath, frame, options.frames);
+		}
+		renderer->drawFrame(false, 0, 0);
+		if (options.capture) {
+			capture.captureFrame(options.width, options.height);
+		}
+		else {
+			glFinish();
+		}
+		Clock::time_point rendered = Clock::now();
+
+		if (options.writeFrames && !options.capture) {
+			readFrame(frameImage);
+			snprintf(fileName, sizeof(fileName), "%s_%04d.ppm", options.outputPrefix.c_str(), frame);
+			frameImage.save(fileName);
+		}
+		Clock::time_point done = Clock::now();
+
+		renderSeconds += std::chrono::duration<double>(rendered - start).count();
+		totalSeconds += std::chrono::duration<double>(done - start).count();
+	}
+
+	capture.stop();
+
+	printf("headless: %d frames at %dx%d, render %.3f ms/frame (%.1f fps), with readback and output %.1f fps\n",
+		options.frames, options.width, options.height,
+		1000.0 * renderSeconds / options.frames, options.frames / renderSeconds,
+		options.frames / totalSeconds);
+	if (options.textureCompression != COMPRESSION_NONE) {
+		renderer->textureManager.printStats();
+	}
+	if (renderer->dynamicResolution) {
+		const ResolutionScalerStats& scalerStats = renderer->resolutionScaler.getStats();
+		printf("dynamic resolution: last frame %dx%d (scale %.2f), %d increases, %d decreases (%d taken back)\n",
+			renderer->getFrameWidth(), renderer->getFrameHeight(), renderer->resolutionScaler.getScale(),
+			scalerStats.increases, scalerStats.decreases, scalerStats.reverts);
+	}
+
+	delete renderer;
+	destroyOffscreenContext();
+	return 0;
+}
@@ -0,0 +1,76 @@
+/*  =================== File Information =================
+	File Name: Headless.h
+	Description:
+	Author:
+
+	Purpose: Renders the scene without a window, through an offscreen
+			 software OpenGL context (EGL pbuffer, e.g. Mesa llvmpipe),
+			 and writes the frames as ppm images.
+	Usage:	ComputerGraphics --headless [--size 800x500] [--frames 100]
+				[--camera-path path.txt] [--camera-spline catmull-rom|b-spline]
+				[--output frame] [--no-write]
+				[--mesh model.ply] [--shaders] [--texture-compression bc1|bc7]
+				[--resize-textures pot|WxH] [--max-texture-size N]
+				[--resample-filter box|bilinear|lanczos3]
+				[--dynamic-resolution] [--resolution-scale 0.5,1.0]
+				[--target-frame-ms 16.7]
+				[--capture ... see FrameCapture.h]
+
+			The camera path file lists one eye position "x y z" per line.
+			The eye is moved linearly through these points over the frames.
+			With --camera-spline the points are the control points of a
+			spline instead, travelled at constant speed while looking
+			along it.  Without a path file the viewer's loop around the
+			scene is flown.
+	===================================================== */
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <string>
+#include "FrameCapture.h"
+#include "TextureCompression.h"
+#include "Resample.h"
+#include "ResolutionScaler.h"
+
+struct HeadlessOptions {
+	int width;
+	int height;
+	int frames;
+	std::string cameraPath;		// empty keeps the default eye position
+	std::string cameraSpline;	// spline type, empty for the linear path
+	std::string meshFile;		// optional .ply/.obj model drawn next to the sphere
+	std::string outputPrefix;	// frames are written to <prefix>_0000.ppm, ...
+	bool writeFrames;
+	bool shaders;				// SceneRenderer::shaderPipeline
+	TextureCompression textureCompression;
+	ResizePolicy textureResize;	// see TextureManager::setResize
+	bool dynamicResolution;		// SceneRenderer::dynamicResolution
+	ResolutionScaler resolutionScaler;
+	bool capture;				// use the asynchronous frame capture instead of --output
+	CaptureOptions captureOptions;
+};
+
+/*	===============================================
+Desc:	Parses the command line.  Returns true if --headless was given, in
+		which case options holds the requested settings.
+Precondition:
+Postcondition:
+=============================================== */
+bool parseHeadlessOptions(int argc, char** argv, HeadlessOptions& options);
+/*	===============================================
+Desc:	Creates an offscreen OpenGL context with a width x height color and
+		depth buffer and makes it current.
+Precondition:	No other offscreen context is active.
+Postcondition:	Returns false if no context could be created.
+=============================================== */
+bool createOffscreenContext(int width, int height);
+void destroyOffscreenContext();
+/*	===============================================
+Desc:	Creates the offscreen context, renders the requested frames and
+		prints the frame rate.  Returns the process exit code.
+Precondition:
+Postcondition:
+=============================================== */
+int runHeadless(const HeadlessOptions& options);
+
+#endif
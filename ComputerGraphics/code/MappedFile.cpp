@@ -0,0 +1,118 @@
+/*  =================== File Information =================
+	File Name: MappedFile.cpp
+	Description:
+	Author:
+
+	Purpose: Memory mapped file input
+	Usage:
+	===================================================== */
+
+#include <iostream>
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() {
+	mapped = NULL;
+	length = 0;
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = NULL;
+#endif
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(std::string fileName) {
+	close();
+	fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		std::cout << "Unable to open file: " << fileName << std::endl;
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(fileHandle, &fileSize);
+	length = (size_t)fileSize.QuadPart;
+	if (length == 0) {
+		return true;
+	}
+	mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle != NULL) {
+		mapped = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	}
+	if (mapped == NULL) {
+		std::cout << "Unable to map file: " << fileName << std::endl;
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close() {
+	if (mapped != NULL) {
+		UnmapViewOfFile(mapped);
+	}
+	if (mappingHandle != NULL) {
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle != INVALID_HANDLE_VALUE) {
+		CloseHandle(fileHandle);
+	}
+	mapped = NULL;
+	length = 0;
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = NULL;
+}
+
+#else
+
+bool MappedFile::open(std::string fileName) {
+	close();
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::cout << "Unable to open file: " << fileName << std::endl;
+		return false;
+	}
+	struct stat status;
+	if (fstat(fd, &status) != 0) {
+		::close(fd);
+		return false;
+	}
+	length = (size_t)status.st_size;
+	if (length > 0) {
+		void* address = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (address == MAP_FAILED) {
+			std::cout << "Unable to map file: " << fileName << std::endl;
+			length = 0;
+			::close(fd);
+			return false;
+		}
+		// the file is read front to back exactly once
+		madvise(address, length, MADV_SEQUENTIAL);
+		mapped = (const char*)address;
+	}
+	// the mapping stays valid without the descriptor
+	::close(fd);
+	return true;
+}
+
+void MappedFile::close() {
+	if (mapped != NULL) {
+		munmap((void*)mapped, length);
+	}
+	mapped = NULL;
+	length = 0;
+}
+
+#endif
@@ -0,0 +1,48 @@
+/*  =================== File Information =================
+	File Name: MappedFile.h
+	Description:
+	Author:
+
+	Purpose: Read only view of a whole file through the virtual memory
+			 system (mmap / CreateFileMapping), so large files are parsed
+			 in place without being copied into a buffer first.
+	Usage:	MappedFile file;
+			if (file.open("model.ply")) { parse(file.data(), file.size()); }
+	===================================================== */
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+
+	/*	===============================================
+	Desc:	Maps the file, closing any file mapped before
+	Precondition:
+	Postcondition:	Returns false if the file could not be opened.  An
+					empty file opens successfully with data() == NULL.
+	=============================================== */
+	bool open(std::string fileName);
+	void close();
+
+	const char* data() { return mapped; }
+	size_t size() { return length; }
+
+private:
+	// no copies, the destructor unmaps
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	const char* mapped;
+	size_t length;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+};
+
+#endif
@@ -0,0 +1,333 @@
+/*  =================== File Information =================
+	File Name: MeshBVH.cpp
+	Description:
+	Author:
+
+	Purpose: Binned SAH bounding volume hierarchy for triangle meshes
+	Usage:
+	===================================================== */
+
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include "MeshBVH.h"
+
+struct MeshBVH::BuildState {
+	const glm::vec3* positions;
+	const unsigned int* indices;
+	std::vector<glm::vec3> centroids;
+	std::vector<glm::vec3> lowers;		// per triangle bounds
+	std::vector<glm::vec3> uppers;
+	std::atomic<unsigned int> nodeCount;
+	int parallelDepth;					// levels whose children are built on a new thread
+};
+
+/*	Half the surface area of a box, the SAH only compares ratios */
+static float halfArea(const glm::vec3& lower, const glm::vec3& upper) {
+	glm::vec3 e = glm::max(upper - lower, glm::vec3(0, 0, 0));
+	return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+MeshBVH::MeshBVH() {
+	mesh = NULL;
+	buildSeconds = 0;
+}
+
+void MeshBVH::build(const TriangleMesh& _mesh, int threads) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	mesh = &_mesh;
+	int count = mesh->triangleCount();
+	nodes.clear();
+	triangles.resize(count);
+	if (count == 0) {
+		return;
+	}
+	if (threads <= 0) {
+		threads = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+
+	BuildState state;
+	state.positions = mesh->positions.data();
+	state.indices = mesh->indices.data();
+	state.centroids.resize(count);
+	state.lowers.resize(count);
+	state.uppers.resize(count);
+	state.nodeCount = 1;
+	state.parallelDepth = 0;
+	while ((1 << state.parallelDepth) < threads) {
+		state.parallelDepth++;
+	}
+	for (int i = 0; i < count; i++) {
+		const glm::vec3& p0 = state.positions[state.indices[3 * i]];
+		const glm::vec3& p1 = state.positions[state.indices[3 * i + 1]];
+		const glm::vec3& p2 = state.positions[state.indices[3 * i + 2]];
+		state.lowers[i] = glm::min(p0, glm::min(p1, p2));
+		state.uppers[i] = glm::max(p0, glm::max(p1, p2));
+		state.centroids[i] = 0.5f * (state.lowers[i] + state.uppers[i]);
+		triangles[i] = i;
+	}
+
+	// a binary tree over n leaves of at least one triangle has < 2n nodes
+	nodes.resize(2 * count);
+	buildNode(state, 0, 0, count, 0);
+	nodes.resize(state.nodeCount);
+	buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void MeshBVH::buildNode(BuildState& state, unsigned int nodeIndex, unsigned int first, unsigned int count, int depth) {
+	glm::vec3 lower = state.lowers[triangles[first]];
+	glm::vec3 upper = state.uppers[triangles[first]];
+	glm::vec3 centroidLower = state.centroids[triangles[first]];
+	glm::vec3 centroidUpper = centroidLower;
+	for (unsigned int i = first + 1; i < first + count; i++) {
+		unsigned int t = triangles[i];
+		lower = glm::min(lower, state.lowers[t]);
+		upper = glm::max(upper, state.uppers[t]);
+		centroidLower = glm::min(centroidLower, state.centroids[t]);
+		centroidUpper = glm::max(centroidUpper, state.centroids[t]);
+	}
+	BVHNode& node = nodes[nodeIndex];
+	for (int k = 0; k < 3; k++) {
+		node.lower[k] = lower[k];
+		node.upper[k] = upper[k];
+	}
+	node.leftOrFirst = first;
+	node.count = count;
+	// deeper trees would overflow the traversal stack
+	if (count <= BVH_MAX_LEAF_SIZE || depth >= BVH_STACK_SIZE - 2) {
+		return;
+	}
+
+	// bin the centroids along all three axes in one pass over the triangles
+	glm::vec3 binLower[3][BVH_BINS];
+	glm::vec3 binUpper[3][BVH_BINS];
+	int binCount[3][BVH_BINS];
+	glm::vec3 scale(0, 0, 0);
+	for (int axis = 0; axis < 3; axis++) {
+		float extent = centroidUpper[axis] - centroidLower[axis];
+		if (extent > 0.0f) {
+			scale[axis] = BVH_BINS / extent;
+		}
+		for (int b = 0; b < BVH_BINS; b++) {
+			binLower[axis][b] = glm::vec3(INFINITY, INFINITY, INFINITY);
+			binUpper[axis][b] = glm::vec3(-INFINITY, -INFINITY, -INFINITY);
+			binCount[axis][b] = 0;
+		}
+	}
+	for (unsigned int i = first; i < first + count; i++) {
+		unsigned int t = triangles[i];
+		const glm::vec3& triangleLower = state.lowers[t];
+		const glm::vec3& triangleUpper = state.uppers[t];
+		for (int axis = 0; axis < 3; axis++) {
+			int b = std::min(BVH_BINS - 1, (int)((state.centroids[t][axis] - centroidLower[axis]) * scale[axis]));
+			binCount[axis][b]++;
+			binLower[axis][b] = glm::min(binLower[axis][b], triangleLower);
+			binUpper[axis][b] = glm::max(binUpper[axis][b], triangleUpper);
+		}
+	}
+
+	// sweep the bins of every axis for the cheapest split plane
+	float bestCost = INFINITY;
+	int bestAxis = -1;
+	int bestSplit = 0;
+	for (int axis = 0; axis < 3; axis++) {
+		if (scale[axis] == 0.0f) {
+			continue;
+		}
+		// area * count of everything left of each plane, then right of it
+		float leftCost[BVH_BINS - 1];
+		glm::vec3 l(INFINITY, INFINITY, INFINITY);
+		glm::vec3 u(-INFINITY, -INFINITY, -INFINITY);
+		int n = 0;
+		for (int b = 0; b < BVH_BINS - 1; b++) {
+			n += binCount[axis][b];
+			l = glm::min(l, binLower[axis][b]);
+			u = glm::max(u, binUpper[axis][b]);
+			leftCost[b] = (n > 0) ? n * halfArea(l, u) : 0.0f;
+		}
+		l = glm::vec3(INFINITY, INFINITY, INFINITY);
+		u = glm::vec3(-INFINITY, -INFINITY, -INFINITY);
+		n = 0;
+		for (int b = BVH_BINS - 1; b > 0; b--) {
+			n += binCount[axis][b];
+			l = glm::min(l, binLower[axis][b]);
+			u = glm::max(u, binUpper[axis][b]);
+			float cost = leftCost[b - 1] + ((n > 0) ? n * halfArea(l, u) : 0.0f);
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = b;
+			}
+		}
+	}
+	// stop when splitting does not beat testing every triangle here
+	float leafCost = count * halfArea(lower, upper);
+	if (bestAxis < 0 || bestCost >= leafCost) {
+		return;
+	}
+
+	float splitScale = scale[bestAxis];
+	float origin = centroidLower[bestAxis];
+	const glm::vec3* centroids = state.centroids.data();
+	unsigned int* middle = std::partition(&triangles[first], &triangles[first] + count, [&](unsigned int t) {
+		return std::min(BVH_BINS - 1, (int)((centroids[t][bestAxis] - origin) * splitScale)) < bestSplit;
+	});
+	unsigned int leftCount = (unsigned int)(middle - &triangles[first]);
+	if (leftCount == 0 || leftCount == count) {
+		return;
+	}
+
+	unsigned int left = state.nodeCount.fetch_add(2);
+	node.leftOrFirst = left;
+	node.count = 0;
+	if (depth < state.parallelDepth && count >= BVH_PARALLEL_MIN_TRIANGLES) {
+		std::thread worker(&MeshBVH::buildNode, this, std::ref(state), left, first, leftCount, depth + 1);
+		buildNode(state, left + 1, first + leftCount, count - leftCount, depth + 1);
+		worker.join();
+	}
+	else {
+		buildNode(state, left, first, leftCount, depth + 1);
+		buildNode(state, left + 1, first + leftCount, count - leftCount, depth + 1);
+	}
+}
+
+/*	Entry distance of the ray into the node's box, INFINITY for a miss or
+	a box farther away than tMax
+*/
+static inline float enterBox(const BVHNode& node, const glm::vec3& origin, const glm::vec3& inverseDir, float tMax) {
+	float tx0 = (node.lower[0] - origin.x) * inverseDir.x;
+	float tx1 = (node.upper[0] - origin.x) * inverseDir.x;
+	float ty0 = (node.lower[1] - origin.y) * inverseDir.y;
+	float ty1 = (node.upper[1] - origin.y) * inverseDir.y;
+	float tz0 = (node.lower[2] - origin.z) * inverseDir.z;
+	float tz1 = (node.upper[2] - origin.z) * inverseDir.z;
+	float tEnter = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0f));
+	float tExit = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::min(std::max(tz0, tz1), tMax));
+	return (tEnter <= tExit) ? tEnter : INFINITY;
+}
+
+bool MeshBVH::intersect(const glm::vec3& origin, const glm::vec3& dir, MeshHit& hit) const {
+	if (nodes.empty()) {
+		return false;
+	}
+	glm::vec3 inverseDir(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+
+	// watertight test setup: shear the ray onto the +z axis of its largest component
+	int kz = 0;
+	if (fabs(dir.y) > fabs(dir[kz])) kz = 1;
+	if (fabs(dir.z) > fabs(dir[kz])) kz = 2;
+	int kx = (kz + 1) % 3;
+	int ky = (kx + 1) % 3;
+	if (dir[kz] < 0.0f) {
+		std::swap(kx, ky);
+	}
+	float sx = dir[kx] / dir[kz];
+	float sy = dir[ky] / dir[kz];
+	float sz = 1.0f / dir[kz];
+
+	const glm::vec3* positions = mesh->positions.data();
+	const unsigned int* indices = mesh->indices.data();
+	float tBest = INFINITY;
+	int bestTriangle = -1;
+	float bestU = 0;
+	float bestV = 0;
+
+	unsigned int stack[BVH_STACK_SIZE];
+	float stackEnter[BVH_STACK_SIZE];
+	int stackSize = 0;
+	if (enterBox(nodes[0], origin, inverseDir, tBest) == INFINITY) {
+		return false;
+	}
+	unsigned int nodeIndex = 0;
+	while (true) {
+		const BVHNode& node = nodes[nodeIndex];
+		if (node.count > 0) {
+			for (unsigned int i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++) {
+				unsigned int triangle = triangles[i];
+				glm::vec3 a = positions[indices[3 * triangle]] - origin;
+				glm::vec3 b = positions[indices[3 * triangle + 1]] - origin;
+				glm::vec3 c = positions[indices[3 * triangle + 2]] - origin;
+				float ax = a[kx] - sx * a[kz];
+				float ay = a[ky] - sy * a[kz];
+				float bx = b[kx] - sx * b[kz];
+				float by = b[ky] - sy * b[kz];
+				float cx = c[kx] - sx * c[kz];
+				float cy = c[ky] - sy * c[kz];
+				float u = cx * by - cy * bx;
+				float v = ax * cy - ay * cx;
+				float w = bx * ay - by * ax;
+				if (u == 0.0f || v == 0.0f || w == 0.0f) {
+					// exactly on an edge in float, decide it in double
+					u = (float)((double)cx * by - (double)cy * bx);
+					v = (float)((double)ax * cy - (double)ay * cx);
+					w = (float)((double)bx * ay - (double)by * ax);
+				}
+				// both windings count
+				if ((u < 0.0f || v < 0.0f || w < 0.0f) && (u > 0.0f || v > 0.0f || w > 0.0f)) {
+					continue;
+				}
+				float determinant = u + v + w;
+				if (determinant == 0.0f) {
+					continue;
+				}
+				float t = (u * sz * a[kz] + v * sz * b[kz] + w * sz * c[kz]) / determinant;
+				if (t > RAY_EPSILON && t < tBest) {
+					tBest = t;
+					bestTriangle = (int)triangle;
+					bestU = v / determinant;
+					bestV = w / determinant;
+				}
+			}
+		}
+		else {
+			// descend into the nearer child, the other one waits on the stack
+			unsigned int nearChild = node.leftOrFirst;
+			unsigned int farChild = nearChild + 1;
+			float nearEnter = enterBox(nodes[nearChild], origin, inverseDir, tBest);
+			float farEnter = enterBox(nodes[farChild], origin, inverseDir, tBest);
+			if (farEnter < nearEnter) {
+				std::swap(nearChild, farChild);
+				std::swap(nearEnter, farEnter);
+			}
+			if (nearEnter != INFINITY) {
+				if (farEnter != INFINITY) {
+					stack[stackSize] = farChild;
+					stackEnter[stackSize] = farEnter;
+					stackSize++;
+				}
+				nodeIndex = nearChild;
+				continue;
+			}
+		}
+		// next node on the stack that can still hold a nearer hit
+		while (stackSize > 0 && stackEnter[stackSize - 1] >= tBest) {
+			stackSize--;
+		}
+		if (stackSize == 0) {
+			break;
+		}
+		nodeIndex = stack[--stackSize];
+	}
+
+	if (bestTriangle < 0) {
+		return false;
+	}
+	hit.t = tBest;
+	hit.triangle = bestTriangle;
+	hit.u = bestU;
+	hit.v = bestV;
+	return true;
+}
+
+bool MeshBVH::intersect(const glm::vec3& origin, const glm::vec3& dir, RayHit& hit) const {
+	MeshHit meshHit;
+	if (!intersect(origin, dir, meshHit)) {
+		return false;
+	}
+	hit.t = meshHit.t;
+	mesh->fillHit(meshHit.triangle, meshHit.u, meshHit.v, dir, hit);
+	return true;
+}
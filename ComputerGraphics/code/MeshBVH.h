@@ -0,0 +1,87 @@
+/*  =================== File Information =================
+	File Name: MeshBVH.h
+	Description:
+	Author:
+
+	Purpose: Bounding volume hierarchy over the triangles of one mesh, so
+			 a ray only tests the handful of triangles near its path.
+			 Built top down with the binned surface area heuristic, the
+			 upper levels in parallel.  Nodes are 32 bytes (two per cache
+			 line) and are traversed with an explicit stack; triangles
+			 are tested with the watertight algorithm of Woop, Benthin
+			 and Wald (2013), so rays never slip through shared edges.
+	Usage:	MeshBVH bvh;
+			bvh.build(mesh);
+			MeshHit hit;
+			if (bvh.intersect(origin, dir, hit)) { ... hit.triangle ... }
+	===================================================== */
+#ifndef MESH_BVH_H
+#define MESH_BVH_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "Primitives.h"
+
+#define BVH_BINS 16				// SAH candidates per axis
+#define BVH_MAX_LEAF_SIZE 4
+#define BVH_STACK_SIZE 64
+#define BVH_PARALLEL_MIN_TRIANGLES 16384	// smaller subtrees are built by the thread that reached them
+
+/*
+	Leaves hold count triangles starting at leftOrFirst in the triangle
+	order of the tree, interior nodes (count == 0) have their two children
+	at leftOrFirst and leftOrFirst + 1.
+*/
+struct BVHNode {
+	float lower[3];
+	float upper[3];
+	unsigned int leftOrFirst;
+	unsigned int count;
+};
+
+struct MeshHit {
+	float t;
+	int triangle;	// index into the mesh's triangles
+	float u;		// barycentrics: point = (1 - u - v) p0 + u p1 + v p2
+	float v;
+};
+
+class MeshBVH {
+public:
+	MeshBVH();
+
+	/*	===============================================
+	Desc:	Builds the tree.  threads <= 0 uses every hardware thread.
+	Precondition:	mesh outlives the tree and does not change.
+	Postcondition:
+	=============================================== */
+	void build(const TriangleMesh& mesh, int threads = 0);
+	/*	===============================================
+	Desc:	Finds the nearest triangle hit by the ray in object space
+	Precondition:	build() was called.
+	Postcondition:	Returns false for a miss.
+	=============================================== */
+	bool intersect(const glm::vec3& origin, const glm::vec3& dir, MeshHit& hit) const;
+	/*	===============================================
+	Desc:	Same, reporting the face normal and texture coordinate, so the
+			tree can be used as a shape with intersectShape (Primitives.h)
+	Precondition:
+	Postcondition:
+	=============================================== */
+	bool intersect(const glm::vec3& origin, const glm::vec3& dir, RayHit& hit) const;
+
+	const TriangleMesh* getMesh() const { return mesh; }
+	int getNodeCount() const { return (int)nodes.size(); }
+	double getBuildSeconds() const { return buildSeconds; }
+
+private:
+	struct BuildState;
+	void buildNode(BuildState& state, unsigned int nodeIndex, unsigned int first, unsigned int count, int depth);
+
+	const TriangleMesh* mesh;
+	std::vector<BVHNode> nodes;
+	std::vector<unsigned int> triangles;	// triangle indices in leaf order
+	double buildSeconds;
+};
+
+#endif
@@ -0,0 +1,129 @@
+/*  =================== File Information =================
+	File Name: MeshBuffer.cpp
+	Description:
+	Author:
+
+	Purpose: Vertex and index buffers of a triangle mesh
+	Usage:
+	===================================================== */
+
+#include <vector>
+#include "MeshBuffer.h"
+#include "ShaderPipeline.h"
+
+// position (3), normal (3), texture coordinate (2)
+#define MESH_VERTEX_FLOATS 8
+
+MeshBuffer::MeshBuffer() {
+	vertexBuffer = 0;
+	indexBuffer = 0;
+	vertexArray = 0;
+	indexCount = 0;
+	uploadBytes = 0;
+}
+
+MeshBuffer::~MeshBuffer() {
+	release();
+}
+
+void MeshBuffer::upload(const TriangleMesh& mesh) {
+	release();
+	if (mesh.indices.empty()) {
+		return;
+	}
+	bool hasNormals = mesh.normals.size() == mesh.positions.size();
+	bool hasUVs = mesh.uvs.size() == mesh.positions.size();
+	std::vector<float> vertices(mesh.positions.size() * MESH_VERTEX_FLOATS, 0.0f);
+	for (size_t i = 0; i < mesh.positions.size(); i++) {
+		float* vertex = &vertices[i * MESH_VERTEX_FLOATS];
+		vertex[0] = mesh.positions[i].x;
+		vertex[1] = mesh.positions[i].y;
+		vertex[2] = mesh.positions[i].z;
+		if (hasNormals) {
+			vertex[3] = mesh.normals[i].x;
+			vertex[4] = mesh.normals[i].y;
+			vertex[5] = mesh.normals[i].z;
+		}
+		if (hasUVs) {
+			vertex[6] = mesh.uvs[i].x;
+			vertex[7] = mesh.uvs[i].y;
+		}
+	}
+
+	glGenBuffers(1, &vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glGenBuffers(1, &indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	indexCount = (int)mesh.indices.size();
+	uploadBytes = vertices.size() * sizeof(float) + mesh.indices.size() * sizeof(unsigned int);
+}
+
+void MeshBuffer::draw() {
+	if (indexCount == 0) {
+		return;
+	}
+	GLsizei stride = MESH_VERTEX_FLOATS * sizeof(float);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	// with a buffer bound the pointers are byte offsets into it
+	glVertexPointer(3, GL_FLOAT, stride, (const void*)0);
+	glNormalPointer(GL_FLOAT, stride, (const void*)(3 * sizeof(float)));
+	glTexCoordPointer(2, GL_FLOAT, stride, (const void*)(6 * sizeof(float)));
+
+	glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (const void*)0);
+
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MeshBuffer::drawAttributes(GLStateCache& state) {
+	if (indexCount == 0) {
+		return;
+	}
+	if (vertexArray == 0) {
+		GLsizei stride = MESH_VERTEX_FLOATS * sizeof(float);
+		glGenVertexArrays(1, &vertexArray);
+		state.bindVertexArray(vertexArray);
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glVertexAttribPointer(ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, stride, (const void*)0);
+		glVertexAttribPointer(ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, stride, (const void*)(3 * sizeof(float)));
+		glVertexAttribPointer(ATTRIBUTE_TEXCOORD, 2, GL_FLOAT, GL_FALSE, stride, (const void*)(6 * sizeof(float)));
+		glEnableVertexAttribArray(ATTRIBUTE_POSITION);
+		glEnableVertexAttribArray(ATTRIBUTE_NORMAL);
+		glEnableVertexAttribArray(ATTRIBUTE_TEXCOORD);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		// the index buffer binding is part of the vertex array
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	}
+	state.bindVertexArray(vertexArray);
+	glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (const void*)0);
+}
+
+void MeshBuffer::release() {
+	if (vertexArray != 0) {
+		glDeleteVertexArrays(1, &vertexArray);
+	}
+	vertexArray = 0;
+	if (vertexBuffer != 0) {
+		glDeleteBuffers(1, &vertexBuffer);
+	}
+	if (indexBuffer != 0) {
+		glDeleteBuffers(1, &indexBuffer);
+	}
+	vertexBuffer = 0;
+	indexBuffer = 0;
+	indexCount = 0;
+	uploadBytes = 0;
+}
@@ -0,0 +1,56 @@
+/*  =================== File Information =================
+	File Name: MeshBuffer.h
+	Description:
+	Author:
+
+	Purpose: A triangle mesh stored on the GPU: one vertex buffer with
+			 interleaved position, normal and texture coordinate, and one
+			 index buffer, drawn with a single glDrawElements call.
+	Usage:	upload() once the GL context exists, draw() every frame.
+	===================================================== */
+#ifndef MESH_BUFFER_H
+#define MESH_BUFFER_H
+
+#include "GLExt.h"
+#include "Primitives.h"
+#include "GLStateCache.h"
+
+class MeshBuffer {
+public:
+	MeshBuffer();
+	/*	===============================================
+	Desc:	Deletes the buffers
+	Precondition:	The GL context that uploaded them is current.
+	Postcondition:
+	=============================================== */
+	~MeshBuffer();
+
+	/*	===============================================
+	Desc:	Copies the mesh into GL buffers, replacing any earlier upload.
+			Missing normals or uvs are sent as zeros.
+	Precondition:	A GL context is current.
+	Postcondition:
+	=============================================== */
+	void upload(const TriangleMesh& mesh);
+	void draw();
+	/*	===============================================
+	Desc:	Draws through generic vertex attributes for the shader
+			pipeline, from a vertex array created on the first call
+	Precondition:	A program is current.
+	Postcondition:	The mesh's vertex array stays bound.
+	=============================================== */
+	void drawAttributes(GLStateCache& state);
+	void release();
+
+	bool isLoaded() { return indexCount > 0; }
+	size_t getUploadBytes() { return uploadBytes; }
+
+private:
+	GLuint vertexBuffer;
+	GLuint indexBuffer;
+	GLuint vertexArray;
+	int indexCount;
+	size_t uploadBytes;
+};
+
+#endif
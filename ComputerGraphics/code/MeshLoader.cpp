@@ -0,0 +1,870 @@
+/*  =================== File Information =================
+	File Name: MeshLoader.cpp
+	Description:
+	Author:
+
+	Purpose: PLY / OBJ mesh loading
+	Usage:
+	===================================================== */
+
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <cstring>
+#include <cctype>
+#include <cstdint>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include "MeshLoader.h"
+#include "MappedFile.h"
+
+/*	Splits [0, count) into one contiguous range per thread and runs
+	body(begin, end) on each
+*/
+template <class Body>
+static void parallelFor(int count, int threads, Body body) {
+	if (threads <= 1 || count < 2 * threads) {
+		body(0, count);
+		return;
+	}
+	std::vector<std::thread> workers;
+	int chunk = (count + threads - 1) / threads;
+	for (int begin = chunk; begin < count; begin += chunk) {
+		workers.push_back(std::thread(body, begin, std::min(begin + chunk, count)));
+	}
+	body(0, std::min(chunk, count));
+	for (size_t i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+}
+
+/*
+	Cursor over the mapped file.  The text parsers never read past end,
+	since the mapping is not null terminated.
+*/
+struct Reader {
+	const char* p;
+	const char* end;
+	bool error;
+
+	Reader(const char* _p, const char* _end) : p(_p), end(_end), error(false) {}
+
+	bool atEnd() { return p >= end; }
+	void skipSpaces() {
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+			p++;
+		}
+	}
+	void skipWhitespace() {
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+			p++;
+		}
+	}
+	void skipLine() {
+		while (p < end && *p != '\n') {
+			p++;
+		}
+		if (p < end) {
+			p++;
+		}
+	}
+	bool atLineEnd() {
+		skipSpaces();
+		return p >= end || *p == '\n' || *p == '#';
+	}
+	long parseInt() {
+		skipSpaces();
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = (*p == '-');
+			p++;
+		}
+		if (p >= end || *p < '0' || *p > '9') {
+			error = true;
+			return 0;
+		}
+		long value = 0;
+		while (p < end && *p >= '0' && *p <= '9') {
+			value = value * 10 + (*p - '0');
+			p++;
+		}
+		return negative ? -value : value;
+	}
+	double parseDouble() {
+		skipSpaces();
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = (*p == '-');
+			p++;
+		}
+		// up to 18 significant digits are kept exactly, the rest only scale
+		uint64_t mantissa = 0;
+		int digits = 0;
+		int exponent = 0;
+		bool any = false;
+		while (p < end && *p >= '0' && *p <= '9') {
+			if (digits < 18) {
+				mantissa = mantissa * 10 + (*p - '0');
+				if (mantissa != 0) {
+					digits++;
+				}
+			}
+			else {
+				exponent++;
+			}
+			p++;
+			any = true;
+		}
+		if (p < end && *p == '.') {
+			p++;
+			while (p < end && *p >= '0' && *p <= '9') {
+				if (digits < 18) {
+					mantissa = mantissa * 10 + (*p - '0');
+					if (mantissa != 0) {
+						digits++;
+					}
+					exponent--;
+				}
+				p++;
+				any = true;
+			}
+		}
+		if (!any) {
+			error = true;
+			return 0;
+		}
+		if (p < end && (*p == 'e' || *p == 'E')) {
+			p++;
+			bool negativeExponent = false;
+			if (p < end && (*p == '-' || *p == '+')) {
+				negativeExponent = (*p == '-');
+				p++;
+			}
+			int e = 0;
+			while (p < end && *p >= '0' && *p <= '9') {
+				e = std::min(e * 10 + (*p - '0'), 10000);
+				p++;
+			}
+			exponent += negativeExponent ? -e : e;
+		}
+		static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16 };
+		double value = (double)mantissa;
+		if (exponent < 0 && exponent >= -16) {
+			value /= powers[-exponent];
+		}
+		else if (exponent > 0 && exponent <= 16) {
+			value *= powers[exponent];
+		}
+		else if (exponent != 0) {
+			value *= pow(10.0, exponent);
+		}
+		return negative ? -value : value;
+	}
+};
+
+/* ------------------------------------------------------------------ PLY */
+
+enum PlyType { PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64, PLY_INVALID };
+enum PlyFormat { PLY_ASCII, PLY_BINARY_LE, PLY_BINARY_BE };
+
+static const int plyTypeSize[] = { 1, 1, 2, 2, 4, 4, 4, 8, 0 };
+
+struct PlyProperty {
+	std::string name;
+	PlyType type;
+	bool list;
+	PlyType countType;
+};
+
+struct PlyElement {
+	std::string name;
+	long count;
+	std::vector<PlyProperty> properties;
+};
+
+static PlyType plyTypeFromName(const std::string& name) {
+	if (name == "char" || name == "int8") return PLY_INT8;
+	if (name == "uchar" || name == "uint8") return PLY_UINT8;
+	if (name == "short" || name == "int16") return PLY_INT16;
+	if (name == "ushort" || name == "uint16") return PLY_UINT16;
+	if (name == "int" || name == "int32") return PLY_INT32;
+	if (name == "uint" || name == "uint32") return PLY_UINT32;
+	if (name == "float" || name == "float32") return PLY_FLOAT32;
+	if (name == "double" || name == "float64") return PLY_FLOAT64;
+	return PLY_INVALID;
+}
+
+static bool hostIsLittleEndian() {
+	uint16_t probe = 1;
+	return *(unsigned char*)&probe == 1;
+}
+
+/*	Converts one binary scalar */
+static inline double decodePlyValue(const char* data, PlyType type, bool swap) {
+	unsigned char bytes[8];
+	int size = plyTypeSize[type];
+	memcpy(bytes, data, size);
+	if (swap) {
+		std::reverse(bytes, bytes + size);
+	}
+	switch (type) {
+	case PLY_INT8: { int8_t v; memcpy(&v, bytes, 1); return v; }
+	case PLY_UINT8: { uint8_t v; memcpy(&v, bytes, 1); return v; }
+	case PLY_INT16: { int16_t v; memcpy(&v, bytes, 2); return v; }
+	case PLY_UINT16: { uint16_t v; memcpy(&v, bytes, 2); return v; }
+	case PLY_INT32: { int32_t v; memcpy(&v, bytes, 4); return v; }
+	case PLY_UINT32: { uint32_t v; memcpy(&v, bytes, 4); return v; }
+	case PLY_FLOAT32: { float v; memcpy(&v, bytes, 4); return v; }
+	case PLY_FLOAT64: { double v; memcpy(&v, bytes, 8); return v; }
+	default: break;
+	}
+	return 0;
+}
+
+/*	Reads one scalar in the file's format */
+static double readPlyValue(Reader& reader, PlyType type, PlyFormat format, bool swap) {
+	if (format == PLY_ASCII) {
+		reader.skipWhitespace();
+		return (type == PLY_FLOAT32 || type == PLY_FLOAT64) ? reader.parseDouble() : (double)reader.parseInt();
+	}
+	int size = plyTypeSize[type];
+	if (reader.end - reader.p < size) {
+		reader.error = true;
+		return 0;
+	}
+	double value = decodePlyValue(reader.p, type, swap);
+	reader.p += size;
+	return value;
+}
+
+/*	Reads the length of a list and checks it against the rest of the file,
+	where a binary item takes its size and a text one a character and a
+	separator.  A length that cannot be right sets reader.error and reads
+	as 0. */
+static int readPlyListCount(Reader& reader, const PlyProperty& property, PlyFormat format, bool swap) {
+	double count = readPlyValue(reader, property.countType, format, swap);
+	size_t remaining = reader.end - reader.p;
+	size_t items = (format == PLY_ASCII) ? (remaining + 1) / 2 : remaining / plyTypeSize[property.type];
+	if (reader.error || count < 0 || count > (double)items) {
+		reader.error = true;
+		return 0;
+	}
+	return (int)count;
+}
+
+/*
+	Vertices are merged when both position and uv match bit for bit
+*/
+struct VertexKey {
+	float values[5];
+
+	bool operator==(const VertexKey& other) const { return memcmp(values, other.values, sizeof(values)) == 0; }
+};
+
+static uint64_t hashKey(const VertexKey& key) {
+	uint32_t words[5];
+	memcpy(words, key.values, sizeof(words));
+	uint64_t hash = 1469598103934665603ull;
+	for (int i = 0; i < 5; i++) {
+		hash = (hash ^ words[i]) * 1099511628211ull;
+	}
+	return hash ^ (hash >> 29);
+}
+
+static uint64_t hashKey(uint64_t key) {
+	key *= 0x9E3779B97F4A7C15ull;
+	return key ^ (key >> 32);
+}
+
+/*
+	Open addressing table handing out consecutive ids to distinct keys.
+	Much faster than std::unordered_map for millions of vertices, since
+	it never allocates per key.
+*/
+#define DEDUP_EMPTY 0xFFFFFFFFu
+
+template <class Key>
+class DedupTable {
+public:
+	DedupTable(size_t expected) {
+		keys.reserve(expected);
+		resize(expected);
+	}
+
+	/*	Returns the id of key, adding it if it is new (inserted is set then) */
+	unsigned int insert(const Key& key, bool& inserted) {
+		if (2 * (keys.size() + 1) > slots.size()) {
+			resize(2 * keys.size() + 1);
+		}
+		size_t slot = (size_t)hashKey(key) & mask;
+		while (true) {
+			unsigned int id = slots[slot];
+			if (id == DEDUP_EMPTY) {
+				slots[slot] = (unsigned int)keys.size();
+				keys.push_back(key);
+				inserted = true;
+				return slots[slot];
+			}
+			if (keys[id] == key) {
+				inserted = false;
+				return id;
+			}
+			slot = (slot + 1) & mask;
+		}
+	}
+
+private:
+	void resize(size_t expected) {
+		size_t capacity = 16;
+		while (capacity < 2 * expected) {
+			capacity *= 2;
+		}
+		slots.assign(capacity, DEDUP_EMPTY);
+		mask = capacity - 1;
+		for (size_t id = 0; id < keys.size(); id++) {
+			size_t slot = (size_t)hashKey(keys[id]) & mask;
+			while (slots[slot] != DEDUP_EMPTY) {
+				slot = (slot + 1) & mask;
+			}
+			slots[slot] = (unsigned int)id;
+		}
+	}
+
+	std::vector<unsigned int> slots;
+	std::vector<Key> keys;
+	size_t mask;
+};
+
+static bool loadPLY(const char* data, size_t size, TriangleMesh& mesh, MeshLoadStats& stats) {
+	Reader reader(data, data + size);
+	// the header is short text, parse it line by line
+	const char* headerEnd = NULL;
+	for (const char* p = data; p + 10 <= data + size; p++) {
+		if (memcmp(p, "end_header", 10) == 0 && (p == data || p[-1] == '\n')) {
+			headerEnd = p;
+			break;
+		}
+	}
+	if (size < 3 || memcmp(data, "ply", 3) != 0 || headerEnd == NULL) {
+		std::cout << "not a ply file" << std::endl;
+		return false;
+	}
+	std::istringstream header(std::string(data, headerEnd));
+	reader.p = headerEnd;
+	reader.skipLine();
+
+	PlyFormat format = PLY_ASCII;
+	std::vector<PlyElement> elements;
+	std::string line;
+	while (getline(header, line)) {
+		std::istringstream words(line);
+		std::string keyword;
+		words >> keyword;
+		if (keyword == "format") {
+			std::string name;
+			words >> name;
+			if (name == "binary_little_endian") {
+				format = PLY_BINARY_LE;
+			}
+			else if (name == "binary_big_endian") {
+				format = PLY_BINARY_BE;
+			}
+		}
+		else if (keyword == "element") {
+			PlyElement element;
+			element.count = 0;
+			words >> element.name >> element.count;
+			elements.push_back(element);
+		}
+		else if (keyword == "property" && !elements.empty()) {
+			PlyProperty property;
+			std::string type;
+			words >> type;
+			property.list = (type == "list");
+			property.countType = PLY_INVALID;
+			if (property.list) {
+				std::string countType;
+				words >> countType >> type;
+				property.countType = plyTypeFromName(countType);
+			}
+			property.type = plyTypeFromName(type);
+			words >> property.name;
+			if (property.type == PLY_INVALID || (property.list && property.countType == PLY_INVALID)) {
+				std::cout << "unsupported ply property: " << line << std::endl;
+				return false;
+			}
+			elements.back().properties.push_back(property);
+		}
+	}
+	bool swap = (format == PLY_BINARY_LE) != hostIsLittleEndian() && format != PLY_ASCII;
+
+	// counts are checked against the file before anything is allocated
+	// for them: a binary record takes at least its scalars and list
+	// counts, a text one a character and a separator per property
+	size_t remaining = reader.end - reader.p;
+	for (size_t e = 0; e < elements.size(); e++) {
+		const PlyElement& element = elements[e];
+		size_t recordSize = 0;
+		for (size_t i = 0; i < element.properties.size(); i++) {
+			const PlyProperty& property = element.properties[i];
+			if (format == PLY_ASCII) {
+				recordSize += 2;
+			}
+			else {
+				recordSize += plyTypeSize[property.list ? property.countType : property.type];
+			}
+		}
+		if (element.count < 0 || (recordSize > 0 && (size_t)element.count > (remaining + 1) / recordSize)) {
+			std::cout << "ply element " << element.name << " has an invalid count of " << element.count << std::endl;
+			return false;
+		}
+	}
+
+	std::vector<glm::vec3> filePositions;
+	std::vector<glm::vec2> fileUVs;
+	std::vector<unsigned int> fileIndices;
+	bool hasUVs = false;
+	std::vector<double> values;
+	std::vector<unsigned int> polygon;
+
+	for (size_t e = 0; e < elements.size() && !reader.error; e++) {
+		const PlyElement& element = elements[e];
+		const std::vector<PlyProperty>& properties = element.properties;
+		if (element.name == "vertex") {
+			int x = -1, y = -1, z = -1, u = -1, v = -1;
+			for (size_t i = 0; i < properties.size(); i++) {
+				const std::string& name = properties[i].name;
+				if (name == "x") x = (int)i;
+				else if (name == "y") y = (int)i;
+				else if (name == "z") z = (int)i;
+				else if (name == "s" || name == "u" || name == "texture_u") u = (int)i;
+				else if (name == "t" || name == "v" || name == "texture_v") v = (int)i;
+			}
+			if (x < 0 || y < 0 || z < 0) {
+				std::cout << "ply vertices have no x, y, z" << std::endl;
+				return false;
+			}
+			hasUVs = (u >= 0 && v >= 0);
+			filePositions.resize(element.count);
+			if (hasUVs) {
+				fileUVs.resize(element.count);
+			}
+			values.resize(properties.size());
+
+			// binary records of fixed size are read in place
+			bool fixedSize = (format != PLY_ASCII);
+			size_t stride = 0;
+			std::vector<size_t> offsets;
+			for (size_t i = 0; i < properties.size(); i++) {
+				fixedSize = fixedSize && !properties[i].list;
+				offsets.push_back(stride);
+				stride += plyTypeSize[properties[i].type];
+			}
+			if (fixedSize) {
+				if ((size_t)(reader.end - reader.p) < stride * element.count) {
+					reader.error = true;
+					break;
+				}
+				const char* record = reader.p;
+				for (long n = 0; n < element.count; n++, record += stride) {
+					filePositions[n] = glm::vec3((float)decodePlyValue(record + offsets[x], properties[x].type, swap),
+						(float)decodePlyValue(record + offsets[y], properties[y].type, swap),
+						(float)decodePlyValue(record + offsets[z], properties[z].type, swap));
+					if (hasUVs) {
+						fileUVs[n] = glm::vec2((float)decodePlyValue(record + offsets[u], properties[u].type, swap),
+							(float)decodePlyValue(record + offsets[v], properties[v].type, swap));
+					}
+				}
+				reader.p = record;
+				continue;
+			}
+			for (long n = 0; n < element.count && !reader.error; n++) {
+				for (size_t i = 0; i < properties.size(); i++) {
+					if (properties[i].list) {
+						int count = readPlyListCount(reader, properties[i], format, swap);
+						for (int k = 0; k < count; k++) {
+							readPlyValue(reader, properties[i].type, format, swap);
+						}
+						values[i] = 0;
+					}
+					else {
+						values[i] = readPlyValue(reader, properties[i].type, format, swap);
+					}
+				}
+				filePositions[n] = glm::vec3((float)values[x], (float)values[y], (float)values[z]);
+				if (hasUVs) {
+					fileUVs[n] = glm::vec2((float)values[u], (float)values[v]);
+				}
+			}
+		}
+		else if (element.name == "face") {
+			fileIndices.reserve(element.count * 3);
+			// the common binary layout: nothing but a list of 32 bit indices
+			bool intIndices = properties.size() == 1 && properties[0].list &&
+				(properties[0].type == PLY_INT32 || properties[0].type == PLY_UINT32);
+			if (format != PLY_ASCII && intIndices) {
+				PlyType countType = properties[0].countType;
+				PlyType indexType = properties[0].type;
+				int countSize = plyTypeSize[countType];
+				for (long n = 0; n < element.count; n++) {
+					if (reader.end - reader.p < countSize) {
+						reader.error = true;
+						break;
+					}
+					int count = (int)decodePlyValue(reader.p, countType, swap);
+					reader.p += countSize;
+					if (count < 0 || reader.end - reader.p < 4 * (long)count) {
+						reader.error = true;
+						break;
+					}
+					polygon.resize(count);
+					if (!swap) {
+						memcpy(polygon.data(), reader.p, 4 * count);
+					}
+					else {
+						for (int k = 0; k < count; k++) {
+							polygon[k] = (unsigned int)decodePlyValue(reader.p + 4 * k, indexType, swap);
+						}
+					}
+					reader.p += 4 * count;
+					for (int k = 2; k < count; k++) {
+						fileIndices.push_back(polygon[0]);
+						fileIndices.push_back(polygon[k - 1]);
+						fileIndices.push_back(polygon[k]);
+					}
+				}
+				continue;
+			}
+			for (long n = 0; n < element.count && !reader.error; n++) {
+				for (size_t i = 0; i < properties.size(); i++) {
+					const PlyProperty& property = properties[i];
+					if (!property.list) {
+						readPlyValue(reader, property.type, format, swap);
+						continue;
+					}
+					int count = readPlyListCount(reader, property, format, swap);
+					bool indices = (property.name == "vertex_indices" || property.name == "vertex_index");
+					polygon.clear();
+					for (int k = 0; k < count && !reader.error; k++) {
+						polygon.push_back((unsigned int)readPlyValue(reader, property.type, format, swap));
+					}
+					// triangle fan around the first corner
+					for (size_t k = 2; indices && k < polygon.size(); k++) {
+						fileIndices.push_back(polygon[0]);
+						fileIndices.push_back(polygon[k - 1]);
+						fileIndices.push_back(polygon[k]);
+					}
+				}
+			}
+		}
+		else if (format == PLY_ASCII) {
+			// unknown elements hold one item per line
+			reader.skipWhitespace();
+			for (long n = 0; n < element.count; n++) {
+				reader.skipLine();
+			}
+		}
+		else {
+			for (long n = 0; n < element.count && !reader.error; n++) {
+				for (size_t i = 0; i < properties.size(); i++) {
+					int count = 1;
+					if (properties[i].list) {
+						count = readPlyListCount(reader, properties[i], format, swap);
+					}
+					for (int k = 0; k < count; k++) {
+						readPlyValue(reader, properties[i].type, format, swap);
+					}
+				}
+			}
+		}
+	}
+	if (reader.error) {
+		std::cout << "ply file is truncated or malformed" << std::endl;
+		return false;
+	}
+
+	// merge identical vertices, then renumber the triangles
+	stats.fileVertices = (int)filePositions.size();
+	std::vector<unsigned int> remap(filePositions.size());
+	DedupTable<VertexKey> unique(filePositions.size());
+	mesh.positions.reserve(filePositions.size());
+	mesh.uvs.reserve(hasUVs ? fileUVs.size() : 0);
+	for (size_t i = 0; i < filePositions.size(); i++) {
+		VertexKey key;
+		key.values[0] = filePositions[i].x;
+		key.values[1] = filePositions[i].y;
+		key.values[2] = filePositions[i].z;
+		key.values[3] = hasUVs ? fileUVs[i].x : 0.0f;
+		key.values[4] = hasUVs ? fileUVs[i].y : 0.0f;
+		bool inserted;
+		remap[i] = unique.insert(key, inserted);
+		if (inserted) {
+			mesh.positions.push_back(filePositions[i]);
+			if (hasUVs) {
+				mesh.uvs.push_back(fileUVs[i]);
+			}
+		}
+	}
+	mesh.indices.reserve(fileIndices.size());
+	for (size_t i = 0; i + 2 < fileIndices.size(); i += 3) {
+		if (fileIndices[i] >= remap.size() || fileIndices[i + 1] >= remap.size() || fileIndices[i + 2] >= remap.size()) {
+			continue;
+		}
+		unsigned int a = remap[fileIndices[i]];
+		unsigned int b = remap[fileIndices[i + 1]];
+		unsigned int c = remap[fileIndices[i + 2]];
+		// merging can collapse a triangle
+		if (a == b || b == c || a == c) {
+			continue;
+		}
+		mesh.indices.push_back(a);
+		mesh.indices.push_back(b);
+		mesh.indices.push_back(c);
+	}
+	return true;
+}
+
+/* ------------------------------------------------------------------ OBJ */
+
+static bool loadOBJ(const char* data, size_t size, TriangleMesh& mesh, MeshLoadStats& stats) {
+	Reader reader(data, data + size);
+	std::vector<glm::vec3> filePositions;
+	std::vector<glm::vec2> fileUVs;
+	// one mesh vertex per distinct position/texture coordinate pair
+	DedupTable<uint64_t> unique(1024);
+	std::vector<unsigned int> polygon;
+	bool anyUV = false;
+	int lineNumber = 0;
+
+	while (!reader.atEnd()) {
+		lineNumber++;
+		reader.skipSpaces();
+		if (reader.atEnd()) {
+			break;
+		}
+		char c = *reader.p;
+		char next = (reader.p + 1 < reader.end) ? reader.p[1] : '\n';
+		if (c == 'v' && (next == ' ' || next == '\t')) {
+			reader.p++;
+			float x = (float)reader.parseDouble();
+			float y = (float)reader.parseDouble();
+			float z = (float)reader.parseDouble();
+			filePositions.push_back(glm::vec3(x, y, z));
+		}
+		else if (c == 'v' && next == 't') {
+			reader.p += 2;
+			float u = (float)reader.parseDouble();
+			float v = reader.atLineEnd() ? 0.0f : (float)reader.parseDouble();
+			fileUVs.push_back(glm::vec2(u, v));
+		}
+		else if (c == 'f' && (next == ' ' || next == '\t')) {
+			reader.p++;
+			polygon.clear();
+			while (!reader.atLineEnd() && !reader.error) {
+				long position = reader.parseInt();
+				long uv = 0;
+				if (reader.p < reader.end && *reader.p == '/') {
+					reader.p++;
+					if (reader.p < reader.end && *reader.p != '/') {
+						uv = reader.parseInt();
+					}
+					if (reader.p < reader.end && *reader.p == '/') {
+						// normals are recomputed, skip the index
+						reader.p++;
+						reader.parseInt();
+					}
+				}
+				// negative indices count back from the newest element
+				position = (position < 0) ? (long)filePositions.size() + position : position - 1;
+				uv = (uv < 0) ? (long)fileUVs.size() + uv : uv - 1;
+				if (position < 0 || position >= (long)filePositions.size() || uv >= (long)fileUVs.size()) {
+					std::cout << "obj line " << lineNumber << ": index out of range" << std::endl;
+					return false;
+				}
+				anyUV = anyUV || uv >= 0;
+				uint64_t key = ((uint64_t)position << 32) | (uint32_t)(uv + 1);
+				bool inserted;
+				unsigned int id = unique.insert(key, inserted);
+				if (inserted) {
+					mesh.positions.push_back(filePositions[position]);
+					mesh.uvs.push_back(uv >= 0 ? fileUVs[uv] : glm::vec2(0, 0));
+				}
+				polygon.push_back(id);
+			}
+			for (size_t k = 2; k < polygon.size(); k++) {
+				mesh.indices.push_back(polygon[0]);
+				mesh.indices.push_back(polygon[k - 1]);
+				mesh.indices.push_back(polygon[k]);
+			}
+		}
+		if (reader.error) {
+			std::cout << "obj line " << lineNumber << ": malformed number" << std::endl;
+			return false;
+		}
+		reader.skipLine();
+	}
+	if (!anyUV) {
+		mesh.uvs.clear();
+	}
+	stats.fileVertices = (int)filePositions.size();
+	return true;
+}
+
+/* --------------------------------------------------------------- public */
+
+bool loadMesh(std::string fileName, TriangleMesh& mesh, MeshLoadStats* stats) {
+	typedef std::chrono::steady_clock Clock;
+	MeshLoadStats localStats;
+	memset(&localStats, 0, sizeof(localStats));
+	mesh.positions.clear();
+	mesh.uvs.clear();
+	mesh.normals.clear();
+	mesh.indices.clear();
+
+	std::string extension = fileName.substr(fileName.find_last_of('.') + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	if (extension != "ply" && extension != "obj") {
+		std::cout << "Unknown mesh format: " << fileName << std::endl;
+		return false;
+	}
+
+	Clock::time_point start = Clock::now();
+	MappedFile file;
+	if (!file.open(fileName)) {
+		return false;
+	}
+	localStats.fileBytes = file.size();
+	bool loaded = (extension == "ply") ? loadPLY(file.data(), file.size(), mesh, localStats)
+		: loadOBJ(file.data(), file.size(), mesh, localStats);
+	file.close();
+	if (!loaded) {
+		std::cout << "Unable to load mesh: " << fileName << std::endl;
+		return false;
+	}
+	Clock::time_point parsed = Clock::now();
+	computeNormals(mesh);
+	Clock::time_point done = Clock::now();
+
+	localStats.vertices = (int)mesh.positions.size();
+	localStats.triangles = mesh.triangleCount();
+	localStats.parseSeconds = std::chrono::duration<double>(parsed - start).count();
+	localStats.normalSeconds = std::chrono::duration<double>(done - parsed).count();
+	if (stats != NULL) {
+		*stats = localStats;
+	}
+	return true;
+}
+
+void computeNormals(TriangleMesh& mesh, int threads) {
+	if (threads <= 0) {
+		threads = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+	int vertexCount = (int)mesh.positions.size();
+	int triangleCount = mesh.triangleCount();
+	const glm::vec3* positions = mesh.positions.data();
+	const unsigned int* indices = mesh.indices.data();
+
+	// 1. area weighted face normals (the cross product's length is twice the area)
+	std::vector<glm::vec3> faceNormals(triangleCount);
+	parallelFor(triangleCount, threads, [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			const glm::vec3& p0 = positions[indices[3 * i]];
+			faceNormals[i] = glm::cross(positions[indices[3 * i + 1]] - p0, positions[indices[3 * i + 2]] - p0);
+		}
+	});
+
+	// 2. faces around every vertex, in compressed rows
+	std::vector<int> firstFace(vertexCount + 1, 0);
+	for (size_t i = 0; i < mesh.indices.size(); i++) {
+		firstFace[indices[i] + 1]++;
+	}
+	for (int v = 0; v < vertexCount; v++) {
+		firstFace[v + 1] += firstFace[v];
+	}
+	std::vector<int> fill(firstFace.begin(), firstFace.end() - 1);
+	std::vector<int> adjacentFaces(mesh.indices.size());
+	for (size_t i = 0; i < mesh.indices.size(); i++) {
+		adjacentFaces[fill[indices[i]]++] = (int)(i / 3);
+	}
+
+	// 3. each vertex sums its own faces, so no two threads write the same normal
+	mesh.normals.resize(vertexCount);
+	parallelFor(vertexCount, threads, [&](int begin, int end) {
+		for (int v = begin; v < end; v++) {
+			glm::vec3 sum(0, 0, 0);
+			for (int k = firstFace[v]; k < firstFace[v + 1]; k++) {
+				sum = sum + faceNormals[adjacentFaces[k]];
+			}
+			float length = glm::length(sum);
+			mesh.normals[v] = (length > 0.0f) ? sum / length : glm::vec3(0, 1, 0);
+		}
+	});
+}
+
+void fitMeshToUnitCube(TriangleMesh& mesh) {
+	if (mesh.positions.empty()) {
+		return;
+	}
+	glm::vec3 lower = mesh.positions[0];
+	glm::vec3 upper = mesh.positions[0];
+	for (size_t i = 1; i < mesh.positions.size(); i++) {
+		lower = glm::min(lower, mesh.positions[i]);
+		upper = glm::max(upper, mesh.positions[i]);
+	}
+	glm::vec3 extent = upper - lower;
+	float largest = std::max(extent.x, std::max(extent.y, extent.z));
+	float scale = (largest > 0.0f) ? 1.0f / largest : 1.0f;
+	glm::vec3 center = 0.5f * (lower + upper);
+	for (size_t i = 0; i < mesh.positions.size(); i++) {
+		mesh.positions[i] = (mesh.positions[i] - center) * scale;
+	}
+}
+
+bool saveMeshPLY(const TriangleMesh& mesh, std::string fileName, bool binary) {
+	std::ofstream file(fileName.c_str(), std::ios::binary);
+	if (!file.is_open()) {
+		std::cout << "Unable to write mesh: " << fileName << std::endl;
+		return false;
+	}
+	bool hasUVs = mesh.uvs.size() == mesh.positions.size() && !mesh.uvs.empty();
+	file << "ply\n";
+	file << "format " << (binary ? (hostIsLittleEndian() ? "binary_little_endian" : "binary_big_endian") : "ascii") << " 1.0\n";
+	file << "comment CREATOR: ComputerGraphics\n";
+	file << "element vertex " << mesh.positions.size() << "\n";
+	file << "property float x\nproperty float y\nproperty float z\n";
+	if (hasUVs) {
+		file << "property float s\nproperty float t\n";
+	}
+	file << "element face " << mesh.triangleCount() << "\n";
+	file << "property list uchar int vertex_indices\n";
+	file << "end_header\n";
+
+	if (binary) {
+		for (size_t i = 0; i < mesh.positions.size(); i++) {
+			file.write((const char*)&mesh.positions[i], 3 * sizeof(float));
+			if (hasUVs) {
+				file.write((const char*)&mesh.uvs[i], 2 * sizeof(float));
+			}
+		}
+		for (int i = 0; i < mesh.triangleCount(); i++) {
+			unsigned char three = 3;
+			file.write((const char*)&three, 1);
+			file.write((const char*)&mesh.indices[3 * i], 3 * sizeof(unsigned int));
+		}
+	}
+	else {
+		for (size_t i = 0; i < mesh.positions.size(); i++) {
+			file << mesh.positions[i].x << " " << mesh.positions[i].y << " " << mesh.positions[i].z;
+			if (hasUVs) {
+				file << " " << mesh.uvs[i].x << " " << mesh.uvs[i].y;
+			}
+			file << "\n";
+		}
+		for (int i = 0; i < mesh.triangleCount(); i++) {
+			file << "3 " << mesh.indices[3 * i] << " " << mesh.indices[3 * i + 1] << " " << mesh.indices[3 * i + 2] << "\n";
+		}
+	}
+	return file.good();
+}
@@ -0,0 +1,58 @@
+/*  =================== File Information =================
+	File Name: MeshLoader.h
+	Description:
+	Author:
+
+	Purpose: Reads triangle meshes from .ply (ascii and binary, either
+			 byte order) and .obj files.  The file is memory mapped and
+			 parsed in a single pass, polygons are split into triangle
+			 fans, identical vertices are merged into one index, and
+			 smooth vertex normals are computed on all cores.
+	Usage:	TriangleMesh mesh;
+			if (loadMesh("bunny.ply", mesh)) { ... }
+	===================================================== */
+#ifndef MESH_LOADER_H
+#define MESH_LOADER_H
+
+#include <string>
+#include "Primitives.h"
+
+struct MeshLoadStats {
+	int fileVertices;		// vertices (or distinct v/vt pairs) in the file
+	int vertices;			// after merging identical vertices
+	int triangles;
+	size_t fileBytes;
+	double parseSeconds;
+	double normalSeconds;
+};
+
+/*	===============================================
+Desc:	Loads a .ply or .obj file (chosen by extension) into mesh, replacing
+		its contents, and computes the vertex normals.
+Precondition:
+Postcondition:	Returns false and prints the reason if the file could not be
+				read.  stats receives sizes and timings if not NULL.
+=============================================== */
+bool loadMesh(std::string fileName, TriangleMesh& mesh, MeshLoadStats* stats = NULL);
+/*	===============================================
+Desc:	Sets mesh.normals to the area weighted average of the face normals
+		around each vertex.  threads <= 0 uses every hardware thread.
+Precondition:
+Postcondition:
+=============================================== */
+void computeNormals(TriangleMesh& mesh, int threads = 0);
+/*	===============================================
+Desc:	Moves and uniformly scales the positions so the mesh is centered at
+		the origin and its largest side is 1, like the other primitives.
+Precondition:
+Postcondition:
+=============================================== */
+void fitMeshToUnitCube(TriangleMesh& mesh);
+/*	===============================================
+Desc:	Writes positions, uvs (as s, t) and triangles as a .ply file
+Precondition:
+Postcondition:	Returns false if the file could not be written.
+=============================================== */
+bool saveMeshPLY(const TriangleMesh& mesh, std::string fileName, bool binary = true);
+
+#endif
@@ -0,0 +1,314 @@
+/*  =================== File Information =================
+	File Name: MicroBenchmarks.cpp
+	Description:
+	Author:
+
+	Purpose: Timing of the hot CPU paths (ray generation, intersection,
+			 camera matrices, BVH build and traversal, ppm parsing,
+			 texture compression, resampling) in
+			 isolation.  Only links the core library, no OpenGL context is
+			 needed.
+	Usage:	cglab_microbench [name filter] [model.ply|model.obj]
+			Run from the ComputerGraphics directory so ./data is found.
+			The mesh loading benchmarks write a generated 2M triangle
+			model in every format to the working directory first; a model
+			given on the command line is timed as well.
+	===================================================== */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "Camera.h"
+#include "Picking.h"
+#include "Primitives.h"
+#include "MeshLoader.h"
+#include "MeshBVH.h"
+#include "CameraSpline.h"
+#include "TextureCompression.h"
+#include "Resample.h"
+#include "ppm.h"
+
+static std::string filter;
+// Results are accumulated here so the compiler cannot drop the timed work
+static volatile double sink = 0;
+
+/*	Runs body(i) for i in [0, iterations) and prints the time per call */
+template <class Body>
+static void runMicroBenchmark(const char* name, int iterations, Body body) {
+	if (!filter.empty() && std::string(name).find(filter) == std::string::npos) {
+		return;
+	}
+	typedef std::chrono::steady_clock Clock;
+	// one untimed pass over a tenth of the iterations to warm caches
+	for (int i = 0; i < iterations / 10; i++) {
+		body(i);
+	}
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < iterations; i++) {
+		body(i);
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	printf("%-32s %12.2f ns/op %14.0f ops/s\n", name, 1e9 * seconds / iterations, iterations / seconds);
+}
+
+/*	Loads a mesh once and prints the triangle throughput of the parser */
+static void runMeshBenchmark(const char* name, std::string fileName) {
+	if (!filter.empty() && std::string(name).find(filter) == std::string::npos) {
+		return;
+	}
+	TriangleMesh mesh;
+	MeshLoadStats stats;
+	if (!loadMesh(fileName, mesh, &stats)) {
+		return;
+	}
+	printf("%-32s %8.1f ms parse %8.1f ms normals %8.2f M triangles/s %8.1f MB/s (%d triangles, %d -> %d vertices)\n",
+		name, 1000.0 * stats.parseSeconds, 1000.0 * stats.normalSeconds,
+		stats.triangles / stats.parseSeconds / 1e6, stats.fileBytes / stats.parseSeconds / 1e6,
+		stats.triangles, stats.fileVertices, stats.vertices);
+}
+
+/*	Encodes an image a few times and prints the throughput, the size
+	reduction against GL_RGB and the quality of the result
+*/
+static void runCompressionBenchmark(const char* name, ppm& image, TextureCompression format, int threads) {
+	if (!filter.empty() && std::string(name).find(filter) == std::string::npos) {
+		return;
+	}
+	typedef std::chrono::steady_clock Clock;
+	const unsigned char* pixels = (const unsigned char*)image.getPixels();
+	int width = image.getWidth();
+	int height = image.getHeight();
+	CompressedImage compressed;
+	compressImage(pixels, width, height, format, compressed, threads);
+	const int runs = 5;
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < runs; i++) {
+		compressImage(pixels, width, height, format, compressed, threads);
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count() / runs;
+	std::vector<unsigned char> decoded;
+	decompressImage(compressed, decoded);
+	printf("%-32s %8.2f ms %8.1f MPix/s %6.1f:1 PSNR %.2f dB\n", name, 1000.0 * seconds,
+		width * height / seconds / 1e6, (double)compressedSize(COMPRESSION_NONE, width, height) / compressed.blocks.size(),
+		computePSNR(pixels, &decoded[0], decoded.size()));
+}
+
+/*	Resamples image to targetWidth x targetHeight and prints the time
+	and the throughput in source texels
+*/
+static void runResampleBenchmark(const char* name, ppm& image, int targetWidth, int targetHeight, ResampleFilter resampleFilter, int threads) {
+	if (!filter.empty() && std::string(name).find(filter) == std::string::npos) {
+		return;
+	}
+	typedef std::chrono::steady_clock Clock;
+	const unsigned char* pixels = (const unsigned char*)image.getPixels();
+	int width = image.getWidth();
+	int height = image.getHeight();
+	std::vector<unsigned char> target((size_t)targetWidth * targetHeight * 3);
+	resampleImage(pixels, width, height, &target[0], targetWidth, targetHeight, resampleFilter, threads);
+	const int runs = 10;
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < runs; i++) {
+		resampleImage(pixels, width, height, &target[0], targetWidth, targetHeight, resampleFilter, threads);
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count() / runs;
+	sink += target[target.size() / 2];
+	printf("%-32s %8.2f ms %8.1f MPix/s in %8.1f MPix/s out\n", name, 1000.0 * seconds,
+		width * height / seconds / 1e6, targetWidth * targetHeight / seconds / 1e6);
+}
+
+/*	An n x n quad height field over the xz unit square, 2 n^2 triangles */
+static void buildGridMesh(int n, TriangleMesh& grid) {
+	for (int y = 0; y <= n; y++) {
+		for (int x = 0; x <= n; x++) {
+			float u = (float)x / n;
+			float v = (float)y / n;
+			grid.positions.push_back(glm::vec3(u, 0.1f * sin(20.0f * u) * cos(20.0f * v), v));
+			grid.uvs.push_back(glm::vec2(u, v));
+		}
+	}
+	for (int y = 0; y < n; y++) {
+		for (int x = 0; x < n; x++) {
+			unsigned int i = y * (n + 1) + x;
+			unsigned int quad[6] = { i, i + 1, i + n + 2, i, i + n + 2, i + n + 1 };
+			grid.indices.insert(grid.indices.end(), quad, quad + 6);
+		}
+	}
+}
+
+/*	The 1000 x 1000 grid, 2M triangles */
+static void writeBenchmarkMeshes() {
+	TriangleMesh grid;
+	buildGridMesh(1000, grid);
+	saveMeshPLY(grid, "bench_mesh_binary.ply", true);
+	saveMeshPLY(grid, "bench_mesh_ascii.ply", false);
+	FILE* obj = fopen("bench_mesh.obj", "w");
+	if (obj == NULL) {
+		return;
+	}
+	for (size_t i = 0; i < grid.positions.size(); i++) {
+		fprintf(obj, "v %f %f %f\n", grid.positions[i].x, grid.positions[i].y, grid.positions[i].z);
+	}
+	for (size_t i = 0; i < grid.uvs.size(); i++) {
+		fprintf(obj, "vt %f %f\n", grid.uvs[i].x, grid.uvs[i].y);
+	}
+	for (size_t i = 0; i < grid.indices.size(); i += 3) {
+		unsigned int a = grid.indices[i] + 1, b = grid.indices[i + 1] + 1, c = grid.indices[i + 2] + 1;
+		fprintf(obj, "f %u/%u %u/%u %u/%u\n", a, a, b, b, c, c);
+	}
+	fclose(obj);
+}
+
+int main(int argc, char **argv) {
+	if (argc > 1) {
+		filter = argv[1];
+	}
+
+	Camera camera;
+	camera.setViewAngle(60);
+	camera.setNearPlane(0.01f);
+	camera.setFarPlane(10.0f);
+	camera.setScreenSize(640, 480);
+	camera.orientLookVec(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0));
+	glm::vec3 eye = camera.getEyePoint();
+	glm::mat4 sphereTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.1f, 0.0f, 0.0f));
+
+	runMicroBenchmark("camera/projection_matrix", 1000000, [&](int) {
+		sink += camera.getProjectionMatrix()[0][0];
+	});
+	runMicroBenchmark("camera/modelview_matrix", 1000000, [&](int) {
+		sink += camera.getModelViewMatrix()[0][0];
+	});
+	runMicroBenchmark("picking/generate_ray", 1000000, [&](int i) {
+		sink += generateRay(camera, i % 640, (i / 640) % 480).x;
+	});
+	runMicroBenchmark("picking/intersect_hit", 1000000, [&](int) {
+		sink += intersect(eye, glm::vec3(0, 0, -1), sphereTransform);
+	});
+	runMicroBenchmark("picking/intersect_miss", 1000000, [&](int) {
+		sink += intersect(eye, glm::vec3(0, 1, 0), sphereTransform);
+	});
+	runMicroBenchmark("picking/sphere_translate_hit", 1000000, [&](int) {
+		RayHit hit;
+		if (intersectSphere(eye, glm::vec3(0, 0, -1), TranslateTransform(glm::vec3(0.1f, 0.0f, 0.0f)), hit)) {
+			sink += hit.t;
+		}
+	});
+	runMicroBenchmark("picking/sphere_translate_miss", 1000000, [&](int) {
+		RayHit hit;
+		if (intersectSphere(eye, glm::vec3(0, 1, 0), TranslateTransform(glm::vec3(0.1f, 0.0f, 0.0f)), hit)) {
+			sink += hit.t;
+		}
+	});
+	runMicroBenchmark("picking/sphere_uniform_scale_hit", 1000000, [&](int) {
+		RayHit hit;
+		if (intersectSphere(eye, glm::vec3(0, 0, -1), UniformScaleTransform(glm::vec3(0.1f, 0.0f, 0.0f), 2.0f), hit)) {
+			sink += hit.t;
+		}
+	});
+	runMicroBenchmark("picking/ray_and_intersect_640x480", 640 * 480, [&](int i) {
+		glm::vec3 ray = generateRay(camera, i % 640, i / 640);
+		sink += intersect(eye, ray, sphereTransform);
+	});
+	// one of each shape side by side, the mesh being a single quad
+	TriangleMesh quad;
+	quad.positions.push_back(glm::vec3(-0.5f, -0.5f, 0.0f));
+	quad.positions.push_back(glm::vec3(0.5f, -0.5f, 0.0f));
+	quad.positions.push_back(glm::vec3(0.5f, 0.5f, 0.0f));
+	quad.positions.push_back(glm::vec3(-0.5f, 0.5f, 0.0f));
+	unsigned int quadIndices[6] = { 0, 1, 2, 0, 2, 3 };
+	quad.indices.assign(quadIndices, quadIndices + 6);
+	std::vector<Primitive> scene;
+	scene.push_back(makePrimitive(PRIMITIVE_SPHERE, glm::vec3(-1.0f, 0.4f, 0.0f), 0.5f));
+	scene.push_back(makePrimitive(PRIMITIVE_CUBE, glm::vec3(-0.4f, 0.4f, 0.0f), 0.5f));
+	scene.push_back(makePrimitive(PRIMITIVE_CYLINDER, glm::vec3(0.2f, 0.4f, 0.0f), 0.5f));
+	scene.push_back(makePrimitive(PRIMITIVE_CONE, glm::vec3(0.8f, 0.4f, 0.0f), 0.5f));
+	scene.push_back(makePrimitive(PRIMITIVE_MESH, glm::vec3(0.0f, -0.4f, 0.0f), 0.5f, &quad));
+	runMicroBenchmark("primitives/mixed_scene_640x480", 640 * 480, [&](int i) {
+		glm::vec3 ray = generateRay(camera, i % 640, i / 640);
+		RayHit hit;
+		sink += intersectPrimitives(scene, eye, ray, hit);
+	});
+	// a 64 point closed loop, 6400 arc length samples
+	std::vector<glm::vec3> loop;
+	for (int i = 0; i < 64; i++) {
+		float angle = 2.0f * PI * (float)i / 64.0f;
+		loop.push_back(glm::vec3(3.0f * sin(angle), 0.5f * sin(5.0f * angle), 3.0f * cos(angle)));
+	}
+	CameraSpline spline;
+	runMicroBenchmark("spline/build_64_points", 1000, [&](int) {
+		spline.setControlPoints(loop, SPLINE_CATMULL_ROM, true);
+		sink += spline.getLength();
+	});
+	runMicroBenchmark("spline/pose_at", 1000000, [&](int i) {
+		sink += spline.poseAt(0.001f * (float)i).position.x;
+	});
+	std::vector<CameraPose> poses;
+	runMicroBenchmark("spline/sample_10k_poses", 100, [&](int) {
+		spline.samplePoses(0.0f, spline.getLength() / 10000.0f, 10000, poses);
+		sink += poses.back().position.x;
+	});
+	runMicroBenchmark("ppm/parse_smile_512x512", 5, [&](int) {
+		ppm image("./data/smile.ppm");
+		sink += image.getWidth();
+	});
+
+	if (std::string("texture/bc1_512x512 texture/bc7_512x512 texture/bc1_512x512_1_thread texture/bc7_512x512_1_thread").find(filter) != std::string::npos) {
+		ppm smile("./data/smile.ppm");
+		runCompressionBenchmark("texture/bc1_512x512", smile, COMPRESSION_BC1, 0);
+		runCompressionBenchmark("texture/bc7_512x512", smile, COMPRESSION_BC7, 0);
+		runCompressionBenchmark("texture/bc1_512x512_1_thread", smile, COMPRESSION_BC1, 1);
+		runCompressionBenchmark("texture/bc7_512x512_1_thread", smile, COMPRESSION_BC7, 1);
+	}
+
+	if (std::string("resample/box_to_256 resample/bilinear_to_256 resample/lanczos3_to_256 resample/bilinear_to_1024 resample/lanczos3_to_1024 resample/lanczos3_to_256_1_thread").find(filter) != std::string::npos) {
+		ppm smile("./data/smile.ppm");
+		runResampleBenchmark("resample/box_to_256", smile, 256, 256, RESAMPLE_BOX, 0);
+		runResampleBenchmark("resample/bilinear_to_256", smile, 256, 256, RESAMPLE_BILINEAR, 0);
+		runResampleBenchmark("resample/lanczos3_to_256", smile, 256, 256, RESAMPLE_LANCZOS3, 0);
+		runResampleBenchmark("resample/bilinear_to_1024", smile, 1024, 1024, RESAMPLE_BILINEAR, 0);
+		runResampleBenchmark("resample/lanczos3_to_1024", smile, 1024, 1024, RESAMPLE_LANCZOS3, 0);
+		runResampleBenchmark("resample/lanczos3_to_256_1_thread", smile, 256, 256, RESAMPLE_LANCZOS3, 1);
+	}
+
+	// a 1M triangle height field standing upright in front of the camera
+	if (std::string("bvh/build_1M bvh/rays_640x480_1M").find(filter) != std::string::npos) {
+		TriangleMesh field;
+		buildGridMesh(707, field);
+		for (size_t i = 0; i < field.positions.size(); i++) {
+			glm::vec3 p = field.positions[i];
+			field.positions[i] = glm::vec3(2.0f * p.x - 1.0f, 1.0f - 2.0f * p.z, p.y);
+		}
+		MeshBVH bvh;
+		bvh.build(field);
+		printf("%-32s %8.1f ms (%d triangles, %d nodes)\n", "bvh/build_1M", 1000.0 * bvh.getBuildSeconds(), field.triangleCount(), bvh.getNodeCount());
+		runMicroBenchmark("bvh/rays_640x480_1M", 640 * 480, [&](int i) {
+			glm::vec3 ray = generateRay(camera, i % 640, i / 640);
+			MeshHit hit;
+			if (bvh.intersect(eye, ray, hit)) {
+				sink += hit.t;
+			}
+		});
+	}
+
+	// writing the models takes a while, skip it unless one of them is timed
+	if (std::string("mesh/load_ply_binary_2M mesh/load_ply_ascii_2M mesh/load_obj_2M").find(filter) != std::string::npos) {
+		writeBenchmarkMeshes();
+		runMeshBenchmark("mesh/load_ply_binary_2M", "bench_mesh_binary.ply");
+		runMeshBenchmark("mesh/load_ply_ascii_2M", "bench_mesh_ascii.ply");
+		runMeshBenchmark("mesh/load_obj_2M", "bench_mesh.obj");
+		remove("bench_mesh_binary.ply");
+		remove("bench_mesh_ascii.ply");
+		remove("bench_mesh.obj");
+	}
+	if (argc > 2) {
+		runMeshBenchmark("mesh/load_model", argv[2]);
+	}
+
+	return 0;
+}
@@ -3,6 +3,7 @@
 #ifndef MYGLCANVAS_H
 #define MYGLCANVAS_H
 
+#include "GLExt.h"
 #include <FL/gl.h>
 #include <FL/glut.h>
 #include <FL/glu.h>
@@ -10,56 +11,34 @@
 #include <time.h>
 #include <iostream>
 
-#include "SceneObject.h"
-#include "Camera.h"
-
-#define SPLINE_SIZE 100
-#define COASTER_SPEED 0.0001
+#include "SceneRenderer.h"
+#include "FrameCapture.h"
+#include "Benchmark.h"
 
 class MyGLCanvas : public Fl_Gl_Window {
 public:
 
-	// Length of our spline (i.e how many points do we randomly generate)
-
+	// Scene state (eye position, wireframe, sphere position, ...) and drawing
+	SceneRenderer renderer;
 
-	glm::vec3 eyePosition;
-	glm::vec3 rotVec;
-	glm::vec3 lookatPoint;
+	// Frame capture settings, toggled with 'c'
+	CaptureOptions captureOptions;
+	bool captureEnabled;
 
-	int wireframe;
-	int  viewAngle;
-	float clipNear;
-	float clipFar;
+	// Records the input events for replay by the benchmark harness (--record)
+	EventRecorder recorder;
 
 	MyGLCanvas(int x, int y, int w, int h, const char *l = 0);
 	~MyGLCanvas();
 
 private:
-	glm::vec3 generateRay(int pixelX, int pixelY);
-	glm::vec3 getEyePoint();
-	glm::vec3 getIsectPointWorldCoord(glm::vec3 eye, glm::vec3 ray, float t);
-	double intersect(glm::vec3 eyePointP, glm::vec3 rayV, glm::mat4 transformMatrix);
-
 	void draw();
-	void drawScene();
-
-	void drawAxis();
-	void drawGrid();
 
 	int handle(int);
 	void resize(int x, int y, int w, int h);
-	void updateCamera(int width, int height);
 
-	SceneObject* myObject;
-	Camera camera;
+	FrameCapture capture;
 	bool castRay;
-	bool drag;
-	glm::vec3 oldCenter;
-	glm::vec3 oldIsectPoint;
-	float oldT;
-
-	//// Used for intersection
-	glm::vec3 spherePosition;
 
 	int mouseX = 0;
 	int mouseY = 0;
@@ -0,0 +1,271 @@
+/*  =================== File Information =================
+	File Name: PaintHistory.cpp
+	Description:
+	Author:
+
+	Purpose: Tile images of the painting undo history
+	Usage:
+	===================================================== */
+
+#include <cstring>
+#include <algorithm>
+#include "PaintHistory.h"
+
+PaintHistory::PaintHistory(bool _compress) {
+	compress = _compress;
+	width = 0;
+	height = 0;
+	undoSteps = 0;
+	strokeOpen = false;
+	strokeNumber = 0;
+	stroke.bytes = 0;
+	memset(&stats, 0, sizeof(stats));
+}
+
+PaintHistory::~PaintHistory() {
+	clear();
+}
+
+void PaintHistory::clear() {
+	for (size_t i = 0; i < steps.size(); i++) {
+		releaseStep(steps[i]);
+	}
+	steps.clear();
+	undoSteps = 0;
+	releaseStep(stroke);
+	strokeOpen = false;
+	for (size_t i = 0; i < current.size(); i++) {
+		if (current[i] != NULL) {
+			release(current[i]);
+		}
+	}
+	current.clear();
+	tileStroke.clear();
+	restoredTiles.clear();
+	width = 0;
+	height = 0;
+	stats.undoSteps = 0;
+	stats.redoSteps = 0;
+}
+
+void PaintHistory::beginStroke(int _width, int _height) {
+	if (strokeOpen) {
+		return;
+	}
+	if (_width != width || _height != height) {
+		clear();
+		width = _width;
+		height = _height;
+		int tiles = tilesX() * ((height + PAINT_TILE_SIZE - 1) / PAINT_TILE_SIZE);
+		tileStroke.assign(tiles, 0);
+		current.assign(tiles, NULL);
+	}
+	strokeNumber++;
+	strokeOpen = true;
+	stroke.bytes = 0;
+}
+
+void PaintHistory::touch(ppm* image, int x, int y) {
+	if (x < 0 || y < 0 || x >= width || y >= height) {
+		return;
+	}
+	int tile = (y / PAINT_TILE_SIZE) * tilesX() + x / PAINT_TILE_SIZE;
+	if (tileStroke[tile] == strokeNumber) {
+		return;
+	}
+	tileStroke[tile] = strokeNumber;
+	// the image the tile got from the last step on it, if there was one
+	TileImage* before = current[tile];
+	if (before == NULL) {
+		before = capture(image, tile);
+		stroke.bytes += before->data.size();
+		retain(before);
+		current[tile] = before;
+	}
+	retain(before);
+	stroke.tiles.push_back(tile);
+	stroke.before.push_back(before);
+}
+
+void PaintHistory::endStroke(ppm* image) {
+	if (!strokeOpen) {
+		return;
+	}
+	strokeOpen = false;
+	if (stroke.tiles.empty()) {
+		return;
+	}
+	for (size_t i = 0; i < stroke.tiles.size(); i++) {
+		int tile = stroke.tiles[i];
+		TileImage* after = capture(image, tile);
+		stroke.bytes += after->data.size();
+		retain(after);
+		stroke.after.push_back(after);
+		retain(after);
+		release(current[tile]);
+		current[tile] = after;
+	}
+
+	// a new stroke ends what could be redone
+	for (size_t i = undoSteps; i < steps.size(); i++) {
+		releaseStep(steps[i]);
+	}
+	steps.resize(undoSteps);
+	steps.push_back(Step());
+	Step& step = steps.back();
+	step.tiles.swap(stroke.tiles);
+	step.before.swap(stroke.before);
+	step.after.swap(stroke.after);
+	step.bytes = stroke.bytes;
+	undoSteps++;
+	enforceLimits();
+	stats.undoSteps = undoSteps;
+	stats.redoSteps = 0;
+}
+
+bool PaintHistory::undo(ppm* image) {
+	endStroke(image);
+	restoredTiles.clear();
+	if (undoSteps == 0) {
+		return false;
+	}
+	undoSteps--;
+	return apply(image, steps[undoSteps], false);
+}
+
+bool PaintHistory::redo(ppm* image) {
+	// a stroke that touched anything drops the steps that could be redone
+	endStroke(image);
+	restoredTiles.clear();
+	if (undoSteps == (int)steps.size()) {
+		return false;
+	}
+	undoSteps++;
+	return apply(image, steps[undoSteps - 1], true);
+}
+
+bool PaintHistory::apply(ppm* image, Step& step, bool forward) {
+	for (size_t i = 0; i < step.tiles.size(); i++) {
+		int tile = step.tiles[i];
+		TileImage* tileImage = forward ? step.after[i] : step.before[i];
+		restore(image, tile, tileImage);
+		retain(tileImage);
+		release(current[tile]);
+		current[tile] = tileImage;
+		restoredTiles.push_back(tile);
+	}
+	stats.restoredTiles += (int)step.tiles.size();
+	stats.undoSteps = undoSteps;
+	stats.redoSteps = (int)steps.size() - undoSteps;
+	return true;
+}
+
+void PaintHistory::getRestoredRect(int i, int& x, int& y, int& tileWidth, int& tileHeight) {
+	tileRect(restoredTiles[i], x, y, tileWidth, tileHeight);
+}
+
+void PaintHistory::tileRect(int tile, int& x, int& y, int& tileWidth, int& tileHeight) {
+	x = (tile % tilesX()) * PAINT_TILE_SIZE;
+	y = (tile / tilesX()) * PAINT_TILE_SIZE;
+	tileWidth = std::min(PAINT_TILE_SIZE, width - x);
+	tileHeight = std::min(PAINT_TILE_SIZE, height - y);
+}
+
+/*	Run length encoding of whole texels: a count - 1 byte followed by
+	the texel, for runs of up to 256.
+*/
+PaintHistory::TileImage* PaintHistory::capture(ppm* image, int tile) {
+	int x, y, tileWidth, tileHeight;
+	tileRect(tile, x, y, tileWidth, tileHeight);
+	size_t rowBytes = (size_t)tileWidth * 3;
+	size_t rawBytes = rowBytes * tileHeight;
+	scratch.resize(rawBytes);
+	const unsigned char* pixels = (const unsigned char*)image->getPixels();
+	for (int row = 0; row < tileHeight; row++) {
+		memcpy(&scratch[row * rowBytes], pixels + ((size_t)(y + row) * width + x) * 3, rowBytes);
+	}
+
+	TileImage* tileImage = new TileImage();
+	tileImage->references = 0;
+	tileImage->compressed = false;
+	tileImage->rawBytes = rawBytes;
+	if (compress) {
+		std::vector<unsigned char>& runs = tileImage->data;
+		size_t texels = rawBytes / 3;
+		for (size_t i = 0; i < texels && runs.size() < rawBytes;) {
+			const unsigned char* texel = &scratch[i * 3];
+			size_t length = 1;
+			while (i + length < texels && length < 256 && memcmp(texel, &scratch[(i + length) * 3], 3) == 0) {
+				length++;
+			}
+			runs.push_back((unsigned char)(length - 1));
+			runs.insert(runs.end(), texel, texel + 3);
+			i += length;
+		}
+		tileImage->compressed = (runs.size() < rawBytes);
+	}
+	if (!tileImage->compressed) {
+		tileImage->data.assign(scratch.begin(), scratch.end());
+	}
+	tileImage->data.shrink_to_fit();
+	stats.tileImages++;
+	stats.bytes += tileImage->data.size();
+	stats.rawBytes += rawBytes;
+	return tileImage;
+}
+
+void PaintHistory::restore(ppm* image, int tile, const TileImage* tileImage) {
+	int x, y, tileWidth, tileHeight;
+	tileRect(tile, x, y, tileWidth, tileHeight);
+	size_t rowBytes = (size_t)tileWidth * 3;
+	const unsigned char* texels = &tileImage->data[0];
+	if (tileImage->compressed) {
+		scratch.resize(rowBytes * tileHeight);
+		size_t texel = 0;
+		for (size_t i = 0; i < tileImage->data.size(); i += 4) {
+			for (int k = 0; k <= tileImage->data[i]; k++, texel++) {
+				memcpy(&scratch[texel * 3], &tileImage->data[i + 1], 3);
+			}
+		}
+		texels = &scratch[0];
+	}
+	unsigned char* pixels = (unsigned char*)image->getPixels();
+	for (int row = 0; row < tileHeight; row++) {
+		memcpy(pixels + ((size_t)(y + row) * width + x) * 3, texels + row * rowBytes, rowBytes);
+	}
+}
+
+void PaintHistory::release(TileImage* tileImage) {
+	if (--tileImage->references > 0) {
+		return;
+	}
+	stats.tileImages--;
+	stats.bytes -= tileImage->data.size();
+	stats.rawBytes -= tileImage->rawBytes;
+	delete tileImage;
+}
+
+void PaintHistory::releaseStep(Step& step) {
+	for (size_t i = 0; i < step.before.size(); i++) {
+		release(step.before[i]);
+	}
+	for (size_t i = 0; i < step.after.size(); i++) {
+		release(step.after[i]);
+	}
+	step.tiles.clear();
+	step.before.clear();
+	step.after.clear();
+	step.bytes = 0;
+}
+
+/*	The oldest steps go first, the last one is kept whatever it holds.
+	Only called by endStroke(), when nothing can be redone.
+*/
+void PaintHistory::enforceLimits() {
+	while (undoSteps > 1 && (undoSteps > PAINT_HISTORY_STEPS || stats.bytes > PAINT_HISTORY_BYTES)) {
+		releaseStep(steps[0]);
+		steps.erase(steps.begin());
+		undoSteps--;
+		stats.droppedSteps++;
+	}
+}
@@ -0,0 +1,157 @@
+/*  =================== File Information =================
+	File Name: PaintHistory.h
+	Description:
+	Author:
+
+	Purpose: Undo and redo of painting.  The image is divided into
+			 PAINT_TILE_SIZE square tiles and a stroke keeps only the
+			 tiles it touched, as they were before and after it, instead
+			 of a copy of the whole image.
+
+			 Tile images are shared and reference counted: the image of a
+			 tile after one stroke is the image before the next stroke on
+			 that tile, so every version of a tile is held once however
+			 many steps refer to it.  With compression on they are run
+			 length encoded, which painted images with flat areas shrink
+			 well; a tile that would grow is kept raw.
+
+			 The oldest steps are dropped when there are more than
+			 PAINT_HISTORY_STEPS or they hold more than
+			 PAINT_HISTORY_BYTES.
+	Usage:	PaintHistory history;
+			history.beginStroke(image->getWidth(), image->getHeight());
+			history.touch(image, x, y);		// before every texel painted
+			image->setPixel(x, y, r, g, b);
+			history.endStroke(image);
+			if (history.undo(image)) {
+				// upload getRestoredRect(i) for i < getRestoredCount()
+			}
+
+			Every change of the image has to go through a stroke, or the
+			history has to be cleared: a tile image is trusted to still
+			be what the tile holds.
+	===================================================== */
+#ifndef PAINT_HISTORY_H
+#define PAINT_HISTORY_H
+
+#include <vector>
+#include <cstddef>
+#include "ppm.h"
+
+#define PAINT_TILE_SIZE 32					// texels per tile side, 3 KB raw
+#define PAINT_HISTORY_STEPS 64				// strokes kept for undo
+#define PAINT_HISTORY_BYTES (32 << 20)		// tile images kept for undo and redo
+
+struct PaintHistoryStats {
+	int undoSteps;
+	int redoSteps;
+	int tileImages;			// distinct tile images held
+	size_t bytes;			// held by those
+	size_t rawBytes;		// what they would take uncompressed
+	int droppedSteps;		// oldest steps dropped for the limits
+	int restoredTiles;		// by every undo and redo
+};
+
+class PaintHistory {
+public:
+	PaintHistory(bool _compress = true);
+	~PaintHistory();
+
+	/*	===============================================
+	Desc:	Drops every step, e.g. when the image is replaced
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void clear();
+	// compress the tile images taken from now on
+	void setCompression(bool enabled) { compress = enabled; }
+
+	/*	===============================================
+	Desc:	Starts a step.  An image of another size than the last one
+			clears the history first.
+	Precondition:
+	Postcondition:	Does nothing if a stroke is open.
+	=============================================== */
+	void beginStroke(int width, int height);
+	bool isStrokeOpen() { return strokeOpen; }
+	/*	===============================================
+	Desc:	Records the tile of texel (x, y) the first time the stroke
+			touches it.  Call it before the texel is changed.
+	Precondition:	isStrokeOpen(), image is the size given to beginStroke
+	Postcondition:	Texels outside the image are ignored.
+	=============================================== */
+	void touch(ppm* image, int x, int y);
+	/*	===============================================
+	Desc:	Closes the stroke, which drops the steps that could be redone.
+			A stroke that touched nothing is not kept.
+	Precondition:	image is the one painted
+	Postcondition:
+	=============================================== */
+	void endStroke(ppm* image);
+
+	/*	===============================================
+	Desc:	Puts the tiles of the last step back as they were before it,
+			or after it for redo().  An open stroke is ended first.
+	Precondition:	image is the one painted
+	Postcondition:	Returns false if there is nothing to undo or redo,
+					otherwise getRestoredRect lists the tiles changed.
+	=============================================== */
+	bool undo(ppm* image);
+	bool redo(ppm* image);
+	int getRestoredCount() { return (int)restoredTiles.size(); }
+	void getRestoredRect(int i, int& x, int& y, int& width, int& height);
+
+	/*	===============================================
+	Desc:	Steps, oldest first, including those that can be redone
+			(step >= getStats().undoSteps).  The bytes of a step are the
+			tile images it added to the history, images it shares with
+			the step before are counted there.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	int getStepCount() { return (int)steps.size(); }
+	size_t getStepBytes(int step) { return steps[step].bytes; }
+	int getStepTiles(int step) { return (int)steps[step].tiles.size(); }
+	const PaintHistoryStats& getStats() { return stats; }
+
+private:
+	// one version of a tile, shared by every step that refers to it
+	struct TileImage {
+		int references;
+		bool compressed;
+		size_t rawBytes;
+		std::vector<unsigned char> data;
+	};
+	struct Step {
+		std::vector<int> tiles;
+		std::vector<TileImage*> before;
+		std::vector<TileImage*> after;
+		size_t bytes;
+	};
+
+	int tilesX() { return (width + PAINT_TILE_SIZE - 1) / PAINT_TILE_SIZE; }
+	void tileRect(int tile, int& x, int& y, int& tileWidth, int& tileHeight);
+	TileImage* capture(ppm* image, int tile);
+	void restore(ppm* image, int tile, const TileImage* tileImage);
+	void retain(TileImage* tileImage) { tileImage->references++; }
+	void release(TileImage* tileImage);
+	void releaseStep(Step& step);
+	void enforceLimits();
+	bool apply(ppm* image, Step& step, bool forward);
+
+	bool compress;
+	int width;
+	int height;
+	std::vector<Step> steps;
+	int undoSteps;				// steps[0, undoSteps) can be undone
+	Step stroke;				// the open stroke
+	bool strokeOpen;
+	unsigned int strokeNumber;
+	std::vector<unsigned int> tileStroke;	// stroke that last touched every tile
+	std::vector<TileImage*> current;		// what every tile holds, NULL if not taken yet
+	std::vector<int> restoredTiles;
+	std::vector<unsigned char> scratch;		// a raw tile
+	PaintHistoryStats stats;
+};
+
+#endif
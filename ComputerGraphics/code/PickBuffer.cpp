@@ -0,0 +1,226 @@
+/*  =================== File Information =================
+	File Name: PickBuffer.cpp
+	Description:
+	Author:
+
+	Purpose: CPU rasterizer for the object id and depth buffer
+	Usage:
+	===================================================== */
+
+#include <cmath>
+#include <algorithm>
+#include "PickBuffer.h"
+
+PickBuffer::PickBuffer() {
+	width = 0;
+	height = 0;
+	downscale = 1;
+	screenWidth = 0;
+	screenHeight = 0;
+	viewProjection = glm::mat4(1.0f);
+	inverseViewProjection = glm::mat4(1.0f);
+}
+
+void PickBuffer::begin(Camera& camera, int _downscale) {
+	downscale = std::max(1, _downscale);
+	screenWidth = camera.getScreenWidth();
+	screenHeight = camera.getScreenHeight();
+	width = std::max(1, (screenWidth + downscale - 1) / downscale);
+	height = std::max(1, (screenHeight + downscale - 1) / downscale);
+	viewProjection = camera.getProjectionMatrix() * camera.getModelViewMatrix();
+	inverseViewProjection = glm::inverse(viewProjection);
+	ids.assign(width * height, PICK_NONE);
+	depths.assign(width * height, INFINITY);
+}
+
+void PickBuffer::copyFrom(const PickBuffer& layer) {
+	width = layer.width;
+	height = layer.height;
+	downscale = layer.downscale;
+	screenWidth = layer.screenWidth;
+	screenHeight = layer.screenHeight;
+	viewProjection = layer.viewProjection;
+	inverseViewProjection = layer.inverseViewProjection;
+	// the vectors keep their capacity, only the scratch space is not copied
+	ids = layer.ids;
+	depths = layer.depths;
+}
+
+void PickBuffer::pixelRay(float x, float y, glm::vec3& origin, glm::vec3& dir) const {
+	float ndcX = 2.0f * x / screenWidth - 1.0f;
+	float ndcY = 1.0f - 2.0f * y / screenHeight;
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+	origin = glm::vec3(nearPoint) / nearPoint.w;
+	dir = glm::vec3(farPoint) / farPoint.w - origin;
+}
+
+float PickBuffer::clipW(const glm::vec3& p) const {
+	return viewProjection[0][3] * p.x + viewProjection[1][3] * p.y + viewProjection[2][3] * p.z + viewProjection[3][3];
+}
+
+void PickBuffer::drawSphere(int id, const glm::vec3& center, float radius) {
+	if (ids.empty()) {
+		return;
+	}
+	// cells covered by the projected bounding cube, all of them if it
+	// reaches behind the eye
+	float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+	bool behind = false;
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec3 p = center + radius * glm::vec3((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+		glm::vec4 clip = viewProjection * glm::vec4(p, 1.0f);
+		if (clip.w <= 0.0f) {
+			behind = true;
+			break;
+		}
+		float x = (clip.x / clip.w + 1.0f) * 0.5f * screenWidth / downscale - 0.5f;
+		float y = (1.0f - clip.y / clip.w) * 0.5f * screenHeight / downscale - 0.5f;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+	}
+	int x0 = behind ? 0 : std::max(0, (int)ceil(minX));
+	int y0 = behind ? 0 : std::max(0, (int)ceil(minY));
+	int x1 = behind ? width - 1 : std::min(width - 1, (int)floor(maxX));
+	int y1 = behind ? height - 1 : std::min(height - 1, (int)floor(maxY));
+
+	for (int cellY = y0; cellY <= y1; cellY++) {
+		for (int cellX = x0; cellX <= x1; cellX++) {
+			glm::vec3 origin, dir;
+			pixelRay((cellX + 0.5f) * downscale, (cellY + 0.5f) * downscale, origin, dir);
+			glm::vec3 oc = origin - center;
+			float a = glm::dot(dir, dir);
+			float halfB = glm::dot(dir, oc);
+			float c = glm::dot(oc, oc) - radius * radius;
+			float discriminant = halfB * halfB - a * c;
+			if (discriminant < 0.0f) {
+				continue;
+			}
+			float root = sqrt(discriminant);
+			float t = (-halfB - root) / a;
+			if (t < 0.0f) {
+				// the near plane cuts the sphere, the far side shows
+				t = (-halfB + root) / a;
+				if (t < 0.0f) {
+					continue;
+				}
+			}
+			float depth = clipW(origin + t * dir);
+			int cell = cellY * width + cellX;
+			if (depth < depths[cell]) {
+				depths[cell] = depth;
+				ids[cell] = id;
+			}
+		}
+	}
+}
+
+void PickBuffer::drawMesh(int id, const TriangleMesh& mesh, const glm::vec3& translation) {
+	if (ids.empty()) {
+		return;
+	}
+	clipPositions.resize(mesh.positions.size());
+	for (size_t i = 0; i < mesh.positions.size(); i++) {
+		clipPositions[i] = viewProjection * glm::vec4(mesh.positions[i] + translation, 1.0f);
+	}
+
+	int count = mesh.triangleCount();
+	for (int i = 0; i < count; i++) {
+		const glm::vec4& a = clipPositions[mesh.indices[3 * i]];
+		const glm::vec4& b = clipPositions[mesh.indices[3 * i + 1]];
+		const glm::vec4& c = clipPositions[mesh.indices[3 * i + 2]];
+		// whole triangle outside one of the side planes
+		if ((a.x > a.w && b.x > b.w && c.x > c.w) || (a.x < -a.w && b.x < -b.w && c.x < -c.w) ||
+			(a.y > a.w && b.y > b.w && c.y > c.w) || (a.y < -a.w && b.y < -b.w && c.y < -c.w)) {
+			continue;
+		}
+		// distances to the near plane z = -w, negative behind it
+		float da = a.z + a.w;
+		float db = b.z + b.w;
+		float dc = c.z + c.w;
+		if (da >= 0.0f && db >= 0.0f && dc >= 0.0f) {
+			drawTriangle(id, a, b, c);
+			continue;
+		}
+		if (da < 0.0f && db < 0.0f && dc < 0.0f) {
+			continue;
+		}
+		// clip the polygon at the near plane, which leaves 3 or 4 corners
+		const glm::vec4* in[3] = { &a, &b, &c };
+		float d[3] = { da, db, dc };
+		glm::vec4 out[4];
+		int outCount = 0;
+		for (int k = 0; k < 3; k++) {
+			int next = (k + 1) % 3;
+			if (d[k] >= 0.0f) {
+				out[outCount++] = *in[k];
+			}
+			if ((d[k] >= 0.0f) != (d[next] >= 0.0f)) {
+				float s = d[k] / (d[k] - d[next]);
+				out[outCount++] = *in[k] + s * (*in[next] - *in[k]);
+			}
+		}
+		for (int k = 1; k + 1 < outCount; k++) {
+			drawTriangle(id, out[0], out[k], out[k + 1]);
+		}
+	}
+}
+
+void PickBuffer::drawTriangle(int id, const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+	// corners in cell units, cell centres at whole numbers
+	float scaleX = 0.5f * screenWidth / downscale;
+	float scaleY = 0.5f * screenHeight / downscale;
+	float ax = (a.x / a.w + 1.0f) * scaleX - 0.5f, ay = (1.0f - a.y / a.w) * scaleY - 0.5f;
+	float bx = (b.x / b.w + 1.0f) * scaleX - 0.5f, by = (1.0f - b.y / b.w) * scaleY - 0.5f;
+	float cx = (c.x / c.w + 1.0f) * scaleX - 0.5f, cy = (1.0f - c.y / c.w) * scaleY - 0.5f;
+
+	int x0 = std::max(0, (int)ceil(std::min(ax, std::min(bx, cx))));
+	int x1 = std::min(width - 1, (int)floor(std::max(ax, std::max(bx, cx))));
+	int y0 = std::max(0, (int)ceil(std::min(ay, std::min(by, cy))));
+	int y1 = std::min(height - 1, (int)floor(std::max(ay, std::max(by, cy))));
+	if (x0 > x1 || y0 > y1) {
+		return;
+	}
+	float area = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+	if (area == 0.0f) {
+		return;
+	}
+	// barycentric weights and 1 / w are linear in screen space
+	float inverseArea = 1.0f / area;
+	float inverseWA = 1.0f / a.w, inverseWB = 1.0f / b.w, inverseWC = 1.0f / c.w;
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			float wa = ((bx - x) * (cy - y) - (by - y) * (cx - x)) * inverseArea;
+			float wb = ((cx - x) * (ay - y) - (cy - y) * (ax - x)) * inverseArea;
+			float wc = 1.0f - wa - wb;
+			if (wa < 0.0f || wb < 0.0f || wc < 0.0f) {
+				continue;
+			}
+			float depth = 1.0f / (wa * inverseWA + wb * inverseWB + wc * inverseWC);
+			int cell = y * width + x;
+			if (depth < depths[cell]) {
+				depths[cell] = depth;
+				ids[cell] = id;
+			}
+		}
+	}
+}
+
+int PickBuffer::lookup(int x, int y, glm::vec3* point) const {
+	if (x < 0 || y < 0 || x >= screenWidth || y >= screenHeight || ids.empty()) {
+		return PICK_NONE;
+	}
+	int cell = (y / downscale) * width + x / downscale;
+	if (point != NULL && ids[cell] != PICK_NONE) {
+		// the point at the cell's depth along the ray through the pixel itself
+		glm::vec3 origin, dir;
+		pixelRay((float)x, (float)y, origin, dir);
+		float originW = clipW(origin);
+		float slope = clipW(origin + dir) - originW;
+		float t = (slope != 0.0f) ? (depths[cell] - originW) / slope : 0.0f;
+		*point = origin + t * dir;
+	}
+	return ids[cell];
+}
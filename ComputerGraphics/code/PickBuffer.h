@@ -0,0 +1,92 @@
+/*  =================== File Information =================
+	File Name: PickBuffer.h
+	Description:
+	Author:
+
+	Purpose: Object id and depth buffer rasterized on the CPU at a fraction
+			 of the window resolution.  It is redrawn only when the camera
+			 or an object moves; in between, finding the object under the
+			 mouse is one array lookup no matter how many objects or
+			 triangles the scene has.
+	Usage:	PickBuffer buffer;
+			buffer.begin(camera, PICK_BUFFER_DOWNSCALE);
+			buffer.drawSphere(sphereId, center, 0.5f);
+			buffer.drawMesh(meshId, mesh, meshPosition);
+			int id = buffer.lookup(mouseX, mouseY);
+	===================================================== */
+#ifndef PICK_BUFFER_H
+#define PICK_BUFFER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "Camera.h"
+#include "Primitives.h"
+
+#define PICK_BUFFER_DOWNSCALE 4		// window pixels per buffer cell along each axis
+#define PICK_NONE -1				// id of the cells no object covers
+
+class PickBuffer {
+public:
+	PickBuffer();
+
+	/*	===============================================
+	Desc:	Clears the buffer and sizes it to the camera's screen divided
+			by downscale.  Objects are drawn with the camera's projection
+			and model view matrices, the same ones the scene is drawn with.
+	Precondition:	downscale >= 1
+	Postcondition:	Every cell holds PICK_NONE.
+	=============================================== */
+	void begin(Camera& camera, int downscale);
+	/*	===============================================
+	Desc:	Draws a sphere, depth tested against what is already there
+	Precondition:	begin() was called.
+	Postcondition:
+	=============================================== */
+	void drawSphere(int id, const glm::vec3& center, float radius);
+	/*	===============================================
+	Desc:	Draws every triangle of a mesh placed at translation, clipped at
+			the near plane.  Both sides of the triangles are drawn.
+	Precondition:	begin() was called.
+	Postcondition:
+	=============================================== */
+	void drawMesh(int id, const TriangleMesh& mesh, const glm::vec3& translation);
+	/*	===============================================
+	Desc:	Makes this buffer a copy of another one, e.g. a layer of the
+			objects that did not move, before drawing the ones that did
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void copyFrom(const PickBuffer& layer);
+	/*	===============================================
+	Desc:	Returns the id of the nearest object at window pixel (x, y),
+			y counted from the top like the mouse coordinates.
+	Precondition:
+	Postcondition:	Returns PICK_NONE outside the window or where no object
+					was drawn.  point receives the world space point on
+					the object if it is not NULL.
+	=============================================== */
+	int lookup(int x, int y, glm::vec3* point = NULL) const;
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+
+private:
+	// world space ray through window pixel (x, y), t = 0 at the near plane
+	void pixelRay(float x, float y, glm::vec3& origin, glm::vec3& dir) const;
+	// clip space w of a world space point
+	float clipW(const glm::vec3& p) const;
+	void drawTriangle(int id, const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+
+	int width;
+	int height;
+	int downscale;
+	int screenWidth;
+	int screenHeight;
+	glm::mat4 viewProjection;
+	glm::mat4 inverseViewProjection;
+	std::vector<int> ids;
+	std::vector<float> depths;		// clip space w, the distance in front of the eye
+	std::vector<glm::vec4> clipPositions;	// drawMesh scratch, kept to avoid reallocating
+};
+
+#endif
@@ -0,0 +1,90 @@
+/*  =================== File Information =================
+	File Name: Picking.cpp
+	Description:
+	Author:
+
+	Purpose: Ray generation and ray-sphere intersection
+	Usage:
+	===================================================== */
+
+#include <cmath>
+#include "Picking.h"
+
+/* The generateRay function accepts the camera and the mouse click coordinates
+	(in x and y, which will be integers between 0 and screen width and 0 and screen height respectively).
+   The function returns the ray
+*/
+glm::vec3 generateRay(Camera& camera, float pixelX, float pixelY) {
+	glm::vec3 eyePoint = camera.getEyePoint();
+	glm::vec3 lookVector = camera.getLookVector();
+	float nearPlane = camera.getNearPlane();
+	int screenWidth = camera.getScreenWidth(); // do we use pixelWidth?
+	int screenHeight = camera.getScreenHeight();
+	float viewAngle = camera.getViewAngle();
+	float screenWidthRatio = (float)screenHeight / (float)screenWidth;
+	glm::vec3 upVector = camera.getUpVector();
+	glm::vec3 w = -1.0f * lookVector / glm::length(lookVector);
+	glm::vec3 u = glm::cross(upVector, w) / glm::length(glm::cross(upVector, w));
+	glm::vec3 v = glm::cross(w, u);
+	float width = (tan(glm::radians(viewAngle) / 2.0f) * nearPlane); // w/2=tan(theta_w/2)*far
+	float height = width * screenWidthRatio;
+
+	glm::vec3 Q = eyePoint - nearPlane * w;
+	float a = -width + 2.0f * width * (pixelX / (float)screenWidth);
+	// pixel rows go down the screen, v points up
+	float b = height - 2.0f * height * (pixelY / (float)screenHeight);
+
+	glm::vec3 S = Q + a * u + b * v;
+	glm::vec3 dHat = glm::normalize(S - eyePoint);
+	return dHat;
+}
+
+/* The getIsectPointWorldCoord function accepts three input parameters:
+	(1) the eye point (in world coordinate)
+	(2) the ray vector (in world coordinate)
+	(3) the "t" value
+
+	The function should return the intersection point on the sphere
+*/
+glm::vec3 getIsectPointWorldCoord(glm::vec3 eye, glm::vec3 ray, float t) {
+	glm::vec3 p = eye + t * ray;
+	return p;
+}
+
+/* The intersect function accepts three input parameters:
+	(1) the eye point (in world coordinate)
+	(2) the ray vector (in world coordinate)
+	(3) the transform matrix that would be applied to there sphere to transform it from object coordinate to world coordinate
+
+	The function should return:
+	(1) a -1 if no intersection is found
+	(2) OR, the "t" value which is the distance from the origin of the ray to the (nearest) intersection point on the sphere
+*/
+double intersect(const glm::vec3& eyePointP, const glm::vec3& rayV, const glm::mat4& transformMatrix) {
+	glm::mat4 inverseTransform = glm::inverse(transformMatrix);
+	glm::vec3 eyePointPO = glm::vec3(inverseTransform * glm::vec4(eyePointP, 1));
+	glm::vec3 d = glm::vec3(inverseTransform * glm::vec4(rayV, 0));
+
+	// in object space the sphere sits at the origin
+	RayHit hit;
+	if (!intersectSphere(eyePointPO, d, TranslateTransform(glm::vec3(0, 0, 0)), hit)) {
+		return -1;
+	}
+	return hit.t;
+}
+
+glm::vec2 sphereUV(glm::vec3 objectPoint) {
+	// undo the glRotatef(90, 0, 1, 0) the sphere is drawn with
+	glm::vec3 drawn(-objectPoint.z, objectPoint.y, objectPoint.x);
+	float longitude = atan2(drawn.z, drawn.x);		// -PI..PI, 0 along +x
+	if (longitude < 0) {
+		longitude += 2.0f * PI;
+	}
+	float latitude = asin(glm::clamp(2.0f * drawn.y, -1.0f, 1.0f));	// -PI/2 at the bottom
+	float u = 1.0f - longitude / (2.0f * PI);
+	// the vertices of stack i get v = 1 - (i - 1) / segments
+	float stack = (latitude + PI / 2.0f) / (PI / (float)SPHERE_SEGMENTS_Y);
+	float v = 1.0f - (stack - 1.0f) / (float)SPHERE_SEGMENTS_Y;
+	v -= floor(v);
+	return glm::vec2(u >= 1.0f ? 0.0f : u, v >= 1.0f ? 0.0f : v);
+}
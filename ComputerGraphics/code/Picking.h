@@ -0,0 +1,133 @@
+/*  =================== File Information =================
+	File Name: Picking.h
+	Description:
+	Author:
+
+	Purpose: Ray casting used to pick the sphere with the mouse.  This
+			 code only depends on glm and the camera, not on OpenGL or
+			 FLTK.
+	Usage:
+	===================================================== */
+#ifndef PICKING_H
+#define PICKING_H
+
+#include <cmath>
+#include <glm/glm.hpp>
+#include "Camera.h"
+
+// Rays closer than this to their origin do not count as hits
+#define RAY_EPSILON 1e-4f
+
+#define SPHERE_SEGMENTS_X 20	// slices of drawTexturedSphere around the y axis
+#define SPHERE_SEGMENTS_Y 20	// stacks from pole to pole
+
+/*
+	Everything known about the nearest hit of a ray
+*/
+struct RayHit {
+	float t;			// ray parameter, > 0
+	glm::vec3 point;	// world space
+	glm::vec3 normal;	// world space, unit length, pointing out of the object
+	glm::vec2 uv;		// texture coordinate in [0, 1)
+};
+
+/*
+	Placements of an object whose kind is known at compile time, so the
+	intersection does not have to invert a general matrix.  Both only
+	move the object and scale it by a constant.
+*/
+struct TranslateTransform {
+	glm::vec3 translation;
+
+	TranslateTransform(glm::vec3 _translation) : translation(_translation) {}
+	float scale() const { return 1.0f; }
+};
+
+struct UniformScaleTransform {
+	glm::vec3 translation;
+	float scaleFactor;
+
+	UniformScaleTransform(glm::vec3 _translation, float _scaleFactor) : translation(_translation), scaleFactor(_scaleFactor) {}
+	float scale() const { return scaleFactor; }
+};
+
+/*	===============================================
+Desc:	Returns the normalized world space direction of the ray from the eye
+		through pixel (pixelX, pixelY) of the camera's screen.  Fractional
+		pixel positions are allowed.
+Precondition:	The camera's screen size has been set.
+Postcondition:
+=============================================== */
+glm::vec3 generateRay(Camera& camera, float pixelX, float pixelY);
+/*	===============================================
+Desc:	Returns the point eye + t * ray
+Precondition:
+Postcondition:
+=============================================== */
+glm::vec3 getIsectPointWorldCoord(glm::vec3 eye, glm::vec3 ray, float t);
+/*	===============================================
+Desc:	Intersects a ray with the unit diameter sphere placed in the world by
+		transformMatrix
+Precondition:
+Postcondition:	Returns -1 if there is no intersection, otherwise the ray
+				parameter t of the nearest intersection in front of the eye.
+=============================================== */
+double intersect(const glm::vec3& eyePointP, const glm::vec3& rayV, const glm::mat4& transformMatrix);
+/*	===============================================
+Desc:	Returns the texture coordinate the drawn sphere shows at a point of
+		the unit diameter sphere, given relative to its center.  The scene
+		draws every sphere turned by 90 degrees about y, which is undone
+		here; then u runs backwards around the y axis and v follows the
+		triangles of drawTexturedSphere, one stack off from the latitude.
+Precondition:
+Postcondition:	Both coordinates are wrapped into [0, 1) like GL_REPEAT.
+=============================================== */
+glm::vec2 sphereUV(glm::vec3 objectPoint);
+/*	===============================================
+Desc:	Intersects a ray with the unit diameter sphere placed by a
+		translation or uniform scale transform.  Tangent rays count as hits,
+		and a ray starting inside the sphere hits the far side.
+Precondition:
+Postcondition:	Returns false if there is no hit in front of the eye,
+				otherwise hit describes the nearest one.
+=============================================== */
+template <class Transform>
+bool intersectSphere(const glm::vec3& eyePoint, const glm::vec3& ray, const Transform& transform, RayHit& hit) {
+	float radius = 0.5f * transform.scale();
+	glm::vec3 oc = eyePoint - transform.translation;
+	// t^2 a + 2 t halfB + c = 0
+	float halfB = glm::dot(oc, ray);
+	float c = glm::dot(oc, oc) - radius * radius;
+	// starting outside and pointing away from the center can never hit
+	if (c > 0.0f && halfB > 0.0f) {
+		return false;
+	}
+	float a = glm::dot(ray, ray);
+	float discriminant = halfB * halfB - a * c;
+	if (discriminant < 0.0f) {
+		return false;
+	}
+	// q / a and c / q are the two roots without cancellation in either
+	float q = -(halfB + std::copysign(std::sqrt(discriminant), halfB));
+	if (q == 0.0f) {
+		return false;
+	}
+	float t0 = q / a;
+	float t1 = c / q;
+	if (t0 > t1) {
+		float swap = t0;
+		t0 = t1;
+		t1 = swap;
+	}
+	float t = (t0 > RAY_EPSILON) ? t0 : t1;
+	if (t <= RAY_EPSILON) {
+		return false;
+	}
+	hit.t = t;
+	hit.point = eyePoint + t * ray;
+	hit.normal = (hit.point - transform.translation) / radius;
+	hit.uv = sphereUV(0.5f * hit.normal);
+	return true;
+}
+
+#endif
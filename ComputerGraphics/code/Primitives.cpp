@@ -0,0 +1,270 @@
+/*  =================== File Information =================
+	File Name: Primitives.cpp
+	Description:
+	Author:
+
+	Purpose: Ray intersection for the basic shapes
+	Usage:
+	===================================================== */
+
+#include <cmath>
+#include "Primitives.h"
+#include "MeshBVH.h"
+
+/*	Roots t0 <= t1 of a t^2 + 2 halfB t + c = 0, without cancellation.
+	A (nearly) zero a leaves the linear equation with a single root.
+*/
+static bool solveQuadratic(float a, float halfB, float c, float& t0, float& t1) {
+	if (fabs(a) < 1e-12f) {
+		if (halfB == 0.0f) {
+			return false;
+		}
+		t0 = t1 = -c / (2.0f * halfB);
+		return true;
+	}
+	float discriminant = halfB * halfB - a * c;
+	if (discriminant < 0.0f) {
+		return false;
+	}
+	float q = -(halfB + std::copysign(std::sqrt(discriminant), halfB));
+	if (q == 0.0f) {
+		t0 = t1 = 0.0f;
+		return true;
+	}
+	t0 = q / a;
+	t1 = c / q;
+	if (t0 > t1) {
+		float swap = t0;
+		t0 = t1;
+		t1 = swap;
+	}
+	return true;
+}
+
+/*	u running backwards around the y axis, 0 along +x */
+static float aroundY(float x, float z) {
+	float longitude = atan2(z, x);
+	if (longitude < 0) {
+		longitude += 2.0f * PI;
+	}
+	float u = 1.0f - longitude / (2.0f * PI);
+	return u >= 1.0f ? 0.0f : u;
+}
+
+/*	Hit of the disc of radius 0.5 at height y, facing up or down */
+static bool intersectCap(const glm::vec3& origin, const glm::vec3& dir, float y, float normalY, float& t, RayHit& hit) {
+	if (dir.y == 0.0f) {
+		return false;
+	}
+	float tCap = (y - origin.y) / dir.y;
+	if (tCap <= RAY_EPSILON || tCap >= t) {
+		return false;
+	}
+	glm::vec3 p = origin + tCap * dir;
+	if (p.x * p.x + p.z * p.z > 0.25f) {
+		return false;
+	}
+	t = tCap;
+	hit.t = tCap;
+	hit.normal = glm::vec3(0.0f, normalY, 0.0f);
+	hit.uv = glm::vec2(p.x + 0.5f, p.z + 0.5f);
+	return true;
+}
+
+bool Sphere::intersect(const glm::vec3& origin, const glm::vec3& dir, RayHit& hit) const {
+	return intersectSphere(origin, dir, TranslateTransform(glm::vec3(0, 0, 0)), hit);
+}
+
+bool Cube::intersect(const glm::vec3& origin, const glm::vec3& dir, RayHit& hit) const {
+	// slab test, remembering which axis bounds the interval on each side
+	float tNear = -INFINITY;
+	float tFar = INFINITY;
+	int nearAxis = 0;
+	int farAxis = 0;
+	for (int axis = 0; axis < 3; axis++) {
+		float inverse = 1.0f / dir[axis];
+		float t0 = (-0.5f - origin[axis]) * inverse;
+		float t1 = (0.5f - origin[axis]) * inverse;
+		if (t0 > t1) {
+			float swap = t0;
+			t0 = t1;
+			t1 = swap;
+		}
+		if (t0 > tNear) {
+			tNear = t0;
+			nearAxis = axis;
+		}
+		if (t1 < tFar) {
+			tFar = t1;
+			farAxis = axis;
+		}
+	}
+	if (tNear > tFar || tFar <= RAY_EPSILON) {
+		return false;
+	}
+	// from inside the cube the ray leaves through the far face
+	bool inside = tNear <= RAY_EPSILON;
+	int axis = inside ? farAxis : nearAxis;
+	hit.t = inside ? tFar : tNear;
+	hit.normal = glm::vec3(0, 0, 0);
+	hit.normal[axis] = ((dir[axis] > 0) == inside) ? 1.0f : -1.0f;
+
+	glm::vec3 p = origin + hit.t * dir;
+	float side = hit.normal[axis];
+	if (axis == 0) {
+		hit.uv = glm::vec2(side > 0 ? 0.5f - p.z : p.z + 0.5f, 0.5f - p.y);
+	}
+	else if (axis == 1) {
+		hit.uv = glm::vec2(p.x + 0.5f, side > 0 ? p.z + 0.5f : 0.5f - p.z);
+	}
+	else {
+		hit.uv = glm::vec2(side > 0 ? p.x + 0.5f : 0.5f - p.x, 0.5f - p.y);
+	}
+	return true;
+}
+
+bool Cylinder::intersect(const glm::vec3& origin, const glm::vec3& dir, RayHit& hit) const {
+	float t = INFINITY;
+	float t0, t1;
+	float a = dir.x * dir.x + dir.z * dir.z;
+	float halfB = origin.x * dir.x + origin.z * dir.z;
+	float c = origin.x * origin.x + origin.z * origin.z - 0.25f;
+	if (a > 0.0f && solveQuadratic(a, halfB, c, t0, t1)) {
+		float roots[2] = { t0, t1 };
+		for (int i = 0; i < 2; i++) {
+			glm::vec3 p = origin + roots[i] * dir;
+			if (roots[i] > RAY_EPSILON && fabs(p.y) <= 0.5f) {
+				t = roots[i];
+				hit.t = t;
+				hit.normal = glm::vec3(2.0f * p.x, 0.0f, 2.0f * p.z);
+				hit.uv = glm::vec2(aroundY(p.x, p.z), 0.5f - p.y);
+				break;
+			}
+		}
+	}
+	intersectCap(origin, dir, 0.5f, 1.0f, t, hit);
+	intersectCap(origin, dir, -0.5f, -1.0f, t, hit);
+	return t < INFINITY;
+}
+
+bool Cone::intersect(const glm::vec3& origin, const glm::vec3& dir, RayHit& hit) const {
+	// x^2 + z^2 = ((0.5 - y) / 2)^2, with h the height of the origin below the apex
+	float t = INFINITY;
+	float t0, t1;
+	float h = 0.5f - origin.y;
+	float a = dir.x * dir.x + dir.z * dir.z - 0.25f * dir.y * dir.y;
+	float halfB = origin.x * dir.x + origin.z * dir.z + 0.25f * h * dir.y;
+	float c = origin.x * origin.x + origin.z * origin.z - 0.25f * h * h;
+	if (solveQuadratic(a, halfB, c, t0, t1)) {
+		float roots[2] = { t0, t1 };
+		for (int i = 0; i < 2; i++) {
+			glm::vec3 p = origin + roots[i] * dir;
+			if (roots[i] > RAY_EPSILON && fabs(p.y) <= 0.5f) {
+				t = roots[i];
+				hit.t = t;
+				glm::vec3 gradient(2.0f * p.x, 0.5f * (0.5f - p.y), 2.0f * p.z);
+				hit.normal = (glm::dot(gradient, gradient) > 0.0f) ? glm::normalize(gradient) : glm::vec3(0, 1, 0);
+				hit.uv = glm::vec2(aroundY(p.x, p.z), 0.5f - p.y);
+				break;
+			}
+		}
+	}
+	intersectCap(origin, dir, -0.5f, -1.0f, t, hit);
+	return t < INFINITY;
+}
+
+bool TriangleMesh::intersect(const glm::vec3& origin, const glm::vec3& dir, RayHit& hit) const {
+	float nearest = INFINITY;
+	int nearestTriangle = -1;
+	float nearestU = 0;
+	float nearestV = 0;
+	int count = triangleCount();
+	for (int i = 0; i < count; i++) {
+		// Moller-Trumbore, both sides of the triangle count
+		const glm::vec3& p0 = positions[indices[3 * i]];
+		glm::vec3 e1 = positions[indices[3 * i + 1]] - p0;
+		glm::vec3 e2 = positions[indices[3 * i + 2]] - p0;
+		glm::vec3 pv = glm::cross(dir, e2);
+		float determinant = glm::dot(e1, pv);
+		if (fabs(determinant) < 1e-12f) {
+			continue;
+		}
+		float inverse = 1.0f / determinant;
+		glm::vec3 tv = origin - p0;
+		float u = glm::dot(tv, pv) * inverse;
+		if (u < 0.0f || u > 1.0f) {
+			continue;
+		}
+		glm::vec3 qv = glm::cross(tv, e1);
+		float v = glm::dot(dir, qv) * inverse;
+		if (v < 0.0f || u + v > 1.0f) {
+			continue;
+		}
+		float t = glm::dot(e2, qv) * inverse;
+		if (t > RAY_EPSILON && t < nearest) {
+			nearest = t;
+			nearestTriangle = i;
+			nearestU = u;
+			nearestV = v;
+		}
+	}
+	if (nearestTriangle < 0) {
+		return false;
+	}
+	hit.t = nearest;
+	fillHit(nearestTriangle, nearestU, nearestV, dir, hit);
+	return true;
+}
+
+void TriangleMesh::fillHit(int triangle, float u, float v, const glm::vec3& dir, RayHit& hit) const {
+	const unsigned int* corners = &indices[3 * triangle];
+	glm::vec3 normal = glm::normalize(glm::cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]));
+	hit.normal = (glm::dot(normal, dir) > 0.0f) ? -normal : normal;
+	if (uvs.size() == positions.size()) {
+		hit.uv = (1.0f - u - v) * uvs[corners[0]] + u * uvs[corners[1]] + v * uvs[corners[2]];
+	}
+	else {
+		hit.uv = glm::vec2(u, v);
+	}
+}
+
+Primitive makePrimitive(PrimitiveType type, glm::vec3 translation, float scale, const TriangleMesh* mesh, const MeshBVH* bvh) {
+	Primitive primitive;
+	primitive.type = type;
+	primitive.translation = translation;
+	primitive.scale = scale;
+	primitive.mesh = mesh;
+	primitive.bvh = bvh;
+	return primitive;
+}
+
+bool intersectPrimitive(const Primitive& primitive, const glm::vec3& eyePoint, const glm::vec3& ray, RayHit& hit) {
+	UniformScaleTransform transform(primitive.translation, primitive.scale);
+	switch (primitive.type) {
+	case PRIMITIVE_SPHERE: return intersectShape(Sphere(), transform, eyePoint, ray, hit);
+	case PRIMITIVE_CUBE: return intersectShape(Cube(), transform, eyePoint, ray, hit);
+	case PRIMITIVE_CYLINDER: return intersectShape(Cylinder(), transform, eyePoint, ray, hit);
+	case PRIMITIVE_CONE: return intersectShape(Cone(), transform, eyePoint, ray, hit);
+	case PRIMITIVE_MESH:
+		if (primitive.bvh != NULL) {
+			return intersectShape(*primitive.bvh, transform, eyePoint, ray, hit);
+		}
+		if (primitive.mesh == NULL) {
+			return false;
+		}
+		return intersectShape(*primitive.mesh, transform, eyePoint, ray, hit);
+	}
+	return false;
+}
+
+int intersectPrimitives(const std::vector<Primitive>& primitives, const glm::vec3& eyePoint, const glm::vec3& ray, RayHit& hit) {
+	int nearest = -1;
+	RayHit candidate;
+	for (size_t i = 0; i < primitives.size(); i++) {
+		if (intersectPrimitive(primitives[i], eyePoint, ray, candidate) && (nearest < 0 || candidate.t < hit.t)) {
+			hit = candidate;
+			nearest = (int)i;
+		}
+	}
+	return nearest;
+}
@@ -0,0 +1,126 @@
+/*  =================== File Information =================
+	File Name: Primitives.h
+	Description:
+	Author:
+
+	Purpose: Ray intersection for the basic shapes (sphere, cube, cylinder,
+			 cone and triangle mesh).  Every shape answers the same
+			 question: the nearest hit with its normal and texture
+			 coordinate.  Shapes are plain structs without virtual
+			 functions; intersectShape<Shape> is resolved at compile time
+			 and a Primitive is a tagged record dispatched with a switch,
+			 so a mixed scene costs no virtual call per ray.
+	Usage:	std::vector<Primitive> scene;
+			scene.push_back(makePrimitive(PRIMITIVE_CUBE, position, 1.0f));
+			RayHit hit;
+			int index = intersectPrimitives(scene, eye, ray, hit);
+	===================================================== */
+#ifndef PRIMITIVES_H
+#define PRIMITIVES_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "Picking.h"
+
+/*
+	The shapes are given in object space, centered at the origin and
+	fitting the unit cube [-0.5, 0.5]^3 like the unit diameter sphere.
+	intersect() fills t, normal and uv of the hit; the point is left to
+	the caller, who knows the world space ray.
+*/
+struct Sphere {
+	bool intersect(const glm::vec3& origin, const glm::vec3& dir, RayHit& hit) const;
+};
+
+struct Cube {
+	bool intersect(const glm::vec3& origin, const glm::vec3& dir, RayHit& hit) const;
+};
+
+// Radius 0.5 around the y axis, capped at y = -0.5 and y = 0.5
+struct Cylinder {
+	bool intersect(const glm::vec3& origin, const glm::vec3& dir, RayHit& hit) const;
+};
+
+// Base of radius 0.5 at y = -0.5, apex at y = 0.5
+struct Cone {
+	bool intersect(const glm::vec3& origin, const glm::vec3& dir, RayHit& hit) const;
+};
+
+/*
+	Indexed triangles.  uvs and normals are either empty or hold one
+	entry per position; without uvs the hit's uv are the barycentrics of
+	the hit triangle.  Hits always report the face normal.  Every
+	triangle is tested, large meshes need an acceleration structure on
+	top.
+*/
+struct TriangleMesh {
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	std::vector<unsigned int> indices;	// three per triangle
+
+	int triangleCount() const { return (int)(indices.size() / 3); }
+	bool intersect(const glm::vec3& origin, const glm::vec3& dir, RayHit& hit) const;
+	/*	Sets the normal (facing against dir) and uv of a hit at barycentrics
+		(u, v) of a triangle */
+	void fillHit(int triangle, float u, float v, const glm::vec3& dir, RayHit& hit) const;
+};
+
+class MeshBVH;
+
+/*	===============================================
+Desc:	Intersects a world space ray with a shape placed by a translation or
+		uniform scale transform (see Picking.h)
+Precondition:
+Postcondition:	Returns false if there is no hit in front of the eye,
+				otherwise hit describes the nearest one in world space.
+=============================================== */
+template <class Shape, class Transform>
+bool intersectShape(const Shape& shape, const Transform& transform, const glm::vec3& eyePoint, const glm::vec3& ray, RayHit& hit) {
+	// scaling the direction as well keeps t the same in both spaces
+	float inverseScale = 1.0f / transform.scale();
+	glm::vec3 origin = (eyePoint - transform.translation) * inverseScale;
+	glm::vec3 dir = ray * inverseScale;
+	if (!shape.intersect(origin, dir, hit)) {
+		return false;
+	}
+	hit.point = eyePoint + hit.t * ray;
+	return true;
+}
+
+enum PrimitiveType {
+	PRIMITIVE_SPHERE,
+	PRIMITIVE_CUBE,
+	PRIMITIVE_CYLINDER,
+	PRIMITIVE_CONE,
+	PRIMITIVE_MESH
+};
+
+/*
+	One object of a mixed scene.  mesh is only used by PRIMITIVE_MESH and
+	is not owned; if bvh is set the mesh is intersected through it.
+*/
+struct Primitive {
+	PrimitiveType type;
+	glm::vec3 translation;
+	float scale;
+	const TriangleMesh* mesh;
+	const MeshBVH* bvh;
+};
+
+Primitive makePrimitive(PrimitiveType type, glm::vec3 translation, float scale, const TriangleMesh* mesh = NULL, const MeshBVH* bvh = NULL);
+/*	===============================================
+Desc:	Intersects a ray with one primitive
+Precondition:
+Postcondition:	Returns false for a miss.
+=============================================== */
+bool intersectPrimitive(const Primitive& primitive, const glm::vec3& eyePoint, const glm::vec3& ray, RayHit& hit);
+/*	===============================================
+Desc:	Finds the nearest primitive hit by the ray
+Precondition:
+Postcondition:	Returns the index of the primitive, or -1 if the ray hits
+				nothing.  hit is only valid for a hit.
+=============================================== */
+int intersectPrimitives(const std::vector<Primitive>& primitives, const glm::vec3& eyePoint, const glm::vec3& ray, RayHit& hit);
+
+#endif
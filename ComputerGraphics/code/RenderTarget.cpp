@@ -0,0 +1,75 @@
+/*  =================== File Information =================
+	File Name: RenderTarget.cpp
+	Description:
+	Author:
+
+	Purpose: Offscreen framebuffer of dynamic resolution
+	Usage:
+	===================================================== */
+
+#include <iostream>
+#include "RenderTarget.h"
+
+RenderTarget::RenderTarget() {
+	framebuffer = 0;
+	colorBuffer = 0;
+	depthBuffer = 0;
+	width = 0;
+	height = 0;
+}
+
+RenderTarget::~RenderTarget() {
+	release();
+}
+
+void RenderTarget::release() {
+	if (framebuffer != 0) {
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteRenderbuffers(1, &colorBuffer);
+		glDeleteRenderbuffers(1, &depthBuffer);
+	}
+	framebuffer = 0;
+	colorBuffer = 0;
+	depthBuffer = 0;
+	width = 0;
+	height = 0;
+}
+
+bool RenderTarget::begin(int _width, int _height) {
+	if (!hasGLShaderFunctions()) {
+		return false;
+	}
+	if (framebuffer == 0) {
+		glGenFramebuffers(1, &framebuffer);
+		glGenRenderbuffers(1, &colorBuffer);
+		glGenRenderbuffers(1, &depthBuffer);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	if (_width != width || _height != height) {
+		width = _width;
+		height = _height;
+		glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			std::cout << "cannot render into a " << width << " x " << height << " framebuffer" << std::endl;
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			release();
+			return false;
+		}
+	}
+	glViewport(0, 0, width, height);
+	return true;
+}
+
+void RenderTarget::end(int windowWidth, int windowHeight) {
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, windowWidth, windowHeight);
+}
@@ -0,0 +1,65 @@
+/*  =================== File Information =================
+	File Name: RenderTarget.h
+	Description:
+	Author:
+
+	Purpose: Offscreen framebuffer the scene is drawn into at a reduced
+			 resolution, then stretched onto the window with a linear
+			 filtered blit.  Color and depth are renderbuffers, they are
+			 only reallocated when the size changes.
+	Usage:	if (target.begin(640, 400)) {
+				// draw, the viewport is 640 x 400
+				target.end(1280, 800);	// onto the window's framebuffer
+			}
+	===================================================== */
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include "GLExt.h"
+
+class RenderTarget {
+public:
+	RenderTarget();
+	/*	===============================================
+	Desc:	Deletes the framebuffer
+	Precondition:	The GL context it was created in is current.
+	Postcondition:
+	=============================================== */
+	~RenderTarget();
+
+	/*	===============================================
+	Desc:	Binds a width x height framebuffer and sets the viewport to it,
+			(re)creating it if it is of another size
+	Precondition:	A GL context is current.
+	Postcondition:	Returns false, with the window's framebuffer still bound,
+					if the context cannot render into one.
+	=============================================== */
+	bool begin(int width, int height);
+	/*	===============================================
+	Desc:	Stretches the frame onto the window's framebuffer, binds that
+			again and sets the viewport to the window
+	Precondition:	begin() succeeded.
+	Postcondition:
+	=============================================== */
+	void end(int windowWidth, int windowHeight);
+	/*	===============================================
+	Desc:	Deletes the framebuffer, e.g. when the context goes away
+	Precondition:	The GL context it was created in is current.
+	Postcondition:
+	=============================================== */
+	void release();
+
+	int getWidth() { return width; }
+	int getHeight() { return height; }
+	// renderbuffer bytes, 4 of color and 4 of depth per texel
+	size_t getBytes() { return (size_t)width * height * 8; }
+
+private:
+	GLuint framebuffer;
+	GLuint colorBuffer;
+	GLuint depthBuffer;
+	int width;
+	int height;
+};
+
+#endif
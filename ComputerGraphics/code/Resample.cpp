@@ -0,0 +1,432 @@
+/*  =================== File Information =================
+	File Name: Resample.cpp
+	Description:
+	Author:
+
+	Purpose: Separable image resampling and the batch conversion mode
+	Usage:
+	===================================================== */
+
+#include <iostream>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include "Resample.h"
+#ifdef RESAMPLE_SSE
+#include <emmintrin.h>
+#endif
+
+#define RESAMPLE_PI 3.14159265358979f
+
+/*
+	The source texels and weights of every texel along one axis.  Every
+	texel has the same number of taps, indices past the edges are
+	clamped to it.
+*/
+struct Contributions {
+	int taps;
+	std::vector<int> indices;
+	std::vector<float> weights;
+};
+
+const char* resampleFilterName(ResampleFilter filter) {
+	switch (filter) {
+	case RESAMPLE_BOX: return "box";
+	case RESAMPLE_BILINEAR: return "bilinear";
+	default: return "lanczos3";
+	}
+}
+
+bool parseResampleFilter(std::string name, ResampleFilter& filter) {
+	if (name == "box") {
+		filter = RESAMPLE_BOX;
+	}
+	else if (name == "bilinear") {
+		filter = RESAMPLE_BILINEAR;
+	}
+	else if (name == "lanczos3") {
+		filter = RESAMPLE_LANCZOS3;
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+bool parseResizeSize(std::string text, ResizePolicy& policy) {
+	if (text == "pot") {
+		policy.powerOfTwo = true;
+		return true;
+	}
+	int width = 0;
+	int height = 0;
+	if (sscanf(text.c_str(), "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+		return false;
+	}
+	policy.width = width;
+	policy.height = height;
+	return true;
+}
+
+ResizePolicy noResize() {
+	ResizePolicy policy = { RESAMPLE_LANCZOS3, 0, 0, false, 0 };
+	return policy;
+}
+
+bool isResizing(const ResizePolicy& policy) {
+	return policy.width > 0 || policy.powerOfTwo || policy.maxDimension > 0;
+}
+
+/*	Ties go up, 48 becomes 64 */
+static int nearestPowerOfTwo(int n, int limit) {
+	int power = 1;
+	while (power * 2 <= n) {
+		power *= 2;
+	}
+	if (n - power >= power * 2 - n) {
+		power *= 2;
+	}
+	while (limit > 0 && power > limit && power > 1) {
+		power /= 2;
+	}
+	return power;
+}
+
+void resizeTarget(const ResizePolicy& policy, int width, int height, int& targetWidth, int& targetHeight) {
+	targetWidth = (policy.width > 0) ? policy.width : width;
+	targetHeight = (policy.height > 0) ? policy.height : height;
+	int largest = std::max(targetWidth, targetHeight);
+	if (policy.maxDimension > 0 && largest > policy.maxDimension) {
+		double scale = (double)policy.maxDimension / largest;
+		targetWidth = std::max((int)(targetWidth * scale + 0.5), 1);
+		targetHeight = std::max((int)(targetHeight * scale + 0.5), 1);
+	}
+	if (policy.powerOfTwo) {
+		targetWidth = nearestPowerOfTwo(targetWidth, policy.maxDimension);
+		targetHeight = nearestPowerOfTwo(targetHeight, policy.maxDimension);
+	}
+}
+
+static float filterSupport(ResampleFilter filter) {
+	switch (filter) {
+	case RESAMPLE_BOX: return 0.5f;
+	case RESAMPLE_BILINEAR: return 1.0f;
+	default: return 3.0f;
+	}
+}
+
+/*	Bilinear (tent) or Lanczos-3 weight of a texel x texels away */
+static float filterWeight(ResampleFilter filter, float x) {
+	switch (filter) {
+	case RESAMPLE_BILINEAR:
+		return std::max(1.0f - fabsf(x), 0.0f);
+	default:
+		if (fabsf(x) < 1e-6f) {
+			return 1.0f;
+		}
+		if (fabsf(x) >= 3.0f) {
+			return 0.0f;
+		}
+		return 3.0f * sinf(RESAMPLE_PI * x) * sinf(RESAMPLE_PI * x / 3.0f) / (RESAMPLE_PI * RESAMPLE_PI * x * x);
+	}
+}
+
+/*	Texel i of the target covers source texels [i, i + 1) * scale, the
+	filter is stretched by the scale when shrinking.  The box filter
+	weights every source texel by how much of it is covered, which
+	sampling it at the texel centers would get wrong by a whole texel
+	for scales that are not whole numbers.
+*/
+static void computeContributions(int sourceSize, int targetSize, ResampleFilter filter, Contributions& contributions) {
+	float scale = (float)sourceSize / targetSize;
+	float filterScale = std::max(scale, 1.0f);
+	float support = filterSupport(filter) * filterScale;
+	int taps = (int)ceilf(2.0f * support) + 1;
+	contributions.taps = taps;
+	contributions.indices.resize((size_t)targetSize * taps);
+	contributions.weights.resize((size_t)targetSize * taps);
+	for (int i = 0; i < targetSize; i++) {
+		float center = (i + 0.5f) * scale;
+		int first = (int)floorf(center - support);
+		int* indices = &contributions.indices[(size_t)i * taps];
+		float* weights = &contributions.weights[(size_t)i * taps];
+		float sum = 0;
+		for (int k = 0; k < taps; k++) {
+			int j = first + k;
+			if (filter == RESAMPLE_BOX) {
+				float overlap = std::min(j + 1.0f, center + 0.5f * scale) - std::max((float)j, center - 0.5f * scale);
+				weights[k] = std::max(overlap, 0.0f);
+			}
+			else {
+				weights[k] = filterWeight(filter, (j + 0.5f - center) / filterScale);
+			}
+			indices[k] = std::min(std::max(j, 0), sourceSize - 1);
+			sum += weights[k];
+		}
+		for (int k = 0; k < taps && sum != 0; k++) {
+			weights[k] /= sum;
+		}
+	}
+}
+
+struct ResampleJob {
+	const unsigned char* source;
+	int width;
+	int height;
+	unsigned char* target;
+	int targetWidth;
+	int targetHeight;
+	Contributions horizontal;
+	Contributions vertical;
+};
+
+/*	Weighted sum of taps float4 texels of row, starting at the texel indices */
+static inline void filterTexel(const float* row, const int* indices, const float* weights, int taps, float* result) {
+#ifdef RESAMPLE_SSE
+	__m128 sum = _mm_setzero_ps();
+	for (int k = 0; k < taps; k++) {
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(row + indices[k] * 4)));
+	}
+	_mm_storeu_ps(result, sum);
+#else
+	result[0] = result[1] = result[2] = result[3] = 0;
+	for (int k = 0; k < taps; k++) {
+		const float* texel = row + indices[k] * 4;
+		for (int c = 0; c < 4; c++) {
+			result[c] += weights[k] * texel[c];
+		}
+	}
+#endif
+}
+
+/*	Every step-th band of RESAMPLE_BAND_ROWS output rows from first.  A
+	band filters the source rows it needs horizontally into rows, then
+	each of its output rows vertically from those.
+*/
+static void resampleBands(const ResampleJob* job, int first, int step) {
+	const Contributions& horizontal = job->horizontal;
+	const Contributions& vertical = job->vertical;
+	int bands = (job->targetHeight + RESAMPLE_BAND_ROWS - 1) / RESAMPLE_BAND_ROWS;
+	size_t rowFloats = (size_t)job->targetWidth * 4;
+	std::vector<float> sourceRow((size_t)job->width * 4);
+	std::vector<float> rows;
+	std::vector<float> sum(rowFloats);
+	for (int band = first; band < bands; band += step) {
+		int y0 = band * RESAMPLE_BAND_ROWS;
+		int y1 = std::min(y0 + RESAMPLE_BAND_ROWS, job->targetHeight);
+		// the indices only grow along the axis
+		int rowMin = vertical.indices[(size_t)y0 * vertical.taps];
+		int rowMax = vertical.indices[(size_t)y1 * vertical.taps - 1];
+		rows.resize((size_t)(rowMax - rowMin + 1) * rowFloats);
+
+		for (int y = rowMin; y <= rowMax; y++) {
+			const unsigned char* texels = job->source + (size_t)y * job->width * 3;
+			for (int x = 0; x < job->width; x++) {
+				sourceRow[x * 4] = texels[x * 3];
+				sourceRow[x * 4 + 1] = texels[x * 3 + 1];
+				sourceRow[x * 4 + 2] = texels[x * 3 + 2];
+				sourceRow[x * 4 + 3] = 0;
+			}
+			float* row = &rows[(size_t)(y - rowMin) * rowFloats];
+			for (int x = 0; x < job->targetWidth; x++) {
+				size_t tap = (size_t)x * horizontal.taps;
+				filterTexel(&sourceRow[0], &horizontal.indices[tap], &horizontal.weights[tap], horizontal.taps, row + x * 4);
+			}
+		}
+
+		for (int y = y0; y < y1; y++) {
+			const int* indices = &vertical.indices[(size_t)y * vertical.taps];
+			const float* weights = &vertical.weights[(size_t)y * vertical.taps];
+			// whole rows at a time, four floats are one texel
+			std::fill(sum.begin(), sum.end(), 0.0f);
+			for (int k = 0; k < vertical.taps; k++) {
+				if (weights[k] == 0) {
+					continue;
+				}
+				const float* row = &rows[(size_t)(indices[k] - rowMin) * rowFloats];
+#ifdef RESAMPLE_SSE
+				__m128 weight = _mm_set1_ps(weights[k]);
+				for (size_t i = 0; i < rowFloats; i += 4) {
+					_mm_storeu_ps(&sum[i], _mm_add_ps(_mm_loadu_ps(&sum[i]), _mm_mul_ps(weight, _mm_loadu_ps(row + i))));
+				}
+#else
+				for (size_t i = 0; i < rowFloats; i++) {
+					sum[i] += weights[k] * row[i];
+				}
+#endif
+			}
+			unsigned char* target = job->target + (size_t)y * job->targetWidth * 3;
+			for (int x = 0; x < job->targetWidth; x++) {
+#ifdef RESAMPLE_SSE
+				// the packs saturate, which clamps the Lanczos overshoot
+				__m128i value = _mm_cvtps_epi32(_mm_loadu_ps(&sum[x * 4]));
+				value = _mm_packus_epi16(_mm_packs_epi32(value, value), value);
+				int packed = _mm_cvtsi128_si32(value);
+				memcpy(target + x * 3, &packed, 3);
+#else
+				for (int c = 0; c < 3; c++) {
+					float value = floorf(sum[x * 4 + c] + 0.5f);
+					target[x * 3 + c] = (unsigned char)std::min(std::max(value, 0.0f), 255.0f);
+				}
+#endif
+			}
+		}
+	}
+}
+
+void resampleImage(const unsigned char* source, int width, int height, unsigned char* target,
+	int targetWidth, int targetHeight, ResampleFilter filter, int threads) {
+	if (width <= 0 || height <= 0 || targetWidth <= 0 || targetHeight <= 0) {
+		return;
+	}
+	ResampleJob job;
+	job.source = source;
+	job.width = width;
+	job.height = height;
+	job.target = target;
+	job.targetWidth = targetWidth;
+	job.targetHeight = targetHeight;
+	computeContributions(width, targetWidth, filter, job.horizontal);
+	computeContributions(height, targetHeight, filter, job.vertical);
+
+	int bands = (targetHeight + RESAMPLE_BAND_ROWS - 1) / RESAMPLE_BAND_ROWS;
+	if (threads <= 0) {
+		threads = std::max((int)std::thread::hardware_concurrency(), 1);
+	}
+	threads = std::min(threads, bands);
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; t++) {
+		workers.push_back(std::thread(resampleBands, &job, t, threads));
+	}
+	resampleBands(&job, 0, threads);
+	for (size_t t = 0; t < workers.size(); t++) {
+		workers[t].join();
+	}
+}
+
+ppm* resizeImage(ppm* image, const ResizePolicy& policy, int threads) {
+	int width, height;
+	resizeTarget(policy, image->getWidth(), image->getHeight(), width, height);
+	if (width == image->getWidth() && height == image->getHeight()) {
+		return NULL;
+	}
+	ppm* resized = new ppm(width, height);
+	resampleImage((const unsigned char*)image->getPixels(), image->getWidth(), image->getHeight(),
+		(unsigned char*)resized->getPixels(), width, height, policy.filter, threads);
+	return resized;
+}
+
+bool parseResampleBatchOptions(int argc, char** argv, ResampleBatchOptions& options) {
+	bool batch = false;
+	options.policy = noResize();
+	options.threads = 0;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--resample-dir" && i + 2 < argc) {
+			batch = true;
+			options.inputDirectory = argv[++i];
+			options.outputDirectory = argv[++i];
+		}
+		else if (arg == "--threads" && i + 1 < argc) {
+			options.threads = atoi(argv[++i]);
+		}
+	}
+	parseResizePolicy(argc, argv, options.policy);
+	return batch;
+}
+
+bool parseResizePolicy(int argc, char** argv, ResizePolicy& policy) {
+	bool given = false;
+	for (int i = 1; i + 1 < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--resize-textures") {
+			if (!parseResizeSize(argv[++i], policy)) {
+				std::cout << "invalid --resize-textures, expected pot or WxH" << std::endl;
+			}
+			given = true;
+		}
+		else if (arg == "--max-texture-size") {
+			policy.maxDimension = std::max(atoi(argv[++i]), 0);
+			given = true;
+		}
+		else if (arg == "--resample-filter") {
+			if (!parseResampleFilter(argv[++i], policy.filter)) {
+				std::cout << "invalid --resample-filter, expected box, bilinear or lanczos3" << std::endl;
+			}
+		}
+	}
+	return given;
+}
+
+int runResampleBatch(const ResampleBatchOptions& options) {
+	namespace fs = std::filesystem;
+	typedef std::chrono::steady_clock Clock;
+	std::error_code error;
+	std::vector<fs::path> files;
+	for (fs::directory_iterator it(options.inputDirectory, error), end; !error && it != end; it.increment(error)) {
+		if (it->is_regular_file() && it->path().extension() == ".ppm") {
+			files.push_back(it->path());
+		}
+	}
+	if (error) {
+		std::cout << "Unable to read directory: " << options.inputDirectory << std::endl;
+		return 1;
+	}
+	std::sort(files.begin(), files.end());
+	fs::create_directories(options.outputDirectory, error);
+	if (fs::equivalent(options.inputDirectory, options.outputDirectory, error)) {
+		std::cout << "--resample-dir would overwrite its input, give another output directory" << std::endl;
+		return 1;
+	}
+
+	int threads = options.threads;
+	if (threads <= 0) {
+		threads = std::max((int)std::thread::hardware_concurrency(), 1);
+	}
+	threads = std::max(std::min(threads, (int)files.size()), 1);
+	std::atomic<int> nextFile(0);
+	std::atomic<int> failed(0);
+	std::atomic<long long> sourceTexels(0);
+	std::atomic<long long> targetTexels(0);
+	// each thread converts whole files, one at a time
+	auto convert = [&]() {
+		for (int i = nextFile++; i < (int)files.size(); i = nextFile++) {
+			ppm image(files[i].string());
+			if (image.getPixels() == NULL) {
+				failed++;
+				continue;
+			}
+			ppm* resized = resizeImage(&image, options.policy, 1);
+			ppm* result = (resized != NULL) ? resized : &image;
+			std::string outputFile = (fs::path(options.outputDirectory) / files[i].filename()).string();
+			if (!result->save(outputFile, false)) {
+				failed++;
+			}
+			printf("%s: %d x %d -> %d x %d\n", outputFile.c_str(), image.getWidth(), image.getHeight(),
+				result->getWidth(), result->getHeight());
+			sourceTexels += (long long)image.getWidth() * image.getHeight();
+			targetTexels += (long long)result->getWidth() * result->getHeight();
+			delete resized;
+		}
+	};
+	Clock::time_point start = Clock::now();
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; t++) {
+		workers.push_back(std::thread(convert));
+	}
+	convert();
+	for (size_t t = 0; t < workers.size(); t++) {
+		workers[t].join();
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	printf("%d files (%d failed) with %s on %d threads in %.2f s, %.1f MPix/s in, %.1f MPix/s out, parsing and writing included\n",
+		(int)files.size(), (int)failed, resampleFilterName(options.policy.filter), threads, seconds,
+		sourceTexels / seconds / 1e6, targetTexels / seconds / 1e6);
+	return failed > 0 ? 1 : 0;
+}
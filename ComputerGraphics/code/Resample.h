@@ -0,0 +1,137 @@
+/*  =================== File Information =================
+	File Name: Resample.h
+	Description:
+	Author:
+
+	Purpose: Resizes RGB images with a box (area average), bilinear
+			 (tent) or Lanczos-3 filter, so textures can be brought to
+			 power of two sizes and oversized ones scaled down when they
+			 are loaded.
+			 The filter is applied separably, rows first: every output
+			 texel is a fixed list of weighted source texels, computed
+			 once per axis, and the filter widens by the scale factor
+			 when shrinking so every source texel contributes.  Texels
+			 are weighted as four floats at a time with SSE, and bands
+			 of output rows are shared out among threads.
+
+			 Edges are clamped.  Lanczos-3 has negative lobes, the
+			 results are clamped to 0..255.
+	Usage:	resampleImage(pixels, 640, 480, target, 512, 512, RESAMPLE_LANCZOS3);
+
+			ResizePolicy policy = { RESAMPLE_LANCZOS3, 0, 0, true, 1024 };
+			int width, height;
+			resizeTarget(policy, image->getWidth(), image->getHeight(), width, height);
+
+			Batch mode, converts every .ppm file of a directory:
+			cglab_bench --resample-dir in out [--resize-textures pot|WxH]
+				[--max-texture-size N] [--resample-filter box|bilinear|lanczos3]
+				[--threads N]
+	===================================================== */
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#include <string>
+#include "ppm.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RESAMPLE_SSE 1
+#endif
+
+#define RESAMPLE_BAND_ROWS 32	// output rows per band handed to a thread
+
+enum ResampleFilter {
+	RESAMPLE_BOX,
+	RESAMPLE_BILINEAR,
+	RESAMPLE_LANCZOS3
+};
+
+/*
+	Size an image is brought to.  A fixed size wins over the image's
+	own, then it is scaled down to maxDimension keeping its aspect, then
+	each side is rounded to the nearest power of two that is not above
+	maxDimension.
+*/
+struct ResizePolicy {
+	ResampleFilter filter;
+	int width;			// fixed size, 0 keeps the image's own
+	int height;
+	bool powerOfTwo;
+	int maxDimension;	// 0 for no limit
+};
+
+/*	===============================================
+Desc:	Name of a filter as used on the command line ("box", "bilinear",
+		"lanczos3") and back.
+Precondition:
+Postcondition:	parseResampleFilter returns false for an unknown name.
+=============================================== */
+const char* resampleFilterName(ResampleFilter filter);
+bool parseResampleFilter(std::string name, ResampleFilter& filter);
+/*	===============================================
+Desc:	Reads "pot" or "WxH" into the size part of a policy
+Precondition:
+Postcondition:	Returns false for anything else.
+=============================================== */
+bool parseResizeSize(std::string text, ResizePolicy& policy);
+/*	===============================================
+Desc:	Reads --resize-textures pot|WxH, --max-texture-size N and
+		--resample-filter from the command line into policy
+Precondition:
+Postcondition:	Returns true if a size option was given.
+=============================================== */
+bool parseResizePolicy(int argc, char** argv, ResizePolicy& policy);
+// a policy that keeps every image as it is
+ResizePolicy noResize();
+bool isResizing(const ResizePolicy& policy);
+
+/*	===============================================
+Desc:	Size the policy gives an image of width x height
+Precondition:	width, height > 0
+Postcondition:	targetWidth, targetHeight >= 1
+=============================================== */
+void resizeTarget(const ResizePolicy& policy, int width, int height, int& targetWidth, int& targetHeight);
+
+/*	===============================================
+Desc:	Resamples RGB texels, row by row without padding, into target.
+		threads <= 0 uses every hardware thread.
+Precondition:	target holds targetWidth * targetHeight * 3 bytes and does
+				not overlap source.
+Postcondition:
+=============================================== */
+void resampleImage(const unsigned char* source, int width, int height, unsigned char* target,
+	int targetWidth, int targetHeight, ResampleFilter filter, int threads = 0);
+/*	===============================================
+Desc:	Returns a new image of the size the policy gives image, or NULL
+		if that is its size already.
+Precondition:
+Postcondition:	The caller owns the result.
+=============================================== */
+ppm* resizeImage(ppm* image, const ResizePolicy& policy, int threads = 0);
+
+/*
+	Batch conversion of a directory, see the usage above
+*/
+struct ResampleBatchOptions {
+	std::string inputDirectory;
+	std::string outputDirectory;
+	ResizePolicy policy;
+	int threads;		// images converted at once, 0 for every hardware thread
+};
+
+/*	===============================================
+Desc:	Reads --resample-dir and the resize options from the command line
+Precondition:
+Postcondition:	Returns true if --resample-dir was given.
+=============================================== */
+bool parseResampleBatchOptions(int argc, char** argv, ResampleBatchOptions& options);
+/*	===============================================
+Desc:	Resizes every .ppm file of the input directory by the policy and
+		writes it under the same name to the output directory, as plain
+		text ppm that ppm(fileName) can read back.  The files are shared
+		out among threads, each converting one file at a time.
+Precondition:
+Postcondition:	Returns the process exit code, 1 if a file failed.
+=============================================== */
+int runResampleBatch(const ResampleBatchOptions& options);
+
+#endif
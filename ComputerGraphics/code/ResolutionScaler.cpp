@@ -0,0 +1,142 @@
+/*  =================== File Information =================
+	File Name: ResolutionScaler.cpp
+	Description:
+	Author:
+
+	Purpose: Frame time driven choice of the render resolution
+	Usage:
+	===================================================== */
+
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include "ResolutionScaler.h"
+
+ResolutionScaler::ResolutionScaler() {
+	minScale = 0.5f;
+	maxScale = 1.0f;
+	targetMs = DEFAULT_TARGET_FRAME_MS;
+	stats.frames = 0;
+	stats.increases = 0;
+	stats.decreases = 0;
+	stats.reverts = 0;
+	reset();
+}
+
+void ResolutionScaler::setBounds(float _minScale, float _maxScale) {
+	minScale = _minScale;
+	maxScale = std::max(_maxScale, _minScale);
+	scale = std::min(std::max(scale, minScale), maxScale);
+}
+
+void ResolutionScaler::setTargetTime(double milliseconds) {
+	targetMs = milliseconds;
+}
+
+void ResolutionScaler::reset() {
+	scale = maxScale;
+	frameCount = 0;
+	frameSum = 0;
+	decreasedFrom = 0;
+	decreasedFromMs = 0;
+	backoffFrames = 0;
+	stats.averageMs = 0;
+}
+
+bool ResolutionScaler::addFrameTime(double milliseconds) {
+	frameSum += milliseconds;
+	if (frameCount == RESOLUTION_SCALE_FRAMES) {
+		frameSum -= frameTimes[stats.frames % RESOLUTION_SCALE_FRAMES];
+	}
+	else {
+		frameCount++;
+	}
+	frameTimes[stats.frames % RESOLUTION_SCALE_FRAMES] = milliseconds;
+	stats.frames++;
+	stats.averageMs = frameSum / frameCount;
+	if (backoffFrames > 0) {
+		backoffFrames--;
+	}
+	if (frameCount < RESOLUTION_SCALE_FRAMES) {
+		return false;
+	}
+
+	if (decreasedFrom > 0 && stats.averageMs >= decreasedFromMs) {
+		// the smaller frames were no faster
+		scale = decreasedFrom;
+		decreasedFrom = 0;
+		backoffFrames = RESOLUTION_SCALE_BACKOFF;
+		stats.reverts++;
+		frameCount = 0;
+		frameSum = 0;
+		return true;
+	}
+	decreasedFrom = 0;
+
+	float wanted = scale;
+	if (stats.averageMs > targetMs && backoffFrames == 0) {
+		wanted = scale * (float)sqrt(targetMs / stats.averageMs);
+	}
+	else if (stats.averageMs < RESOLUTION_SCALE_HEADROOM * targetMs) {
+		// aims at the headroom, so the next frames do not land right on the target
+		wanted = std::min(scale * (float)sqrt(RESOLUTION_SCALE_HEADROOM * targetMs / stats.averageMs),
+			scale * RESOLUTION_SCALE_MAX_RISE);
+	}
+	wanted = std::min(std::max(wanted, minScale), maxScale);
+	// the bounds themselves are always reached
+	if (fabsf(wanted - scale) < RESOLUTION_SCALE_MIN_CHANGE && wanted != minScale && wanted != maxScale) {
+		return false;
+	}
+	if (wanted == scale) {
+		return false;
+	}
+	if (wanted < scale) {
+		stats.decreases++;
+		decreasedFrom = scale;
+		decreasedFromMs = stats.averageMs;
+	}
+	else {
+		stats.increases++;
+	}
+	scale = wanted;
+	frameCount = 0;
+	frameSum = 0;
+	return true;
+}
+
+void ResolutionScaler::scaledSize(int width, int height, int& scaledWidth, int& scaledHeight) {
+	scaledWidth = std::max((int)(width * scale + 0.5f), 1);
+	scaledHeight = std::max((int)(height * scale + 0.5f), 1);
+}
+
+bool parseResolutionOptions(int argc, char** argv, ResolutionScaler& scaler) {
+	bool enabled = false;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = (i + 1 < argc);
+		if (arg == "--dynamic-resolution") {
+			enabled = true;
+		}
+		else if (arg == "--resolution-scale" && hasValue) {
+			float minScale, maxScale;
+			if (sscanf(argv[++i], "%f,%f", &minScale, &maxScale) != 2 || minScale <= 0 || maxScale < minScale) {
+				std::cout << "invalid --resolution-scale, expected MIN,MAX with 0 < MIN <= MAX" << std::endl;
+				continue;
+			}
+			scaler.setBounds(minScale, maxScale);
+			scaler.reset();
+		}
+		else if (arg == "--target-frame-ms" && hasValue) {
+			double milliseconds = atof(argv[++i]);
+			if (milliseconds <= 0) {
+				std::cout << "invalid --target-frame-ms, expected a time above 0" << std::endl;
+				continue;
+			}
+			scaler.setTargetTime(milliseconds);
+		}
+	}
+	return enabled;
+}
@@ -0,0 +1,113 @@
+/*  =================== File Information =================
+	File Name: ResolutionScaler.h
+	Description:
+	Author:
+
+	Purpose: Chooses the resolution the scene is rendered at from the
+			 time recent frames took, for dynamic resolution.  The scale
+			 applies to both sides of the window and stays between
+			 configurable bounds.  The average of the last
+			 RESOLUTION_SCALE_FRAMES frame times is compared with the
+			 target frame time: above it the scale drops, well below it
+			 (RESOLUTION_SCALE_HEADROOM) it rises again, by at most
+			 RESOLUTION_SCALE_MAX_RISE at a time.
+
+			 The time of a frame is taken to follow its pixel count, so
+			 the new scale is the old one times the square root of
+			 target / average.  After every change the average starts
+			 over, so the next decision only sees frames of the new
+			 resolution.  That does not hold where stretching the frame
+			 onto the window costs more than the pixels saved (llvmpipe
+			 with a simple scene): a decrease that did not make the
+			 frames faster is taken back, and none is tried for the next
+			 RESOLUTION_SCALE_BACKOFF frames.
+	Usage:	ResolutionScaler scaler;
+			scaler.setBounds(0.5f, 1.0f);
+			scaler.setTargetTime(16.7);
+			// after every frame
+			if (scaler.addFrameTime(milliseconds)) {
+				scaler.scaledSize(windowWidth, windowHeight, width, height);
+			}
+
+			Command line options, see parseResolutionOptions:
+			--dynamic-resolution [--resolution-scale MIN,MAX]
+			[--target-frame-ms MS]
+	===================================================== */
+#ifndef RESOLUTION_SCALER_H
+#define RESOLUTION_SCALER_H
+
+#define RESOLUTION_SCALE_FRAMES 16			// frame times averaged
+#define RESOLUTION_SCALE_HEADROOM 0.8		// the scale rises below this fraction of the target
+#define RESOLUTION_SCALE_MAX_RISE 1.1f		// factor the scale rises by at most per change
+#define RESOLUTION_SCALE_MIN_CHANGE 0.02f	// smaller changes are not worth a new render target
+#define RESOLUTION_SCALE_BACKOFF 300		// frames without a decrease after one was taken back
+#define DEFAULT_TARGET_FRAME_MS 16.7
+
+struct ResolutionScalerStats {
+	int frames;				// frame times added
+	int increases;
+	int decreases;
+	int reverts;			// decreases taken back
+	double averageMs;		// of the frames averaged so far
+};
+
+class ResolutionScaler {
+public:
+	ResolutionScaler();
+
+	/*	===============================================
+	Desc:	Bounds of the scale, e.g. 0.5 and 1.0.  The scale is clamped
+			into them.
+	Precondition:	0 < minScale <= maxScale
+	Postcondition:
+	=============================================== */
+	void setBounds(float minScale, float maxScale);
+	void setTargetTime(double milliseconds);
+	float getMinScale() { return minScale; }
+	float getMaxScale() { return maxScale; }
+	double getTargetTime() { return targetMs; }
+	/*	===============================================
+	Desc:	Goes back to the largest scale and forgets the frame times
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void reset();
+
+	/*	===============================================
+	Desc:	Adds the time a frame took to render
+	Precondition:	The frame was rendered at the current scale.
+	Postcondition:	Returns true if the scale changed.
+	=============================================== */
+	bool addFrameTime(double milliseconds);
+	float getScale() { return scale; }
+	/*	===============================================
+	Desc:	Size of a width x height window at the current scale
+	Precondition:
+	Postcondition:	scaledWidth, scaledHeight >= 1
+	=============================================== */
+	void scaledSize(int width, int height, int& scaledWidth, int& scaledHeight);
+	const ResolutionScalerStats& getStats() { return stats; }
+
+private:
+	float scale;
+	float minScale;
+	float maxScale;
+	double targetMs;
+	double frameTimes[RESOLUTION_SCALE_FRAMES];		// ring of the latest frame times
+	int frameCount;			// of those, since the last change
+	double frameSum;
+	float decreasedFrom;	// scale before the last change if it was a decrease, 0 otherwise
+	double decreasedFromMs;	// average frame time at that scale
+	int backoffFrames;		// left until a decrease is tried again
+	ResolutionScalerStats stats;
+};
+
+/*	===============================================
+Desc:	Reads --resolution-scale MIN,MAX and --target-frame-ms MS into
+		scaler
+Precondition:
+Postcondition:	Returns true if --dynamic-resolution was given.
+=============================================== */
+bool parseResolutionOptions(int argc, char** argv, ResolutionScaler& scaler);
+
+#endif
@@ -12,6 +12,7 @@
 
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 #include "SceneObject.h"
 #include <glm/gtc/constants.hpp>
 
@@ -22,12 +23,24 @@ Desc:
 Precondition: 
 Postcondition:
 =============================================== */ 
-SceneObject::SceneObject(int _id){
+SceneObject::SceneObject(int _id, TextureManager* _textureManager){
 	id = _id;
 	radius = 0.5;
+	textureManager = _textureManager;
 
-	baseTexture = NULL;
-	blendTexture = NULL;
+	baseTexture = -1;
+	blendTexture = -1;
+	atlasTexture = false;
+	uvOffset = glm::vec2(0.0f);
+	uvScale = glm::vec2(1.0f);
+	virtualTexture = NULL;
+
+	paintMinX = paintMinY = 0;
+	paintMaxX = paintMaxY = -1;
+	paintHistoryEnabled = false;
+
+	recordedRadius = 0;
+	recordedTexture = -1;
 }
 /*	===============================================
 Desc:
@@ -35,11 +48,9 @@ Precondition:
 Postcondition:
 =============================================== */ 
 SceneObject::~SceneObject(){
-	if(baseTexture!=NULL){
-		delete baseTexture;
-	}
-	if(blendTexture!=NULL){
-		delete blendTexture;
+	textureManager->release(baseTexture);
+	if(!atlasTexture){
+		textureManager->release(blendTexture);
 	}
 }
 /*	===============================================
@@ -48,23 +59,150 @@ Precondition:
 Postcondition:
 =============================================== */ 
 void SceneObject::paintTexture(int x, int y, char r, char g, char b){
-	blendTexture->setPixel(x, y, r, g, b);
-		glGenTextures(1,&blendTextureID);
-		// Now we begin to edit the texture
-	//std::cout << "binding texture" << std::endl;
-		glBindTexture(GL_TEXTURE_2D, blendTextureID);
-		//  Now map the actual ppm image to the texture
-	//std::cout << "store texture in memory " << std::endl;
-		glTexImage2D(GL_TEXTURE_2D, 
-					  0,
-					  GL_RGB,
-					  blendTexture->getWidth(),
-					  blendTexture->getHeight(),
-					  0,
-					  GL_RGB,
-					  GL_UNSIGNED_BYTE,
-					  blendTexture->getPixels());
+	if(virtualTexture != NULL){
+		virtualTexture->getStore().paintDisc(x, y, 0, (unsigned char)r, (unsigned char)g, (unsigned char)b);
+		return;
+	}
+	ppm* image = textureManager->getImage(blendTexture);
+	if(image == NULL){
+		return;
+	}
+	if(x < 0 || y < 0 || x >= image->getWidth() || y >= image->getHeight()){
+		return;
+	}
+	// The painted image can no longer be reloaded from its file
+	textureManager->markDirty(blendTexture);
+	recordPaint(image, x, y);
+	image->setPixel(x, y, r, g, b);
+	addPaintedTexel(x, y);
+}
+
+/*	===============================================
+Desc:	
+Precondition: 
+Postcondition:
+=============================================== */ 
+void SceneObject::stampBrush(glm::vec2 texCoord, int brushRadius, char r, char g, char b){
+	if(virtualTexture != NULL){
+		// the store wraps the disc and updates the coarser levels itself
+		TileStore& store = virtualTexture->getStore();
+		int size = store.getSize();
+		store.paintDisc((int)floor(texCoord.x * size), (int)floor(texCoord.y * size), brushRadius,
+			(unsigned char)r, (unsigned char)g, (unsigned char)b);
+		return;
+	}
+	ppm* image = textureManager->getImage(blendTexture);
+	if(image == NULL){
+		return;
+	}
+	textureManager->markDirty(blendTexture);
+	int width = image->getWidth();
+	int height = image->getHeight();
+	// GL_NEAREST samples the texel the coordinate falls into
+	int centerX = (int)floor(texCoord.x * width);
+	int centerY = (int)floor(texCoord.y * height);
+	for(int dy = -brushRadius; dy <= brushRadius; dy++){
+		for(int dx = -brushRadius; dx <= brushRadius; dx++){
+			if(dx * dx + dy * dy > brushRadius * brushRadius){
+				continue;
+			}
+			int x = ((centerX + dx) % width + width) % width;
+			int y = ((centerY + dy) % height + height) % height;
+			recordPaint(image, x, y);
+			image->setPixel(x, y, r, g, b);
+			addPaintedTexel(x, y);
+		}
+	}
+}
+
+/*	===============================================
+Desc:	
+Precondition: 
+Postcondition:
+=============================================== */ 
+void SceneObject::flushPaint(){
+	// painted tiles are sent by VirtualTexture::update()
+	if(virtualTexture != NULL || paintMinX > paintMaxX){
+		return;
+	}
+	// A stamp that wrapped around the seam makes this span the whole width,
+	// which is still cheaper than one upload per stamp
+	textureManager->updateRegion(blendTexture, paintMinX, paintMinY, paintMaxX - paintMinX + 1, paintMaxY - paintMinY + 1);
+	paintMinX = paintMinY = 0;
+	paintMaxX = paintMaxY = -1;
+}
+
+void SceneObject::recordPaint(ppm* image, int x, int y){
+	if(!paintHistoryEnabled){
+		return;
+	}
+	paintHistory.beginStroke(image->getWidth(), image->getHeight());
+	paintHistory.touch(image, x, y);
+}
+
+/*	===============================================
+Desc:	
+Precondition: 
+Postcondition:
+=============================================== */ 
+void SceneObject::setPaintHistory(bool enabled){
+	if(!enabled && paintHistoryEnabled){
+		paintHistory.clear();
+	}
+	paintHistoryEnabled = enabled;
+}
 
+void SceneObject::endStroke(){
+	ppm* image = textureManager->getImage(blendTexture);
+	if(image != NULL){
+		paintHistory.endStroke(image);
+	}
+}
+
+/*	===============================================
+Desc:	
+Precondition: 
+Postcondition:
+=============================================== */ 
+bool SceneObject::undoPaint(){
+	ppm* image = textureManager->getImage(blendTexture);
+	if(image == NULL || !paintHistory.undo(image)){
+		return false;
+	}
+	uploadRestored();
+	return true;
+}
+
+bool SceneObject::redoPaint(){
+	ppm* image = textureManager->getImage(blendTexture);
+	if(image == NULL || !paintHistory.redo(image)){
+		return false;
+	}
+	uploadRestored();
+	return true;
+}
+
+void SceneObject::uploadRestored(){
+	// texels painted but not flushed yet may be in the restored tiles too
+	flushPaint();
+	textureManager->markDirty(blendTexture);
+	for(int i = 0; i < paintHistory.getRestoredCount(); i++){
+		int x, y, width, height;
+		paintHistory.getRestoredRect(i, x, y, width, height);
+		textureManager->updateRegion(blendTexture, x, y, width, height);
+	}
+}
+
+void SceneObject::addPaintedTexel(int x, int y){
+	if(paintMinX > paintMaxX){
+		paintMinX = paintMaxX = x;
+		paintMinY = paintMaxY = y;
+		return;
+	}
+	paintMinX = std::min(paintMinX, x);
+	paintMaxX = std::max(paintMaxX, x);
+	paintMinY = std::min(paintMinY, y);
+	paintMaxY = std::max(paintMaxY, y);
 }
 
 /*	===============================================
@@ -81,68 +219,57 @@ Postcondition:
 void SceneObject::setTexture(int textureNumber,std::string _fileName){
 	/*
 		Algorithm
-		Step 1: Allocate memory for texture
-		Step 2: Generate textures and bind them to object
+		Step 1: Release the texture previously set for this layer
+		Step 2: Register the new image with the texture manager, which
+				uploads it the first time it is drawn
 	*/
 
 	if(textureNumber <= 0){
-		if(baseTexture==NULL){
-			baseTexture = new ppm(_fileName);
-			baseTextureID = loadTexture(baseTexture->getWidth(),baseTexture->getHeight(),baseTexture->getPixels());
-		}
-		else{
-			delete baseTexture;
-			baseTexture = new ppm(_fileName);
-			glBindTexture(GL_TEXTURE_2D, 0);
-			baseTextureID = loadTexture(baseTexture->getWidth(),baseTexture->getHeight(),baseTexture->getPixels());
-		}
-		std::cout << "baseTextureID: " << baseTextureID << std::endl;
+		textureManager->release(baseTexture);
+		baseTexture = textureManager->load(_fileName);
+		std::cout << "baseTexture: " << baseTexture << std::endl;
 	}
 	else if(textureNumber >= 1){
-		if(blendTexture==NULL){
-			blendTexture = new ppm(_fileName);
-			blendTextureID = loadTexture(blendTexture->getWidth(),blendTexture->getHeight(),blendTexture->getPixels());
-		}
-		else{
-			delete blendTexture;
-			blendTexture = new ppm(_fileName);
-			glBindTexture(GL_TEXTURE_2D, 0);
-			blendTextureID = loadTexture(blendTexture->getWidth(),blendTexture->getHeight(),blendTexture->getPixels());
+		if(!atlasTexture){
+			textureManager->release(blendTexture);
 		}
-		std::cout << "blendTextureID: " << blendTextureID << std::endl;
+		atlasTexture = false;
+		uvOffset = glm::vec2(0.0f);
+		uvScale = glm::vec2(1.0f);
+		sphereCommands.clear();
+		paintHistory.clear();
+		blendTexture = textureManager->load(_fileName);
+		std::cout << "blendTexture: " << blendTexture << std::endl;
 	}
 }
 
 /*	===============================================
-Desc:	Loads a new array of colors of a specified dimension
-		into our object.
+Desc:	
 Precondition: 
 Postcondition:
-=============================================== */
-GLuint SceneObject::loadTexture(int width, int height, char* pixels){
-	//std::cout << "loading texture" << std::endl;
-	GLuint textureId;
-		glGenTextures(1,&textureId);
-		// Now we begin to edit the texture
-	//std::cout << "binding texture" << std::endl;
-		glBindTexture(GL_TEXTURE_2D, textureId);
-
-		//  Now map the actual ppm image to the texture
-	//std::cout << "store texture in memory " << std::endl;
-		glTexImage2D(GL_TEXTURE_2D, 
-					  0,
-					  GL_RGB,
-					  width,
-					  height,
-					  0,
-					  GL_RGB,
-					  GL_UNSIGNED_BYTE,
-					  pixels);
-	// Now at this point we have generated some textures that can be used for this object
-	// We do not need our ppms at this point, because they have been shipped off to the
-	// GPU!
-
-	return textureId;
+=============================================== */ 
+void SceneObject::setAtlasTexture(int handle, const AtlasRegion& region){
+	if(!atlasTexture){
+		textureManager->release(blendTexture);
+	}
+	blendTexture = handle;
+	atlasTexture = true;
+	paintHistory.clear();
+	uvOffset = region.uvOffset;
+	uvScale = region.uvScale;
+	// the texture coordinates are recorded, not only the handle
+	sphereCommands.clear();
+}
+
+/*	===============================================
+Desc:	
+Precondition: 
+Postcondition:
+=============================================== */ 
+void SceneObject::setVirtualTexture(VirtualTexture* _virtualTexture){
+	virtualTexture = _virtualTexture;
+	// the recording binds the blend texture only without one
+	sphereCommands.clear();
 }
 
 
@@ -156,24 +283,65 @@ Desc:	This function is an example of how to map a full
 Precondition: 
 Postcondition:
 =============================================== */ 
-void SceneObject::drawTexturedSphere()
+void SceneObject::drawTexturedSphere(GLStateCache& state)
+{
+	updateRecording();
+	if(virtualTexture != NULL){
+		textureManager->bind(blendTexture);
+	}
+	sphereCommands.replay(state);
+}
+
+void SceneObject::drawTexturedSphere(GLStateCache& state, ShaderPipeline& pipeline)
+{
+	updateRecording();
+	if(virtualTexture != NULL){
+		virtualTexture->bind(state, pipeline);
+		sphereCommands.replay(state, pipeline);
+		pipeline.setVirtualTexture(false, glm::vec4(0.0f));
+		return;
+	}
+	sphereCommands.replay(state, pipeline);
+}
+
+void SceneObject::updateRecording()
+{
+	if(sphereCommands.isRecorded() && (recordedRadius != radius || recordedTexture != blendTexture)){
+		sphereCommands.clear();
+	}
+	if(!sphereCommands.isRecorded()){
+		recordSphere(sphereCommands);
+		sphereCommands.finish();
+		recordedRadius = radius;
+		recordedTexture = blendTexture;
+	}
+}
+
+/*	===============================================
+Desc:	Records the calls drawTexturedSphere used to make every frame.
+Precondition: 
+Postcondition:
+=============================================== */ 
+void SceneObject::recordSphere(CommandBuffer& commands)
 {
 	float angle = 0;
 	float angleH = -PI / (float)2.0;
 
-	int m_segmentsX = 20;
-	int m_segmentsY = 20;
+	int m_segmentsX = SPHERE_SEGMENTS_X;
+	int m_segmentsY = SPHERE_SEGMENTS_Y;
 
 	float angle_delta = 2.0 * PI / (float)m_segmentsX;
 	float angleH_delta = PI / (float)m_segmentsY;
 
-	glEnable(GL_TEXTURE_2D);
+	commands.enable(GL_TEXTURE_2D);
 
-	glBindTexture(GL_TEXTURE_2D, blendTextureID);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	// the texture manager sets the GL_NEAREST filters when it uploads,
+	// a virtual texture is bound by drawTexturedSphere
+	if (virtualTexture == NULL) {
+		commands.bindTexture(textureManager, blendTexture);
+	}
 
-	glBegin(GL_TRIANGLES);
+	commands.begin(GL_TRIANGLES);
 	for (int i = 0; i < m_segmentsY; i++) {
 		angle = 0;
 		for (int j = 0; j < m_segmentsX; j++) {
@@ -213,29 +381,37 @@ void SceneObject::drawTexturedSphere()
 			float etx = 1 - (j + 1)*textureCoordX_delta;// ending x pixel coordinate
 			float ety = 1 - (i - 1)*textureCoordY_delta;// ending y pixel coordinate
 
-			glTexCoord2f(tx, ety); 		// glTexCoord2f(0.0f, 1.0f);
-			glNormal3f(x, y, z);
-			glVertex3f(x, y, z);
+			if (atlasTexture) {
+				// there is no GL_REPEAT inside an atlas page
+				tx = uvOffset.x + std::min(std::max(tx, 0.0f), 1.0f) * uvScale.x;
+				ty = uvOffset.y + std::min(std::max(ty, 0.0f), 1.0f) * uvScale.y;
+				etx = uvOffset.x + std::min(std::max(etx, 0.0f), 1.0f) * uvScale.x;
+				ety = uvOffset.y + std::min(std::max(ety, 0.0f), 1.0f) * uvScale.y;
+			}
+
+			commands.texCoord2f(tx, ety); 		// glTexCoord2f(0.0f, 1.0f);
+			commands.normal3f(x, y, z);
+			commands.vertex3f(x, y, z);
 
-			glTexCoord2f(etx, ety); 		// glTexCoord2f(1.0f, 1.0f);
-			glNormal3f(newx, newy, newz);
-			glVertex3f(newx, newy, newz);
+			commands.texCoord2f(etx, ety); 		// glTexCoord2f(1.0f, 1.0f);
+			commands.normal3f(newx, newy, newz);
+			commands.vertex3f(newx, newy, newz);
 
-			glTexCoord2f(etx, ty); 		// glTexCoord2f(1.0f, 0.0f);
-			glNormal3f(newx_next, newy_next, newz_next);
-			glVertex3f(newx_next, newy_next, newz_next);
+			commands.texCoord2f(etx, ty); 		// glTexCoord2f(1.0f, 0.0f);
+			commands.normal3f(newx_next, newy_next, newz_next);
+			commands.vertex3f(newx_next, newy_next, newz_next);
 
-			glTexCoord2f(etx, ty); 		// glTexCoord2f(1.0f, 0.0f);
-			glNormal3f(newx_next, newy_next, newz_next);
-			glVertex3f(newx_next, newy_next, newz_next);
+			commands.texCoord2f(etx, ty); 		// glTexCoord2f(1.0f, 0.0f);
+			commands.normal3f(newx_next, newy_next, newz_next);
+			commands.vertex3f(newx_next, newy_next, newz_next);
 
-			glTexCoord2f(tx, ty); 		// glTexCoord2f(0.0f, 0.0f);
-			glNormal3f(x_next, y_next, z_next);
-			glVertex3f(x_next, y_next, z_next);
+			commands.texCoord2f(tx, ty); 		// glTexCoord2f(0.0f, 0.0f);
+			commands.normal3f(x_next, y_next, z_next);
+			commands.vertex3f(x_next, y_next, z_next);
 
-			glTexCoord2f(tx, ety); 		// glTexCoord2f(0.0f, 1.0f);
-			glNormal3f(x, y, z);
-			glVertex3f(x, y, z);
+			commands.texCoord2f(tx, ety); 		// glTexCoord2f(0.0f, 1.0f);
+			commands.normal3f(x, y, z);
+			commands.vertex3f(x, y, z);
 
 			//				glTexCoord2f(tx, ety); 		// glTexCoord2f(0.0f, 1.0f);
 			//				glNormal3f(x, y, z);
@@ -265,8 +441,8 @@ void SceneObject::drawTexturedSphere()
 		}
 		angleH = angleH + angleH_delta;
 	}
-	glEnd();
+	commands.end();
 
-	glDisable(GL_TEXTURE_2D);
+	commands.disable(GL_TEXTURE_2D);
 }
 
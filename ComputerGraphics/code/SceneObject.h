@@ -12,9 +12,15 @@
 #ifndef SCENE_OBJECT_H
 #define SCENE_OBJECT_H
 
-#include <FL/gl.h>
-#include <FL/glu.h>
+#include "GLExt.h"
 #include "ppm.h"
+#include "TextureManager.h"
+#include "CommandBuffer.h"
+#include "TextureAtlas.h"
+#include "VirtualTexture.h"
+#include "PaintHistory.h"
+#include "Picking.h"
+#include <glm/glm.hpp>
 
 /*
 	This object renders a piece of geometry ('a sphere by default')
@@ -25,10 +31,10 @@ class SceneObject {
 	public:
 		/*	===============================================
 		Desc:
-		Precondition: 
+		Precondition: _textureManager outlives this object
 		Postcondition:
 		=============================================== */ 
-		SceneObject(int _id);
+		SceneObject(int _id, TextureManager* _textureManager);
 		/*	===============================================
 		Desc:
 		Precondition: 
@@ -36,41 +42,98 @@ class SceneObject {
 		=============================================== */ 
 		~SceneObject();
 		/*	===============================================
-		Desc:
-		Precondition: 
-		Postcondition:
-		=============================================== */
-		GLuint loadTexture(int width, int height, char* pixels);
-		/*	===============================================
 		Desc:	This instantiates an image to be rendered.
 				
-				If memory has already been allocated for this,
-				then our contract is to delete the previous image,
+				If a texture has already been set for this layer,
+				then our contract is to release the previous image,
 				and overwrite it with the new one.
 		Precondition: 
 		Postcondition:
 		=============================================== */ 
 		void setTexture(int textureNumber,std::string _fileName);
+		/*	===============================================
+		Desc:	Draws the blend layer from a region of a shared atlas page
+				instead of a texture of its own.  The texture coordinates
+				of the sphere are clamped to [0, 1] and mapped into the
+				region, so the last stack near the south pole shows the
+				edge row of the image instead of wrapping to its top.
+		Precondition:	handle is a page of the texture manager that
+						outlives this object, region is where the image is
+						on it (see TextureAtlas.h)
+		Postcondition:	The page is not released with this object.
+		=============================================== */
+		void setAtlasTexture(int handle, const AtlasRegion& region);
+		/*	===============================================
+		Desc:	Draws the blend layer from a virtual texture in the shader
+				pipeline, and paints into it instead of the blend texture.
+				The fixed function path cannot read a virtual texture, it
+				keeps drawing the blend texture.  NULL goes back to the
+				blend texture.
+		Precondition:	virtualTexture outlives this object or is set to
+						NULL first, the caller keeps it updated every frame
+		Postcondition:
+		=============================================== */
+		void setVirtualTexture(VirtualTexture* _virtualTexture);
 
 		/*	===============================================
-		Desc:	Draw the actual rendered spheres
-		Precondition: 
+		Desc:	Draw the actual rendered spheres.  The triangles are recorded
+				into a command buffer the first time and replayed from then
+				on, until the radius or the blend texture changes.
+		Precondition: A GL context is current, state is its cache.
 		Postcondition:
 		=============================================== */ 
-		void drawTexturedSphere();
+		void drawTexturedSphere(GLStateCache& state);
+		// the same through the shader pipeline, the object block is bound
+		void drawTexturedSphere(GLStateCache& state, ShaderPipeline& pipeline);
 		/*	===============================================
 		Desc:			Calls into this function modify a previously loaded ppm's
 						color array.
 
 						Note that this does NOT change the original ppm image at all.
 
-						Also note, that a new OpenGL Texture is generated everytime, we
-						paint on the texture.  There could probably be a buffer to improve
-						the performance of this call.
+						The painted texel is sent to the existing OpenGL texture by
+						the next flushPaint(), and the painted image stays pinned in
+						the texture manager.  Texels outside the image are ignored.
 		Precondition: 
 		Postcondition:
 		=============================================== */ 
 		void paintTexture(int x, int y, char r, char g, char b);
+		/*	===============================================
+		Desc:	Paints a disc of brushRadius texels around a texture
+				coordinate into the blend texture.  The brush wraps around the
+				texture edges like GL_REPEAT does, so a stroke across the seam
+				of the sphere continues on the other side.
+		Precondition: 
+		Postcondition:	Nothing is uploaded until flushPaint().
+		=============================================== */
+		void stampBrush(glm::vec2 texCoord, int brushRadius, char r, char g, char b);
+		/*	===============================================
+		Desc:	Sends every texel painted since the last call to the GL
+				texture as one sub-image upload.
+		Precondition: A GL context is current.
+		Postcondition:
+		=============================================== */
+		void flushPaint();
+		/*	===============================================
+		Desc:	Records paintTexture and stampBrush for undo while enabled.
+				The first paint after endStroke() starts a new step, so a
+				stroke is everything painted in between.  Disabling drops
+				the history.
+		Precondition:
+		Postcondition:
+		=============================================== */
+		void setPaintHistory(bool enabled);
+		void endStroke();
+		/*	===============================================
+		Desc:	Undoes or redoes the last stroke on the blend texture and
+				sends only the tiles it changed to the GL texture.  Painting
+				into a virtual texture is not recorded.
+		Precondition:	A GL context is current.
+		Postcondition:	Returns false if there was nothing to undo or redo.
+		=============================================== */
+		bool undoPaint();
+		bool redoPaint();
+		PaintHistory& getPaintHistory() { return paintHistory; }
 
 		
 		/*
@@ -79,22 +142,46 @@ class SceneObject {
 		int id;	// This is a unique id that we can reference our object by
 		float radius; // default radius of our sphere object
 				
-		// The first texture image
+		// Handle of the first texture image in the texture manager (-1 if not set)
 		// This should be a white, black, pink, or other solid image that
 		// we can draw on.
-		ppm* baseTexture;
-		// A second texture image that can be loaded
+		int baseTexture;
+		// Handle of a second texture image that can be loaded (-1 if not set)
 		// This is a second texture that we can blend onto our sphere
 		// This is demonstrating multiple textures or 'multitexturing' as it
 		// is called in the graphics world.
-		ppm* blendTexture;
+		int blendTexture;
+		// blendTexture is a shared atlas page, texture coordinates are
+		// mapped to uvOffset + (s, t) * uvScale
+		bool atlasTexture;
+		glm::vec2 uvOffset;
+		glm::vec2 uvScale;
+		// not owned, NULL unless setVirtualTexture was called
+		VirtualTexture* virtualTexture;
 
 	private:
-	// Create a texture id that uniquly identifies each texture image
-		// I believe OpenGL will use these id's when we generate a texture
-		// to uniquely identify which array of pixels to map to an image.
-		GLuint baseTextureID;
-		GLuint blendTextureID;
+		// The manager owns the ppm images and the OpenGL texture ids, and may
+		// evict either copy when they have not been drawn recently.
+		TextureManager* textureManager;
+
+		// Texels painted since the last flushPaint(), empty when paintMinX > paintMaxX
+		int paintMinX;
+		int paintMinY;
+		int paintMaxX;
+		int paintMaxY;
+		void addPaintedTexel(int x, int y);
+		// called before texel (x, y) of image is painted
+		void recordPaint(ppm* image, int x, int y);
+		void uploadRestored();
+
+		bool paintHistoryEnabled;
+		PaintHistory paintHistory;
+
+		CommandBuffer sphereCommands;
+		float recordedRadius;	// what sphereCommands was recorded with
+		int recordedTexture;
+		void recordSphere(CommandBuffer& commands);
+		void updateRecording();	// re-records sphereCommands if it is stale
 
 };
 
@@ -0,0 +1,937 @@
+#include "SceneRenderer.h"
+#include "Picking.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <algorithm>
+
+/*	Replacements for glutWireCube and glutSolidSphere, so the scene does
+	not need FLTK's glut implementation.
+*/
+static void drawWireCube(float size) {
+	float h = size / 2.0f;
+	static const int edges[12][2] = {
+		{0, 1}, {1, 3}, {3, 2}, {2, 0},
+		{4, 5}, {5, 7}, {7, 6}, {6, 4},
+		{0, 4}, {1, 5}, {2, 6}, {3, 7}
+	};
+	glBegin(GL_LINES);
+	for (int i = 0; i < 12; i++) {
+		for (int k = 0; k < 2; k++) {
+			int c = edges[i][k];
+			glVertex3f((c & 1) ? h : -h, (c & 2) ? h : -h, (c & 4) ? h : -h);
+		}
+	}
+	glEnd();
+}
+
+/*	Seconds on a monotonic clock, used to time drag events */
+static double currentTime() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void drawSolidSphere(float radius, int slices, int stacks) {
+	GLUquadric* quadric = gluNewQuadric();
+	gluSphere(quadric, radius, slices, stacks);
+	gluDeleteQuadric(quadric);
+}
+
+SceneRenderer::SceneRenderer() {
+	eyePosition = glm::vec3(0.0f, 0.0f, 3.0f);
+	lookVector = glm::vec3(0.0f, 0.0f, -1.0f);
+	lookatPoint = glm::vec3(0.0f, 0.0f, 0.0f);
+	rotVec = glm::vec3(0.0f, 0.0f, 0.0f);
+
+	wireframe = 0;
+	viewAngle = 60;
+	clipNear = 0.01f;
+	clipFar = 10.0f;
+
+	spherePosition = glm::vec3(0, 0, 0);
+	meshFile = "";
+	meshPosition = glm::vec3(1.2f, 0, 0);
+
+	paintMode = false;
+	brushRadius = 4;
+	// a stroke queues a few stamps per frame, reserved so queuing one
+	// does not allocate
+	brushStamps.reserve(64);
+	paintActions.reserve(16);
+	paintHistory = true;
+	brushColor[0] = 255;
+	brushColor[1] = 0;
+	brushColor[2] = 0;
+
+	showGrid = true;
+
+	// a figure eight crossing over the sphere, so looking along the path
+	// heads towards the objects twice per loop
+	std::vector<glm::vec3> loop;
+	for (int i = 0; i < 12; i++) {
+		float angle = 2.0f * PI * (float)i / 12.0f;
+		float side = sin(angle);
+		loop.push_back(glm::vec3(3.0f * side, 0.8f - 0.6f * side * side, 2.5f * sin(2.0f * angle)));
+	}
+	cameraSpline.setControlPoints(loop, SPLINE_CATMULL_ROM, true);
+	followSpline = false;
+	splineDistance = 0;
+	splineTime = 0;
+	savedEyePosition = eyePosition;
+	savedLookVector = lookVector;
+
+	frustumCulling = true;
+	occlusionCulling = false;
+	shaderPipeline = false;
+	streamTransforms = true;
+	transformStats.objects = 0;
+	transformStats.seconds = 0;
+	virtualTextureSize = 32768;
+	lightDirection = eyePosition;
+	meshRadius = 0;
+
+	pickBufferEnabled = false;
+	hoverObject = PICK_NONE;
+	pickBufferValid = false;
+	pickScreenWidth = 0;
+	pickScreenHeight = 0;
+
+	dynamicResolution = false;
+	scaleChanges = 0;
+	windowWidth = 0;
+	windowHeight = 0;
+
+	textureManager.setStateCache(&glState);
+	myObject = new SceneObject(175, &textureManager);
+	camera.setViewAngle(viewAngle);
+	camera.setNearPlane(clipNear);
+	camera.setFarPlane(clipFar);
+	// Set the mode so we are modifying our objects.
+	camera.orientLookVec(eyePosition, lookVector, glm::vec3(0, 1, 0));
+}
+
+SceneRenderer::~SceneRenderer() {
+	setInstanceTextures("", false);
+	delete myObject;
+	virtualTexture.close();
+}
+
+void SceneRenderer::moveEye(int key) {
+	switch (key) {
+	case 'w': eyePosition.y += 0.05f;  break;
+	case 'a': eyePosition.x += 0.05f; break;
+	case 's': eyePosition.y -= 0.05f;  break;
+	case 'd': eyePosition.x -= 0.05f; break;
+	}
+}
+
+void SceneRenderer::zoom(int dy) {
+	eyePosition.z += dy * -0.05f;
+}
+
+bool SceneRenderer::beginDrag(int x, int y) {
+	glm::vec3 isectPointWorldCoord;
+	float t;
+	if (pickBufferEnabled && pickBufferValid) {
+		t = (pickObject(x, y, &isectPointWorldCoord) == myObject->id) ? 1.0f : -1.0f;
+	}
+	else {
+		t = pick(x, y, &isectPointWorldCoord);
+	}
+
+	if (t > 0) {
+		glm::vec2 pixel = framePixel(x, y);
+		dragController.begin(camera, pixel.x, pixel.y, isectPointWorldCoord, spherePosition, currentTime());
+	}
+	return dragController.isActive();
+}
+
+void SceneRenderer::dragTo(int x, int y) {
+	glm::vec2 pixel = framePixel(x, y);
+	dragController.moveTo(pixel.x, pixel.y, currentTime());
+}
+
+void SceneRenderer::endDrag() {
+	dragController.end(camera, spherePosition);
+}
+
+void SceneRenderer::setSphereInstances(int count) {
+	sphereInstances.clear();
+	for (int i = 0; i < count; i++) {
+		int column = i % 20;
+		int row = i / 20;
+		sphereInstances.push_back(glm::vec3(1.2f * (column - 9.5f), 0.0f, -1.5f - 1.2f * row));
+	}
+	updatePickPrimitives();
+}
+
+void SceneRenderer::animateSphereInstances(double seconds) {
+	for (size_t i = 0; i < sphereInstances.size(); i++) {
+		float phase = (float)(2.0 * seconds) - 0.3f * (i % 20) - 0.5f * (i / 20);
+		sphereInstances[i].y = 0.25f * sin(phase);
+	}
+}
+
+void SceneRenderer::setInstanceTextures(std::string fileList, bool useAtlas) {
+	for (size_t i = 0; i < instanceObjects.size(); i++) {
+		delete instanceObjects[i];
+	}
+	instanceObjects.clear();
+	for (size_t i = 0; i < atlasPages.size(); i++) {
+		textureManager.release(atlasPages[i]);
+	}
+	atlasPages.clear();
+	atlas.clear();
+
+	std::vector<std::string> files;
+	size_t start = 0;
+	while (start < fileList.size()) {
+		size_t comma = fileList.find(',', start);
+		if (comma == std::string::npos) {
+			comma = fileList.size();
+		}
+		if (comma > start) {
+			files.push_back(fileList.substr(start, comma - start));
+		}
+		start = comma + 1;
+	}
+
+	for (size_t i = 0; i < files.size(); i++) {
+		// the instances are not in the pick buffer, they do not need an id
+		SceneObject* object = new SceneObject(PICK_NONE, &textureManager);
+		object->radius = myObject->radius;
+		if (!useAtlas) {
+			object->setTexture(1, files[i]);
+		}
+		instanceObjects.push_back(object);
+	}
+	if (!useAtlas || files.empty()) {
+		return;
+	}
+
+	// the atlas copies the images, they are not kept afterwards
+	std::vector<ppm*> images;
+	std::vector<int> regions(files.size(), -1);
+	for (size_t i = 0; i < files.size(); i++) {
+		ppm* image = new ppm(files[i]);
+		if (image->getPixels() == NULL) {
+			printf("Unable to load texture: %s\n", files[i].c_str());
+			delete image;
+			continue;
+		}
+		// the atlas bypasses the texture manager, so it is resized here
+		ppm* resized = resizeImage(image, textureManager.getResize());
+		if (resized != NULL) {
+			delete image;
+			image = resized;
+		}
+		regions[i] = atlas.add(image);
+		images.push_back(image);
+	}
+	atlas.build();
+	for (size_t i = 0; i < images.size(); i++) {
+		delete images[i];
+	}
+	for (int page = 0; page < atlas.getPageCount(); page++) {
+		char name[64];
+		snprintf(name, sizeof(name), "atlas page %d", page);
+		atlasPages.push_back(textureManager.add(atlas.takePage(page), name));
+	}
+	for (size_t i = 0; i < files.size(); i++) {
+		if (regions[i] < 0) {
+			continue;
+		}
+		const AtlasRegion& region = atlas.getRegion(regions[i]);
+		if (region.page < 0) {
+			instanceObjects[i]->setTexture(1, files[i]);
+		}
+		else {
+			instanceObjects[i]->setAtlasTexture(atlasPages[region.page], region);
+		}
+	}
+	const AtlasStats& stats = atlas.getStats();
+	printf("texture atlas: %d of %d images on %d pages of %d texels, %.1f%% used, packed in %.2f ms\n",
+		stats.images, (int)files.size(), stats.pages, ATLAS_PAGE_SIZE, 100.0 * stats.efficiency,
+		1000.0 * stats.packSeconds);
+}
+
+void SceneRenderer::paintAt(int x, int y) {
+	brushStamps.push_back(std::make_pair(x, y));
+}
+
+void SceneRenderer::endStroke() {
+	paintActions.push_back(std::make_pair(PAINT_END_STROKE, brushStamps.size()));
+}
+
+void SceneRenderer::undoPaint() {
+	paintActions.push_back(std::make_pair(PAINT_UNDO, brushStamps.size()));
+}
+
+void SceneRenderer::redoPaint() {
+	paintActions.push_back(std::make_pair(PAINT_REDO, brushStamps.size()));
+}
+
+void SceneRenderer::applyBrushStamps() {
+	myObject->setPaintHistory(paintHistory);
+	size_t action = 0;
+	for (size_t i = 0; i <= brushStamps.size(); i++) {
+		// the actions queued before stamp i
+		for (; action < paintActions.size() && paintActions[action].second == i; action++) {
+			applyPaintAction(paintActions[action].first);
+		}
+		if (i < brushStamps.size()) {
+			applyBrushStamp(brushStamps[i].first, brushStamps[i].second);
+		}
+	}
+	brushStamps.clear();
+	paintActions.clear();
+	// one upload for all stamps (and paintTexture calls) of this frame
+	myObject->flushPaint();
+}
+
+void SceneRenderer::applyBrushStamp(int x, int y) {
+	if (virtualTexture.isOpen()) {
+		// brushRadius is in texels of the level on screen
+		glm::vec2 texCoord;
+		int level;
+		glm::vec2 pixel = framePixel(x, y);
+		if (virtualTexel(pixel.x, pixel.y, texCoord, level)) {
+			myObject->stampBrush(texCoord, brushRadius << level, (char)brushColor[0], (char)brushColor[1], (char)brushColor[2]);
+		}
+		return;
+	}
+	RayHit hit;
+	if (!pick(x, y, hit)) {
+		return;
+	}
+	myObject->stampBrush(hit.uv, brushRadius, (char)brushColor[0], (char)brushColor[1], (char)brushColor[2]);
+}
+
+void SceneRenderer::applyPaintAction(PaintAction action) {
+	if (action == PAINT_END_STROKE) {
+		myObject->endStroke();
+		return;
+	}
+	bool undo = (action == PAINT_UNDO);
+	if (!(undo ? myObject->undoPaint() : myObject->redoPaint())) {
+		printf("nothing to %s\n", undo ? "undo" : "redo");
+		return;
+	}
+	PaintHistory& history = myObject->getPaintHistory();
+	const PaintHistoryStats& stats = history.getStats();
+	printf("%s: %d tiles restored, %d undo and %d redo steps in %.1f KB\n", undo ? "undo" : "redo",
+		history.getRestoredCount(), stats.undoSteps, stats.redoSteps, stats.bytes / 1024.0);
+}
+
+bool SceneRenderer::virtualTexel(float x, float y, glm::vec2& texCoord, int& level) {
+	float u[3];
+	float v[3];
+	for (int i = 0; i < 3; i++) {
+		RayHit hit;
+		if (!pickSphere(x + (i == 1 ? 1 : 0), y + (i == 2 ? 1 : 0), hit)) {
+			if (i == 0) {
+				return false;
+			}
+			// at the silhouette, the pixel itself has to do
+			u[i] = u[0];
+			v[i] = v[0];
+			continue;
+		}
+		u[i] = hit.uv.x;
+		v[i] = hit.uv.y;
+	}
+	float size = (float)virtualTexture.getStore().getSize();
+	float footprint = 0;
+	for (int i = 1; i < 3; i++) {
+		// hit.uv wraps at the seam, the drawn coordinates do not
+		float du = u[i] - u[0];
+		float dv = v[i] - v[0];
+		du -= floorf(du + 0.5f);
+		dv -= floorf(dv + 0.5f);
+		footprint = std::max(footprint, sqrtf(du * du + dv * dv) * size);
+	}
+	texCoord = glm::vec2(u[0], v[0]);
+	level = virtualTexture.levelFor(footprint);
+	return true;
+}
+
+void SceneRenderer::updateVirtualTexture() {
+	virtualTexture.beginFeedback();
+	int width = camera.getScreenWidth();
+	int height = camera.getScreenHeight();
+	for (int y = VIRTUAL_FEEDBACK_SCALE / 2; y < height; y += VIRTUAL_FEEDBACK_SCALE) {
+		for (int x = VIRTUAL_FEEDBACK_SCALE / 2; x < width; x += VIRTUAL_FEEDBACK_SCALE) {
+			glm::vec2 texCoord;
+			int level;
+			if (virtualTexel((float)x, (float)y, texCoord, level)) {
+				virtualTexture.request(texCoord, level);
+			}
+		}
+	}
+	virtualTexture.update(glState);
+}
+
+float SceneRenderer::pick(int x, int y, glm::vec3* isectPoint) {
+	RayHit hit;
+	if (!pick(x, y, hit)) {
+		return -1;
+	}
+	if (isectPoint != NULL) {
+		*isectPoint = hit.point;
+	}
+	return hit.t;
+}
+
+bool SceneRenderer::pick(int x, int y, RayHit& hit) {
+	return pickScene(x, y, hit) == PICK_PRIMITIVE_SPHERE;
+}
+
+int SceneRenderer::pickScene(int x, int y, RayHit& hit) {
+	updatePickPrimitives();
+	glm::vec2 pixel = framePixel(x, y);
+	return intersectPrimitives(pickPrimitives, getEyePoint(), generateRay(camera, pixel.x, pixel.y), hit);
+}
+
+bool SceneRenderer::pickSphere(float x, float y, RayHit& hit) {
+	glm::vec3 eyePointP = getEyePoint();
+	glm::vec3 rayV = generateRay(camera, x, y);
+	// the sphere is only ever translated, and sized by its radius
+	return intersectSphere(eyePointP, rayV, UniformScaleTransform(spherePosition, 2.0f * myObject->radius), hit);
+}
+
+void SceneRenderer::updatePickPrimitives() {
+	// the capacity stays, so this only allocates when instances are added
+	pickPrimitives.resize(PICK_PRIMITIVE_INSTANCES + sphereInstances.size());
+	float diameter = 2.0f * myObject->radius;
+	pickPrimitives[PICK_PRIMITIVE_SPHERE] = makePrimitive(PRIMITIVE_SPHERE, spherePosition, diameter);
+	bool meshLoaded = meshBVH.getNodeCount() > 0;
+	pickPrimitives[PICK_PRIMITIVE_MESH] = makePrimitive(PRIMITIVE_MESH, meshPosition, 1.0f,
+		meshLoaded ? &mesh : NULL, meshLoaded ? &meshBVH : NULL);
+	for (size_t i = 0; i < sphereInstances.size(); i++) {
+		pickPrimitives[PICK_PRIMITIVE_INSTANCES + i] = makePrimitive(PRIMITIVE_SPHERE, sphereInstances[i], diameter);
+	}
+}
+
+int SceneRenderer::pickObject(int x, int y, glm::vec3* point) {
+	if (!pickBufferValid) {
+		return PICK_NONE;
+	}
+	glm::vec2 pixel = framePixel(x, y);
+	return pickBuffer.lookup((int)pixel.x, (int)pixel.y, point);
+}
+
+glm::vec2 SceneRenderer::framePixel(int x, int y) {
+	if (windowWidth <= 0 || windowHeight <= 0) {
+		return glm::vec2((float)x, (float)y);
+	}
+	// generateRay maps 0 and the screen size to the edges, so this keeps
+	// every window pixel on the same point of the view
+	return glm::vec2((float)x * camera.getScreenWidth() / windowWidth, (float)y * camera.getScreenHeight() / windowHeight);
+}
+
+void SceneRenderer::updatePickBuffer() {
+	glm::mat4 viewProjection = camera.getProjectionMatrix() * camera.getModelViewMatrix();
+	bool cameraMoved = !pickBufferValid || camera.getScreenWidth() != pickScreenWidth || camera.getScreenHeight() != pickScreenHeight;
+	for (int i = 0; i < 4 && !cameraMoved; i++) {
+		for (int j = 0; j < 4; j++) {
+			if (viewProjection[i][j] != pickViewProjection[i][j]) {
+				cameraMoved = true;
+			}
+		}
+	}
+	if (!cameraMoved && spherePosition == pickSpherePosition) {
+		return;
+	}
+	if (cameraMoved) {
+		meshPickLayer.begin(camera, PICK_BUFFER_DOWNSCALE);
+		if (meshBuffer.isLoaded()) {
+			meshPickLayer.drawMesh(MESH_OBJECT_ID, mesh, meshPosition);
+		}
+		pickViewProjection = viewProjection;
+		pickScreenWidth = camera.getScreenWidth();
+		pickScreenHeight = camera.getScreenHeight();
+	}
+	pickBuffer.copyFrom(meshPickLayer);
+	pickBuffer.drawSphere(myObject->id, spherePosition, myObject->radius);
+	pickSpherePosition = spherePosition;
+	pickBufferValid = true;
+}
+
+void SceneRenderer::setFollowSpline(bool follow) {
+	if (follow == followSpline) {
+		return;
+	}
+	if (follow) {
+		savedEyePosition = eyePosition;
+		savedLookVector = lookVector;
+		splineTime = 0;
+	}
+	else {
+		eyePosition = savedEyePosition;
+		lookVector = savedLookVector;
+	}
+	followSpline = follow;
+}
+
+void SceneRenderer::advanceSpline(double seconds) {
+	float length = cameraSpline.getLength();
+	splineDistance += (float)(COASTER_SPEED * 1000.0 * seconds) * length;
+	if (length > 0 && splineDistance >= length) {
+		// an open path starts over
+		splineDistance = fmod(splineDistance, length);
+	}
+	CameraPose pose = cameraSpline.poseAt(splineDistance);
+	eyePosition = pose.position;
+	lookVector = pose.look;
+}
+
+glm::vec3 SceneRenderer::getEyePoint() {
+	return camera.getEyePoint();
+}
+
+
+void SceneRenderer::initGL(int width, int height) {
+	// Set the base texture of our object. Note that loading gl texture can 
+	//  only happen after the gl context has been established
+	if (myObject->baseTexture < 0) {
+		myObject->setTexture(0, "./data/pink.ppm");
+	}
+	// Set a second texture layer to our object
+	if (myObject->blendTexture < 0) {
+		myObject->setTexture(1, "./data/smile.ppm");
+	}
+	if (!virtualTextureFile.empty() && !virtualTexture.isOpen()) {
+		// new tiles are sampled from the blend image until painted
+		if (virtualTexture.open(virtualTextureFile, virtualTextureSize, "./data/smile.ppm")) {
+			myObject->setVirtualTexture(&virtualTexture);
+		}
+		else {
+			printf("%s: cannot open or create the virtual texture\n", virtualTextureFile.c_str());
+		}
+	}
+
+	if (!meshFile.empty() && !meshBuffer.isLoaded()) {
+		MeshLoadStats stats;
+		if (loadMesh(meshFile, mesh, &stats)) {
+			fitMeshToUnitCube(mesh);
+			meshBuffer.upload(mesh);
+			meshBVH.build(mesh);
+			for (size_t i = 0; i < mesh.positions.size(); i++) {
+				meshRadius = std::max(meshRadius, glm::length(mesh.positions[i]));
+			}
+			printf("%s: %d triangles, %d of %d vertices unique, parsed in %.1f ms (%.2f M triangles/s), normals in %.1f ms\n",
+				meshFile.c_str(), stats.triangles, stats.vertices, stats.fileVertices, 1000.0 * stats.parseSeconds,
+				stats.triangles / stats.parseSeconds / 1e6, 1000.0 * stats.normalSeconds);
+			printf("%s: BVH of %d nodes built in %.1f ms\n", meshFile.c_str(), meshBVH.getNodeCount(), 1000.0 * meshBVH.getBuildSeconds());
+		}
+	}
+
+	// the context may be new, nothing is known about its state
+	loadGLExtensions();
+	glState.reset();
+	glViewport(0, 0, width, height);
+	updateCamera(width, height);
+
+	glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+	//glShadeModel(GL_SMOOTH);
+	glShadeModel(GL_FLAT);
+
+	GLfloat light_pos0[] = { eyePosition.x, eyePosition.y, eyePosition.z, 0.0f };
+	GLfloat ambient[] = { 0.7f, 0.7f, 0.7f, 1.0f };
+	GLfloat diffuse[] = { 0.5f, 0.5f, 0.5f, 1.0f };
+
+	glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse);
+	glLightfv(GL_LIGHT0, GL_AMBIENT, ambient);
+	glLightfv(GL_LIGHT0, GL_POSITION, light_pos0);
+	// GL turns the position into eye space with the modelview matrix of
+	// this moment, the shaders light with the same direction
+	glm::mat4 lightModelView;
+	glGetFloatv(GL_MODELVIEW_MATRIX, glm::value_ptr(lightModelView));
+	lightDirection = glm::vec3(lightModelView * glm::vec4(eyePosition, 0.0f));
+
+	glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
+	glState.enable(GL_COLOR_MATERIAL);
+
+	glState.enable(GL_LIGHTING);
+	glState.enable(GL_LIGHT0);
+
+	/****************************************/
+	/*          Enable z-buferring          */
+	/****************************************/
+
+	glState.enable(GL_DEPTH_TEST);
+	glPolygonOffset(1, 1);
+}
+
+void SceneRenderer::drawFrame(bool castRay, int mouseX, int mouseY) {
+	// the scale changes between frames, the camera follows it here
+	int frameWidth = windowWidth;
+	int frameHeight = windowHeight;
+	if (dynamicResolution) {
+		resolutionScaler.scaledSize(windowWidth, windowHeight, frameWidth, frameHeight);
+	}
+	if (frameWidth != camera.getScreenWidth() || frameHeight != camera.getScreenHeight()) {
+		updateCamera(windowWidth, windowHeight);
+	}
+	// at full scale the frame goes straight to the window, stretching
+	// it costs about as much as drawing a simple scene on llvmpipe
+	bool scaled = dynamicResolution && (frameWidth != windowWidth || frameHeight != windowHeight);
+	bool offscreen = scaled && renderTarget.begin(frameWidth, frameHeight);
+	if (scaled && !offscreen) {
+		printf("dynamic resolution off, the context cannot render offscreen\n");
+		dynamicResolution = false;
+		updateCamera(windowWidth, windowHeight);
+	}
+	else if (!dynamicResolution) {
+		if (renderTarget.getWidth() > 0) {
+			renderTarget.release();
+		}
+		// frames still in flight would come back when it is on again
+		frameTimer.release();
+	}
+	if (dynamicResolution) {
+		frameTimer.begin(scaleChanges);
+	}
+
+	// Clear the buffer of colors in each bit plane.
+	// bit plane - A set of bits that are on or off (Think of a black and white image)
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// nothing of the last frame's arena memory is used any more
+	frameArena.reset();
+	textureManager.beginFrame();
+	glState.beginFrame();
+	drawScene(castRay, mouseX, mouseY);
+
+	if (offscreen) {
+		renderTarget.end(windowWidth, windowHeight);
+	}
+	if (dynamicResolution) {
+		frameTimer.end();
+		// the time of the frame before; frames drawn before the last
+		// change of the scale say nothing about the current one
+		double milliseconds;
+		int tag;
+		while (frameTimer.collect(milliseconds, tag)) {
+			if (tag == scaleChanges && resolutionScaler.addFrameTime(milliseconds)) {
+				scaleChanges++;
+			}
+		}
+	}
+}
+
+void SceneRenderer::drawScene(bool castRay, int mouseX, int mouseY) {
+	if (followSpline && !cameraSpline.isEmpty()) {
+		double now = currentTime();
+		advanceSpline(splineTime > 0 ? now - splineTime : 0.0);
+		splineTime = now;
+	}
+	// Set the mode so we are modifying our objects.
+	camera.orientLookVec(eyePosition, lookVector, glm::vec3(0, 1, 0));
+	if (shaderPipeline && !pipeline.isReady() && !pipeline.init()) {
+		shaderPipeline = false;
+	}
+	if (shaderPipeline) {
+		pipeline.setStreaming(streamTransforms);
+		pipeline.beginFrame(camera.getProjectionMatrix(), camera.getModelViewMatrix(), lightDirection);
+	}
+	else {
+		glState.matrixMode(GL_MODELVIEW);
+		glState.loadMatrix(camera.getModelViewMatrix());
+	}
+
+	// all drag events since the last frame result in one position update
+	dragController.update(camera, currentTime(), spherePosition);
+	applyBrushStamps();
+	if (shaderPipeline && virtualTexture.isOpen()) {
+		updateVirtualTexture();
+	}
+	if (pickBufferEnabled) {
+		updatePickBuffer();
+	}
+
+	if (castRay == true) {
+		RayHit hit;
+		int hitObject = -1;
+		if (pickBufferEnabled) {
+			// the buffer holds the sphere and the mesh, not the instances
+			int id = pickObject(mouseX, mouseY, &hit.point);
+			if (id == myObject->id) {
+				hitObject = PICK_PRIMITIVE_SPHERE;
+			}
+			else if (id == MESH_OBJECT_ID) {
+				hitObject = PICK_PRIMITIVE_MESH;
+			}
+		}
+		else {
+			hitObject = pickScene(mouseX, mouseY, hit);
+		}
+
+		if (hitObject == PICK_PRIMITIVE_MESH) {
+			setColor(1, 0, 0);
+			drawMarker(hit.point, 0.02f);
+			printf("mesh hit!\n");
+		}
+		else if (hitObject >= PICK_PRIMITIVE_INSTANCES) {
+			setColor(1, 0, 0);
+			drawHighlight(sphereInstances[hitObject - PICK_PRIMITIVE_INSTANCES]);
+			drawMarker(hit.point, 0.05f);
+			printf("instance %d hit!\n", hitObject - PICK_PRIMITIVE_INSTANCES);
+		}
+		else if (hitObject == PICK_PRIMITIVE_SPHERE) {
+			setColor(1, 0, 0);
+			drawHighlight(spherePosition);
+			drawMarker(hit.point, 0.05f);
+			printf("hit!\n");
+		}
+		else {
+			printf("miss!\n");
+		}
+	}
+	else if (pickBufferEnabled && hoverObject == myObject->id) {
+		setColor(0.5f, 0.5f, 0.5f);
+		drawHighlight(spherePosition);
+	}
+
+	glState.disable(GL_POLYGON_OFFSET_FILL);
+	if (showGrid) {
+		// recorded once, from then on a frame only replays the buffer
+		if (!staticCommands.isRecorded()) {
+			recordAxis(staticCommands);
+			recordGrid(staticCommands);
+			staticCommands.finish();
+		}
+		if (shaderPipeline) {
+			pipeline.useObject(pipeline.addObject(glm::mat4(1.0f)));
+			staticCommands.replay(glState, pipeline);
+		}
+		else {
+			staticCommands.replay(glState);
+		}
+	}
+	setColor(1.0, 1.0, 1.0);
+	if (wireframe) {
+		glState.polygonMode(GL_LINE);
+	}
+	else {
+		glState.polygonMode(GL_FILL);
+	}
+	drawObjects();
+	if (shaderPipeline) {
+		pipeline.endFrame(glState);
+	}
+}
+
+SceneObject* SceneRenderer::instanceObject(int instance) {
+	if (instance < 0 || instanceObjects.empty()) {
+		return myObject;
+	}
+	return instanceObjects[instance % instanceObjects.size()];
+}
+
+void SceneRenderer::drawObjects() {
+	// the sphere is object 0, then the mesh if there is one, then the instances
+	culler.clear();
+	culler.add(spherePosition, myObject->radius, true);
+	int meshIndex = -1;
+	if (meshBuffer.isLoaded()) {
+		// not solid enough to hide anything
+		meshIndex = culler.add(meshPosition, meshRadius, false);
+	}
+	int firstInstance = culler.size();
+	for (size_t i = 0; i < sphereInstances.size(); i++) {
+		culler.add(sphereInstances[i], myObject->radius, true);
+	}
+	culler.cull(camera, frustumCulling, occlusionCulling, visibleObjects, frameArena);
+
+	// the shaders take every object's transform from one upload, or
+	// straight from the stream buffer
+	int firstObject = 0;
+	transformStats.objects = 0;
+	transformStats.seconds = 0;
+	if (shaderPipeline) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < visibleObjects.size(); i++) {
+			int index = visibleObjects[i];
+			glm::mat4 model;
+			if (index == meshIndex) {
+				model = glm::translate(glm::mat4(1.0f), meshPosition);
+			}
+			else {
+				glm::vec3 position = (index == 0) ? spherePosition : sphereInstances[index - firstInstance];
+				model = glm::rotate(glm::translate(glm::mat4(1.0f), position), glm::radians(90.0f), glm::vec3(0, 1, 0));
+			}
+			int object = pipeline.addObject(model);
+			if (i == 0) {
+				firstObject = object;
+			}
+		}
+		pipeline.flushObjects();
+		transformStats.objects = (int)visibleObjects.size();
+		transformStats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	for (size_t i = 0; i < visibleObjects.size(); i++) {
+		int index = visibleObjects[i];
+		if (shaderPipeline) {
+			pipeline.useObject(firstObject + (int)i);
+			if (index == meshIndex) {
+				pipeline.prepareDraw(glState, true, false);
+				meshBuffer.drawAttributes(glState);
+			}
+			else {
+				instanceObject(index - firstInstance)->drawTexturedSphere(glState, pipeline);
+			}
+			continue;
+		}
+		if (index == meshIndex) {
+			glState.pushMatrix();
+				glState.translate(meshPosition[0], meshPosition[1], meshPosition[2]);
+				meshBuffer.draw();
+			glState.popMatrix();
+			continue;
+		}
+		glm::vec3 position = (index == 0) ? spherePosition : sphereInstances[index - firstInstance];
+		glState.pushMatrix();
+			//move the sphere to the designated position
+			glState.translate(position[0], position[1], position[2]);
+			glState.rotate(90, 0, 1, 0);
+			instanceObject(index - firstInstance)->drawTexturedSphere(glState);
+		glState.popMatrix();
+	}
+}
+
+
+void SceneRenderer::updateCamera(int width, int height) {
+	windowWidth = width;
+	windowHeight = height;
+	// the camera's screen is the frame that is rendered
+	int frameWidth = width;
+	int frameHeight = height;
+	if (dynamicResolution) {
+		resolutionScaler.scaledSize(width, height, frameWidth, frameHeight);
+	}
+	if (isDragging() && (frameWidth != camera.getScreenWidth() || frameHeight != camera.getScreenHeight())) {
+		dragController.scaleCursor((float)frameWidth / camera.getScreenWidth(), (float)frameHeight / camera.getScreenHeight());
+	}
+
+	// the projection takes its aspect ratio from the screen size
+	camera.setScreenSize(frameWidth, frameHeight);
+
+	// Determine if we are modifying the camera(GL_PROJECITON) matrix(which is our viewing volume)
+	// Otherwise we could modify the object transormations in our world with GL_MODELVIEW
+	glState.matrixMode(GL_PROJECTION);
+	glm::mat4 projection = camera.getProjectionMatrix();
+	glState.loadMatrix(projection);
+}
+
+
+void SceneRenderer::recordAxis(CommandBuffer& commands) {
+	commands.disable(GL_LIGHTING);
+	commands.begin(GL_LINES);
+		commands.color3f(1.0, 0.0, 0.0);
+		commands.vertex3f(0, 0, 0); commands.vertex3f(1.0, 0, 0);
+		commands.color3f(0.0, 1.0, 0.0);
+		commands.vertex3f(0, 0, 0); commands.vertex3f(0.0, 1.0, 0);
+		commands.color3f(0.0, 0.0, 1.0);
+		commands.vertex3f(0, 0, 0); commands.vertex3f(0, 0, 1.0);
+	commands.end();
+	commands.enable(GL_LIGHTING);
+}
+
+void SceneRenderer::recordGrid(CommandBuffer& commands) {
+	int lines = (int)(2.0f * GRID_SIZE / GRID_SPACING + 0.5f);
+	commands.disable(GL_LIGHTING);
+	commands.begin(GL_LINES);
+		commands.color3f(0.4f, 0.4f, 0.4f);
+		for (int i = 0; i <= lines; i++) {
+			float offset = -GRID_SIZE + i * GRID_SPACING;
+			commands.vertex3f(offset, GRID_HEIGHT, -GRID_SIZE); commands.vertex3f(offset, GRID_HEIGHT, GRID_SIZE);
+			commands.vertex3f(-GRID_SIZE, GRID_HEIGHT, offset); commands.vertex3f(GRID_SIZE, GRID_HEIGHT, offset);
+		}
+	commands.end();
+	commands.enable(GL_LIGHTING);
+}
+
+void SceneRenderer::recordHighlight(CommandBuffer& commands) {
+	static const int edges[12][2] = {
+		{0, 1}, {1, 3}, {3, 2}, {2, 0},
+		{4, 5}, {5, 7}, {7, 6}, {6, 4},
+		{0, 4}, {1, 5}, {2, 6}, {3, 7}
+	};
+	commands.disable(GL_LIGHTING);
+	commands.begin(GL_LINES);
+	for (int i = 0; i < 12; i++) {
+		for (int k = 0; k < 2; k++) {
+			int c = edges[i][k];
+			commands.vertex3f((c & 1) ? 0.5f : -0.5f, (c & 2) ? 0.5f : -0.5f, (c & 4) ? 0.5f : -0.5f);
+		}
+	}
+	commands.end();
+	commands.enable(GL_LIGHTING);
+}
+
+void SceneRenderer::recordMarker(CommandBuffer& commands) {
+	// the 10 by 10 sphere of the fixed function path's drawSolidSphere
+	const int slices = 10;
+	const int stacks = 10;
+	commands.begin(GL_TRIANGLES);
+	for (int i = 0; i < stacks; i++) {
+		for (int j = 0; j < slices; j++) {
+			glm::vec3 corners[4];
+			for (int k = 0; k < 4; k++) {
+				float angleH = PI * (float)(i + (k >> 1)) / stacks - PI / 2.0f;
+				float angle = 2.0f * PI * (float)(j + (k & 1)) / slices;
+				corners[k] = glm::vec3(cos(angleH) * cos(angle), sin(angleH), cos(angleH) * sin(angle));
+			}
+			static const int order[6] = { 0, 2, 1, 1, 2, 3 };
+			for (int k = 0; k < 6; k++) {
+				glm::vec3 c = corners[order[k]];
+				commands.normal3f(c.x, c.y, c.z);
+				commands.vertex3f(c.x, c.y, c.z);
+			}
+		}
+	}
+	commands.end();
+}
+
+void SceneRenderer::setColor(float r, float g, float b) {
+	if (shaderPipeline) {
+		pipeline.setColor(r, g, b);
+	}
+	else {
+		glState.color3f(r, g, b);
+	}
+}
+
+void SceneRenderer::drawHighlight(const glm::vec3& position) {
+	if (!shaderPipeline) {
+		glState.pushMatrix();
+			glState.translate(position[0], position[1], position[2]);
+			drawWireCube(1.0f);
+		glState.popMatrix();
+		return;
+	}
+	if (!highlightCommands.isRecorded()) {
+		recordHighlight(highlightCommands);
+		highlightCommands.finish();
+	}
+	pipeline.useObject(pipeline.addObject(glm::translate(glm::mat4(1.0f), position)));
+	highlightCommands.replay(glState, pipeline);
+}
+
+void SceneRenderer::drawMarker(const glm::vec3& position, float radius) {
+	if (!shaderPipeline) {
+		glState.pushMatrix();
+			glState.translate(position[0], position[1], position[2]);
+			drawSolidSphere(radius, 10, 10);
+		glState.popMatrix();
+		return;
+	}
+	if (!markerCommands.isRecorded()) {
+		recordMarker(markerCommands);
+		markerCommands.finish();
+	}
+	glm::mat4 translation = glm::translate(glm::mat4(1.0f), position);
+	pipeline.useObject(pipeline.addObject(glm::scale(translation, glm::vec3(radius)), translation));
+	markerCommands.replay(glState, pipeline);
+}
@@ -0,0 +1,384 @@
+/*  =================== File Information =================
+	File Name: SceneRenderer.h
+	Description:
+	Author:
+
+	Purpose: Holds the scene (camera, sphere and textures) and draws it
+			 into whatever OpenGL context is current.  MyGLCanvas uses it
+			 inside the FLTK window, the headless mode uses it with an
+			 offscreen context.
+	Usage:
+	===================================================== */
+#ifndef SCENE_RENDERER_H
+#define SCENE_RENDERER_H
+
+#include "GLExt.h"
+#include <vector>
+#include <utility>
+#include <glm/glm.hpp>
+
+#include "SceneObject.h"
+#include "TextureManager.h"
+#include "TextureAtlas.h"
+#include "VirtualTexture.h"
+#include "Camera.h"
+#include "DragController.h"
+#include "Picking.h"
+#include "MeshLoader.h"
+#include "MeshBuffer.h"
+#include "CommandBuffer.h"
+#include "GLStateCache.h"
+#include "ShaderPipeline.h"
+#include "MeshBVH.h"
+#include "Primitives.h"
+#include "PickBuffer.h"
+#include "Culling.h"
+#include "CameraSpline.h"
+#include "FrameArena.h"
+#include "ResolutionScaler.h"
+#include "RenderTarget.h"
+#include "FrameTimer.h"
+
+#define MESH_OBJECT_ID 1	// pick buffer id of the loaded mesh, the sphere uses its own id
+
+// Order of the objects in the list pickScene casts rays against
+#define PICK_PRIMITIVE_SPHERE 0
+#define PICK_PRIMITIVE_MESH 1			// never hit while no mesh is loaded
+#define PICK_PRIMITIVE_INSTANCES 2		// sphere instance i is PICK_PRIMITIVE_INSTANCES + i
+
+#define GRID_SIZE 5.0f		// the grid covers -GRID_SIZE..GRID_SIZE in x and z
+#define GRID_SPACING 0.5f
+#define GRID_HEIGHT -0.5f	// under the sphere
+
+// Object transforms the shader pipeline was given in the last frame and
+// the time writing them took, uploads included
+struct TransformStats {
+	int objects;
+	double seconds;
+};
+
+class SceneRenderer {
+public:
+	glm::vec3 eyePosition;
+	glm::vec3 lookVector;	// direction the camera looks in
+	glm::vec3 rotVec;
+	glm::vec3 lookatPoint;
+
+	int wireframe;
+	int  viewAngle;
+	float clipNear;
+	float clipFar;
+
+	// Used for intersection
+	glm::vec3 spherePosition;
+
+	// Optional .ply/.obj model drawn next to the sphere, loaded by initGL
+	std::string meshFile;
+	glm::vec3 meshPosition;
+
+	// Paint mode: left drags paint into the sphere's blend texture
+	bool paintMode;
+	int brushRadius;		// in texels
+	int brushColor[3];
+	// Strokes into the blend texture can be undone, see PaintHistory.h
+	bool paintHistory;
+
+	// Axis and ground grid, recorded once into staticCommands
+	bool showGrid;
+
+	// Camera path the eye travels along at COASTER_SPEED while
+	// followSpline is set, a loop around the scene by default
+	CameraSpline cameraSpline;
+	bool followSpline;
+
+	// Copies of the textured sphere laid out behind it (setSphereInstances)
+	std::vector<glm::vec3> sphereInstances;
+	bool frustumCulling;
+	bool occlusionCulling;
+
+	// Draw through ShaderPipeline instead of the fixed function lighting
+	// and matrix stacks, switched off again if the context cannot
+	bool shaderPipeline;
+	// Write the shaders' object transforms into a persistently mapped
+	// ring instead of uploading them, see ShaderPipeline::setStreaming
+	bool streamTransforms;
+
+	// Tile file the sphere's blend layer is drawn and painted from in the
+	// shader pipeline, opened (or created, virtualTextureSize texels per
+	// side) by initGL.  Empty for the ordinary blend texture.
+	std::string virtualTextureFile;
+	int virtualTextureSize;
+
+	// Render at the resolution resolutionScaler picks from the frame
+	// times (FrameTimer) into an offscreen target stretched onto the
+	// window, straight into the window at full scale.  Mouse
+	// positions stay in window pixels; the camera's screen, and with it
+	// picking, the pick buffer and the virtual texture feedback, is the
+	// smaller frame.
+	bool dynamicResolution;
+	ResolutionScaler resolutionScaler;
+
+	// Picking through the CPU object id buffer instead of casting rays
+	bool pickBufferEnabled;
+	int hoverObject;		// id under the mouse, PICK_NONE if nothing
+
+	SceneRenderer();
+	~SceneRenderer();
+
+	/*	===============================================
+	Desc:	Loads the textures and sets up lighting and depth state.
+	Precondition:	A GL context is current.  Called again whenever the
+					context is (re)established or the viewport is resized.
+	Postcondition:
+	=============================================== */
+	void initGL(int width, int height);
+	/*	===============================================
+	Desc:	Sets the window size and the projection of the camera, whose
+			screen is the window scaled by the resolution scale
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void updateCamera(int width, int height);
+	/*	===============================================
+	Desc:	Clears the framebuffer and draws one frame.  When castRay is set
+			a ray is cast through pixel (mouseX, mouseY) and the hit is
+			highlighted.  With dynamicResolution the frame is drawn
+			offscreen, stretched onto the window and timed for the
+			resolution scaler.
+	Precondition:	initGL has been called for the current context.
+	Postcondition:
+	=============================================== */
+	void drawFrame(bool castRay, int mouseX, int mouseY);
+
+	/*	===============================================
+	Desc:	Input actions shared by the FLTK canvas and the benchmark
+			replay.  moveEye takes the 'w', 'a', 's' and 'd' keys, zoom the
+			mouse wheel delta.  beginDrag returns true if the ray through
+			(x, y) hits the sphere, which then follows dragTo until endDrag.
+			Drag events are only queued, the sphere is moved once per frame
+			by drawFrame.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void moveEye(int key);
+	void zoom(int dy);
+	bool beginDrag(int x, int y);
+	void dragTo(int x, int y);
+	void endDrag();
+	bool isDragging() { return dragController.isActive(); }
+	/*	===============================================
+	Desc:	Queues a brush stamp where the ray through (x, y) hits the
+			sphere.  The queued stamps are painted and uploaded together
+			at the start of the next frame.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void paintAt(int x, int y);
+	/*	===============================================
+	Desc:	endStroke closes the stroke the stamps since the last call
+			belong to (left button released).  undoPaint and redoPaint
+			step through the strokes.  Like the stamps they are carried
+			out at the start of the next frame, in the order queued.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void endStroke();
+	void undoPaint();
+	void redoPaint();
+	/*	===============================================
+	Desc:	Starts or stops following cameraSpline.  Stopping puts the eye
+			back where it was when following started.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void setFollowSpline(bool follow);
+	/*	===============================================
+	Desc:	Moves the eye along cameraSpline by the distance covered in
+			seconds, so the speed does not depend on the frame rate.
+			drawFrame calls it with the time since the last frame.
+	Precondition:	!cameraSpline.isEmpty()
+	Postcondition:
+	=============================================== */
+	void advanceSpline(double seconds);
+
+	/*	===============================================
+	Desc:	Fills sphereInstances with count spheres in rows of 20 going
+			away from the eye behind the sphere, so a part of them is
+			outside the view and many hide behind the front rows.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void setSphereInstances(int count);
+	/*	===============================================
+	Desc:	Moves every sphere instance up and down on a wave running
+			through the rows, as it is seconds into the animation, so
+			every transform changes from frame to frame.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void animateSphereInstances(double seconds);
+	/*	===============================================
+	Desc:	Gives the sphere instances textures of their own, instance i
+			draws the (i % count)th of the comma separated ppm files.
+			With atlas the images are packed into shared atlas pages
+			first, so the instances bind one texture per page instead of
+			one per image.  Images too large for a page keep a texture of
+			their own.
+	Precondition:
+	Postcondition:	An empty list makes every instance draw myObject again.
+	=============================================== */
+	void setInstanceTextures(std::string fileList, bool atlas);
+	const AtlasStats& getAtlasStats() { return atlas.getStats(); }
+	// Counts of the last frame's culling
+	const CullStats& getCullStats() { return culler.getStats(); }
+	// GL calls issued and skipped by the state cache in the last frame
+	const GLStateStats& getGLStateStats() { return glState.getStats(); }
+	const TransformStats& getTransformStats() { return transformStats; }
+	bool isStreamingTransforms() { return shaderPipeline && pipeline.isStreaming(); }
+	const StreamBufferStats& getStreamStats() { return pipeline.getStreamStats(); }
+	// size of the frame rendered, the window's without dynamic resolution
+	int getFrameWidth() { return camera.getScreenWidth(); }
+	int getFrameHeight() { return camera.getScreenHeight(); }
+
+	/*	===============================================
+	Desc:	Casts a ray through window pixel (x, y) against the sphere.
+			Other objects in front of it hide it.
+	Precondition:
+	Postcondition:	Returns the ray parameter t of the hit, or a value <= 0
+					for a miss.  isectPoint receives the hit point if not NULL.
+	=============================================== */
+	float pick(int x, int y, glm::vec3* isectPoint = NULL);
+	/*	===============================================
+	Desc:	Same as above, but reports the normal and texture coordinate of
+			the hit as well
+	Precondition:
+	Postcondition:	Returns false for a miss.
+	=============================================== */
+	bool pick(int x, int y, RayHit& hit);
+	/*	===============================================
+	Desc:	Casts a ray through window pixel (x, y) against every object of
+			the scene: the sphere, the loaded mesh (through its BVH) and
+			the sphere instances
+	Precondition:
+	Postcondition:	Returns the PICK_PRIMITIVE_ index of the nearest object
+					hit, or -1.  hit is in world space.
+	=============================================== */
+	int pickScene(int x, int y, RayHit& hit);
+	/*	===============================================
+	Desc:	Looks up the object under window pixel (x, y) in the pick buffer.  The
+			buffer is redrawn by drawFrame only when the camera or an
+			object moved, so this is a single array lookup.
+	Precondition:	pickBufferEnabled and a frame has been drawn since.
+	Postcondition:	Returns the object id (myObject->id, MESH_OBJECT_ID) or
+					PICK_NONE.  point receives the world space point if not
+					NULL.
+	=============================================== */
+	int pickObject(int x, int y, glm::vec3* point = NULL);
+
+	glm::vec3 getEyePoint();
+
+	// every change of the shadowed GL state goes through glState
+	GLStateCache glState;
+	TextureManager textureManager;
+	SceneObject* myObject;
+	std::vector<SceneObject*> instanceObjects;	// textured by setInstanceTextures
+	VirtualTexture virtualTexture;
+	TriangleMesh mesh;
+	MeshBVH meshBVH;
+	MeshBuffer meshBuffer;
+	Camera camera;
+	DragController dragController;
+	// per frame scratch memory, reset by drawFrame
+	FrameArena frameArena;
+
+private:
+
+	void drawScene(bool castRay, int mouseX, int mouseY);
+	void applyBrushStamps();
+	/*	===============================================
+	Desc:	Texture coordinate of the sphere under pixel (x, y) of the
+			frame and the virtual texture level the shader reads there,
+			from the rays through the pixel and its right and lower
+			neighbours
+	Precondition:	virtualTexture.isOpen()
+	Postcondition:	Returns false if the ray misses the sphere.
+	=============================================== */
+	bool virtualTexel(float x, float y, glm::vec2& texCoord, int& level);
+	// feedback pass and tile uploads before the sphere is drawn
+	void updateVirtualTexture();
+	void drawObjects();
+	// object drawn for instance i, myObject for the sphere itself (i < 0)
+	SceneObject* instanceObject(int instance);
+	void updatePickBuffer();
+	// window pixel (x, y) in pixels of the frame, fractions included
+	glm::vec2 framePixel(int x, int y);
+	// the sphere hit by the ray through pixel (x, y) of the frame, the
+	// other objects are not tested
+	bool pickSphere(float x, float y, RayHit& hit);
+	// puts the objects where they are now into pickPrimitives
+	void updatePickPrimitives();
+	std::vector<Primitive> pickPrimitives;
+
+	RenderTarget renderTarget;
+	FrameTimer frameTimer;
+	int scaleChanges;		// by resolutionScaler, tags the frames timed
+	int windowWidth;
+	int windowHeight;
+
+	std::vector<std::pair<int, int> > brushStamps;	// pixels queued by paintAt
+	// queued by endStroke, undoPaint and redoPaint, with the number of
+	// stamps queued before them
+	enum PaintAction {
+		PAINT_END_STROKE,
+		PAINT_UNDO,
+		PAINT_REDO
+	};
+	std::vector<std::pair<PaintAction, size_t> > paintActions;
+	void applyBrushStamp(int x, int y);
+	void applyPaintAction(PaintAction action);
+
+	// The mesh only changes with the camera, so it is kept in a layer of
+	// its own and the sphere is drawn onto a copy of it
+	PickBuffer meshPickLayer;
+	PickBuffer pickBuffer;
+	bool pickBufferValid;
+	glm::mat4 pickViewProjection;	// camera the buffer was drawn with
+	int pickScreenWidth;
+	int pickScreenHeight;
+	glm::vec3 pickSpherePosition;
+
+	float splineDistance;		// how far along cameraSpline the eye is
+	double splineTime;			// time of the last advance, 0 before the first
+	glm::vec3 savedEyePosition;	// restored by setFollowSpline(false)
+	glm::vec3 savedLookVector;
+
+	TextureAtlas atlas;
+	std::vector<int> atlasPages;		// texture manager handles of its pages
+
+	SceneCuller culler;
+	std::vector<int> visibleObjects;	// culler indices drawn this frame
+	TransformStats transformStats;
+	float meshRadius;					// bounding sphere of the mesh around meshPosition
+
+	CommandBuffer staticCommands;
+	void recordAxis(CommandBuffer& commands);
+	void recordGrid(CommandBuffer& commands);
+
+	ShaderPipeline pipeline;
+	glm::vec3 lightDirection;			// of GL_LIGHT0 in eye space, for the shaders
+	CommandBuffer highlightCommands;	// unit wire cube
+	CommandBuffer markerCommands;		// unit sphere
+	void recordHighlight(CommandBuffer& commands);
+	void recordMarker(CommandBuffer& commands);
+	/*	===============================================
+	Desc:	The pick highlight and the hit marker, drawn by whichever
+			path is active
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void setColor(float r, float g, float b);
+	void drawHighlight(const glm::vec3& position);
+	void drawMarker(const glm::vec3& position, float radius);
+};
+
+#endif
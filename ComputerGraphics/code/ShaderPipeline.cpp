@@ -0,0 +1,366 @@
+/*  =================== File Information =================
+	File Name: ShaderPipeline.cpp
+	Description:
+	Author:
+
+	Purpose: Core profile shaders and uniform buffers of the scene
+	Usage:
+	===================================================== */
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <glm/gtc/type_ptr.hpp>
+#include "ShaderPipeline.h"
+
+/*	The lit and the unlit program share the sources, LIT switches the
+	Lambert term on.  The fixed function path shades flat, so the color
+	is computed per vertex and taken from the provoking vertex.
+*/
+static const char* vertexSource =
+	"layout(std140) uniform Camera {\n"
+	"	mat4 projection;\n"
+	"	mat4 view;\n"
+	"	vec4 lightDirection;	// eye space, towards the light\n"
+	"	vec4 light;				// ambient, diffuse, scene ambient\n"
+	"};\n"
+	"layout(std140) uniform Object {\n"
+	"	mat4 model;\n"
+	"	mat4 normalModel;		// model without its scale\n"
+	"};\n"
+	"layout(location = 0) in vec3 vertexPosition;\n"
+	"layout(location = 1) in vec3 vertexNormal;\n"
+	"layout(location = 2) in vec2 vertexTexCoord;\n"
+	"layout(location = 3) in vec4 vertexColor;\n"
+	"flat out vec4 shade;\n"
+	"out vec2 texCoord;\n"
+	"void main() {\n"
+	"	mat4 modelView = view * model;\n"
+	"	gl_Position = projection * (modelView * vec4(vertexPosition, 1.0));\n"
+	"#ifdef LIT\n"
+	"	// like the fixed function path the normal is not renormalized\n"
+	"	vec3 normal = mat3(view * normalModel) * vertexNormal;\n"
+	"	float diffuse = max(dot(normal, lightDirection.xyz), 0.0);\n"
+	"	shade = vec4(clamp(vertexColor.rgb * (light.x + light.z + light.y * diffuse), 0.0, 1.0), vertexColor.a);\n"
+	"#else\n"
+	"	shade = vertexColor;\n"
+	"#endif\n"
+	"	texCoord = vertexTexCoord;\n"
+	"}\n";
+
+/*	VIRTUAL reads the image through a virtual texture: the page table
+	entry of the tile and mip level under the fragment names the cache
+	slot to read, see VirtualTexture.h.  The level is chosen like
+	GL_NEAREST_MIPMAP_NEAREST would, the feedback pass does the same.
+*/
+static const char* fragmentSource =
+	"uniform sampler2D image;\n"
+	"uniform bool textured;\n"
+	"flat in vec4 shade;\n"
+	"in vec2 texCoord;\n"
+	"out vec4 fragColor;\n"
+	"#ifdef VIRTUAL\n"
+	"uniform sampler2D pageTable;\n"
+	"uniform vec4 virtualInfo;		// image size, tile size, coarsest level\n"
+	"vec4 virtualTexel(vec2 coord) {\n"
+	"	vec2 texel = coord * virtualInfo.x;\n"
+	"	float footprint = max(length(dFdx(texel)), length(dFdy(texel)));\n"
+	"	int level = int(min(floor(log2(max(footprint, 1.0))), virtualInfo.z));\n"
+	"	vec2 uv = fract(coord);\n"
+	"	ivec2 tile = ivec2(uv * virtualInfo.x / (virtualInfo.y * exp2(float(level))));\n"
+	"	vec4 entry = floor(texelFetch(pageTable, tile, level) * 255.0 + 0.5);\n"
+	"	vec2 levelTexel = uv * virtualInfo.x / exp2(entry.z);\n"
+	"	vec2 inTile = min(levelTexel - floor(levelTexel / virtualInfo.y) * virtualInfo.y, virtualInfo.y - 1.0);\n"
+	"	return texelFetch(image, ivec2(entry.xy * virtualInfo.y + inTile), 0);\n"
+	"}\n"
+	"#endif\n"
+	"void main() {\n"
+	"#ifdef VIRTUAL\n"
+	"	fragColor = shade * virtualTexel(texCoord);\n"
+	"#else\n"
+	"	fragColor = textured ? shade * texture(image, texCoord) : shade;\n"
+	"#endif\n"
+	"}\n";
+
+// std140 layout of the camera block: two matrices and two vectors
+#define CAMERA_BLOCK_FLOATS (16 + 16 + 4 + 4)
+#define OBJECT_BLOCK_BYTES (32 * sizeof(float))
+
+ShaderPipeline::ShaderPipeline() {
+	litProgram = 0;
+	unlitProgram = 0;
+	litVirtualProgram = 0;
+	unlitVirtualProgram = 0;
+	litVirtualInfo = unlitVirtualInfo = -1;
+	virtualTexturing = false;
+	virtualInfo = glm::vec4(0.0f);
+	litTextured = unlitTextured = -1;
+	litTexturedValue = unlitTexturedValue = -1;
+	cameraBuffer = 0;
+	objectBuffer = 0;
+	objectStride = OBJECT_BLOCK_BYTES;
+	objectBufferSize = 0;
+	objectCount = 0;
+	firstUploaded = 0;
+	streamFull = false;
+	objectsUploaded = false;
+	streaming = true;
+	streamMissing = false;
+	lighting = true;
+	texturing = false;
+	color = glm::vec3(1.0f);
+}
+
+ShaderPipeline::~ShaderPipeline() {
+	release();
+}
+
+GLuint ShaderPipeline::compile(GLenum type, const char* defines, const char* source) {
+	GLuint shader = glCreateShader(type);
+	const char* sources[3] = { "#version 330 core\n", defines, source };
+	glShaderSource(shader, 3, sources, NULL);
+	glCompileShader(shader);
+	GLint status = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (status != GL_TRUE) {
+		char log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		std::cout << "shader compilation failed: " << log << std::endl;
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+GLuint ShaderPipeline::link(const char* defines) {
+	GLuint vertexShader = compile(GL_VERTEX_SHADER, defines, vertexSource);
+	GLuint fragmentShader = compile(GL_FRAGMENT_SHADER, defines, fragmentSource);
+	if (vertexShader == 0 || fragmentShader == 0) {
+		if (vertexShader != 0) {
+			glDeleteShader(vertexShader);
+		}
+		if (fragmentShader != 0) {
+			glDeleteShader(fragmentShader);
+		}
+		return 0;
+	}
+	GLuint program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	glLinkProgram(program);
+	// the program keeps them until it is deleted itself
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+	GLint status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE) {
+		char log[1024];
+		glGetProgramInfoLog(program, sizeof(log), NULL, log);
+		std::cout << "shader program link failed: " << log << std::endl;
+		glDeleteProgram(program);
+		return 0;
+	}
+	glUniformBlockBinding(program, glGetUniformBlockIndex(program, "Camera"), CAMERA_BLOCK_BINDING);
+	glUniformBlockBinding(program, glGetUniformBlockIndex(program, "Object"), OBJECT_BLOCK_BINDING);
+	return program;
+}
+
+bool ShaderPipeline::init() {
+	release();
+	const char* version = (const char*)glGetString(GL_SHADING_LANGUAGE_VERSION);
+	if (!hasGLShaderFunctions() || version == NULL || atof(version) < 3.3) {
+		std::cout << "the shader pipeline needs GLSL 3.30, the context has " << (version ? version : "none") << std::endl;
+		return false;
+	}
+	litProgram = link("#define LIT\n");
+	unlitProgram = link("");
+	litVirtualProgram = link("#define LIT\n#define VIRTUAL\n");
+	unlitVirtualProgram = link("#define VIRTUAL\n");
+	if (litProgram == 0 || unlitProgram == 0 || litVirtualProgram == 0 || unlitVirtualProgram == 0) {
+		release();
+		return false;
+	}
+	litTextured = glGetUniformLocation(litProgram, "textured");
+	unlitTextured = glGetUniformLocation(unlitProgram, "textured");
+	litTexturedValue = unlitTexturedValue = -1;
+	litVirtualInfo = glGetUniformLocation(litVirtualProgram, "virtualInfo");
+	unlitVirtualInfo = glGetUniformLocation(unlitVirtualProgram, "virtualInfo");
+	// the samplers never change; program 0 is current again afterwards, as
+	// it is after every endFrame()
+	GLuint virtualPrograms[2] = { litVirtualProgram, unlitVirtualProgram };
+	for (int i = 0; i < 2; i++) {
+		glUseProgram(virtualPrograms[i]);
+		glUniform1i(glGetUniformLocation(virtualPrograms[i], "pageTable"), PAGE_TABLE_UNIT);
+	}
+	glUseProgram(0);
+
+	// blocks bound with glBindBufferRange must start at a multiple of this
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	alignment = alignment > 0 ? alignment : 256;
+	objectStride = (OBJECT_BLOCK_BYTES + alignment - 1) / alignment * alignment;
+
+	glGenBuffers(1, &cameraBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, cameraBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, CAMERA_BLOCK_FLOATS * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+	glGenBuffers(1, &objectBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	objectBufferSize = 0;
+	streamMissing = false;
+	return true;
+}
+
+void ShaderPipeline::release() {
+	if (litProgram != 0) {
+		glDeleteProgram(litProgram);
+	}
+	if (unlitProgram != 0) {
+		glDeleteProgram(unlitProgram);
+	}
+	if (litVirtualProgram != 0) {
+		glDeleteProgram(litVirtualProgram);
+	}
+	if (unlitVirtualProgram != 0) {
+		glDeleteProgram(unlitVirtualProgram);
+	}
+	if (cameraBuffer != 0) {
+		glDeleteBuffers(1, &cameraBuffer);
+	}
+	if (objectBuffer != 0) {
+		glDeleteBuffers(1, &objectBuffer);
+	}
+	objectStream.release();
+	litProgram = unlitProgram = 0;
+	litVirtualProgram = unlitVirtualProgram = 0;
+	cameraBuffer = objectBuffer = 0;
+	objectBufferSize = 0;
+}
+
+void ShaderPipeline::beginFrame(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& lightDirection) {
+	float block[CAMERA_BLOCK_FLOATS];
+	memcpy(block, glm::value_ptr(projection), 16 * sizeof(float));
+	memcpy(block + 16, glm::value_ptr(view), 16 * sizeof(float));
+	glm::vec3 direction = glm::normalize(lightDirection);
+	block[32] = direction.x;
+	block[33] = direction.y;
+	block[34] = direction.z;
+	block[35] = 0.0f;
+	block[36] = SHADER_LIGHT_AMBIENT;
+	block[37] = SHADER_LIGHT_DIFFUSE;
+	block[38] = SHADER_SCENE_AMBIENT;
+	block[39] = 0.0f;
+	glBindBuffer(GL_UNIFORM_BUFFER, cameraBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, cameraBuffer);
+
+	if (streaming && !objectStream.isReady() && !streamMissing) {
+		if (!objectStream.init(GL_UNIFORM_BUFFER, OBJECT_STREAM_BLOCKS * objectStride)) {
+			std::cout << "the context cannot map buffers persistently, object blocks are uploaded every frame" << std::endl;
+			streamMissing = true;
+		}
+	}
+	else if (!streaming && objectStream.isReady()) {
+		objectStream.release();
+	}
+	if (objectStream.isReady()) {
+		objectStream.beginFrame();
+	}
+	objectCount = 0;
+	firstUploaded = 0;
+	streamFull = false;
+	objectsUploaded = false;
+}
+
+void ShaderPipeline::endFrame(GLStateCache& state) {
+	state.useProgram(0);
+	state.bindVertexArray(0);
+	if (objectStream.isReady()) {
+		objectStream.endFrame();
+	}
+}
+
+int ShaderPipeline::addObject(const glm::mat4& model) {
+	return addObject(model, model);
+}
+
+int ShaderPipeline::addObject(const glm::mat4& model, const glm::mat4& normalModel) {
+	unsigned char* block = NULL;
+	if (objectStream.isReady() && !streamFull) {
+		size_t offset = objectCount * objectStride;
+		unsigned char* region = objectStream.reserve(offset + objectStride);
+		if (region != NULL) {
+			block = region + offset;
+		}
+		else {
+			// out of buffer memory, the rest of the frame is uploaded;
+			// the blocks streamed so far stay where they are
+			streamFull = true;
+			firstUploaded = objectCount;
+		}
+	}
+	if (block == NULL) {
+		size_t offset = (objectCount - firstUploaded) * objectStride;
+		if (objects.size() < offset + objectStride) {
+			objects.resize(offset + objectStride);
+		}
+		block = &objects[offset];
+		objectsUploaded = false;
+	}
+	memcpy(block, glm::value_ptr(model), 16 * sizeof(float));
+	memcpy(block + 16 * sizeof(float), glm::value_ptr(normalModel), 16 * sizeof(float));
+	return objectCount++;
+}
+
+void ShaderPipeline::flushObjects() {
+	if (objectsUploaded || (objectStream.isReady() && !streamFull) || objectCount == firstUploaded) {
+		return;
+	}
+	// one upload for all blocks added since the last one, the old
+	// storage is orphaned so draws still reading it do not stall
+	size_t bytes = (objectCount - firstUploaded) * objectStride;
+	glBindBuffer(GL_UNIFORM_BUFFER, objectBuffer);
+	if (bytes > objectBufferSize) {
+		objectBufferSize = bytes * 2;
+	}
+	glBufferData(GL_UNIFORM_BUFFER, objectBufferSize, NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, bytes, &objects[0]);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	objectsUploaded = true;
+}
+
+void ShaderPipeline::useObject(int index) {
+	if (index < 0 || index >= objectCount) {
+		return;
+	}
+	if (objectStream.isReady() && (!streamFull || index < firstUploaded)) {
+		glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BLOCK_BINDING, objectStream.getBuffer(),
+			objectStream.getRegionOffset() + index * objectStride, OBJECT_BLOCK_BYTES);
+		return;
+	}
+	flushObjects();
+	glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BLOCK_BINDING, objectBuffer, (index - firstUploaded) * objectStride, OBJECT_BLOCK_BYTES);
+}
+
+void ShaderPipeline::prepareDraw(GLStateCache& state, bool vertexNormals, bool vertexColors) {
+	if (texturing && virtualTexturing) {
+		state.useProgram(lighting ? litVirtualProgram : unlitVirtualProgram);
+		glUniform4f(lighting ? litVirtualInfo : unlitVirtualInfo, virtualInfo.x, virtualInfo.y, virtualInfo.z, virtualInfo.w);
+	}
+	else {
+		GLuint program = lighting ? litProgram : unlitProgram;
+		GLint location = lighting ? litTextured : unlitTextured;
+		int& value = lighting ? litTexturedValue : unlitTexturedValue;
+		state.useProgram(program);
+		if (value != (int)texturing) {
+			glUniform1i(location, texturing ? 1 : 0);
+			value = texturing ? 1 : 0;
+		}
+	}
+	if (!vertexColors) {
+		glVertexAttrib4f(ATTRIBUTE_COLOR, color.x, color.y, color.z, 1.0f);
+	}
+	if (!vertexNormals) {
+		glVertexAttrib4f(ATTRIBUTE_NORMAL, 0.0f, 0.0f, 1.0f, 1.0f);
+	}
+}
@@ -0,0 +1,189 @@
+/*  =================== File Information =================
+	File Name: ShaderPipeline.h
+	Description:
+	Author:
+
+	Purpose: Draws the scene with GLSL 3.30 core shaders instead of the
+			 fixed function lighting and matrix stacks.  Only core profile
+			 features are used: vertex arrays with generic attributes, two
+			 programs and two uniform buffers, one with the camera and one
+			 with a block per object drawn in the frame.
+			 The object blocks are written straight into a persistently
+			 mapped StreamBuffer where the context has one (GL 4.4 or
+			 GL_ARB_buffer_storage) and setStreaming() is on; otherwise
+			 they are collected in memory and uploaded into orphaned
+			 storage when the first of them is used.
+	Usage:	pipeline.init();						// once per context
+			pipeline.beginFrame(projection, view, light);
+			int object = pipeline.addObject(model);
+			pipeline.useObject(object);
+			pipeline.prepareDraw(state, true, false);
+			glDrawArrays(...);						// bound vertex array
+			pipeline.endFrame(state);
+	===================================================== */
+#ifndef SHADER_PIPELINE_H
+#define SHADER_PIPELINE_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "GLExt.h"
+#include "GLStateCache.h"
+#include "StreamBuffer.h"
+
+// generic vertex attributes, every vertex array uses the same locations
+#define ATTRIBUTE_POSITION 0
+#define ATTRIBUTE_NORMAL 1
+#define ATTRIBUTE_TEXCOORD 2
+#define ATTRIBUTE_COLOR 3
+
+// uniform buffer binding points
+#define CAMERA_BLOCK_BINDING 0
+#define OBJECT_BLOCK_BINDING 1
+
+#define PAGE_TABLE_UNIT 1		// texture unit of a virtual texture's page table
+#define OBJECT_STREAM_BLOCKS 256	// object blocks a stream buffer region starts out with
+
+/*
+	Light values of initGL's GL_LIGHT0, plus the default light model
+	ambient the fixed function path adds to them
+*/
+#define SHADER_LIGHT_AMBIENT 0.7f
+#define SHADER_LIGHT_DIFFUSE 0.5f
+#define SHADER_SCENE_AMBIENT 0.2f
+
+class ShaderPipeline {
+public:
+	ShaderPipeline();
+	/*	===============================================
+	Desc:	Deletes the programs and buffers
+	Precondition:	The GL context of init() is current.
+	Postcondition:
+	=============================================== */
+	~ShaderPipeline();
+
+	/*	===============================================
+	Desc:	Compiles the programs and creates the uniform buffers.
+	Precondition:	A GL context is current.
+	Postcondition:	Returns false, after printing why, if the context
+					cannot run GLSL 3.30 shaders.
+	=============================================== */
+	bool init();
+	void release();
+	bool isReady() { return litProgram != 0; }
+
+	/*	===============================================
+	Desc:	Uploads the camera block and forgets the objects of the last
+			frame.  lightDirection points towards the light in eye space.
+	Precondition:	isReady()
+	Postcondition:
+	=============================================== */
+	void beginFrame(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& lightDirection);
+	/*	===============================================
+	Desc:	Returns to the fixed function path: no program and the default
+			vertex array
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void endFrame(GLStateCache& state);
+
+	/*	===============================================
+	Desc:	Adds the block of an object drawn this frame.  The blocks are
+			uploaded together the first time one of them is used.
+			Normals are transformed by normalModel, which leaves out a
+			scale of model so it does not change the shading, as with the
+			fixed function path where scaled objects have their size in
+			the vertices.
+	Precondition:
+	Postcondition:	Returns the index to pass to useObject().
+	=============================================== */
+	int addObject(const glm::mat4& model);
+	int addObject(const glm::mat4& model, const glm::mat4& normalModel);
+	void useObject(int index);
+	/*	===============================================
+	Desc:	Makes the blocks added so far readable by draws, which
+			useObject() otherwise does when it needs to.  Nothing to do
+			for a stream buffer, whose writes the GPU sees right away,
+			unless it could not grow and the rest of the frame's blocks
+			are uploaded.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void flushObjects();
+
+	/*	===============================================
+	Desc:	Chooses between the stream buffer and uploading the object
+			blocks, from the next beginFrame() on.  On by default; without
+			persistent mapping the blocks are uploaded regardless.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void setStreaming(bool enabled) { streaming = enabled; }
+	bool isStreaming() { return objectStream.isReady(); }
+	const StreamBufferStats& getStreamStats() { return objectStream.getStats(); }
+
+	/*	===============================================
+	Desc:	The fixed function state the shaders stand in for.  Lighting
+			and texturing pick the program and its texture switch, the
+			color is used by draws without a color array.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void setLighting(bool enabled) { lighting = enabled; }
+	void setTexturing(bool enabled) { texturing = enabled; }
+	void setColor(float r, float g, float b) { color = glm::vec3(r, g, b); }
+	/*	===============================================
+	Desc:	Textured draws read a virtual texture while enabled, with the
+			cache bound to GL_TEXTURE_2D and the page table to unit
+			PAGE_TABLE_UNIT.  info is the image size, the tile size and
+			the coarsest level, see VirtualTexture::bind.
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void setVirtualTexture(bool enabled, const glm::vec4& info) { virtualTexturing = enabled; virtualInfo = info; }
+
+	/*	===============================================
+	Desc:	Makes the program for the current lighting and texturing
+			state current.  Attributes the bound vertex array does not
+			provide get constants: the color set above, and a normal
+			facing the eye.
+	Precondition:	A vertex array and an object are bound.
+	Postcondition:
+	=============================================== */
+	void prepareDraw(GLStateCache& state, bool vertexNormals, bool vertexColors);
+
+private:
+	GLuint compile(GLenum type, const char* defines, const char* source);
+	GLuint link(const char* defines);
+
+	GLuint litProgram;			// textured Lambert
+	GLuint unlitProgram;		// lines, wireframe overlays and the pick highlight
+	GLint litTextured;			// location of the texture switch of each program
+	GLint unlitTextured;
+	int litTexturedValue;		// last value set, -1 if unknown
+	int unlitTexturedValue;
+	GLuint litVirtualProgram;	// the two above reading a virtual texture
+	GLuint unlitVirtualProgram;
+	GLint litVirtualInfo;		// location of virtualInfo
+	GLint unlitVirtualInfo;
+
+	GLuint cameraBuffer;
+	GLuint objectBuffer;
+	size_t objectStride;		// block size rounded up to the offset alignment
+	size_t objectBufferSize;
+	std::vector<unsigned char> objects;	// blocks of this frame, when not streaming
+	int objectCount;
+	int firstUploaded;			// object of objects[0], 0 unless the stream buffer is full
+	bool streamFull;			// the stream buffer could not grow this frame
+	bool objectsUploaded;
+	bool streaming;
+	bool streamMissing;			// streaming was asked for and is not available
+	StreamBuffer objectStream;
+
+	bool lighting;
+	bool texturing;
+	glm::vec3 color;
+	bool virtualTexturing;
+	glm::vec4 virtualInfo;
+};
+
+#endif
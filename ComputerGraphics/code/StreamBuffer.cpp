@@ -0,0 +1,144 @@
+/*  =================== File Information =================
+	File Name: StreamBuffer.cpp
+	Description:
+	Author:
+
+	Purpose: Persistently mapped ring of per-frame buffer regions
+	Usage:
+	===================================================== */
+
+#include <iostream>
+#include <chrono>
+#include "StreamBuffer.h"
+
+#define STREAM_BUFFER_FLAGS (GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)
+#define STREAM_BUFFER_WAIT_NS 1000000000	// a wait is retried after this, a second
+
+StreamBuffer::StreamBuffer() {
+	target = GL_UNIFORM_BUFFER;
+	buffer = 0;
+	mapped = NULL;
+	regionBytes = 0;
+	region = 0;
+	for (int i = 0; i < STREAM_BUFFER_REGIONS; i++) {
+		fences[i] = 0;
+	}
+	stats.frames = 0;
+	stats.waits = 0;
+	stats.waitSeconds = 0;
+	stats.grows = 0;
+}
+
+StreamBuffer::~StreamBuffer() {
+	release();
+}
+
+bool StreamBuffer::init(GLenum _target, size_t _regionBytes) {
+	release();
+	if (!hasGLBufferStorage()) {
+		return false;
+	}
+	target = _target;
+	region = 0;
+	return create(_regionBytes);
+}
+
+bool StreamBuffer::create(size_t _regionBytes) {
+	GLuint created = 0;
+	glGenBuffers(1, &created);
+	glBindBuffer(target, created);
+	glBufferStorage(target, _regionBytes * STREAM_BUFFER_REGIONS, NULL, STREAM_BUFFER_FLAGS);
+	unsigned char* pointer = (unsigned char*)glMapBufferRange(target, 0, _regionBytes * STREAM_BUFFER_REGIONS, STREAM_BUFFER_FLAGS);
+	glBindBuffer(target, 0);
+	if (pointer == NULL) {
+		std::cout << "cannot map a " << _regionBytes * STREAM_BUFFER_REGIONS << " byte stream buffer" << std::endl;
+		glDeleteBuffers(1, &created);
+		return false;
+	}
+	if (buffer != 0) {
+		// the region written so far moves along; the GPU sees the
+		// coherent writes to the old buffer before the copy
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, created);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, region * regionBytes, region * _regionBytes, regionBytes);
+		glUnmapBuffer(GL_COPY_READ_BUFFER);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		// still alive for the draws that read it
+		glDeleteBuffers(1, &buffer);
+		// and the regions of the new one have never been used
+		deleteFences();
+	}
+	buffer = created;
+	mapped = pointer;
+	regionBytes = _regionBytes;
+	return true;
+}
+
+void StreamBuffer::deleteFences() {
+	for (int i = 0; i < STREAM_BUFFER_REGIONS; i++) {
+		if (fences[i] != 0) {
+			glDeleteSync(fences[i]);
+			fences[i] = 0;
+		}
+	}
+}
+
+void StreamBuffer::release() {
+	if (buffer != 0) {
+		deleteFences();
+		glBindBuffer(target, buffer);
+		glUnmapBuffer(target);
+		glBindBuffer(target, 0);
+		glDeleteBuffers(1, &buffer);
+	}
+	buffer = 0;
+	mapped = NULL;
+	regionBytes = 0;
+}
+
+void StreamBuffer::beginFrame() {
+	region = (region + 1) % STREAM_BUFFER_REGIONS;
+	stats.frames++;
+	GLsync fence = fences[region];
+	if (fence == 0) {
+		return;
+	}
+	fences[region] = 0;
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED) {
+		typedef std::chrono::steady_clock Clock;
+		Clock::time_point start = Clock::now();
+		stats.waits++;
+		// the fence may still sit in an unflushed command buffer
+		do {
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_BUFFER_WAIT_NS);
+		} while (status == GL_TIMEOUT_EXPIRED);
+		stats.waitSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+	}
+	glDeleteSync(fence);
+}
+
+unsigned char* StreamBuffer::reserve(size_t bytes) {
+	if (bytes > regionBytes) {
+		size_t larger = regionBytes;
+		while (larger < bytes) {
+			larger *= 2;
+		}
+		if (create(larger)) {
+			stats.grows++;
+		}
+		else {
+			return NULL;
+		}
+	}
+	return mapped + region * regionBytes;
+}
+
+void StreamBuffer::endFrame() {
+	if (fences[region] != 0) {
+		// endFrame() twice in a frame, the later fence covers both
+		glDeleteSync(fences[region]);
+	}
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,112 @@
+/*  =================== File Information =================
+	File Name: StreamBuffer.h
+	Description:
+	Author:
+
+	Purpose: A GL buffer for data written anew every frame, such as the
+			 per-object transforms of the shader pipeline.  The buffer is
+			 split into STREAM_BUFFER_REGIONS regions, one per frame in
+			 flight, and stays mapped for its whole life
+			 (glBufferStorage with persistent, coherent mapping), so the
+			 CPU writes straight into the memory the GPU reads.
+			 A fence is placed after the draws of each frame; a region
+			 is only written again once the fence of the frame that last
+			 used it has signaled, which with three regions normally
+			 happened long before.  Neither writing nor drawing waits for
+			 the other otherwise, unlike glBufferSubData into a buffer
+			 that is still being read.
+
+			 A frame that needs more than a region holds moves to a
+			 buffer with regions twice as large.  What the frame wrote
+			 so far is copied over by the GPU, the old buffer is deleted
+			 and GL keeps it until the draws reading it are done.
+	Usage:	if (stream.init(GL_UNIFORM_BUFFER, 64 * 1024)) {
+				// every frame
+				stream.beginFrame();
+				unsigned char* region = stream.reserve(bytes);
+				memcpy(region, data, bytes);
+				glBindBufferRange(GL_UNIFORM_BUFFER, 1, stream.getBuffer(), stream.getRegionOffset(), bytes);
+				// draw
+				stream.endFrame();
+			}
+	===================================================== */
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include "GLExt.h"
+
+#define STREAM_BUFFER_REGIONS 3		// frames the CPU may be ahead of the GPU
+
+struct StreamBufferStats {
+	int frames;				// regions written
+	int waits;				// frames that found their region still in use
+	double waitSeconds;		// spent in those waits
+	int grows;				// moves to larger regions
+};
+
+class StreamBuffer {
+public:
+	StreamBuffer();
+	/*	===============================================
+	Desc:	Deletes the buffer and the fences
+	Precondition:	The GL context of init() is current.
+	Postcondition:
+	=============================================== */
+	~StreamBuffer();
+
+	/*	===============================================
+	Desc:	Creates and maps a buffer of STREAM_BUFFER_REGIONS regions of
+			regionBytes each, for the given target.
+	Precondition:	A GL context is current.  regionBytes is a multiple
+					of the offset alignment of the target, e.g.
+					GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+	Postcondition:	Returns false if the context cannot map a buffer
+					persistently.
+	=============================================== */
+	bool init(GLenum target, size_t regionBytes);
+	void release();
+	bool isReady() { return buffer != 0; }
+
+	/*	===============================================
+	Desc:	Moves on to the next region, waiting for the GPU if it has not
+			finished the frame that used it last
+	Precondition:	isReady()
+	Postcondition:
+	=============================================== */
+	void beginFrame();
+	/*	===============================================
+	Desc:	Makes the region of this frame hold at least bytes and returns
+			where it starts.  Bytes written before stay, also when the
+			region grows, but the returned pointer and getBuffer() change
+			then.
+	Precondition:	Between beginFrame() and endFrame()
+	Postcondition:	Returns NULL if a larger buffer cannot be created.
+	=============================================== */
+	unsigned char* reserve(size_t bytes);
+	/*	===============================================
+	Desc:	Places the fence guarding the region of this frame
+	Precondition:	The draws reading the region have been issued.
+	Postcondition:
+	=============================================== */
+	void endFrame();
+
+	GLuint getBuffer() { return buffer; }
+	// offset of this frame's region in getBuffer()
+	size_t getRegionOffset() { return region * regionBytes; }
+	size_t getRegionBytes() { return regionBytes; }
+	const StreamBufferStats& getStats() { return stats; }
+
+private:
+	bool create(size_t regionBytes);
+	void deleteFences();
+
+	GLenum target;
+	GLuint buffer;
+	unsigned char* mapped;		// all regions, mapped until release()
+	size_t regionBytes;
+	int region;					// of the current frame
+	GLsync fences[STREAM_BUFFER_REGIONS];	// after the last frame of each region, 0 if none
+	StreamBufferStats stats;
+};
+
+#endif
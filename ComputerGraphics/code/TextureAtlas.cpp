@@ -0,0 +1,242 @@
+/*  =================== File Information =================
+	File Name: TextureAtlas.cpp
+	Description:
+	Author:
+
+	Purpose: Skyline packing of images into atlas pages
+	Usage:
+	===================================================== */
+
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include "TextureAtlas.h"
+
+TextureAtlas::TextureAtlas(int _pageSize, int _mipLevels) {
+	pageSize = _pageSize;
+	mipLevels = std::max(_mipLevels, 0);
+	stats.images = 0;
+	stats.pages = 0;
+	stats.imageTexels = 0;
+	stats.pageTexels = 0;
+	stats.efficiency = 0;
+	stats.packSeconds = 0;
+}
+
+TextureAtlas::~TextureAtlas() {
+	clear();
+}
+
+int TextureAtlas::add(ppm* image) {
+	AtlasRegion region;
+	region.page = -1;
+	region.x = region.y = 0;
+	region.width = image->getWidth();
+	region.height = image->getHeight();
+	region.uvOffset = glm::vec2(0.0f);
+	region.uvScale = glm::vec2(1.0f);
+	images.push_back(image);
+	regions.push_back(region);
+	return (int)regions.size() - 1;
+}
+
+void TextureAtlas::clear() {
+	for (size_t i = 0; i < pages.size(); i++) {
+		delete pages[i];
+	}
+	pages.clear();
+	images.clear();
+	regions.clear();
+	stats.images = 0;
+	stats.pages = 0;
+	stats.imageTexels = 0;
+	stats.pageTexels = 0;
+	stats.efficiency = 0;
+	stats.packSeconds = 0;
+}
+
+ppm* TextureAtlas::takePage(int page) {
+	ppm* image = pages[page];
+	pages[page] = NULL;
+	return image;
+}
+
+int TextureAtlas::fitSlot(const Page& page, size_t node, int width, int height) {
+	int x = page.skyline[node].x;
+	if (x + width > pageSize) {
+		return -1;
+	}
+	// the slot rests on the highest node it spans
+	int y = 0;
+	int remaining = width;
+	for (size_t i = node; remaining > 0; i++) {
+		y = std::max(y, page.skyline[i].y);
+		if (y + height > pageSize) {
+			return -1;
+		}
+		remaining -= page.skyline[i].width;
+	}
+	return y;
+}
+
+/*	Bottom-left rule: the position with the lowest top edge wins, ties
+	go to the narrower node so wide gaps stay open for wide images.
+*/
+bool TextureAtlas::placeSlot(Page& page, int width, int height, int& x, int& y) {
+	int bestNode = -1;
+	int bestTop = 0;
+	int bestWidth = 0;
+	for (size_t i = 0; i < page.skyline.size(); i++) {
+		int top = fitSlot(page, i, width, height);
+		if (top < 0) {
+			continue;
+		}
+		top += height;
+		if (bestNode < 0 || top < bestTop || (top == bestTop && page.skyline[i].width < bestWidth)) {
+			bestNode = (int)i;
+			bestTop = top;
+			bestWidth = page.skyline[i].width;
+		}
+	}
+	if (bestNode < 0) {
+		return false;
+	}
+	x = page.skyline[bestNode].x;
+	y = bestTop - height;
+	addSkylineLevel(page, bestNode, x, y, width, height);
+	return true;
+}
+
+void TextureAtlas::addSkylineLevel(Page& page, size_t node, int x, int y, int width, int height) {
+	SkylineNode level = { x, y + height, width };
+	std::vector<SkylineNode>& skyline = page.skyline;
+	skyline.insert(skyline.begin() + node, level);
+
+	// cut the nodes the new level now covers
+	for (size_t i = node + 1; i < skyline.size();) {
+		int end = skyline[i - 1].x + skyline[i - 1].width;
+		if (skyline[i].x >= end) {
+			break;
+		}
+		int overlap = end - skyline[i].x;
+		skyline[i].x += overlap;
+		skyline[i].width -= overlap;
+		if (skyline[i].width > 0) {
+			break;
+		}
+		skyline.erase(skyline.begin() + i);
+	}
+	// and join neighbours at the same height
+	for (size_t i = 0; i + 1 < skyline.size();) {
+		if (skyline[i].y == skyline[i + 1].y) {
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+		}
+		else {
+			i++;
+		}
+	}
+	page.usedHeight = std::max(page.usedHeight, y + height);
+}
+
+/*	Fills the whole slot: the image at the padding offset and every
+	texel around it with the nearest edge texel of the image.
+*/
+void TextureAtlas::copyImage(ppm* image, ppm* page, int slotX, int slotY, int slotWidth, int slotHeight) {
+	int width = image->getWidth();
+	int height = image->getHeight();
+	int pad = padding();
+	const char* source = image->getPixels();
+	char* target = page->getPixels();
+	size_t pageRow = (size_t)page->getWidth() * 3;
+	for (int sy = 0; sy < slotHeight; sy++) {
+		int y = std::min(std::max(sy - pad, 0), height - 1);
+		const char* sourceRow = source + (size_t)y * width * 3;
+		char* targetRow = target + (size_t)(slotY + sy) * pageRow + (size_t)slotX * 3;
+		for (int sx = 0; sx < pad; sx++) {
+			memcpy(targetRow + sx * 3, sourceRow, 3);
+		}
+		memcpy(targetRow + pad * 3, sourceRow, (size_t)width * 3);
+		for (int sx = pad + width; sx < slotWidth; sx++) {
+			memcpy(targetRow + sx * 3, sourceRow + (width - 1) * 3, 3);
+		}
+	}
+}
+
+void TextureAtlas::build() {
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point start = Clock::now();
+	if (images.empty()) {
+		return;
+	}
+	int pad = padding();
+	int firstImage = (int)regions.size() - (int)images.size();
+
+	// tallest first keeps the skyline flat
+	std::vector<int> order(images.size());
+	for (size_t i = 0; i < order.size(); i++) {
+		order[i] = (int)i;
+	}
+	std::sort(order.begin(), order.end(), [this](int a, int b) {
+		if (images[a]->getHeight() != images[b]->getHeight()) {
+			return images[a]->getHeight() > images[b]->getHeight();
+		}
+		return images[a]->getWidth() > images[b]->getWidth();
+	});
+
+	std::vector<Page> newPages;
+	std::vector<int> slotX(images.size());
+	std::vector<int> slotY(images.size());
+	std::vector<int> slotPage(images.size(), -1);
+	for (size_t k = 0; k < order.size(); k++) {
+		int i = order[k];
+		int width = align(images[i]->getWidth() + 2 * pad);
+		int height = align(images[i]->getHeight() + 2 * pad);
+		if (width > pageSize || height > pageSize) {
+			continue;
+		}
+		for (size_t p = 0; p < newPages.size() && slotPage[i] < 0; p++) {
+			if (placeSlot(newPages[p], width, height, slotX[i], slotY[i])) {
+				slotPage[i] = (int)p;
+			}
+		}
+		if (slotPage[i] < 0) {
+			Page page;
+			SkylineNode ground = { 0, 0, pageSize };
+			page.skyline.push_back(ground);
+			page.usedHeight = 0;
+			newPages.push_back(page);
+			placeSlot(newPages.back(), width, height, slotX[i], slotY[i]);
+			slotPage[i] = (int)newPages.size() - 1;
+		}
+	}
+
+	int firstPage = (int)pages.size();
+	for (size_t p = 0; p < newPages.size(); p++) {
+		ppm* page = new ppm(pageSize, align(newPages[p].usedHeight));
+		pages.push_back(page);
+		stats.pageTexels += (size_t)page->getWidth() * page->getHeight();
+	}
+	for (size_t i = 0; i < images.size(); i++) {
+		if (slotPage[i] < 0) {
+			continue;
+		}
+		ppm* image = images[i];
+		ppm* page = pages[firstPage + slotPage[i]];
+		copyImage(image, page, slotX[i], slotY[i], align(image->getWidth() + 2 * pad), align(image->getHeight() + 2 * pad));
+
+		AtlasRegion& region = regions[firstImage + i];
+		region.page = firstPage + slotPage[i];
+		region.x = slotX[i] + pad;
+		region.y = slotY[i] + pad;
+		region.uvOffset = glm::vec2((float)region.x / page->getWidth(), (float)region.y / page->getHeight());
+		region.uvScale = glm::vec2((float)region.width / page->getWidth(), (float)region.height / page->getHeight());
+		stats.images++;
+		stats.imageTexels += (size_t)region.width * region.height;
+	}
+	images.clear();
+
+	stats.pages = (int)pages.size();
+	stats.efficiency = stats.pageTexels > 0 ? (double)stats.imageTexels / stats.pageTexels : 0.0;
+	stats.packSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+}
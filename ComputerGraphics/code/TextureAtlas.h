@@ -0,0 +1,125 @@
+/*  =================== File Information =================
+	File Name: TextureAtlas.h
+	Description:
+	Author:
+
+	Purpose: Packs many small images into a few large atlas pages, so
+			 objects with different textures can be drawn without
+			 binding a texture in between.  The images are placed with
+			 a skyline bottom-left packer, tallest first, and a new page
+			 is opened when one is full.
+
+			 Every image is surrounded by a gutter of its own edge texels
+			 and starts on a multiple of 2^mipLevels texels.  Down to mip
+			 level mipLevels a texel then never mixes two images and each
+			 image keeps at least one gutter texel, so filtering or
+			 mipmapping the pages does not bleed the neighbours in.  The
+			 alignment of 4 also keeps BC1/BC7 blocks inside one image.
+	Usage:	TextureAtlas atlas;
+			atlas.add(image);	// for every image, they are copied by build()
+			atlas.build();
+			const AtlasRegion& region = atlas.getRegion(0);
+			// texture coordinate (s, t) of the image becomes
+			//	region.uvOffset + (s, t) * region.uvScale on page region.page
+	===================================================== */
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "ppm.h"
+
+#define ATLAS_PAGE_SIZE 1024	// width and largest height of a page, in texels
+#define ATLAS_MIP_LEVELS 2		// mip levels the gutters stay intact down to
+
+/*
+	Where an image ended up.  Images larger than a page are not packed,
+	their page is -1.
+*/
+struct AtlasRegion {
+	int page;
+	int x;			// first texel of the image on the page, without the gutter
+	int y;
+	int width;
+	int height;
+	glm::vec2 uvOffset;
+	glm::vec2 uvScale;
+};
+
+struct AtlasStats {
+	int images;				// packed, the ones too large are not counted
+	int pages;
+	size_t imageTexels;		// covered by the images themselves
+	size_t pageTexels;		// of all pages, the last rows of each are trimmed
+	double efficiency;		// imageTexels / pageTexels
+	double packSeconds;		// placing and copying
+};
+
+class TextureAtlas {
+public:
+	TextureAtlas(int _pageSize = ATLAS_PAGE_SIZE, int _mipLevels = ATLAS_MIP_LEVELS);
+	~TextureAtlas();
+
+	/*	===============================================
+	Desc:	Queues an image for the next build() and returns its index
+	Precondition:	image stays valid until build() returned
+	Postcondition:
+	=============================================== */
+	int add(ppm* image);
+	/*	===============================================
+	Desc:	Places the queued images and copies them, with their gutters,
+			into new pages.  The pages are only as high as their lowest
+			image needs (rounded up to the alignment).
+	Precondition:
+	Postcondition:	Every queued image has a region, the queue is empty.
+	=============================================== */
+	void build();
+	/*	===============================================
+	Desc:	Forgets the images and deletes the pages still owned
+	Precondition:
+	Postcondition:
+	=============================================== */
+	void clear();
+
+	int getPageCount() { return (int)pages.size(); }
+	ppm* getPage(int page) { return pages[page]; }
+	/*	===============================================
+	Desc:	Hands a page over to the caller, e.g. to
+			TextureManager::add, which deletes it from then on
+	Precondition:
+	Postcondition:	getPage(page) returns NULL.
+	=============================================== */
+	ppm* takePage(int page);
+	int getImageCount() { return (int)regions.size(); }
+	const AtlasRegion& getRegion(int image) { return regions[image]; }
+	const AtlasStats& getStats() { return stats; }
+
+private:
+	// top edge of the used area over [x, x + width)
+	struct SkylineNode {
+		int x;
+		int y;
+		int width;
+	};
+	struct Page {
+		std::vector<SkylineNode> skyline;
+		int usedHeight;
+	};
+
+	int padding() { return 1 << mipLevels; }
+	int align(int value) { return (value + padding() - 1) / padding() * padding(); }
+	// lowest y a width x height slot fits at starting over node, -1 if it does not
+	int fitSlot(const Page& page, size_t node, int width, int height);
+	bool placeSlot(Page& page, int width, int height, int& x, int& y);
+	void addSkylineLevel(Page& page, size_t node, int x, int y, int width, int height);
+	void copyImage(ppm* image, ppm* page, int slotX, int slotY, int slotWidth, int slotHeight);
+
+	int pageSize;
+	int mipLevels;
+	std::vector<ppm*> images;			// queued by add()
+	std::vector<AtlasRegion> regions;	// of the images, by index
+	std::vector<ppm*> pages;
+	AtlasStats stats;
+};
+
+#endif
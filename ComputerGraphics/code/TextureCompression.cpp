@@ -0,0 +1,688 @@
+/*  =================== File Information =================
+	File Name: TextureCompression.cpp
+	Description:
+	Author:
+
+	Purpose: BC1 and BC7 block encoding, decoding and the disk cache
+	Usage:
+	===================================================== */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cfloat>
+#include <cstdint>
+#include <algorithm>
+#include <thread>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glm/glm.hpp>
+#include "TextureCompression.h"
+#ifdef COMPRESSION_SSE
+#include <emmintrin.h>
+#endif
+
+#define COMPRESSION_REFINE_PASSES 2		// least squares fits after the principal axis one
+#define POWER_ITERATIONS 8
+#define CACHE_VERSION 1
+
+// the 16 texels of a block, one array per channel for the SSE search
+struct BlockTexels {
+	alignas(16) float r[16];
+	alignas(16) float g[16];
+	alignas(16) float b[16];
+};
+
+// the colors an index can select, as the decoder computes them
+struct BlockPalette {
+	float r[16];
+	float g[16];
+	float b[16];
+	int count;
+};
+
+// BC7 interpolation weights of a 4 bit index, out of 64 and as the share of the second end point
+static const int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+static const float bc7Shares[16] = { 0 / 64.0f, 4 / 64.0f, 9 / 64.0f, 13 / 64.0f, 17 / 64.0f, 21 / 64.0f,
+	26 / 64.0f, 30 / 64.0f, 34 / 64.0f, 38 / 64.0f, 43 / 64.0f, 47 / 64.0f, 51 / 64.0f, 55 / 64.0f, 60 / 64.0f, 1.0f };
+// BC1 share of the second end point for each index of the four color mode
+static const float bc1Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+struct CacheHeader {
+	char magic[4];			// "CGTC"
+	int version;
+	int format;
+	int width;
+	int height;
+	long long sourceSize;
+	long long sourceTime;
+};
+
+const char* compressionName(TextureCompression format) {
+	switch (format) {
+	case COMPRESSION_BC1:
+		return "bc1";
+	case COMPRESSION_BC7:
+		return "bc7";
+	default:
+		return "none";
+	}
+}
+
+bool parseCompressionName(std::string name, TextureCompression& format) {
+	if (name == "none") {
+		format = COMPRESSION_NONE;
+	}
+	else if (name == "bc1") {
+		format = COMPRESSION_BC1;
+	}
+	else if (name == "bc7") {
+		format = COMPRESSION_BC7;
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+int compressionBlockBytes(TextureCompression format) {
+	return format == COMPRESSION_BC7 ? BC7_BLOCK_BYTES : BC1_BLOCK_BYTES;
+}
+
+size_t compressedSize(TextureCompression format, int width, int height) {
+	if (format == COMPRESSION_NONE) {
+		return (size_t)width * height * 3;
+	}
+	size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+	return blocks * compressionBlockBytes(format);
+}
+
+static float clampColor(float value) {
+	return std::min(std::max(value, 0.0f), 255.0f);
+}
+
+static glm::vec3 clampColor(const glm::vec3& color) {
+	return glm::vec3(clampColor(color.x), clampColor(color.y), clampColor(color.z));
+}
+
+static void loadBlock(const unsigned char* rgb, int width, int height, int blockX, int blockY, BlockTexels& texels) {
+	for (int y = 0; y < 4; y++) {
+		int sy = std::min(blockY * 4 + y, height - 1);
+		for (int x = 0; x < 4; x++) {
+			int sx = std::min(blockX * 4 + x, width - 1);
+			const unsigned char* p = rgb + ((size_t)sy * width + sx) * 3;
+			texels.r[y * 4 + x] = p[0];
+			texels.g[y * 4 + x] = p[1];
+			texels.b[y * 4 + x] = p[2];
+		}
+	}
+}
+
+/*	Picks the closest palette entry of every texel and returns the
+	summed squared error.  Ties go to the lower index either way.
+*/
+static float closestIndices(const BlockTexels& texels, const BlockPalette& palette, int indices[16]) {
+	float total = 0.0f;
+#ifdef COMPRESSION_SSE
+	for (int i = 0; i < 16; i += 4) {
+		__m128 r = _mm_load_ps(texels.r + i);
+		__m128 g = _mm_load_ps(texels.g + i);
+		__m128 b = _mm_load_ps(texels.b + i);
+		__m128 best = _mm_set1_ps(FLT_MAX);
+		__m128i bestIndex = _mm_setzero_si128();
+		for (int k = 0; k < palette.count; k++) {
+			__m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette.r[k]));
+			__m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette.g[k]));
+			__m128 db = _mm_sub_ps(b, _mm_set1_ps(palette.b[k]));
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+			__m128i closer = _mm_castps_si128(_mm_cmplt_ps(d, best));
+			best = _mm_min_ps(d, best);
+			bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(k)), _mm_andnot_si128(closer, bestIndex));
+		}
+		_mm_storeu_si128((__m128i*)(indices + i), bestIndex);
+		alignas(16) float errors[4];
+		_mm_store_ps(errors, best);
+		total += errors[0] + errors[1] + errors[2] + errors[3];
+	}
+#else
+	for (int i = 0; i < 16; i++) {
+		float best = FLT_MAX;
+		int bestIndex = 0;
+		for (int k = 0; k < palette.count; k++) {
+			float dr = texels.r[i] - palette.r[k];
+			float dg = texels.g[i] - palette.g[k];
+			float db = texels.b[i] - palette.b[k];
+			float d = dr * dr + dg * dg + db * db;
+			if (d < best) {
+				best = d;
+				bestIndex = k;
+			}
+		}
+		indices[i] = bestIndex;
+		total += best;
+	}
+#endif
+	return total;
+}
+
+/*	End points on the principal axis of the block colors, at the
+	extreme projections of the texels.  A block of one color gives two
+	equal end points.  Plain loops over the channel arrays, the
+	compiler vectorizes them.
+*/
+static void fitEndpoints(const BlockTexels& texels, glm::vec3& e0, glm::vec3& e1) {
+	float mr = 0.0f;
+	float mg = 0.0f;
+	float mb = 0.0f;
+	for (int i = 0; i < 16; i++) {
+		mr += texels.r[i];
+		mg += texels.g[i];
+		mb += texels.b[i];
+	}
+	mr /= 16.0f;
+	mg /= 16.0f;
+	mb /= 16.0f;
+	// covariance rr, rg, rb, gg, gb, bb
+	float c[6] = { 0, 0, 0, 0, 0, 0 };
+	for (int i = 0; i < 16; i++) {
+		float dr = texels.r[i] - mr;
+		float dg = texels.g[i] - mg;
+		float db = texels.b[i] - mb;
+		c[0] += dr * dr;
+		c[1] += dr * dg;
+		c[2] += dr * db;
+		c[3] += dg * dg;
+		c[4] += dg * db;
+		c[5] += db * db;
+	}
+	glm::vec3 mean(mr, mg, mb);
+	if (c[0] + c[3] + c[5] < 1e-3f) {
+		e0 = e1 = mean;
+		return;
+	}
+	// power iteration, starting from the channel of largest variance
+	float ax = c[0];
+	float ay = c[1];
+	float az = c[2];
+	if (c[3] > c[0] && c[3] >= c[5]) {
+		ax = c[1];
+		ay = c[3];
+		az = c[4];
+	}
+	else if (c[5] > c[0] && c[5] > c[3]) {
+		ax = c[2];
+		ay = c[4];
+		az = c[5];
+	}
+	for (int k = 0; k < POWER_ITERATIONS; k++) {
+		float x = c[0] * ax + c[1] * ay + c[2] * az;
+		float y = c[1] * ax + c[3] * ay + c[4] * az;
+		float z = c[2] * ax + c[4] * ay + c[5] * az;
+		float scale = std::max(fabs(x), std::max(fabs(y), fabs(z)));
+		if (scale < 1e-6f) {
+			break;
+		}
+		ax = x / scale;
+		ay = y / scale;
+		az = z / scale;
+	}
+	float length = sqrt(ax * ax + ay * ay + az * az);
+	if (length < 1e-6f) {
+		e0 = e1 = mean;
+		return;
+	}
+	ax /= length;
+	ay /= length;
+	az /= length;
+	float minT = FLT_MAX;
+	float maxT = -FLT_MAX;
+	for (int i = 0; i < 16; i++) {
+		float t = (texels.r[i] - mr) * ax + (texels.g[i] - mg) * ay + (texels.b[i] - mb) * az;
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+	glm::vec3 axis(ax, ay, az);
+	e0 = clampColor(mean + axis * maxT);
+	e1 = clampColor(mean + axis * minT);
+}
+
+/*	The end points that minimize the squared error of the texels for
+	fixed indices, weights[k] being the share of e1 in palette entry k.
+	Returns false if all texels use the same share.
+*/
+static bool refineEndpoints(const BlockTexels& texels, const int indices[16], const float* weights, glm::vec3& e0, glm::vec3& e1) {
+	float aa = 0.0f;
+	float ab = 0.0f;
+	float bb = 0.0f;
+	float ax[3] = { 0, 0, 0 };	// texels weighted by the share of e0
+	float bx[3] = { 0, 0, 0 };	// and of e1
+	for (int i = 0; i < 16; i++) {
+		float b = weights[indices[i]];
+		float a = 1.0f - b;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		ax[0] += a * texels.r[i];
+		ax[1] += a * texels.g[i];
+		ax[2] += a * texels.b[i];
+		bx[0] += b * texels.r[i];
+		bx[1] += b * texels.g[i];
+		bx[2] += b * texels.b[i];
+	}
+	float det = aa * bb - ab * ab;
+	if (fabs(det) < 1e-6f) {
+		return false;
+	}
+	float inverse = 1.0f / det;
+	e0 = clampColor(glm::vec3(ax[0] * bb - bx[0] * ab, ax[1] * bb - bx[1] * ab, ax[2] * bb - bx[2] * ab) * inverse);
+	e1 = clampColor(glm::vec3(bx[0] * aa - ax[0] * ab, bx[1] * aa - ax[1] * ab, bx[2] * aa - ax[2] * ab) * inverse);
+	return true;
+}
+
+static unsigned short packRGB565(const glm::vec3& c) {
+	int r = (int)(c.x * 31.0f / 255.0f + 0.5f);
+	int g = (int)(c.y * 63.0f / 255.0f + 0.5f);
+	int b = (int)(c.z * 31.0f / 255.0f + 0.5f);
+	return (unsigned short)((r << 11) | (g << 5) | b);
+}
+
+static void unpackRGB565(unsigned short c, int rgb[3]) {
+	int r = (c >> 11) & 31;
+	int g = (c >> 5) & 63;
+	int b = c & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+static void bc1Palette(unsigned short c0, unsigned short c1, int palette[4][3]) {
+	unpackRGB565(c0, palette[0]);
+	unpackRGB565(c1, palette[1]);
+	for (int k = 0; k < 3; k++) {
+		if (c0 > c1) {
+			palette[2][k] = (2 * palette[0][k] + palette[1][k]) / 3;
+			palette[3][k] = (palette[0][k] + 2 * palette[1][k]) / 3;
+		}
+		else {
+			// three colors and black, the encoder only uses it for single color blocks
+			palette[2][k] = (palette[0][k] + palette[1][k]) / 2;
+			palette[3][k] = 0;
+		}
+	}
+}
+
+static void encodeBC1Block(const BlockTexels& texels, unsigned char* block) {
+	glm::vec3 e0;
+	glm::vec3 e1;
+	fitEndpoints(texels, e0, e1);
+	float bestError = FLT_MAX;
+	unsigned short best0 = 0;
+	unsigned short best1 = 0;
+	int bestIndices[16] = { 0 };
+	for (int pass = 0; pass <= COMPRESSION_REFINE_PASSES; pass++) {
+		unsigned short c0 = packRGB565(e0);
+		unsigned short c1 = packRGB565(e1);
+		// the four color mode needs c0 > c1, swapping the end points swaps the palette
+		if (c0 < c1) {
+			std::swap(c0, c1);
+			std::swap(e0, e1);
+		}
+		int colors[4][3];
+		bc1Palette(c0, c1, colors);
+		BlockPalette palette;
+		palette.count = (c0 == c1) ? 1 : 4;
+		for (int k = 0; k < palette.count; k++) {
+			palette.r[k] = (float)colors[k][0];
+			palette.g[k] = (float)colors[k][1];
+			palette.b[k] = (float)colors[k][2];
+		}
+		int indices[16];
+		float error = closestIndices(texels, palette, indices);
+		if (error < bestError) {
+			bestError = error;
+			best0 = c0;
+			best1 = c1;
+			memcpy(bestIndices, indices, sizeof(indices));
+		}
+		if (palette.count == 1 || error == 0.0f || !refineEndpoints(texels, indices, bc1Weights, e0, e1)) {
+			break;
+		}
+	}
+
+	unsigned int bits = 0;
+	for (int i = 0; i < 16; i++) {
+		bits |= (unsigned int)bestIndices[i] << (2 * i);
+	}
+	block[0] = (unsigned char)(best0 & 0xff);
+	block[1] = (unsigned char)(best0 >> 8);
+	block[2] = (unsigned char)(best1 & 0xff);
+	block[3] = (unsigned char)(best1 >> 8);
+	for (int i = 0; i < 4; i++) {
+		block[4 + i] = (unsigned char)(bits >> (8 * i));
+	}
+}
+
+/*	7 bit end point and the low bit shared by its channels that fit
+	the color best
+*/
+static void quantizeBC7(const glm::vec3& color, int q[3], int& p) {
+	float c[3] = { color.x, color.y, color.z };
+	float bestError = FLT_MAX;
+	for (int bit = 0; bit < 2; bit++) {
+		int v[3];
+		float error = 0.0f;
+		for (int k = 0; k < 3; k++) {
+			v[k] = std::min(std::max((int)floor((c[k] - bit) / 2.0f + 0.5f), 0), 127);
+			float d = (float)((v[k] << 1) | bit) - c[k];
+			error += d * d;
+		}
+		if (error < bestError) {
+			bestError = error;
+			p = bit;
+			memcpy(q, v, sizeof(v));
+		}
+	}
+}
+
+static void bc7Palette(const int q0[3], int p0, const int q1[3], int p1, int palette[16][3]) {
+	for (int k = 0; k < 3; k++) {
+		int a = (q0[k] << 1) | p0;
+		int b = (q1[k] << 1) | p1;
+		for (int i = 0; i < 16; i++) {
+			palette[i][k] = ((64 - bc7Weights[i]) * a + bc7Weights[i] * b + 32) >> 6;
+		}
+	}
+}
+
+// little endian bit stream of a 128 bit block
+struct BlockBits {
+	uint64_t words[2];
+	int position;
+
+	void write(unsigned int value, int count) {
+		for (int i = 0; i < count; i++, position++) {
+			words[position >> 6] |= (uint64_t)((value >> i) & 1) << (position & 63);
+		}
+	}
+	unsigned int read(int count) {
+		unsigned int value = 0;
+		for (int i = 0; i < count; i++, position++) {
+			value |= (unsigned int)((words[position >> 6] >> (position & 63)) & 1) << i;
+		}
+		return value;
+	}
+};
+
+/*	Mode 6: one subset, RGBA end points of 7 bits and a low bit each,
+	4 bit indices.  Alpha is stored opaque and never looked at.
+*/
+static void encodeBC7Block(const BlockTexels& texels, unsigned char* block) {
+	glm::vec3 e0;
+	glm::vec3 e1;
+	fitEndpoints(texels, e0, e1);
+	float bestError = FLT_MAX;
+	int best0[3] = { 0, 0, 0 };
+	int best1[3] = { 0, 0, 0 };
+	int bestP0 = 0;
+	int bestP1 = 0;
+	int bestIndices[16] = { 0 };
+	for (int pass = 0; pass <= COMPRESSION_REFINE_PASSES; pass++) {
+		int q0[3];
+		int q1[3];
+		int p0;
+		int p1;
+		quantizeBC7(e0, q0, p0);
+		quantizeBC7(e1, q1, p1);
+		int colors[16][3];
+		bc7Palette(q0, p0, q1, p1, colors);
+		BlockPalette palette;
+		palette.count = 16;
+		for (int k = 0; k < 16; k++) {
+			palette.r[k] = (float)colors[k][0];
+			palette.g[k] = (float)colors[k][1];
+			palette.b[k] = (float)colors[k][2];
+		}
+		int indices[16];
+		float error = closestIndices(texels, palette, indices);
+		if (error < bestError) {
+			bestError = error;
+			memcpy(best0, q0, sizeof(q0));
+			memcpy(best1, q1, sizeof(q1));
+			bestP0 = p0;
+			bestP1 = p1;
+			memcpy(bestIndices, indices, sizeof(indices));
+		}
+		if (error == 0.0f || !refineEndpoints(texels, indices, bc7Shares, e0, e1)) {
+			break;
+		}
+	}
+	// the top bit of the first index is implied 0, the weights are symmetric so swapping fixes it
+	if (bestIndices[0] >= 8) {
+		for (int k = 0; k < 3; k++) {
+			std::swap(best0[k], best1[k]);
+		}
+		std::swap(bestP0, bestP1);
+		for (int i = 0; i < 16; i++) {
+			bestIndices[i] = 15 - bestIndices[i];
+		}
+	}
+
+	BlockBits bits = { { 0, 0 }, 0 };
+	bits.write(1 << 6, 7);
+	for (int k = 0; k < 3; k++) {
+		bits.write(best0[k], 7);
+		bits.write(best1[k], 7);
+	}
+	bits.write(127, 7);
+	bits.write(127, 7);
+	bits.write(bestP0, 1);
+	bits.write(bestP1, 1);
+	bits.write(bestIndices[0], 3);
+	for (int i = 1; i < 16; i++) {
+		bits.write(bestIndices[i], 4);
+	}
+	for (int i = 0; i < 16; i++) {
+		block[i] = (unsigned char)(bits.words[i >> 3] >> (8 * (i & 7)));
+	}
+}
+
+void compressBlocks(const unsigned char* rgb, int width, int height, TextureCompression format,
+	int blockX, int blockY, int blocksWide, int blocksHigh, unsigned char* blocks) {
+	int blockBytes = compressionBlockBytes(format);
+	BlockTexels texels;
+	for (int y = 0; y < blocksHigh; y++) {
+		for (int x = 0; x < blocksWide; x++) {
+			loadBlock(rgb, width, height, blockX + x, blockY + y, texels);
+			unsigned char* block = blocks + ((size_t)y * blocksWide + x) * blockBytes;
+			if (format == COMPRESSION_BC7) {
+				encodeBC7Block(texels, block);
+			}
+			else {
+				encodeBC1Block(texels, block);
+			}
+		}
+	}
+}
+
+/*	Every step-th block row from first, interleaved so that the busy
+	and the flat parts of an image are spread over the threads
+*/
+static void compressRows(const unsigned char* rgb, int width, int height, TextureCompression format,
+	int first, int step, unsigned char* blocks) {
+	int blocksWide = (width + 3) / 4;
+	int blocksHigh = (height + 3) / 4;
+	size_t rowBytes = (size_t)blocksWide * compressionBlockBytes(format);
+	for (int row = first; row < blocksHigh; row += step) {
+		compressBlocks(rgb, width, height, format, 0, row, blocksWide, 1, blocks + row * rowBytes);
+	}
+}
+
+void compressImage(const unsigned char* rgb, int width, int height, TextureCompression format,
+	CompressedImage& image, int threads) {
+	image.format = format;
+	image.width = width;
+	image.height = height;
+	image.blocks.resize(compressedSize(format, width, height));
+	if (image.blocks.empty()) {
+		return;
+	}
+	int blocksHigh = (height + 3) / 4;
+	if (threads <= 0) {
+		threads = std::max((int)std::thread::hardware_concurrency(), 1);
+	}
+	threads = std::min(threads, blocksHigh);
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; t++) {
+		workers.push_back(std::thread(compressRows, rgb, width, height, format, t, threads, &image.blocks[0]));
+	}
+	compressRows(rgb, width, height, format, 0, threads, &image.blocks[0]);
+	for (size_t t = 0; t < workers.size(); t++) {
+		workers[t].join();
+	}
+}
+
+static void decodeBC1Block(const unsigned char* block, int colors[16][3]) {
+	unsigned short c0 = (unsigned short)(block[0] | (block[1] << 8));
+	unsigned short c1 = (unsigned short)(block[2] | (block[3] << 8));
+	int palette[4][3];
+	bc1Palette(c0, c1, palette);
+	unsigned int bits = block[4] | (block[5] << 8) | (block[6] << 16) | ((unsigned int)block[7] << 24);
+	for (int i = 0; i < 16; i++) {
+		memcpy(colors[i], palette[(bits >> (2 * i)) & 3], sizeof(colors[i]));
+	}
+}
+
+static void decodeBC7Block(const unsigned char* block, int colors[16][3]) {
+	BlockBits bits = { { 0, 0 }, 0 };
+	for (int i = 0; i < 16; i++) {
+		bits.words[i >> 3] |= (uint64_t)block[i] << (8 * (i & 7));
+	}
+	if (bits.read(7) != (1 << 6)) {
+		memset(colors, 0, 16 * sizeof(colors[0]));
+		return;
+	}
+	int q0[3];
+	int q1[3];
+	for (int k = 0; k < 3; k++) {
+		q0[k] = bits.read(7);
+		q1[k] = bits.read(7);
+	}
+	bits.read(14);	// alpha
+	int p0 = bits.read(1);
+	int p1 = bits.read(1);
+	int palette[16][3];
+	bc7Palette(q0, p0, q1, p1, palette);
+	for (int i = 0; i < 16; i++) {
+		memcpy(colors[i], palette[bits.read(i == 0 ? 3 : 4)], sizeof(colors[i]));
+	}
+}
+
+void decompressImage(const CompressedImage& image, std::vector<unsigned char>& rgb) {
+	rgb.resize((size_t)image.width * image.height * 3);
+	int blocksWide = (image.width + 3) / 4;
+	int blocksHigh = (image.height + 3) / 4;
+	int blockBytes = compressionBlockBytes(image.format);
+	if (image.format == COMPRESSION_NONE || image.blocks.size() < compressedSize(image.format, image.width, image.height)) {
+		return;
+	}
+	int colors[16][3];
+	for (int by = 0; by < blocksHigh; by++) {
+		for (int bx = 0; bx < blocksWide; bx++) {
+			const unsigned char* block = &image.blocks[((size_t)by * blocksWide + bx) * blockBytes];
+			if (image.format == COMPRESSION_BC7) {
+				decodeBC7Block(block, colors);
+			}
+			else {
+				decodeBC1Block(block, colors);
+			}
+			for (int y = 0; y < 4 && by * 4 + y < image.height; y++) {
+				for (int x = 0; x < 4 && bx * 4 + x < image.width; x++) {
+					unsigned char* p = &rgb[((size_t)(by * 4 + y) * image.width + bx * 4 + x) * 3];
+					p[0] = (unsigned char)colors[y * 4 + x][0];
+					p[1] = (unsigned char)colors[y * 4 + x][1];
+					p[2] = (unsigned char)colors[y * 4 + x][2];
+				}
+			}
+		}
+	}
+}
+
+double computePSNR(const unsigned char* a, const unsigned char* b, size_t bytes) {
+	double sum = 0.0;
+	for (size_t i = 0; i < bytes; i++) {
+		double d = (double)a[i] - (double)b[i];
+		sum += d * d;
+	}
+	if (bytes == 0 || sum == 0.0) {
+		return HUGE_VAL;
+	}
+	return 10.0 * log10(255.0 * 255.0 / (sum / bytes));
+}
+
+std::string compressionCachePath(std::string sourceFile, TextureCompression format) {
+	return sourceFile + "." + compressionName(format);
+}
+
+// size and modification time identify the version of the source file
+static bool sourceVersion(std::string sourceFile, long long& size, long long& time) {
+	struct stat info;
+	if (stat(sourceFile.c_str(), &info) != 0) {
+		return false;
+	}
+	size = (long long)info.st_size;
+	time = (long long)info.st_mtime;
+	return true;
+}
+
+bool loadCompressionCache(std::string sourceFile, TextureCompression format, CompressedImage& image) {
+	long long size;
+	long long time;
+	if (format == COMPRESSION_NONE || !sourceVersion(sourceFile, size, time)) {
+		return false;
+	}
+	FILE* file = fopen(compressionCachePath(sourceFile, format).c_str(), "rb");
+	if (file == NULL) {
+		return false;
+	}
+	CacheHeader header;
+	bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+		memcmp(header.magic, "CGTC", 4) == 0 && header.version == CACHE_VERSION &&
+		header.format == (int)format && header.sourceSize == size && header.sourceTime == time &&
+		header.width > 0 && header.height > 0;
+	if (valid) {
+		image.format = format;
+		image.width = header.width;
+		image.height = header.height;
+		image.blocks.resize(compressedSize(format, header.width, header.height));
+		valid = fread(&image.blocks[0], 1, image.blocks.size(), file) == image.blocks.size();
+	}
+	fclose(file);
+	return valid;
+}
+
+bool saveCompressionCache(std::string sourceFile, const CompressedImage& image) {
+	CacheHeader header;
+	memset(&header, 0, sizeof(header));
+	if (image.format == COMPRESSION_NONE || image.blocks.empty() ||
+		!sourceVersion(sourceFile, header.sourceSize, header.sourceTime)) {
+		return false;
+	}
+	memcpy(header.magic, "CGTC", 4);
+	header.version = CACHE_VERSION;
+	header.format = (int)image.format;
+	header.width = image.width;
+	header.height = image.height;
+	std::string path = compressionCachePath(sourceFile, image.format);
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == NULL) {
+		return false;
+	}
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(&image.blocks[0], 1, image.blocks.size(), file) == image.blocks.size();
+	written = (fclose(file) == 0) && written;
+	if (!written) {
+		// a partial file would only be rejected on every load
+		remove(path.c_str());
+	}
+	return written;
+}
@@ -0,0 +1,119 @@
+/*  =================== File Information =================
+	File Name: TextureCompression.h
+	Description:
+	Author:
+
+	Purpose: CPU encoder for block compressed textures, so that a
+			 texture takes 4 (BC1) or 8 (BC7) bits per texel on the GPU
+			 instead of the 24 of GL_RGB.  Both formats store 4x4 texel
+			 blocks: BC1 two RGB565 end points and a 2 bit index per
+			 texel, BC7 (mode 6 only) two RGB end points of 7 bits plus a
+			 shared low bit each and a 4 bit index per texel.  The end
+			 points are fit along the principal axis of the block colors
+			 and refined by least squares; the index search compares four
+			 texels at a time with SSE.  Block rows are shared out among
+			 threads.
+	Usage:	CompressedImage image;
+			compressImage(pixels, width, height, COMPRESSION_BC1, image);
+			glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+				width, height, 0, image.blocks.size(), &image.blocks[0]);
+
+			Encoded images can be cached next to the source file, the
+			cache is ignored once the source is modified.
+
+			Note that llvmpipe decodes BC7 on every texel fetch, which
+			makes textured frames several times slower there; GPUs
+			sample both formats at full speed.
+	===================================================== */
+#ifndef TEXTURE_COMPRESSION_H
+#define TEXTURE_COMPRESSION_H
+
+#include <string>
+#include <vector>
+
+#define COMPRESSION_BLOCK_SIZE 4	// texels per block side
+#define BC1_BLOCK_BYTES 8
+#define BC7_BLOCK_BYTES 16
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COMPRESSION_SSE 1
+#endif
+
+enum TextureCompression {
+	COMPRESSION_NONE,
+	COMPRESSION_BC1,		// GL_EXT_texture_compression_s3tc, 6:1
+	COMPRESSION_BC7			// GL_ARB_texture_compression_bptc, 3:1, better quality
+};
+
+struct CompressedImage {
+	TextureCompression format;
+	int width;
+	int height;
+	std::vector<unsigned char> blocks;	// row by row, left to right
+};
+
+/*	===============================================
+Desc:	Name of a format as used on the command line ("none", "bc1",
+		"bc7") and back.
+Precondition:
+Postcondition:	parseCompressionName returns false for an unknown name.
+=============================================== */
+const char* compressionName(TextureCompression format);
+bool parseCompressionName(std::string name, TextureCompression& format);
+/*	===============================================
+Desc:	Bytes of the encoded image, 3 bytes per texel for COMPRESSION_NONE
+Precondition:
+Postcondition:
+=============================================== */
+size_t compressedSize(TextureCompression format, int width, int height);
+int compressionBlockBytes(TextureCompression format);
+/*	===============================================
+Desc:	Encodes an RGB image, texels past the right and bottom edges of
+		a partial block repeat the last column and row.  threads 0
+		uses one thread per core.
+Precondition:	format is not COMPRESSION_NONE
+Postcondition:
+=============================================== */
+void compressImage(const unsigned char* rgb, int width, int height, TextureCompression format,
+	CompressedImage& image, int threads = 0);
+/*	===============================================
+Desc:	Encodes the blocks covering blocksWide x blocksHigh blocks from
+		block (blockX, blockY) of the image into blocks, row by row, as
+		needed by glCompressedTexSubImage2D.
+Precondition:	format is not COMPRESSION_NONE, the block range lies
+				within the image
+Postcondition:
+=============================================== */
+void compressBlocks(const unsigned char* rgb, int width, int height, TextureCompression format,
+	int blockX, int blockY, int blocksWide, int blocksHigh, unsigned char* blocks);
+/*	===============================================
+Desc:	Decodes an image written by compressImage back to RGB.  Only the
+		BC7 mode the encoder writes is understood, other blocks decode
+		to black.
+Precondition:
+Postcondition:	rgb holds width * height * 3 bytes.
+=============================================== */
+void decompressImage(const CompressedImage& image, std::vector<unsigned char>& rgb);
+/*	===============================================
+Desc:	Peak signal to noise ratio in dB of b against a, over bytes
+		8 bit values.  Identical images give infinity.
+Precondition:
+Postcondition:
+=============================================== */
+double computePSNR(const unsigned char* a, const unsigned char* b, size_t bytes);
+
+/*	===============================================
+Desc:	Reads or writes the cache file of a source image, the source
+		name with the format name appended (smile.ppm.bc1).  The cache
+		holds the size and modification time of the source and is only
+		used while they still match.
+Precondition:
+Postcondition:	loadCompressionCache returns false if there is no
+				valid cache, saveCompressionCache if it could not be
+				written.
+=============================================== */
+std::string compressionCachePath(std::string sourceFile, TextureCompression format);
+bool loadCompressionCache(std::string sourceFile, TextureCompression format, CompressedImage& image);
+bool saveCompressionCache(std::string sourceFile, const CompressedImage& image);
+
+#endif
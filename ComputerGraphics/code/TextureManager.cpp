@@ -0,0 +1,455 @@
+/*  =================== File Information =================
+	File Name: TextureManager.cpp
+	Description:
+	Author:
+
+	Purpose: LRU managed host and GPU texture storage
+	Usage:
+	===================================================== */
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include "TextureManager.h"
+
+static GLenum compressedGLFormat(TextureCompression format) {
+	// BC7 has no RGB only format, the alpha of the blocks is opaque
+	return format == COMPRESSION_BC7 ? GL_COMPRESSED_RGBA_BPTC_UNORM : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+}
+
+TextureManager::TextureManager(size_t _hostBudget, size_t _gpuBudget) {
+	hostBudget = _hostBudget;
+	gpuBudget = _gpuBudget;
+	tick = 0;
+	frame = 0;
+	stateCache = NULL;
+	stats.hostResidentBytes = 0;
+	stats.gpuResidentBytes = 0;
+	stats.hostEvictions = 0;
+	stats.gpuEvictions = 0;
+	stats.hostReloads = 0;
+	stats.gpuReloads = 0;
+	stats.uploadBytes = 0;
+	stats.compressedUploads = 0;
+	stats.compressionCacheHits = 0;
+	stats.encodeSeconds = 0;
+	stats.encodedTexels = 0;
+	stats.gpuBytesSaved = 0;
+	stats.minPSNR = 0;
+	stats.resampledTextures = 0;
+	stats.resampleSeconds = 0;
+	resize = noResize();
+	compression = COMPRESSION_NONE;
+	compressionCache = true;
+	compressionSupport = -1;
+}
+
+TextureManager::~TextureManager() {
+	for (int i = 0; i < (int)entries.size(); i++) {
+		release(i);
+	}
+}
+
+int TextureManager::load(std::string fileName) {
+	TextureEntry entry;
+	initEntry(entry, fileName);
+	loadHost(entry);
+	if (entry.image == NULL) {
+		return -1;
+	}
+	touch(entry);
+	entries.push_back(entry);
+	enforceBudgets();
+	return (int)entries.size() - 1;
+}
+
+int TextureManager::add(ppm* image, std::string name) {
+	TextureEntry entry;
+	initEntry(entry, name);
+	entry.image = image;
+	entry.width = image->getWidth();
+	entry.height = image->getHeight();
+	// never reloaded from a file, and never cached on disk under its name
+	entry.dirty = true;
+	stats.hostResidentBytes += entryBytes(entry);
+	touch(entry);
+	entries.push_back(entry);
+	enforceBudgets();
+	return (int)entries.size() - 1;
+}
+
+void TextureManager::initEntry(TextureEntry& entry, std::string fileName) {
+	entry.fileName = fileName;
+	entry.image = NULL;
+	entry.textureID = 0;
+	entry.width = 0;
+	entry.height = 0;
+	entry.dirty = false;
+	entry.inUse = true;
+	entry.uploadedOnce = false;
+	entry.resampled = false;
+	entry.gpuFormat = COMPRESSION_NONE;
+	entry.psnr = -1;
+	entry.lastUsed = 0;
+	entry.lastFrame = 0;
+}
+
+GLuint TextureManager::bind(int handle) {
+	if (!valid(handle)) {
+		bindTexture(0);
+		return 0;
+	}
+	TextureEntry& entry = entries[handle];
+	touch(entry);
+	if (entry.textureID == 0) {
+		upload(entry);
+		enforceBudgets();
+	}
+	bindTexture(entry.textureID);
+	return entry.textureID;
+}
+
+ppm* TextureManager::getImage(int handle) {
+	if (!valid(handle)) {
+		return NULL;
+	}
+	TextureEntry& entry = entries[handle];
+	touch(entry);
+	if (entry.image == NULL) {
+		loadHost(entry);
+		stats.hostReloads++;
+		enforceBudgets();
+	}
+	return entry.image;
+}
+
+void TextureManager::markDirty(int handle) {
+	if (!valid(handle)) {
+		return;
+	}
+	// Make sure there is a host copy to pin before flagging it
+	if (entries[handle].image == NULL) {
+		getImage(handle);
+	}
+	entries[handle].dirty = true;
+}
+
+void TextureManager::updateRegion(int handle, int x, int y, int width, int height) {
+	if (!valid(handle)) {
+		return;
+	}
+	TextureEntry& entry = entries[handle];
+	if (entry.textureID == 0 || entry.image == NULL) {
+		// Not on the GPU, the next bind() uploads the whole image anyway
+		return;
+	}
+	if (x < 0) { width += x; x = 0; }
+	if (y < 0) { height += y; y = 0; }
+	if (x + width > entry.width) { width = entry.width - x; }
+	if (y + height > entry.height) { height = entry.height - y; }
+	if (width <= 0 || height <= 0) {
+		return;
+	}
+
+	bindTexture(entry.textureID);
+	if (entry.gpuFormat != COMPRESSION_NONE) {
+		// whole blocks are replaced, a partial block only at the right or bottom
+		// edge.  The upload scratch is large enough for any region already.
+		int blockX = x / COMPRESSION_BLOCK_SIZE;
+		int blockY = y / COMPRESSION_BLOCK_SIZE;
+		int blocksWide = (x + width + COMPRESSION_BLOCK_SIZE - 1) / COMPRESSION_BLOCK_SIZE - blockX;
+		int blocksHigh = (y + height + COMPRESSION_BLOCK_SIZE - 1) / COMPRESSION_BLOCK_SIZE - blockY;
+		std::vector<unsigned char>& blocks = compressedImage.blocks;
+		blocks.resize((size_t)blocksWide * blocksHigh * compressionBlockBytes(entry.gpuFormat));
+		compressBlocks((const unsigned char*)entry.image->getPixels(), entry.width, entry.height, entry.gpuFormat,
+			blockX, blockY, blocksWide, blocksHigh, &blocks[0]);
+		x = blockX * COMPRESSION_BLOCK_SIZE;
+		y = blockY * COMPRESSION_BLOCK_SIZE;
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, x, y,
+			std::min(blocksWide * COMPRESSION_BLOCK_SIZE, entry.width - x),
+			std::min(blocksHigh * COMPRESSION_BLOCK_SIZE, entry.height - y),
+			compressedGLFormat(entry.gpuFormat), (GLsizei)blocks.size(), &blocks[0]);
+		stats.uploadBytes += blocks.size();
+		return;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, entry.width);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, x);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, y);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGB, GL_UNSIGNED_BYTE, entry.image->getPixels());
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+	stats.uploadBytes += (size_t)width * height * 3;
+}
+
+void TextureManager::release(int handle) {
+	if (!valid(handle)) {
+		return;
+	}
+	TextureEntry& entry = entries[handle];
+	entry.dirty = false;
+	evictGPU(entry);
+	evictHost(entry);
+	entry.inUse = false;
+}
+
+void TextureManager::beginFrame() {
+	frame++;
+}
+
+void TextureManager::setCompression(TextureCompression format, bool useCache) {
+	compressionCache = useCache;
+	if (format == compression) {
+		return;
+	}
+	compression = format;
+	compressionSupport = -1;
+	for (int i = 0; i < (int)entries.size(); i++) {
+		entries[i].psnr = -1;
+		if (entries[i].inUse) {
+			evictGPU(entries[i]);
+		}
+	}
+}
+
+void TextureManager::setBudgets(size_t _hostBudget, size_t _gpuBudget) {
+	hostBudget = _hostBudget;
+	gpuBudget = _gpuBudget;
+	enforceBudgets();
+}
+
+int TextureManager::getWidth(int handle) {
+	return valid(handle) ? entries[handle].width : 0;
+}
+
+int TextureManager::getHeight(int handle) {
+	return valid(handle) ? entries[handle].height : 0;
+}
+
+void TextureManager::printStats() {
+	std::cout << "textures: host " << stats.hostResidentBytes << "/" << hostBudget << " bytes, "
+		<< "gpu " << stats.gpuResidentBytes << "/" << gpuBudget << " bytes, "
+		<< "evictions host " << stats.hostEvictions << " gpu " << stats.gpuEvictions << ", "
+		<< "reloads host " << stats.hostReloads << " gpu " << stats.gpuReloads << ", "
+		<< "uploaded " << stats.uploadBytes << " bytes" << std::endl;
+	if (stats.compressedUploads > 0) {
+		printf("compressed textures: %s, %d uploads, %d from the cache, %.1f MPix/s encoding, %zu gpu bytes saved, PSNR >= %.2f dB\n",
+			compressionName(compression), stats.compressedUploads, stats.compressionCacheHits,
+			stats.encodeSeconds > 0 ? stats.encodedTexels / stats.encodeSeconds / 1e6 : 0.0,
+			stats.gpuBytesSaved, stats.minPSNR);
+	}
+	if (stats.resampledTextures > 0) {
+		printf("resampled textures: %d with %s in %.3f s\n", stats.resampledTextures,
+			resampleFilterName(resize.filter), stats.resampleSeconds);
+	}
+}
+
+bool TextureManager::valid(int handle) {
+	return handle >= 0 && handle < (int)entries.size() && entries[handle].inUse;
+}
+
+void TextureManager::touch(TextureEntry& entry) {
+	entry.lastUsed = ++tick;
+	entry.lastFrame = frame;
+}
+
+void TextureManager::loadHost(TextureEntry& entry) {
+	ppm* image = new ppm(entry.fileName);
+	if (image->getPixels() == NULL) {
+		std::cout << "Unable to load texture: " << entry.fileName << std::endl;
+		delete image;
+		return;
+	}
+	if (isResizing(resize)) {
+		typedef std::chrono::steady_clock Clock;
+		Clock::time_point start = Clock::now();
+		ppm* resized = resizeImage(image, resize);
+		if (resized != NULL) {
+			delete image;
+			image = resized;
+			entry.resampled = true;
+			stats.resampledTextures++;
+			stats.resampleSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+		}
+	}
+	entry.image = image;
+	entry.width = image->getWidth();
+	entry.height = image->getHeight();
+	stats.hostResidentBytes += entryBytes(entry);
+}
+
+/*	Uploads the host copy (reloading it first if needed).  Once the
+	pixels are on the GPU the host copy is only kept if it is dirty or
+	there is room for it in the host budget.
+*/
+void TextureManager::upload(TextureEntry& entry) {
+	if (entry.image == NULL) {
+		loadHost(entry);
+		stats.hostReloads++;
+		if (entry.image == NULL) {
+			return;
+		}
+	}
+
+	glGenTextures(1, &entry.textureID);
+	bindTexture(entry.textureID);
+	// set once here, drawing never changes them
+	if (stateCache != NULL) {
+		stateCache->texParameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		stateCache->texParameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+	else {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+	entry.gpuFormat = COMPRESSION_NONE;
+	if (compression != COMPRESSION_NONE && compressionAvailable()) {
+		uploadCompressed(entry);
+	}
+	else {
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D,
+					  0,
+					  GL_RGB,
+					  entry.width,
+					  entry.height,
+					  0,
+					  GL_RGB,
+					  GL_UNSIGNED_BYTE,
+					  entry.image->getPixels());
+	}
+
+	if (entry.uploadedOnce) {
+		stats.gpuReloads++;
+	}
+	entry.uploadedOnce = true;
+	stats.gpuResidentBytes += gpuBytes(entry);
+	stats.uploadBytes += gpuBytes(entry);
+	stats.gpuBytesSaved += entryBytes(entry) - gpuBytes(entry);
+}
+
+/*	Encodes the host copy, or reads the blocks from the disk cache, and
+	uploads them.  A painted or resampled image does not match its file,
+	so it is always encoded and never cached.  The quality of the blocks
+	is measured when they are encoded, and once for blocks from the
+	cache, not again when an evicted texture is uploaded anew.
+*/
+void TextureManager::uploadCompressed(TextureEntry& entry) {
+	typedef std::chrono::steady_clock Clock;
+	const unsigned char* pixels = (const unsigned char*)entry.image->getPixels();
+	bool useCache = compressionCache && !entry.dirty && !entry.resampled;
+	bool cached = useCache && loadCompressionCache(entry.fileName, compression, compressedImage) &&
+		compressedImage.width == entry.width && compressedImage.height == entry.height;
+	if (!cached) {
+		Clock::time_point start = Clock::now();
+		compressImage(pixels, entry.width, entry.height, compression, compressedImage);
+		stats.encodeSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+		stats.encodedTexels += (size_t)entry.width * entry.height;
+		if (useCache && !saveCompressionCache(entry.fileName, compressedImage)) {
+			std::cout << "Unable to write texture cache: " << compressionCachePath(entry.fileName, compression) << std::endl;
+		}
+	}
+	else {
+		stats.compressionCacheHits++;
+	}
+
+	glCompressedTexImage2D(GL_TEXTURE_2D, 0, compressedGLFormat(compression), entry.width, entry.height, 0,
+		(GLsizei)compressedImage.blocks.size(), &compressedImage.blocks[0]);
+	entry.gpuFormat = compression;
+	stats.compressedUploads++;
+
+	if (!cached || entry.psnr < 0) {
+		decompressImage(compressedImage, decodedImage);
+		entry.psnr = computePSNR(pixels, &decodedImage[0], decodedImage.size());
+		if (stats.minPSNR == 0 || entry.psnr < stats.minPSNR) {
+			stats.minPSNR = entry.psnr;
+		}
+	}
+}
+
+bool TextureManager::compressionAvailable() {
+	if (compressionSupport < 0) {
+		const char* extension = (compression == COMPRESSION_BC7) ?
+			"GL_ARB_texture_compression_bptc" : "GL_EXT_texture_compression_s3tc";
+		compressionSupport = hasGLExtension(extension) ? 1 : 0;
+		if (compressionSupport == 0) {
+			std::cout << compressionName(compression) << " textures need " << extension
+				<< ", uploading them uncompressed" << std::endl;
+		}
+	}
+	return compressionSupport == 1;
+}
+
+void TextureManager::evictHost(TextureEntry& entry) {
+	if (entry.image == NULL || entry.dirty) {
+		return;
+	}
+	delete entry.image;
+	entry.image = NULL;
+	stats.hostResidentBytes -= entryBytes(entry);
+}
+
+void TextureManager::evictGPU(TextureEntry& entry) {
+	if (entry.textureID == 0) {
+		return;
+	}
+	if (stateCache != NULL) {
+		stateCache->forgetTexture(entry.textureID);
+	}
+	glDeleteTextures(1, &entry.textureID);
+	entry.textureID = 0;
+	stats.gpuResidentBytes -= gpuBytes(entry);
+	stats.gpuBytesSaved -= entryBytes(entry) - gpuBytes(entry);
+}
+
+void TextureManager::bindTexture(GLuint textureID) {
+	if (stateCache != NULL) {
+		stateCache->bindTexture(textureID);
+	}
+	else {
+		glBindTexture(GL_TEXTURE_2D, textureID);
+	}
+}
+
+/*	Drops least recently used copies until both budgets are met.
+	Textures used during the current frame and dirty host copies are
+	never candidates, so the budgets can be exceeded by the working set
+	of a single frame.
+*/
+void TextureManager::enforceBudgets() {
+	while (stats.gpuResidentBytes > gpuBudget) {
+		int victim = -1;
+		for (int i = 0; i < (int)entries.size(); i++) {
+			TextureEntry& entry = entries[i];
+			if (entry.textureID != 0 && entry.lastFrame != frame &&
+				(victim < 0 || entry.lastUsed < entries[victim].lastUsed)) {
+				victim = i;
+			}
+		}
+		if (victim < 0) {
+			break;
+		}
+		evictGPU(entries[victim]);
+		stats.gpuEvictions++;
+	}
+
+	while (stats.hostResidentBytes > hostBudget) {
+		int victim = -1;
+		for (int i = 0; i < (int)entries.size(); i++) {
+			TextureEntry& entry = entries[i];
+			// a GPU resident texture does not need its pixels on the host any more
+			bool candidate = entry.image != NULL && !entry.dirty &&
+				(entry.textureID != 0 || entry.lastFrame != frame);
+			if (candidate && (victim < 0 || entry.lastUsed < entries[victim].lastUsed)) {
+				victim = i;
+			}
+		}
+		if (victim < 0) {
+			break;
+		}
+		evictHost(entries[victim]);
+		stats.hostEvictions++;
+	}
+}
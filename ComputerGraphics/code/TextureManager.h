@@ -0,0 +1,204 @@
+/*  =================== File Information =================
+	File Name: TextureManager.h
+	Description:
+	Author:
+
+	Purpose: Owns every texture used by the scene objects and keeps
+			 the host (ppm) and GPU (OpenGL texture) copies within a
+			 fixed memory budget.
+	Usage:	Register an image with load() (or add() if it was made in
+			memory), then call bind() every time the texture is drawn.
+			Evicted copies are reloaded from disk or re-uploaded on
+			demand.  With setCompression() the
+			GPU copies are uploaded block compressed, see
+			TextureCompression.h.  With setResize() images are resampled
+			as they are loaded, see Resample.h.
+	===================================================== */
+#ifndef TEXTURE_MANAGER_H
+#define TEXTURE_MANAGER_H
+
+#include "GLExt.h"
+#include <string>
+#include <vector>
+#include "ppm.h"
+#include "GLStateCache.h"
+#include "TextureCompression.h"
+#include "Resample.h"
+
+#define DEFAULT_HOST_TEXTURE_BUDGET (64 * 1024 * 1024)
+#define DEFAULT_GPU_TEXTURE_BUDGET (128 * 1024 * 1024)
+
+/*
+	Counters reported by the texture manager.  Resident byte counts
+	are the current footprint, everything else accumulates from the
+	moment the manager was created.
+*/
+struct TextureStats {
+	size_t hostResidentBytes;
+	size_t gpuResidentBytes;
+	int hostEvictions;		// ppm copies dropped to stay within the host budget
+	int gpuEvictions;		// GL textures deleted to stay within the GPU budget
+	int hostReloads;		// ppm files parsed again after an eviction
+	int gpuReloads;			// GL textures uploaded again after an eviction
+	size_t uploadBytes;		// total number of texel bytes sent to OpenGL
+	int compressedUploads;	// uploads in a block compressed format
+	int compressionCacheHits;	// of those, read from the disk cache instead of encoded
+	double encodeSeconds;	// spent encoding whole textures
+	size_t encodedTexels;
+	size_t gpuBytesSaved;	// GL_RGB size minus the compressed size of the resident textures
+	double minPSNR;			// worst compressed upload against its source, 0 before the first
+	int resampledTextures;	// loads and reloads the resize policy changed the size of
+	double resampleSeconds;
+};
+
+class TextureManager {
+	public:
+		/*	===============================================
+		Desc:	Creates an empty manager with the given budgets in bytes
+		Precondition:
+		Postcondition:	No texture is resident.
+		=============================================== */
+		TextureManager(size_t _hostBudget = DEFAULT_HOST_TEXTURE_BUDGET, size_t _gpuBudget = DEFAULT_GPU_TEXTURE_BUDGET);
+		/*	===============================================
+		Desc:	Deletes every host copy and GL texture still resident
+		Precondition:	The GL context that created the textures is current.
+		Postcondition:
+		=============================================== */
+		~TextureManager();
+		/*	===============================================
+		Desc:	Registers a ppm file and returns a handle to it.
+				The image is parsed immediately so that its dimensions are
+				known, but it may be evicted again at any time afterwards.
+		Precondition:
+		Postcondition:	Returns -1 if the file could not be loaded.
+		=============================================== */
+		int load(std::string fileName);
+		/*	===============================================
+		Desc:	Registers an image made in memory, e.g. an atlas page, under
+				the given name.  The manager takes ownership of it; there is
+				no file to reload it from, so it stays pinned in host memory
+				like a painted image.
+		Precondition:	image was allocated with new
+		Postcondition:	Returns the handle.
+		=============================================== */
+		int add(ppm* image, std::string name);
+		/*	===============================================
+		Desc:	Binds the texture to GL_TEXTURE_2D, uploading it first if it
+				is not resident on the GPU, and marks it as most recently drawn.
+		Precondition:	A GL context is current.
+		Postcondition:	Returns the GL texture id (0 for an invalid handle).
+		=============================================== */
+		GLuint bind(int handle);
+		/*	===============================================
+		Desc:	Returns the host copy of the texture, reloading it from disk
+				if it was evicted.  The pointer is only valid until the next
+				call into the manager unless the texture is marked dirty.
+		Precondition:
+		Postcondition:
+		=============================================== */
+		ppm* getImage(int handle);
+		/*	===============================================
+		Desc:	Records that the host copy was modified (i.e. painted on).
+				Dirty images can no longer be reloaded from their file, so
+				they stay pinned in host memory from now on.
+		Precondition:
+		Postcondition:
+		=============================================== */
+		void markDirty(int handle);
+		/*	===============================================
+		Desc:	Sends a rectangle of the host copy to the GL texture, if the
+				texture is currently resident on the GPU.
+		Precondition:	A GL context is current.
+		Postcondition:
+		=============================================== */
+		void updateRegion(int handle, int x, int y, int width, int height);
+		/*	===============================================
+		Desc:	Frees both copies of a texture.  The handle becomes invalid.
+		Precondition:	A GL context is current.
+		Postcondition:
+		=============================================== */
+		void release(int handle);
+		/*	===============================================
+		Desc:	Starts a new frame.  Textures bound during the current frame
+				are never evicted, even when that exceeds the budget.
+		Precondition:
+		Postcondition:
+		=============================================== */
+		void beginFrame();
+		void setBudgets(size_t _hostBudget, size_t _gpuBudget);
+		/*	===============================================
+		Desc:	Uploads textures in the given format from now on, if the
+				driver has it; textures already on the GPU are uploaded
+				again the next time they are bound.  With useCache the
+				encoded blocks of unpainted textures are kept next to
+				their ppm file and read back instead of encoding again.
+		Precondition:	A GL context is current if textures are resident.
+		Postcondition:
+		=============================================== */
+		void setCompression(TextureCompression format, bool useCache = true);
+		TextureCompression getCompression() { return compression; }
+		/*	===============================================
+		Desc:	Resizes images by the policy when they are loaded.  Set it
+				before the textures are loaded, a reload after it changes
+				would change the size of a texture.
+		Precondition:
+		Postcondition:
+		=============================================== */
+		void setResize(const ResizePolicy& policy) { resize = policy; }
+		const ResizePolicy& getResize() { return resize; }
+		// texture binds and parameters go through the cache if one is set
+		void setStateCache(GLStateCache* cache) { stateCache = cache; }
+
+		int getWidth(int handle);
+		int getHeight(int handle);
+		const TextureStats& getStats() { return stats; }
+		void printStats();
+
+	private:
+		struct TextureEntry {
+			std::string fileName;
+			ppm* image;				// host copy, NULL when evicted
+			GLuint textureID;		// GPU copy, 0 when evicted
+			int width;
+			int height;
+			bool dirty;				// host copy differs from the file on disk
+			bool inUse;				// false once the handle has been released
+			bool uploadedOnce;
+			bool resampled;			// size differs from the file's, which is not cached on disk
+			TextureCompression gpuFormat;	// of the GPU copy
+			double psnr;			// of the compressed blocks against the image, -1 until measured
+			unsigned long lastUsed;	// LRU tick of the last bind/getImage
+			unsigned long lastFrame;
+		};
+
+		void initEntry(TextureEntry& entry, std::string fileName);
+		bool valid(int handle);
+		void touch(TextureEntry& entry);
+		void loadHost(TextureEntry& entry);
+		void upload(TextureEntry& entry);
+		void uploadCompressed(TextureEntry& entry);
+		bool compressionAvailable();
+		void evictHost(TextureEntry& entry);
+		void evictGPU(TextureEntry& entry);
+		void enforceBudgets();
+		void bindTexture(GLuint textureID);
+		size_t entryBytes(const TextureEntry& entry) { return (size_t)entry.width * entry.height * 3; }
+		size_t gpuBytes(const TextureEntry& entry) { return compressedSize(entry.gpuFormat, entry.width, entry.height); }
+
+		std::vector<TextureEntry> entries;
+		size_t hostBudget;
+		size_t gpuBudget;
+		unsigned long tick;
+		unsigned long frame;
+		GLStateCache* stateCache;
+		TextureStats stats;
+
+		TextureCompression compression;
+		bool compressionCache;
+		int compressionSupport;		// -1 until the context has been asked
+		ResizePolicy resize;
+		CompressedImage compressedImage;	// scratch of the uploads
+		std::vector<unsigned char> decodedImage;
+};
+
+#endif
@@ -0,0 +1,420 @@
+/*  =================== File Information =================
+	File Name: TileStore.cpp
+	Description:
+	Author:
+
+	Purpose: Sparse tiled mip chain on disk with a fixed host tile pool
+	Usage:
+	===================================================== */
+
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include "TileStore.h"
+
+#define TILE_FILE_VERSION 1
+#define TILE_BYTES (VIRTUAL_TILE_SIZE * VIRTUAL_TILE_SIZE * 3)
+
+struct TileFileHeader {
+	char magic[4];			// "CGVT"
+	int version;
+	int size;
+	int tileSize;
+	int levels;
+	int reserved;
+	char source[256];		// image the tiles that are not stored are sampled from
+};
+
+// the files outgrow 2 GB once a 32K image is painted all over
+static bool seekFile(FILE* file, unsigned long long offset) {
+#ifdef _WIN32
+	return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+	return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static int wrapTexel(int value, int size) {
+	return ((value % size) + size) % size;
+}
+
+TileStore::TileStore(int _hostTiles) {
+	file = NULL;
+	source = NULL;
+	size = 0;
+	levels = 0;
+	fileEnd = 0;
+	tableDirty = false;
+	// getTile keeps the last two tiles valid, so there must be more
+	hostTiles = std::max(_hostTiles, 4);
+	tick = 0;
+	memset(&stats, 0, sizeof(stats));
+}
+
+TileStore::~TileStore() {
+	close();
+}
+
+bool TileStore::initTiles(int _size) {
+	if (_size < VIRTUAL_TILE_SIZE || _size % VIRTUAL_TILE_SIZE != 0) {
+		return false;
+	}
+	int tiles = _size / VIRTUAL_TILE_SIZE;
+	if ((tiles & (tiles - 1)) != 0) {
+		return false;
+	}
+	size = _size;
+	levels = 1;
+	while ((tiles >> (levels - 1)) > 1) {
+		levels++;
+	}
+	levelFirstTile.resize(levels);
+	int total = 0;
+	for (int level = 0; level < levels; level++) {
+		levelFirstTile[level] = total;
+		total += tilesPerSide(level) * tilesPerSide(level);
+	}
+	tileOffsets.assign(total, 0);
+	tileSlots.assign(total, -1);
+	tileChanged.assign(total, false);
+	changedTiles.clear();
+	// so a brush stroke does not allocate, see Benchmark.h --zero-allocations
+	changedTiles.reserve(hostTiles);
+	paintRects.reserve(hostTiles);
+	parentRects.reserve(hostTiles);
+
+	pool.assign((size_t)hostTiles * TILE_BYTES, 0);
+	slotTiles.assign(hostTiles, -1);
+	slotUsed.assign(hostTiles, 0);
+	slotDirty.assign(hostTiles, false);
+	memset(&stats, 0, sizeof(stats));
+	fileEnd = sizeof(TileFileHeader) + (unsigned long long)total * sizeof(unsigned long long);
+	stats.fileBytes = (size_t)fileEnd;
+	return true;
+}
+
+bool TileStore::create(std::string _fileName, int _size, std::string _sourceFile) {
+	close();
+	if (!initTiles(_size)) {
+		std::cout << "virtual texture size " << _size << " is not " << VIRTUAL_TILE_SIZE << " times a power of two" << std::endl;
+		return false;
+	}
+	if (_sourceFile.size() >= sizeof(((TileFileHeader*)0)->source)) {
+		std::cout << "virtual texture source name too long: " << _sourceFile << std::endl;
+		return false;
+	}
+	file = fopen(_fileName.c_str(), "w+b");
+	if (file == NULL) {
+		std::cout << "Unable to create virtual texture: " << _fileName << std::endl;
+		return false;
+	}
+	fileName = _fileName;
+	sourceFile = _sourceFile;
+	if (!writeHeader()) {
+		std::cout << "Unable to write virtual texture: " << fileName << std::endl;
+		close();
+		return false;
+	}
+	if (!sourceFile.empty()) {
+		source = new ppm(sourceFile);
+		if (source->getPixels() == NULL) {
+			delete source;
+			source = NULL;
+		}
+	}
+	return true;
+}
+
+bool TileStore::open(std::string _fileName) {
+	close();
+	FILE* opened = fopen(_fileName.c_str(), "r+b");
+	if (opened == NULL) {
+		return false;
+	}
+	TileFileHeader header;
+	bool valid = fread(&header, sizeof(header), 1, opened) == 1 &&
+		memcmp(header.magic, "CGVT", 4) == 0 && header.version == TILE_FILE_VERSION &&
+		header.tileSize == VIRTUAL_TILE_SIZE && initTiles(header.size) && header.levels == levels;
+	if (valid) {
+		valid = fread(&tileOffsets[0], sizeof(unsigned long long), tileOffsets.size(), opened) == tileOffsets.size();
+	}
+	if (!valid) {
+		std::cout << "Not a virtual texture: " << _fileName << std::endl;
+		fclose(opened);
+		close();
+		return false;
+	}
+	file = opened;
+	fileName = _fileName;
+	header.source[sizeof(header.source) - 1] = '\0';
+	sourceFile = header.source;
+	for (size_t i = 0; i < tileOffsets.size(); i++) {
+		if (tileOffsets[i] != 0) {
+			fileEnd = std::max(fileEnd, tileOffsets[i] + TILE_BYTES);
+		}
+	}
+	stats.fileBytes = (size_t)fileEnd;
+	if (!sourceFile.empty()) {
+		source = new ppm(sourceFile);
+		if (source->getPixels() == NULL) {
+			delete source;
+			source = NULL;
+		}
+	}
+	return true;
+}
+
+bool TileStore::writeHeader() {
+	TileFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "CGVT", 4);
+	header.version = TILE_FILE_VERSION;
+	header.size = size;
+	header.tileSize = VIRTUAL_TILE_SIZE;
+	header.levels = levels;
+	strncpy(header.source, sourceFile.c_str(), sizeof(header.source) - 1);
+	bool written = seekFile(file, 0) && fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(&tileOffsets[0], sizeof(unsigned long long), tileOffsets.size(), file) == tileOffsets.size();
+	tableDirty = !written;
+	return written;
+}
+
+bool TileStore::flush() {
+	if (file == NULL) {
+		return true;
+	}
+	bool written = true;
+	for (int slot = 0; slot < hostTiles; slot++) {
+		if (slotDirty[slot]) {
+			written = writeTile(slot) && written;
+		}
+	}
+	if (tableDirty) {
+		written = writeHeader() && written;
+	}
+	return (fflush(file) == 0) && written;
+}
+
+void TileStore::close() {
+	if (file != NULL) {
+		if (!flush()) {
+			std::cout << "Unable to write virtual texture: " << fileName << std::endl;
+		}
+		fclose(file);
+		file = NULL;
+	}
+	delete source;
+	source = NULL;
+	// the memory budget is only held while a file is open
+	std::vector<unsigned char>().swap(pool);
+	std::vector<unsigned long long>().swap(tileOffsets);
+	std::vector<int>().swap(tileSlots);
+	std::vector<bool>().swap(tileChanged);
+	changedTiles.clear();
+	size = 0;
+	levels = 0;
+}
+
+void TileStore::tileCoords(int index, int& level, int& x, int& y) {
+	level = levels - 1;
+	while (level > 0 && levelFirstTile[level] > index) {
+		level--;
+	}
+	int local = index - levelFirstTile[level];
+	x = local % tilesPerSide(level);
+	y = local / tilesPerSide(level);
+}
+
+const unsigned char* TileStore::getTile(int level, int x, int y) {
+	return hostTile(tileIndex(level, x, y));
+}
+
+unsigned char* TileStore::hostTile(int tile) {
+	int slot = tileSlots[tile];
+	if (slot < 0) {
+		slot = freeSlot();
+		readTile(tile, &pool[(size_t)slot * TILE_BYTES]);
+		slotTiles[slot] = tile;
+		tileSlots[tile] = slot;
+	}
+	slotUsed[slot] = ++tick;
+	return &pool[(size_t)slot * TILE_BYTES];
+}
+
+int TileStore::freeSlot() {
+	int victim = -1;
+	for (int slot = 0; slot < hostTiles; slot++) {
+		if (slotTiles[slot] < 0) {
+			stats.hostTiles++;
+			return slot;
+		}
+		if (victim < 0 || slotUsed[slot] < slotUsed[victim]) {
+			victim = slot;
+		}
+	}
+	// painted tiles are written back only now
+	if (slotDirty[victim] && !writeTile(victim)) {
+		std::cout << "Unable to write virtual texture: " << fileName << std::endl;
+	}
+	tileSlots[slotTiles[victim]] = -1;
+	slotTiles[victim] = -1;
+	slotDirty[victim] = false;
+	stats.hostEvictions++;
+	return victim;
+}
+
+bool TileStore::writeTile(int slot) {
+	int tile = slotTiles[slot];
+	if (tileOffsets[tile] == 0) {
+		tileOffsets[tile] = fileEnd;
+		fileEnd += TILE_BYTES;
+		stats.fileBytes = (size_t)fileEnd;
+		tableDirty = true;
+	}
+	bool written = seekFile(file, tileOffsets[tile]) &&
+		fwrite(&pool[(size_t)slot * TILE_BYTES], 1, TILE_BYTES, file) == TILE_BYTES;
+	slotDirty[slot] = false;
+	stats.tileWrites++;
+	return written;
+}
+
+void TileStore::readTile(int tile, unsigned char* texels) {
+	if (tileOffsets[tile] != 0) {
+		if (seekFile(file, tileOffsets[tile]) && fread(texels, 1, TILE_BYTES, file) == TILE_BYTES) {
+			stats.tileReads++;
+			return;
+		}
+		std::cout << "Unable to read virtual texture tile " << tile << " of " << fileName << std::endl;
+	}
+	stats.tilesGenerated++;
+	if (source == NULL) {
+		memset(texels, 0, TILE_BYTES);
+		return;
+	}
+	// nearest texel of the source under the center of every level 0 footprint
+	int level, tileX, tileY;
+	tileCoords(tile, level, tileX, tileY);
+	const unsigned char* pixels = (const unsigned char*)source->getPixels();
+	int sourceWidth = source->getWidth();
+	int sourceHeight = source->getHeight();
+	long long scale = 1LL << level;
+	for (int y = 0; y < VIRTUAL_TILE_SIZE; y++) {
+		long long virtualY = ((long long)tileY * VIRTUAL_TILE_SIZE + y) * scale + scale / 2;
+		int sourceY = (int)(virtualY * sourceHeight / size);
+		const unsigned char* sourceRow = pixels + (size_t)sourceY * sourceWidth * 3;
+		unsigned char* row = texels + (size_t)y * VIRTUAL_TILE_SIZE * 3;
+		for (int x = 0; x < VIRTUAL_TILE_SIZE; x++) {
+			long long virtualX = ((long long)tileX * VIRTUAL_TILE_SIZE + x) * scale + scale / 2;
+			const unsigned char* texel = sourceRow + (size_t)(virtualX * sourceWidth / size) * 3;
+			row[x * 3] = texel[0];
+			row[x * 3 + 1] = texel[1];
+			row[x * 3 + 2] = texel[2];
+		}
+	}
+}
+
+void TileStore::markPainted(int tile, int slot) {
+	slotDirty[slot] = true;
+	if (!tileChanged[tile]) {
+		tileChanged[tile] = true;
+		changedTiles.push_back(tile);
+	}
+}
+
+void TileStore::clearChangedTiles() {
+	for (size_t i = 0; i < changedTiles.size(); i++) {
+		tileChanged[changedTiles[i]] = false;
+	}
+	changedTiles.clear();
+}
+
+void TileStore::addRect(std::vector<TileRect>& rects, int tile, int x0, int y0, int x1, int y1) {
+	// the rectangles of the current row of tiles are at the end
+	for (size_t i = rects.size(); i-- > 0;) {
+		TileRect& rect = rects[i];
+		if (rect.tile == tile) {
+			rect.x0 = std::min(rect.x0, x0);
+			rect.y0 = std::min(rect.y0, y0);
+			rect.x1 = std::max(rect.x1, x1);
+			rect.y1 = std::max(rect.y1, y1);
+			return;
+		}
+	}
+	TileRect rect = { tile, x0, y0, x1, y1 };
+	rects.push_back(rect);
+}
+
+void TileStore::paintDisc(int centerX, int centerY, int radius, unsigned char r, unsigned char g, unsigned char b) {
+	if (file == NULL) {
+		return;
+	}
+	radius = std::min(std::max(radius, 0), size / 2 - 1);
+	centerX = wrapTexel(centerX, size);
+	centerY = wrapTexel(centerY, size);
+	paintRects.clear();
+	for (int dy = -radius; dy <= radius; dy++) {
+		int y = wrapTexel(centerY + dy, size);
+		int tileY = y / VIRTUAL_TILE_SIZE;
+		int rowY = y % VIRTUAL_TILE_SIZE;
+		int halfWidth = (int)floor(sqrt((double)(radius * radius - dy * dy)));
+		// the row in pieces that each lie in one tile
+		int x = centerX - halfWidth;
+		while (x <= centerX + halfWidth) {
+			int wrapped = wrapTexel(x, size);
+			int column = wrapped % VIRTUAL_TILE_SIZE;
+			int count = std::min(centerX + halfWidth - x + 1, VIRTUAL_TILE_SIZE - column);
+			int tile = tileIndex(0, wrapped / VIRTUAL_TILE_SIZE, tileY);
+			unsigned char* texel = hostTile(tile) + ((size_t)rowY * VIRTUAL_TILE_SIZE + column) * 3;
+			for (int i = 0; i < count; i++) {
+				texel[i * 3] = r;
+				texel[i * 3 + 1] = g;
+				texel[i * 3 + 2] = b;
+			}
+			markPainted(tile, tileSlots[tile]);
+			addRect(paintRects, tile, column, rowY, column + count - 1, rowY);
+			x += count;
+		}
+	}
+	for (int level = 1; level < levels; level++) {
+		parentRects.clear();
+		for (size_t i = 0; i < paintRects.size(); i++) {
+			downsample(paintRects[i], parentRects);
+		}
+		paintRects.swap(parentRects);
+	}
+}
+
+/*	Recomputes the texels of the parent tile over a painted rectangle of
+	a child tile.  A parent texel covers 2 x 2 texels of one child, as
+	the tiles have an even size.
+*/
+void TileStore::downsample(const TileRect& child, std::vector<TileRect>& parents) {
+	int level, childX, childY;
+	tileCoords(child.tile, level, childX, childY);
+	int parent = tileIndex(level + 1, childX / 2, childY / 2);
+	int offsetX = (childX % 2) * (VIRTUAL_TILE_SIZE / 2);
+	int offsetY = (childY % 2) * (VIRTUAL_TILE_SIZE / 2);
+	int x0 = offsetX + child.x0 / 2;
+	int y0 = offsetY + child.y0 / 2;
+	int x1 = offsetX + child.x1 / 2;
+	int y1 = offsetY + child.y1 / 2;
+
+	// in this order both stay valid, the parent is the second last tile used
+	unsigned char* parentTexels = hostTile(parent);
+	const unsigned char* childTexels = hostTile(child.tile);
+	size_t rowBytes = VIRTUAL_TILE_SIZE * 3;
+	for (int y = y0; y <= y1; y++) {
+		const unsigned char* top = childTexels + (size_t)(2 * (y - offsetY)) * rowBytes;
+		const unsigned char* bottom = top + rowBytes;
+		unsigned char* texel = parentTexels + (size_t)y * rowBytes;
+		for (int x = x0; x <= x1; x++) {
+			int c = 2 * (x - offsetX) * 3;
+			for (int k = 0; k < 3; k++) {
+				texel[x * 3 + k] = (unsigned char)((top[c + k] + top[c + 3 + k] + bottom[c + k] + bottom[c + 3 + k] + 2) / 4);
+			}
+		}
+	}
+	markPainted(parent, tileSlots[parent]);
+	addRect(parents, parent, x0, y0, x1, y1);
+}
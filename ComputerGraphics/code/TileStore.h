@@ -0,0 +1,162 @@
+/*  =================== File Information =================
+	File Name: TileStore.h
+	Description:
+	Author:
+
+	Purpose: Host side of a virtual texture: a square image too large
+			 to hold in memory, e.g. 32768 x 32768, kept on disk as
+			 VIRTUAL_TILE_SIZE square RGB tiles of every mip level down
+			 to a single tile.  Only a fixed pool of tiles is held in
+			 memory, the least recently used one is dropped when another
+			 is needed, and painted tiles are only written back to the
+			 file when they are dropped or on flush().
+
+			 The file is sparse: a tile that was never painted is not
+			 stored but sampled from a small source image (or left
+			 black), so a new 32K surface takes well under a megabyte
+			 until it is painted on.
+	Usage:	TileStore store;
+			if (!store.open("surface.vt")) {
+				store.create("surface.vt", 32768, "./data/smile.ppm");
+			}
+			store.paintDisc(x, y, radius, 255, 0, 0);	// level 0 texels
+			const unsigned char* tile = store.getTile(level, tileX, tileY);
+			store.close();
+
+			File layout: a header, the offset of every tile in the file
+			(0 if it is not stored), then the stored tiles in the order
+			they were first written.
+	===================================================== */
+#ifndef TILE_STORE_H
+#define TILE_STORE_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include "ppm.h"
+
+#define VIRTUAL_TILE_SIZE 128		// texels per tile side
+#define VIRTUAL_HOST_TILES 512		// tiles held in memory, 24 MB of 128 x 128 RGB
+
+struct TileStoreStats {
+	int hostTiles;			// tiles in memory now
+	int tileReads;			// from the file
+	int tilesGenerated;		// sampled from the source because they were not stored
+	int tileWrites;			// painted tiles written back
+	int hostEvictions;
+	size_t fileBytes;		// size of the file, header and table included
+};
+
+class TileStore {
+public:
+	TileStore(int _hostTiles = VIRTUAL_HOST_TILES);
+	/*	===============================================
+	Desc:	Writes the painted tiles back and closes the file
+	Precondition:
+	Postcondition:
+	=============================================== */
+	~TileStore();
+
+	/*	===============================================
+	Desc:	Creates a new file for a size x size image.  Tiles are sampled
+			from sourceFile (nearest texel) until they are painted, an
+			empty name makes them black.
+	Precondition:	size is VIRTUAL_TILE_SIZE times a power of two
+	Postcondition:	Returns false if the file could not be written.
+	=============================================== */
+	bool create(std::string fileName, int size, std::string sourceFile);
+	/*	===============================================
+	Desc:	Opens a file written by create() and earlier sessions
+	Precondition:
+	Postcondition:	Returns false if it does not exist or is not a tile file.
+	=============================================== */
+	bool open(std::string fileName);
+	/*	===============================================
+	Desc:	Writes the painted tiles still in memory and the tile table
+	Precondition:
+	Postcondition:	Returns false if a write failed.
+	=============================================== */
+	bool flush();
+	void close();
+	bool isOpen() { return file != NULL; }
+
+	int getSize() { return size; }
+	int getTileSize() { return VIRTUAL_TILE_SIZE; }
+	int getLevels() { return levels; }		// level levels - 1 is a single tile
+	int getTileCount() { return (int)tileOffsets.size(); }
+	int tilesPerSide(int level) { return (size / VIRTUAL_TILE_SIZE) >> level; }
+	int tileIndex(int level, int x, int y) { return levelFirstTile[level] + y * tilesPerSide(level) + x; }
+	void tileCoords(int index, int& level, int& x, int& y);
+
+	/*	===============================================
+	Desc:	Returns the RGB texels of a tile, row by row, reading or
+			sampling it first if it is not in memory.  The pointer stays
+			valid until the second next call that needs another tile.
+	Precondition:	isOpen(), the tile exists
+	Postcondition:
+	=============================================== */
+	const unsigned char* getTile(int level, int x, int y);
+	/*	===============================================
+	Desc:	Paints a disc of level 0 texels and the texels of the coarser
+			levels above it, which are box filtered again from the level
+			below.  The disc wraps around the image edges like GL_REPEAT.
+			The cost grows with the area at level 0, a wide brush on a
+			32K image touches many tiles.
+	Precondition:	isOpen()
+	Postcondition:	The tiles changed are listed by getChangedTiles().
+	=============================================== */
+	void paintDisc(int centerX, int centerY, int radius, unsigned char r, unsigned char g, unsigned char b);
+	// tile indices painted since clearChangedTiles(), each once
+	const std::vector<int>& getChangedTiles() { return changedTiles; }
+	void clearChangedTiles();
+
+	const TileStoreStats& getStats() { return stats; }
+
+private:
+	// a rectangle of texels inside one tile, inclusive
+	struct TileRect {
+		int tile;
+		int x0;
+		int y0;
+		int x1;
+		int y1;
+	};
+
+	bool initTiles(int _size);
+	unsigned char* hostTile(int tile);		// getTile() that may be written to
+	int freeSlot();
+	bool writeTile(int slot);
+	void readTile(int tile, unsigned char* texels);
+	void markPainted(int tile, int slot);
+	void addRect(std::vector<TileRect>& rects, int tile, int x0, int y0, int x1, int y1);
+	void downsample(const TileRect& child, std::vector<TileRect>& parents);
+	bool writeHeader();
+
+	FILE* file;
+	std::string fileName;
+	std::string sourceFile;
+	ppm* source;			// NULL without a source, tiles are black then
+	int size;
+	int levels;
+	std::vector<int> levelFirstTile;
+	std::vector<unsigned long long> tileOffsets;	// 0 if the tile is not stored
+	std::vector<int> tileSlots;					// host slot of every tile, -1 if not in memory
+	unsigned long long fileEnd;
+	bool tableDirty;
+
+	// fixed pool of host tiles
+	int hostTiles;
+	std::vector<unsigned char> pool;
+	std::vector<int> slotTiles;				// tile in every slot, -1 if free
+	std::vector<unsigned long> slotUsed;	// LRU tick
+	std::vector<bool> slotDirty;			// painted since it was read
+	unsigned long tick;
+
+	std::vector<int> changedTiles;
+	std::vector<bool> tileChanged;
+	std::vector<TileRect> paintRects;		// scratch of paintDisc
+	std::vector<TileRect> parentRects;
+	TileStoreStats stats;
+};
+
+#endif
@@ -0,0 +1,272 @@
+/*  =================== File Information =================
+	File Name: VirtualTexture.cpp
+	Description:
+	Author:
+
+	Purpose: Tile cache and page table of a virtual texture
+	Usage:
+	===================================================== */
+
+#include <iostream>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include "VirtualTexture.h"
+
+#define CACHE_SLOTS (VIRTUAL_CACHE_TILES * VIRTUAL_CACHE_TILES)
+
+VirtualTexture::VirtualTexture() {
+	cacheTexture = 0;
+	pageTableTexture = 0;
+	stateCache = NULL;
+	frame = 0;
+	pageTableDirty = false;
+	memset(&stats, 0, sizeof(stats));
+}
+
+VirtualTexture::~VirtualTexture() {
+	close();
+}
+
+bool VirtualTexture::open(std::string fileName, int size, std::string sourceFile) {
+	close();
+	if (!store.open(fileName)) {
+		if (!store.create(fileName, size, sourceFile)) {
+			return false;
+		}
+		std::cout << "created virtual texture " << fileName << " of " << size << " x " << size << std::endl;
+	}
+	else if (store.getSize() != size) {
+		std::cout << "virtual texture " << fileName << " keeps its size of " << store.getSize() << std::endl;
+	}
+	tileSlots.assign(store.getTileCount(), -1);
+	tileRequested.assign(store.getTileCount(), 0);
+	slotTiles.assign(CACHE_SLOTS, -1);
+	slotRequested.assign(CACHE_SLOTS, 0);
+	requests.clear();
+	requests.reserve(CACHE_SLOTS * 2);
+	frame = 0;
+
+	pageTableLevels.resize(store.getLevels());
+	size_t entries = 0;
+	for (int level = 0; level < store.getLevels(); level++) {
+		pageTableLevels[level] = entries * 4;
+		entries += (size_t)store.tilesPerSide(level) * store.tilesPerSide(level);
+	}
+	pageTable.assign(entries * 4, 0);
+	pageTableDirty = true;
+	memset(&stats, 0, sizeof(stats));
+	return true;
+}
+
+void VirtualTexture::close() {
+	releaseGL();
+	store.close();
+	std::vector<int>().swap(tileSlots);
+	std::vector<unsigned int>().swap(tileRequested);
+	std::vector<unsigned char>().swap(pageTable);
+}
+
+void VirtualTexture::initGL(GLStateCache& state) {
+	stateCache = &state;
+	glGenTextures(1, &cacheTexture);
+	state.bindTexture(cacheTexture);
+	state.texParameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	state.texParameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, cacheSize(), cacheSize(), 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+
+	// one mip level per tile level, the shader fetches the level it wants
+	glGenTextures(1, &pageTableTexture);
+	state.bindTexture(pageTableTexture);
+	state.texParameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	state.texParameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	state.texParameter(GL_TEXTURE_MAX_LEVEL, store.getLevels() - 1);
+	for (int level = 0; level < store.getLevels(); level++) {
+		int tiles = store.tilesPerSide(level);
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, tiles, tiles, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	}
+
+	// the coarsest tile stays in slot 0 for good
+	std::fill(slotTiles.begin(), slotTiles.end(), -1);
+	std::fill(tileSlots.begin(), tileSlots.end(), -1);
+	uploadTile(state, store.tileIndex(store.getLevels() - 1, 0, 0), 0);
+	pageTableDirty = true;
+}
+
+void VirtualTexture::releaseGL() {
+	if (cacheTexture != 0) {
+		if (stateCache != NULL) {
+			stateCache->forgetTexture(cacheTexture);
+		}
+		glDeleteTextures(1, &cacheTexture);
+	}
+	if (pageTableTexture != 0) {
+		if (stateCache != NULL) {
+			stateCache->forgetTexture(pageTableTexture);
+		}
+		glDeleteTextures(1, &pageTableTexture);
+	}
+	cacheTexture = 0;
+	pageTableTexture = 0;
+}
+
+int VirtualTexture::levelFor(float texelsPerPixel) {
+	// the same rounding as the shader
+	int level = (int)floor(log2(std::max(texelsPerPixel, 1.0f)));
+	return std::min(level, store.getLevels() - 1);
+}
+
+void VirtualTexture::beginFeedback() {
+	frame++;
+	requests.clear();
+}
+
+void VirtualTexture::request(const glm::vec2& texCoord, int level) {
+	float u = texCoord.x - floor(texCoord.x);
+	float v = texCoord.y - floor(texCoord.y);
+	level = std::min(std::max(level, 0), store.getLevels() - 1);
+	int tiles = store.tilesPerSide(level);
+	int x = std::min((int)(u * tiles), tiles - 1);
+	int y = std::min((int)(v * tiles), tiles - 1);
+	// the ancestors as well, they are what is drawn until the tile is cached
+	for (; level < store.getLevels(); level++) {
+		int tile = store.tileIndex(level, x, y);
+		if (tileRequested[tile] == frame) {
+			break;
+		}
+		tileRequested[tile] = frame;
+		requests.push_back(tile);
+		x /= 2;
+		y /= 2;
+	}
+}
+
+void VirtualTexture::uploadTile(GLStateCache& state, int tile, int slot) {
+	int level, x, y;
+	store.tileCoords(tile, level, x, y);
+	const unsigned char* texels = store.getTile(level, x, y);
+	state.bindTexture(cacheTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % VIRTUAL_CACHE_TILES) * VIRTUAL_TILE_SIZE,
+		(slot / VIRTUAL_CACHE_TILES) * VIRTUAL_TILE_SIZE, VIRTUAL_TILE_SIZE, VIRTUAL_TILE_SIZE,
+		GL_RGB, GL_UNSIGNED_BYTE, texels);
+	if (slotTiles[slot] >= 0) {
+		tileSlots[slotTiles[slot]] = -1;
+	}
+	slotTiles[slot] = tile;
+	tileSlots[tile] = slot;
+	stats.totalUploads++;
+}
+
+/*	A free slot, else the one requested longest ago; slots requested this
+	frame and slot 0 are never given up.
+*/
+int VirtualTexture::freeSlot() {
+	int victim = -1;
+	for (int slot = 1; slot < CACHE_SLOTS; slot++) {
+		if (slotTiles[slot] < 0) {
+			return slot;
+		}
+		if (slotRequested[slot] != frame && (victim < 0 || slotRequested[slot] < slotRequested[victim])) {
+			victim = slot;
+		}
+	}
+	return victim;
+}
+
+void VirtualTexture::update(GLStateCache& state) {
+	if (cacheTexture == 0) {
+		initGL(state);
+	}
+	stats.requestedTiles = (int)requests.size();
+	stats.uploads = 0;
+	stats.paintUploads = 0;
+
+	const std::vector<int>& changed = store.getChangedTiles();
+	for (size_t i = 0; i < changed.size(); i++) {
+		int slot = tileSlots[changed[i]];
+		if (slot >= 0) {
+			uploadTile(state, changed[i], slot);
+			stats.paintUploads++;
+		}
+	}
+	store.clearChangedTiles();
+
+	// coarse levels have the higher tile indices, they go first
+	std::sort(requests.begin(), requests.end(), std::greater<int>());
+	int missing = 0;
+	for (size_t i = 0; i < requests.size(); i++) {
+		int slot = tileSlots[requests[i]];
+		if (slot >= 0) {
+			slotRequested[slot] = frame;
+		}
+	}
+	for (size_t i = 0; i < requests.size(); i++) {
+		int tile = requests[i];
+		if (tileSlots[tile] >= 0) {
+			continue;
+		}
+		int slot = (stats.uploads < VIRTUAL_UPLOADS_PER_FRAME) ? freeSlot() : -1;
+		if (slot < 0) {
+			missing++;
+			continue;
+		}
+		uploadTile(state, tile, slot);
+		slotRequested[slot] = frame;
+		stats.uploads++;
+		pageTableDirty = true;
+	}
+	stats.missingTiles = missing;
+	stats.cachedTiles = 0;
+	for (int slot = 0; slot < CACHE_SLOTS; slot++) {
+		stats.cachedTiles += (slotTiles[slot] >= 0) ? 1 : 0;
+	}
+
+	if (pageTableDirty) {
+		updatePageTable(state);
+		pageTableDirty = false;
+		stats.pageTableUpdates++;
+	}
+}
+
+/*	Every entry names the slot of its tile, or inherits the entry of its
+	parent, from the coarsest level down.
+*/
+void VirtualTexture::updatePageTable(GLStateCache& state) {
+	state.bindTexture(pageTableTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (int level = store.getLevels() - 1; level >= 0; level--) {
+		int tiles = store.tilesPerSide(level);
+		unsigned char* entries = &pageTable[pageTableLevels[level]];
+		const unsigned char* parents = (level + 1 < store.getLevels()) ? &pageTable[pageTableLevels[level + 1]] : NULL;
+		for (int y = 0; y < tiles; y++) {
+			for (int x = 0; x < tiles; x++) {
+				unsigned char* entry = entries + ((size_t)y * tiles + x) * 4;
+				int slot = tileSlots[store.tileIndex(level, x, y)];
+				if (slot >= 0 || parents == NULL) {
+					slot = std::max(slot, 0);
+					entry[0] = (unsigned char)(slot % VIRTUAL_CACHE_TILES);
+					entry[1] = (unsigned char)(slot / VIRTUAL_CACHE_TILES);
+					entry[2] = (unsigned char)level;
+					entry[3] = 255;
+				}
+				else {
+					const unsigned char* parent = parents + ((size_t)(y / 2) * (tiles / 2) + x / 2) * 4;
+					memcpy(entry, parent, 4);
+				}
+			}
+		}
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, tiles, tiles, GL_RGBA, GL_UNSIGNED_BYTE, entries);
+	}
+}
+
+void VirtualTexture::bind(GLStateCache& state, ShaderPipeline& pipeline) {
+	// the page table is only read by the shaders, the cache does not track unit 1
+	glActiveTexture(GL_TEXTURE0 + PAGE_TABLE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, pageTableTexture);
+	glActiveTexture(GL_TEXTURE0);
+	state.bindTexture(cacheTexture);
+	pipeline.setVirtualTexture(true, glm::vec4((float)store.getSize(), (float)VIRTUAL_TILE_SIZE,
+		(float)(store.getLevels() - 1), 0.0f));
+}
@@ -0,0 +1,143 @@
+/*  =================== File Information =================
+	File Name: VirtualTexture.h
+	Description:
+	Author:
+
+	Purpose: Draws a TileStore image of any size with a fixed amount of
+			 GPU memory.  A cache texture holds VIRTUAL_CACHE_TILES x
+			 VIRTUAL_CACHE_TILES tiles, a page table texture with one mip
+			 level per tile level tells the fragment shader in which
+			 cache slot each tile is.  A tile that is not in the cache
+			 points at the slot of its nearest cached ancestor, so a
+			 missing tile shows up blurred instead of wrong, and the
+			 single tile of the coarsest level is always cached.
+
+			 Which tiles are needed is decided by a feedback pass before
+			 the frame, at a fraction of the screen resolution: every
+			 sample requests the tile and mip level the shader will read
+			 there.  update() then uploads up to VIRTUAL_UPLOADS_PER_FRAME
+			 missing tiles, coarse levels first, into the least recently
+			 requested slots.
+	Usage:	virtualTexture.open("surface.vt", 32768, "./data/smile.ppm");
+			// every frame, after painting
+			virtualTexture.beginFeedback();
+			virtualTexture.request(texCoord, level);	// per feedback sample
+			virtualTexture.update(state);
+			virtualTexture.bind(state, pipeline);
+			// draw with texture coordinates of the whole image
+
+			Only the shader pipeline can look tiles up.  The fixed
+			function path has to draw something else, see
+			SceneObject::setVirtualTexture.
+	===================================================== */
+#ifndef VIRTUAL_TEXTURE_H
+#define VIRTUAL_TEXTURE_H
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "GLExt.h"
+#include "GLStateCache.h"
+#include "ShaderPipeline.h"
+#include "TileStore.h"
+
+#define VIRTUAL_CACHE_TILES 16			// cache texture of 16 x 16 tiles, 2048 texels and 12 MB
+#define VIRTUAL_UPLOADS_PER_FRAME 32	// tiles newly cached per frame, the rest wait
+#define VIRTUAL_FEEDBACK_SCALE 8		// screen pixels per feedback sample and side
+
+/*
+	Counts of the last update(), except the totals
+*/
+struct VirtualTextureStats {
+	int requestedTiles;		// distinct tiles the feedback asked for, ancestors included
+	int missingTiles;		// of those, not cached after the update
+	int uploads;			// tiles newly cached
+	int paintUploads;		// cached tiles sent again because they were painted
+	int cachedTiles;
+	int totalUploads;
+	int pageTableUpdates;	// frames the page table was sent again
+};
+
+class VirtualTexture {
+public:
+	VirtualTexture();
+	/*	===============================================
+	Desc:	Deletes the GL textures and closes the store
+	Precondition:	The GL context of the textures is current.
+	Postcondition:
+	=============================================== */
+	~VirtualTexture();
+
+	/*	===============================================
+	Desc:	Opens fileName, or creates it for a size x size image sampled
+			from sourceFile if it cannot be opened (see TileStore::create)
+	Precondition:
+	Postcondition:	Returns false if neither worked.
+	=============================================== */
+	bool open(std::string fileName, int size, std::string sourceFile);
+	bool isOpen() { return store.isOpen(); }
+	void close();
+	TileStore& getStore() { return store; }
+
+	/*	===============================================
+	Desc:	Mip level the shader reads where one screen pixel covers
+			texelsPerPixel level 0 texels
+	Precondition:	isOpen()
+	Postcondition:
+	=============================================== */
+	int levelFor(float texelsPerPixel);
+	/*	===============================================
+	Desc:	Collects the tiles of one frame.  request() takes a texture
+			coordinate of the whole image, which wraps like GL_REPEAT.
+	Precondition:	isOpen()
+	Postcondition:
+	=============================================== */
+	void beginFeedback();
+	void request(const glm::vec2& texCoord, int level);
+	/*	===============================================
+	Desc:	Sends painted tiles that are cached again, caches the
+			requested tiles within the upload budget and sends the page
+			table if a slot changed.
+	Precondition:	isOpen(), a GL context is current.
+	Postcondition:
+	=============================================== */
+	void update(GLStateCache& state);
+	/*	===============================================
+	Desc:	Binds the cache to GL_TEXTURE_2D and the page table to unit
+			PAGE_TABLE_UNIT, and switches the pipeline to its virtual
+			texture programs until setVirtualTexture(false) is called.
+	Precondition:	update() was called in this context.
+	Postcondition:
+	=============================================== */
+	void bind(GLStateCache& state, ShaderPipeline& pipeline);
+
+	const VirtualTextureStats& getStats() { return stats; }
+	size_t getCacheBytes() { return (size_t)cacheSize() * cacheSize() * 3; }
+
+private:
+	int cacheSize() { return VIRTUAL_CACHE_TILES * VIRTUAL_TILE_SIZE; }
+	void initGL(GLStateCache& state);
+	void releaseGL();
+	void uploadTile(GLStateCache& state, int tile, int slot);
+	int freeSlot();
+	void updatePageTable(GLStateCache& state);
+
+	TileStore store;
+	GLuint cacheTexture;
+	GLuint pageTableTexture;
+	GLStateCache* stateCache;		// the textures were created through, told when they go
+
+	std::vector<int> tileSlots;				// cache slot of every tile, -1 if not cached
+	std::vector<int> slotTiles;				// tile in every slot, -1 if free
+	std::vector<unsigned int> slotRequested;	// frame the slot's tile was last requested
+	std::vector<unsigned int> tileRequested;	// frame of the last request of every tile
+	std::vector<int> requests;				// tiles requested this frame
+	unsigned int frame;
+	bool pageTableDirty;
+	// RGBA8 entries of every level: slot x, slot y, level of the slot's tile
+	std::vector<unsigned char> pageTable;
+	std::vector<size_t> pageTableLevels;	// offset of every level in pageTable
+	VirtualTextureStats stats;
+};
+
+#endif
@@ -4,7 +4,15 @@
 	Author: Michael Shah
 
 	Purpose: Driver for 3D program to load .ply models 
-	Usage:	
+	Usage:	ComputerGraphics [--mesh model.ply|model.obj] [--spheres N] [--shaders]
+			[--texture-compression bc1|bc7] [--instance-textures a.ppm,b.ppm,...]
+			[--atlas] [--virtual-texture surface.vt] [--virtual-size N]
+			[--resize-textures pot|WxH] [--max-texture-size N]
+			[--resample-filter box|bilinear|lanczos3] [--dynamic-resolution]
+			[--resolution-scale 0.5,1.0] [--target-frame-ms 16.7]
+			[--record events.txt]
+			(see Headless.h, Benchmark.h, FrameCapture.h and Resample.h for
+			the others)
 	===================================================== */
 
 #include <string>
@@ -25,6 +33,10 @@
 #include <FL/glu.h>
 
 #include "MyGLCanvas.h"
+#include "Headless.h"
+#include "Benchmark.h"
+#include "Resample.h"
+#include "ResolutionScaler.h"
 
 using namespace std;
 
@@ -75,8 +87,8 @@ MyAppWindow::MyAppWindow(int W, int H, const char*L) : Fl_Window(W, H, L) {
 
 
 	wireButton = new Fl_Check_Button(0, 0, pack->w() - 20, 20, "Wireframe");
-	wireButton->callback(toggleCB, (void*)(&(canvas->wireframe)));
-	wireButton->value(canvas->wireframe);
+	wireButton->callback(toggleCB, (void*)(&(canvas->renderer.wireframe)));
+	wireButton->value(canvas->renderer.wireframe);
 
 	end();
 }
@@ -84,7 +96,64 @@ MyAppWindow::MyAppWindow(int W, int H, const char*L) : Fl_Window(W, H, L) {
 
 /**************************************** main() ********************/
 int main(int argc, char **argv) {
+	// --bench replays an event script offscreen and reports frame statistics
+	BenchmarkOptions benchmarkOptions;
+	if (parseBenchmarkOptions(argc, argv, benchmarkOptions)) {
+		return runBenchmark(benchmarkOptions);
+	}
+	// --headless renders offscreen and writes ppm frames instead of opening a window
+	HeadlessOptions headlessOptions;
+	if (parseHeadlessOptions(argc, argv, headlessOptions)) {
+		return runHeadless(headlessOptions);
+	}
+	// --resample-dir converts a directory of images and exits
+	ResampleBatchOptions resampleOptions;
+	if (parseResampleBatchOptions(argc, argv, resampleOptions)) {
+		return runResampleBatch(resampleOptions);
+	}
+
 	win = new MyAppWindow(800, 500, "Dragging Object");
+	win->canvas->captureEnabled = parseCaptureOptions(argc, argv, win->canvas->captureOptions);
+	win->canvas->renderer.dynamicResolution = parseResolutionOptions(argc, argv, win->canvas->renderer.resolutionScaler);
+	ResizePolicy textureResize = noResize();
+	if (parseResizePolicy(argc, argv, textureResize)) {
+		win->canvas->renderer.textureManager.setResize(textureResize);
+	}
+	bool atlas = false;
+	for (int i = 1; i < argc; i++) {
+		if (string(argv[i]) == "--shaders") {
+			win->canvas->renderer.shaderPipeline = true;
+		}
+		else if (string(argv[i]) == "--atlas") {
+			atlas = true;
+		}
+	}
+	for (int i = 1; i + 1 < argc; i++) {
+		if (string(argv[i]) == "--record") {
+			win->canvas->recorder.open(argv[i + 1]);
+		}
+		else if (string(argv[i]) == "--mesh") {
+			win->canvas->renderer.meshFile = argv[i + 1];
+		}
+		else if (string(argv[i]) == "--spheres") {
+			win->canvas->renderer.setSphereInstances(atoi(argv[i + 1]));
+		}
+		else if (string(argv[i]) == "--virtual-texture") {
+			win->canvas->renderer.virtualTextureFile = argv[i + 1];
+		}
+		else if (string(argv[i]) == "--virtual-size") {
+			win->canvas->renderer.virtualTextureSize = atoi(argv[i + 1]);
+		}
+		else if (string(argv[i]) == "--instance-textures") {
+			win->canvas->renderer.setInstanceTextures(argv[i + 1], atlas);
+		}
+		else if (string(argv[i]) == "--texture-compression") {
+			TextureCompression format;
+			if (parseCompressionName(argv[i + 1], format)) {
+				win->canvas->renderer.textureManager.setCompression(format);
+			}
+		}
+	}
 	win->resizable(win);
 	Fl::add_idle(MyAppWindow::idleCB);
 	win->show();
@@ -8,10 +8,12 @@
 	Usage:	
 	===================================================== */
 
-#include <FL/gl.h>
 #include <iostream>
+#include <cstdlib>
 #include <string>
 #include <fstream>
+#include <cstring>
+#include <vector>
 #include "ppm.h"
 
 /*	===============================================
@@ -27,6 +29,9 @@ ppm::ppm(std::string _fileName){
       Step 2: Read in colors into array
       Step 3: Allocate memory for width and height dimensions
   */
+  width = 0;
+  height = 0;
+  color = NULL;
 
 
   // Open an input file stream for reading a file
@@ -43,10 +48,16 @@ ppm::ppm(std::string _fileName){
 	  char* delimeter_pointer;
 	  int iteration = 0;
 	  int pos = 0;
+	  // strtok writes into the line, so it works on a copy; one buffer is
+	  // grown to the longest line instead of allocating one per line
+	  std::vector<char> copy;
 	  while (getline(ppmFile, line)) {
-		  char* copy = new char[line.length() + 1];
-		  strcpy(copy, line.c_str());
-		  delimeter_pointer = strtok(copy, " ");
+		  copy.assign(line.c_str(), line.c_str() + line.length() + 1);
+		  delimeter_pointer = strtok(&copy[0], " ");
+		  if (delimeter_pointer == NULL) {
+			  iteration++;
+			  continue;
+		  }
 
 		  // Read in the magic number
 		  if (iteration == 0) {
@@ -82,7 +93,7 @@ ppm::ppm(std::string _fileName){
 		  }
 		  else {
 			  // Iterate through the entire line and begin storing values
-			  while (delimeter_pointer != NULL) {
+			  while (delimeter_pointer != NULL && pos < width*height * 3) {
 				  //std::cout << delimeter_pointer << " ";
 				  int value = atoi(delimeter_pointer);
 				  color[pos] = (char)value;
@@ -90,7 +101,6 @@ ppm::ppm(std::string _fileName){
 				  delimeter_pointer = strtok(NULL, " ");
 			  }
 		  }
-		  delete copy;
 		  iteration++;
 	  }
 	  ppmFile.close();
@@ -103,6 +113,19 @@ ppm::ppm(std::string _fileName){
 
 
 
+/*	===============================================
+Desc:	Creates a blank (black) image of the given dimensions
+Precondition: _width and _height are greater than 0
+Postcondition: The array 'color' is allocated memory according to the image dimensions.
+=============================================== */ 
+ppm::ppm(int _width, int _height){
+  magicNumber = "P6";
+  width = _width;
+  height = _height;
+  color = new char[width*height * 3];
+  memset(color, 0, width*height * 3);
+}
+
 /*	===============================================
 Desc:	Default destructor for a ppm
 Precondition: 
@@ -130,19 +153,38 @@ Precondition:
 Postcondition:
 =============================================== */ 
 void ppm::setPixel(int x, int y, int r, int g, int b){
-  if(x > width || y > height){
+  if(x < 0 || y < 0 || x >= width || y >= height){
     return;
   }
   else{
-    /*std::cout << "modifying pixel at " 
-              << x << "," << y << "from (" <<
-              (int)color[x*y] << "," << (int)color[x*y+1] << "," << (int)color[x*y+2] << ")";
-*/
-    color[(x*3)+height*(y*3)] = r;
-    color[(x*3)+height*(y*3)+1] = g;
-    color[(x*3)+height*(y*3)+2] = b;
-/*
-    std::cout << " to (" << (int)color[x*y] << "," << (int)color[x*y+1] << "," << (int)color[x*y+2] << ")" << std::endl;
-*/
+    // rows are width pixels long, so non square images are indexed correctly
+    int index = (y*width + x) * 3;
+    color[index] = r;
+    color[index+1] = g;
+    color[index+2] = b;
+  }
+}
+
+/*  ===============================================
+Desc: Writes the image to a file, as binary (P6) or plain text (P3)
+Precondition: 
+Postcondition: Returns false if the file could not be written
+=============================================== */ 
+bool ppm::save(std::string _fileName, bool binary){
+  std::ofstream ppmFile(_fileName.c_str(), std::ios::out | std::ios::binary);
+  if (!ppmFile.is_open()) {
+    std::cout << "Unable to write ppm file: " << _fileName << std::endl;
+    return false;
+  }
+  // The comment line is required, our reader expects the dimensions on the third line
+  ppmFile << (binary ? "P6" : "P3") << "\n# CREATOR: ComputerGraphics\n" << width << " " << height << "\n255\n";
+  if (binary) {
+    ppmFile.write(color, width*height * 3);
+  }
+  else {
+    for (int i = 0; i < width*height * 3; i++) {
+      ppmFile << (int)(unsigned char)color[i] << ((i % 12 == 11) ? "\n" : " ");
+    }
   }
+  return ppmFile.good();
 }
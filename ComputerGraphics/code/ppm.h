@@ -38,6 +38,12 @@ class ppm{
 		=============================================== */ 
 		ppm(std::string _fileName);
 		/*	===============================================
+		Desc:	Creates a blank (black) image of the given dimensions
+		Precondition: _width and _height are greater than 0
+		Postcondition: The array 'color' is allocated memory according to the image dimensions.
+		=============================================== */ 
+		ppm(int _width, int _height);
+		/*	===============================================
 		Desc:	Default destructor for a ppm
 		Precondition: 
 		Postcondition: 'color' array memory is deleted,
@@ -55,6 +61,12 @@ class ppm{
 		Postcondition:
 		=============================================== */ 
 		void setPixel(int x, int y, int r, int g, int b);
+		/*	===============================================
+		Desc:	Writes the image to a file, as binary (P6) or plain text (P3)
+		Precondition: 
+		Postcondition: Returns false if the file could not be written
+		=============================================== */ 
+		bool save(std::string _fileName, bool binary = true);
 
 		// Getter functions
 		int getWidth() { return width;}